@@ -18,6 +18,7 @@
 
 #include "paddle/fluid/distributed/service/brpc_ps_client.h"
 #include "paddle/fluid/framework/archive.h"
+#include "paddle/fluid/platform/metrics.h"
 
 const static int max_port = 65535;
 
@@ -70,6 +71,46 @@ inline size_t get_sparse_shard(uint32_t shard_num, uint32_t server_num,
   return (key % shard_num) / local_shard_num;
 }
 
+// The metrics of one kind of the requests to the servers, updated when the
+// responses are checked if FLAGS_enable_op_metrics is set.
+struct PsRequestMetrics {
+  paddle::platform::MetricHistogram *latency;
+  paddle::platform::MetricCounter *failures;
+};
+
+static void RecordPsRequestMetrics(brpc::Controller *cntl, int cmd_id,
+                                   bool failed) {
+  if (!FLAGS_enable_op_metrics || !PsCmdID_IsValid(cmd_id)) {
+    return;
+  }
+  static std::atomic<PsRequestMetrics *> all_metrics[PsCmdID_ARRAYSIZE];
+  PsRequestMetrics *metrics =
+      all_metrics[cmd_id].load(std::memory_order_acquire);
+  if (metrics == nullptr) {
+    auto &registry = paddle::platform::MetricsRegistry::Instance();
+    paddle::platform::MetricLabels labels{
+        {"cmd", PsCmdID_Name(static_cast<PsCmdID>(cmd_id))}};
+    std::unique_ptr<PsRequestMetrics> created(new PsRequestMetrics{
+        registry.GetHistogram("paddle_ps_client_request_seconds",
+                              "The latency of the requests to the servers.",
+                              labels),
+        registry.GetCounter("paddle_ps_client_request_failures_total",
+                            "The number of the failed requests to the "
+                            "servers.",
+                            labels)});
+    PsRequestMetrics *expected = nullptr;
+    if (all_metrics[cmd_id].compare_exchange_strong(expected, created.get())) {
+      metrics = created.release();
+    } else {
+      metrics = expected;
+    }
+  }
+  metrics->latency->Observe(static_cast<uint64_t>(cntl->latency_us()) * 1000);
+  if (failed) {
+    metrics->failures->Increase();
+  }
+}
+
 void DownpourPsClientService::service(
     ::google::protobuf::RpcController *controller,
     const PsRequestMessage *request, PsResponseMessage *response,
@@ -190,6 +231,9 @@ int32_t BrpcPsClient::initialize() {
 }
 
 int DownpourBrpcClosure::check_response(size_t request_idx, int cmd_id) {
+  RecordPsRequestMetrics(_cntls[request_idx].get(), cmd_id,
+                         _cntls[request_idx]->Failed() ||
+                             _responses[request_idx].err_code() != 0);
   if (_cntls[request_idx]->Failed()) {
     LOG(ERROR) << "resquest cmd_id:" << cmd_id << " failed, "
                                                   "err:"
@@ -208,6 +252,8 @@ int DownpourBrpcClosure::check_response(size_t request_idx, int cmd_id) {
 
 int DownpourBrpcClosure::check_save_response(size_t request_idx, int cmd_id) {
   uint32_t feasign_size = 0;
+  RecordPsRequestMetrics(_cntls[request_idx].get(), cmd_id,
+                         _cntls[request_idx]->Failed());
   if (_cntls[request_idx]->Failed()) {
     LOG(ERROR) << "resquest cmd_id:" << cmd_id << " failed, "
                                                   "err:"
@@ -13,12 +13,17 @@
 // limitations under the License.
 
 #include "paddle/fluid/distributed/table/common_sparse_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
 #include <sstream>
 
 #include "boost/lexical_cast.hpp"
 #include "glog/logging.h"
 #include "paddle/fluid/platform/enforce.h"
 
+DECLARE_bool(pserver_sparse_table_snapshot_save);
+
 namespace paddle {
 namespace distributed {
 class ValueBlock;
@@ -28,6 +33,43 @@ class ValueBlock;
 namespace paddle {
 namespace distributed {
 
+static const char kSnapshotMagic[8] = {'P', 'D', 'S', 'P', 'S', 'N', 'A', 'P'};
+static const uint32_t kSnapshotVersion = 1;
+// The shards copied but not written yet, which bounds the extra memory of a
+// snapshot save.
+static const int kSnapshotWindow = 2;
+
+template <typename T>
+static void WritePod(std::ostream* os, const T& value) {
+  os->write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+static void WriteColumn(std::ostream* os, const std::vector<T>& column) {
+  os->write(reinterpret_cast<const char*>(column.data()),
+            sizeof(T) * column.size());
+}
+
+template <typename T>
+static T ReadPod(std::istream* is) {
+  T value;
+  is->read(reinterpret_cast<char*>(&value), sizeof(T));
+  return value;
+}
+
+template <typename T>
+static void ReadColumn(std::istream* is, size_t size, std::vector<T>* column) {
+  column->resize(size);
+  is->read(reinterpret_cast<char*>(column->data()), sizeof(T) * size);
+}
+
+static bool IsSnapshotFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  char magic[sizeof(kSnapshotMagic)];
+  file.read(magic, sizeof(magic));
+  return file && memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+}
+
 void CommonSparseTable::ProcessALine(const std::vector<std::string>& columns,
                                      const Meta& meta, const int64_t id,
                                      std::vector<std::vector<float>>* values) {
@@ -166,6 +208,169 @@ int64_t CommonSparseTable::LoadFromText(
   return 0;
 }
 
+void CommonSparseTable::TakeSnapshot(std::shared_ptr<ValueBlock> block,
+                                     const int mode, ShardSnapshot* snapshot) {
+  size_t num = 0;
+  for (auto& table : block->values_) {
+    num += table.size();
+  }
+  snapshot->ids.reserve(num);
+  snapshot->counts.reserve(num);
+  snapshot->unseen_days.reserve(num);
+  snapshot->is_entry.reserve(num);
+  snapshot->values.reserve(num * block->value_length_);
+
+  for (auto& table : block->values_) {
+    for (auto& value : table) {
+      if (mode == SaveMode::delta && !value.second->need_save_) {
+        continue;
+      }
+      snapshot->ids.push_back(value.first);
+      snapshot->counts.push_back(value.second->count_);
+      snapshot->unseen_days.push_back(value.second->unseen_days_);
+      snapshot->is_entry.push_back(value.second->is_entry_);
+      snapshot->values.insert(snapshot->values.end(),
+                              value.second->data_.begin(),
+                              value.second->data_.end());
+      if (mode == SaveMode::base || mode == SaveMode::delta) {
+        value.second->need_save_ = false;
+      }
+    }
+  }
+}
+
+// The file is the header, then a section of columns for every shard:
+//   magic, version, value length, number of sections
+//   count, ids, counts, unseen days, entry flags, values
+int64_t CommonSparseTable::SaveToBinary(const std::string& path,
+                                        const int mode) {
+  std::ofstream os(path, std::ios::binary | std::ios::trunc);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(os), true,
+                    paddle::platform::errors::Unavailable(
+                        "Cannot open %s to save the sparse table.", path));
+  os.write(kSnapshotMagic, sizeof(kSnapshotMagic));
+  WritePod(&os, kSnapshotVersion);
+  WritePod(&os, static_cast<uint32_t>(shard_values_[0]->value_length_));
+  WritePod(&os, static_cast<uint64_t>(task_pool_size_));
+
+  // A shard is copied in its own task thread, the pulls and pushes of it wait
+  // for the copy only, not for the writing.
+  std::vector<ShardSnapshot> snapshots(task_pool_size_);
+  std::vector<std::future<int>> tasks(task_pool_size_);
+  auto take_snapshot = [this, mode, &snapshots, &tasks](int shard_id) {
+    tasks[shard_id] = _shards_task_pool[shard_id]->enqueue(
+        [this, shard_id, mode, &snapshots]() -> int {
+          TakeSnapshot(shard_values_[shard_id], mode, &snapshots[shard_id]);
+          return 0;
+        });
+  };
+  for (int shard_id = 0; shard_id < std::min(kSnapshotWindow, task_pool_size_);
+       ++shard_id) {
+    take_snapshot(shard_id);
+  }
+
+  int64_t total = 0;
+  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
+    tasks[shard_id].wait();
+    if (shard_id + kSnapshotWindow < task_pool_size_) {
+      take_snapshot(shard_id + kSnapshotWindow);
+    }
+    auto& snapshot = snapshots[shard_id];
+    WritePod(&os, static_cast<uint64_t>(snapshot.ids.size()));
+    WriteColumn(&os, snapshot.ids);
+    WriteColumn(&os, snapshot.counts);
+    WriteColumn(&os, snapshot.unseen_days);
+    WriteColumn(&os, snapshot.is_entry);
+    WriteColumn(&os, snapshot.values);
+    total += snapshot.ids.size();
+    snapshot = ShardSnapshot();
+  }
+  os.close();
+  PADDLE_ENFORCE_EQ(static_cast<bool>(os), true,
+                    paddle::platform::errors::Unavailable(
+                        "Failed to save the sparse table to %s.", path));
+  return total;
+}
+
+int64_t CommonSparseTable::LoadFromBinary(
+    const std::string& valuepath, const std::string& metapath,
+    const int pserver_id, const int pserver_num, const int local_shard_num,
+    std::vector<std::shared_ptr<ValueBlock>>* blocks) {
+  Meta meta = Meta(metapath);
+  PADDLE_ENFORCE_EQ(
+      meta.names == value_names_ && meta.dims == value_dims_, true,
+      paddle::platform::errors::InvalidArgument(
+          "The values saved in %s are [%s] of dims [%s], which do not match "
+          "the table.",
+          valuepath, paddle::string::join_strings(meta.names, ','),
+          paddle::string::join_strings(meta.dims, ',')));
+  PADDLE_ENFORCE_EQ(local_shard_num, task_pool_size_,
+                    paddle::platform::errors::InvalidArgument(
+                        "The number of shards %d to load should be %d.",
+                        local_shard_num, task_pool_size_));
+
+  std::ifstream is(valuepath, std::ios::binary);
+  char magic[sizeof(kSnapshotMagic)];
+  is.read(magic, sizeof(magic));
+  auto version = ReadPod<uint32_t>(&is);
+  auto value_length = ReadPod<uint32_t>(&is);
+  auto num_sections = ReadPod<uint64_t>(&is);
+  PADDLE_ENFORCE_EQ(
+      is && memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0 &&
+          version == kSnapshotVersion &&
+          value_length == blocks->at(0)->value_length_,
+      true, paddle::platform::errors::InvalidArgument(
+                "%s is not a snapshot of the sparse table.", valuepath));
+
+  // Insert the rows of a section in the task threads of the shards, while the
+  // next section is read.
+  ShardSnapshot sections[2];
+  std::vector<std::future<int>> tasks;
+  int64_t total = 0;
+  for (uint64_t i = 0; i < num_sections; ++i) {
+    auto& section = sections[i % 2];
+    auto count = ReadPod<uint64_t>(&is);
+    ReadColumn(&is, count, &section.ids);
+    ReadColumn(&is, count, &section.counts);
+    ReadColumn(&is, count, &section.unseen_days);
+    ReadColumn(&is, count, &section.is_entry);
+    ReadColumn(&is, count * value_length, &section.values);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(is), true,
+                      paddle::platform::errors::InvalidArgument(
+                          "The snapshot %s is truncated.", valuepath));
+    for (auto& task : tasks) {
+      task.wait();
+    }
+    tasks.clear();
+    for (int shard_id = 0; shard_id < local_shard_num; ++shard_id) {
+      tasks.push_back(_shards_task_pool[shard_id]->enqueue(
+          [=, &section]() -> int {
+            auto& block = blocks->at(shard_id);
+            for (size_t x = 0; x < section.ids.size(); ++x) {
+              auto id = section.ids[x];
+              if (id % pserver_num != pserver_id ||
+                  id % local_shard_num != shard_id) {
+                continue;
+              }
+              block->Init(id, false);
+              VALUE* value = block->GetValue(id);
+              value->count_ = section.counts[x];
+              value->unseen_days_ = section.unseen_days[x];
+              value->is_entry_ = section.is_entry[x];
+              std::copy_n(section.values.data() + x * value_length,
+                          value_length, value->data_.data());
+            }
+            return 0;
+          }));
+    }
+    total += count;
+  }
+  for (auto& task : tasks) {
+    task.wait();
+  }
+  return total;
+}
+
 int32_t CommonSparseTable::initialize() {
   _shards_task_pool.resize(task_pool_size_);
   for (int i = 0; i < _shards_task_pool.size(); ++i) {
@@ -282,8 +487,13 @@ int32_t CommonSparseTable::load(const std::string& path,
                                 const std::string& param) {
   auto begin = GetCurrentUS();
   rwlock_->WRLock();
-  LoadFromText(path, param, _shard_idx, _shard_num, task_pool_size_,
-               &shard_values_);
+  if (IsSnapshotFile(path)) {
+    LoadFromBinary(path, param, _shard_idx, _shard_num, task_pool_size_,
+                   &shard_values_);
+  } else {
+    LoadFromText(path, param, _shard_idx, _shard_num, task_pool_size_,
+                 &shard_values_);
+  }
   rwlock_->UNLock();
   auto end = GetCurrentUS();
 
@@ -314,19 +524,31 @@ int32_t CommonSparseTable::save(const std::string& dirname,
   std::string shard_var_pre =
       string::Sprintf("%s.block%d", varname, _shard_idx);
 
-  std::string value_ = string::Sprintf("%s/%s.txt", var_store, shard_var_pre);
-
-  std::unique_ptr<std::ofstream> vs(new std::ofstream(value_));
-
+  std::string value_;
   int64_t total_ins = 0;
-  for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
-    // save values
-    auto shard_save_num =
-        SaveValueToText(vs.get(), shard_values_[shard_id],
-                        _shards_task_pool[shard_id], mode, shard_id);
-    total_ins += shard_save_num;
+  if (FLAGS_pserver_sparse_table_snapshot_save) {
+    value_ = string::Sprintf("%s/%s.bin", var_store, shard_var_pre);
+    total_ins = SaveToBinary(value_, mode);
+  } else {
+    value_ = string::Sprintf("%s/%s.txt", var_store, shard_var_pre);
+    std::unique_ptr<std::ofstream> vs(new std::ofstream(value_));
+    for (int shard_id = 0; shard_id < task_pool_size_; ++shard_id) {
+      // save values
+      auto shard_save_num =
+          SaveValueToText(vs.get(), shard_values_[shard_id],
+                          _shards_task_pool[shard_id], mode, shard_id);
+      total_ins += shard_save_num;
+    }
+    vs->close();
   }
-  vs->close();
+  // The value file of the other format left by an earlier save would be
+  // loaded instead of this one, for the snapshot is preferred when both
+  // exist.
+  std::remove(string::Sprintf("%s/%s.%s", var_store, shard_var_pre,
+                              FLAGS_pserver_sparse_table_snapshot_save
+                                  ? "txt"
+                                  : "bin")
+                  .c_str());
 
   std::string meta_ = string::Sprintf("%s/%s.meta", var_store, shard_var_pre);
   std::unique_ptr<std::ofstream> ms(new std::ofstream(meta_));
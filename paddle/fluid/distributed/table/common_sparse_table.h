@@ -109,6 +109,16 @@ struct Meta {
   }
 };
 
+// A consistent copy of the values of a shard, in columns. It is taken in the
+// task thread of the shard, so no pull or push of the shard runs meanwhile.
+struct ShardSnapshot {
+  std::vector<uint64_t> ids;
+  std::vector<int32_t> counts;
+  std::vector<int32_t> unseen_days;
+  std::vector<uint8_t> is_entry;
+  std::vector<float> values;
+};
+
 class CommonSparseTable : public SparseTable {
  public:
   CommonSparseTable() { rwlock_.reset(new framework::RWLock); }
@@ -148,6 +158,20 @@ class CommonSparseTable : public SparseTable {
       const int pserver_id, const int pserver_num, const int local_shard_num,
       std::vector<std::shared_ptr<ValueBlock>>* blocks);
 
+  // The binary snapshot format, saved when
+  // FLAGS_pserver_sparse_table_snapshot_save is set. Every shard is copied
+  // into a ShardSnapshot in its own task thread, and written in columns while
+  // the pulls and pushes of the other shards continue.
+  void TakeSnapshot(std::shared_ptr<ValueBlock> block, const int mode,
+                    ShardSnapshot* snapshot);
+
+  int64_t SaveToBinary(const std::string& path, const int mode);
+
+  virtual int64_t LoadFromBinary(
+      const std::string& valuepath, const std::string& metapath,
+      const int pserver_id, const int pserver_num, const int local_shard_num,
+      std::vector<std::shared_ptr<ValueBlock>>* blocks);
+
   virtual std::pair<int64_t, int64_t> print_table_stat();
   virtual int32_t pull_sparse(float* values, const PullSparseValue& pull_value);
 
@@ -0,0 +1,181 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/distributed/ps.pb.h"
+#include "paddle/fluid/distributed/table/common_sparse_table.h"
+#include "paddle/fluid/distributed/table/table.h"
+
+DECLARE_bool(pserver_sparse_table_snapshot_save);
+
+namespace paddle {
+namespace distributed {
+
+static const int kEmbDim = 8;
+
+static Table* CreateTable() {
+  TableParameter table_config;
+  table_config.set_table_class("CommonSparseTable");
+  FsClientParameter fs_config;
+  Table* table = new CommonSparseTable();
+  TableAccessorParameter* accessor_config = table_config.mutable_accessor();
+  accessor_config->set_accessor_class("CommMergeAccessor");
+  // No ids pre-initialized, so the tables hold the pulled ids only.
+  accessor_config->set_fea_dim(0);
+  CommonAccessorParameter* common_config = table_config.mutable_common();
+  common_config->set_name("sgd");
+  common_config->set_table_name("snapshot_test_table");
+  common_config->set_trainer_num(1);
+  common_config->set_entry("none");
+  common_config->add_params("Param");
+  common_config->add_dims(kEmbDim);
+  common_config->add_initializers("uniform_random&0&-1.0&1.0");
+  common_config->add_params("LearningRate");
+  common_config->add_dims(1);
+  common_config->add_initializers("fill_constant&1.0");
+  table->set_shard(0, 1);
+  EXPECT_EQ(table->initialize(table_config, fs_config), 0);
+  return table;
+}
+
+static void Pull(Table* table, std::vector<uint64_t>* ids, bool is_training,
+                 std::vector<float>* values) {
+  std::vector<uint32_t> frequencies(ids->size(), 1);
+  PullSparseValue pull_value(ids->size(), kEmbDim);
+  pull_value.is_training_ = is_training;
+  pull_value.feasigns_ = ids->data();
+  pull_value.frequencies_ = frequencies.data();
+  values->resize(ids->size() * kEmbDim);
+  table->pull_sparse(values->data(), pull_value);
+}
+
+static std::string ValuePath(const std::string& dirname,
+                             const std::string& suffix) {
+  return dirname + "/snapshot_test_table.shard/snapshot_test_table.block0." +
+         suffix;
+}
+
+TEST(CommonSparseTable, snapshot_save_load) {
+  std::unique_ptr<Table> table(CreateTable());
+  std::vector<uint64_t> ids;
+  for (uint64_t id = 0; id < 1000; ++id) {
+    ids.push_back(id * 7);
+  }
+  std::vector<float> expected;
+  Pull(table.get(), &ids, true, &expected);
+
+  FLAGS_pserver_sparse_table_snapshot_save = true;
+  const std::string dirname = "sparse_table_snapshot_test";
+  ASSERT_EQ(table->save(dirname, "0"), 0);
+  FLAGS_pserver_sparse_table_snapshot_save = false;
+
+  std::unique_ptr<Table> loaded(CreateTable());
+  ASSERT_EQ(loaded->load(ValuePath(dirname, "bin"), ValuePath(dirname, "meta")),
+            0);
+  std::vector<float> values;
+  Pull(loaded.get(), &ids, false, &values);
+  EXPECT_EQ(values, expected);
+  EXPECT_EQ(loaded->print_table_stat().first,
+            table->print_table_stat().first);
+
+  // A later save in text removes the snapshot, which would be loaded in
+  // favor of the text otherwise, and the other way around.
+  ASSERT_EQ(table->save(dirname, "0"), 0);
+  EXPECT_FALSE(std::ifstream(ValuePath(dirname, "bin")).good());
+  EXPECT_TRUE(std::ifstream(ValuePath(dirname, "txt")).good());
+  FLAGS_pserver_sparse_table_snapshot_save = true;
+  ASSERT_EQ(table->save(dirname, "0"), 0);
+  FLAGS_pserver_sparse_table_snapshot_save = false;
+  EXPECT_TRUE(std::ifstream(ValuePath(dirname, "bin")).good());
+  EXPECT_FALSE(std::ifstream(ValuePath(dirname, "txt")).good());
+}
+
+// The throughput of saving a table of 1M ids in text and in snapshots, and
+// the latency of the pulls meanwhile.
+TEST(CommonSparseTable, snapshot_benchmark) {
+  std::unique_ptr<Table> table(CreateTable());
+  const int num_ids = 1 << 20;
+  std::vector<uint64_t> ids(num_ids);
+  for (int i = 0; i < num_ids; ++i) {
+    ids[i] = i;
+  }
+  std::vector<float> values;
+  Pull(table.get(), &ids, true, &values);
+
+  const std::string dirname = "sparse_table_snapshot_benchmark";
+  auto save = [&](bool snapshot) {
+    FLAGS_pserver_sparse_table_snapshot_save = snapshot;
+    std::atomic<bool> saving{true};
+    double max_pull_ms = 0, total_pull_ms = 0;
+    int pulls = 0;
+    std::thread puller([&] {
+      std::vector<uint64_t> batch(1024);
+      std::vector<float> batch_values;
+      while (saving) {
+        for (auto& id : batch) {
+          id = ids[rand() % num_ids];  // NOLINT
+        }
+        auto start = std::chrono::steady_clock::now();
+        Pull(table.get(), &batch, false, &batch_values);
+        double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        max_pull_ms = std::max(max_pull_ms, ms);
+        total_pull_ms += ms;
+        ++pulls;
+      }
+    });
+    auto start = std::chrono::steady_clock::now();
+    table->save(dirname, "0");
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    saving = false;
+    puller.join();
+    LOG(INFO) << (snapshot ? "Snapshot" : "Text") << " save of " << num_ids
+              << " ids: " << num_ids / seconds << " ids/s, " << pulls
+              << " pulls meanwhile, mean latency "
+              << total_pull_ms / std::max(pulls, 1) << " ms, max latency "
+              << max_pull_ms << " ms";
+  };
+  // Each save removes the file of the other format, so each is loaded right
+  // after saved.
+  auto load = [&](bool snapshot) {
+    std::unique_ptr<Table> loaded(CreateTable());
+    auto start = std::chrono::steady_clock::now();
+    loaded->load(ValuePath(dirname, snapshot ? "bin" : "txt"),
+                 ValuePath(dirname, "meta"));
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    LOG(INFO) << "Load " << num_ids << " ids: " << num_ids / seconds
+              << " ids/s from " << (snapshot ? "snapshot" : "text");
+  };
+  for (bool snapshot : {false, true}) {
+    save(snapshot);
+    load(snapshot);
+  }
+  FLAGS_pserver_sparse_table_snapshot_save = false;
+}
+
+}  // namespace distributed
+}  // namespace paddle
@@ -24,6 +24,7 @@ limitations under the License. */
 #include <sys/stat.h>
 #endif
 #include "io/fs.h"
+#include "paddle/fluid/platform/metrics.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/timer.h"
 
@@ -31,6 +32,23 @@ USE_INT_STAT(STAT_total_feasign_num_in_mem);
 namespace paddle {
 namespace framework {
 
+// The metrics of one kind of data feed, updated by Next when
+// FLAGS_enable_op_metrics is set.
+struct DataFeedMetrics {
+  explicit DataFeedMetrics(const std::string& feed) {
+    auto& registry = platform::MetricsRegistry::Instance();
+    next = registry.GetHistogram(
+        "paddle_data_feed_next_seconds",
+        "The time of the data feeds to assemble one batch.", {{"feed", feed}});
+    instances = registry.GetCounter(
+        "paddle_data_feed_instances_total",
+        "The number of instances fed by the data feeds.", {{"feed", feed}});
+  }
+
+  platform::MetricHistogram* next;
+  platform::MetricCounter* instances;
+};
+
 DLManager& global_dlmanager_pool() {
   static DLManager manager;
   return manager;
@@ -208,6 +226,12 @@ template <typename T>
 int PrivateQueueDataFeed<T>::Next() {
 #ifdef _LINUX
   CheckStart();
+  const DataFeedMetrics* metrics = nullptr;
+  if (UNLIKELY(FLAGS_enable_op_metrics)) {
+    static DataFeedMetrics private_queue_metrics("PrivateQueueDataFeed");
+    metrics = &private_queue_metrics;
+  }
+  platform::MetricTimer metric_timer(metrics ? metrics->next : nullptr);
   int index = 0;
   T ins_vec;
   while (index < default_batch_size_) {
@@ -221,6 +245,9 @@ int PrivateQueueDataFeed<T>::Next() {
   if (batch_size_ != 0) {
     PutToFeedVec(ins_vec);
   }
+  if (metrics) {
+    metrics->instances->Increase(batch_size_);
+  }
   return batch_size_;
 #else
   return 0;
@@ -265,6 +292,12 @@ template <typename T>
 int InMemoryDataFeed<T>::Next() {
 #ifdef _LINUX
   this->CheckStart();
+  const DataFeedMetrics* metrics = nullptr;
+  if (UNLIKELY(FLAGS_enable_op_metrics)) {
+    static DataFeedMetrics in_memory_metrics("InMemoryDataFeed");
+    metrics = &in_memory_metrics;
+  }
+  platform::MetricTimer metric_timer(metrics ? metrics->next : nullptr);
   CHECK(output_channel_ != nullptr);
   CHECK(consume_channel_ != nullptr);
   VLOG(3) << "output_channel_ size=" << output_channel_->Size()
@@ -294,6 +327,9 @@ int InMemoryDataFeed<T>::Next() {
             << ", consume_channel_ size=" << consume_channel_->Size()
             << ", thread_id=" << thread_id_;
   }
+  if (metrics) {
+    metrics->instances->Increase(this->batch_size_);
+  }
   return this->batch_size_;
 #else
   return 0;
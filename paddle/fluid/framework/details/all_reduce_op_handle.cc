@@ -15,6 +15,7 @@
 
 #include "paddle/fluid/framework/details/container_cast.h"
 #include "paddle/fluid/framework/details/reduce_and_gather.h"
+#include "paddle/fluid/platform/cpu_collective.h"
 #include "paddle/fluid/platform/profiler.h"
 
 #if defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL)
@@ -228,6 +229,16 @@ void AllReduceOpHandle::AllReduceFunc(
     ReduceBufferData func(lod_tensor_data, trg.data<void>(), numel);
     VisitDataType(trg.type(), func);
 
+#ifndef _WIN32
+    // Reduce trg of the trainers, whose comm is created by ParallelExecutor
+    // in the collective training on the CPU.
+    auto &cpu_comm_ctx = platform::CPUCommContext::Instance();
+    if (cpu_comm_ctx.Has(0)) {
+      cpu_comm_ctx.Get(0)->AllReduceGradient(trg.data<void>(), numel,
+                                             trg.type());
+    }
+#endif
+
     for (size_t i = 1; i < local_exec_scopes_.size(); ++i) {
       auto &scope = local_exec_scopes_[i];
       auto &p = places[i];
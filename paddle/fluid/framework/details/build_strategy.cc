@@ -112,6 +112,15 @@ class ParallelExecutorPassBuilder : public ir::PassBuilder {
       strategy_.fuse_broadcast_ops_ = false;
     }
 
+    if (strategy_.cpu_grad_bucket_size_in_MB_ > 0.0) {
+      LOG_IF(WARNING, strategy_.fuse_all_reduce_ops_ == false)
+          << "cpu_grad_bucket_size_in_MB doesn't work when "
+             "fuse_all_reduce_ops is false.";
+      if (strategy_.fuse_all_reduce_ops_ == boost::none) {
+        strategy_.fuse_all_reduce_ops_ = true;
+      }
+    }
+
     ConvertDefaultValue(&strategy_.fuse_all_optimizer_ops_);
     ConvertDefaultValue(&strategy_.fuse_all_reduce_ops_);
     ConvertDefaultValue(&strategy_.fuse_broadcast_ops_);
@@ -371,6 +380,11 @@ ir::Graph *BuildStrategy::Apply(ir::Graph *graph,
     } else if (pass->Type() == "coalesce_grad_tensor_pass") {
       pass->Erase(kNRanks);
       pass->Set<size_t>(kNRanks, new size_t(nranks));
+      pass->Erase(kGradBucketSizeInMB);
+      pass->Set<double>(kGradBucketSizeInMB,
+                        new double(use_device == p::kCPU
+                                       ? cpu_grad_bucket_size_in_MB_
+                                       : 0.0));
     } else if (pass->Type() == "sequential_execution_pass") {
       LOG(INFO) << "set enable_sequential_execution:"
                 << enable_sequential_execution_;
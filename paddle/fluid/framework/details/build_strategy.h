@@ -111,6 +111,11 @@ struct BuildStrategy {
   // should not be sparse types
   boost::optional<bool> fuse_all_optimizer_ops_{false};
   boost::optional<bool> fuse_all_reduce_ops_{boost::none};
+  // Coalesce the gradients into the buckets of at most this size in MB by
+  // the order they are generated in the CPU training, so that the all reduce
+  // of each bucket overlaps the backward ops left. It turns on
+  // fuse_all_reduce_ops unless it is set false. 0 to disable it.
+  double cpu_grad_bucket_size_in_MB_{0.0};
   // fuse_relu_depthwise_conv can fuse the `relu ->
   // depthwise_conv`
   bool fuse_relu_depthwise_conv_{false};
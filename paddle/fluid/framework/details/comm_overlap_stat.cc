@@ -0,0 +1,136 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/comm_overlap_stat.h"
+
+#include <algorithm>
+
+#include "paddle/fluid/framework/details/fetch_async_op_handle.h"
+#include "paddle/fluid/framework/details/fetch_op_handle.h"
+#include "paddle/fluid/string/printf.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+namespace {
+
+// Merge the overlapping intervals, sorted by the begin.
+std::vector<CommOverlapStat::Interval> Merge(
+    std::vector<CommOverlapStat::Interval> intervals) {
+  std::sort(intervals.begin(), intervals.end());
+  std::vector<CommOverlapStat::Interval> merged;
+  for (auto &interval : intervals) {
+    if (!merged.empty() && interval.first <= merged.back().second) {
+      merged.back().second = std::max(merged.back().second, interval.second);
+    } else {
+      merged.emplace_back(interval);
+    }
+  }
+  return merged;
+}
+
+// The fetch ops copy the results out rather than communicate.
+bool IsCommOp(OpHandleBase *op) {
+  return op->IsMultiDeviceTransfer() &&
+         dynamic_cast<FetchOpHandle *>(op) == nullptr &&
+         dynamic_cast<FetchAsyncOpHandle *>(op) == nullptr;
+}
+
+}  // namespace
+
+CommOverlapStat::OpTimer::OpTimer(CommOverlapStat *stat, OpHandleBase *op)
+    : stat_(stat), op_(op) {
+  if (stat_->IsEnabled()) {
+    start_ = Clock::now();
+  }
+}
+
+CommOverlapStat::OpTimer::~OpTimer() {
+  if (stat_->IsEnabled()) {
+    stat_->Record(IsCommOp(op_), start_, Clock::now());
+  }
+}
+
+void CommOverlapStat::StartStep() {
+  if (!IsEnabled()) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  comm_.clear();
+  compute_.clear();
+  step_start_ = Clock::now();
+}
+
+void CommOverlapStat::Record(bool is_comm, Clock::time_point start,
+                             Clock::time_point end) {
+  using Micro = std::chrono::duration<double, std::micro>;
+  Interval interval(Micro(start - step_start_).count(),
+                    Micro(end - step_start_).count());
+  std::lock_guard<std::mutex> lock(mutex_);
+  (is_comm ? comm_ : compute_).emplace_back(interval);
+}
+
+void CommOverlapStat::EndStep() {
+  if (!IsEnabled()) return;
+  std::lock_guard<std::mutex> lock(mutex_);
+  double comm_us = 0, exposed_comm_us = 0;
+  Measure(std::move(comm_), std::move(compute_), &comm_us, &exposed_comm_us);
+  comm_.clear();
+  compute_.clear();
+  ++summary_.steps;
+  summary_.step_us += std::chrono::duration<double, std::micro>(
+                          Clock::now() - step_start_)
+                          .count();
+  summary_.comm_us += comm_us;
+  summary_.exposed_comm_us += exposed_comm_us;
+  if (summary_.steps < report_interval_) return;
+
+  last_summary_ = summary_;
+  summary_ = Summary();
+  int steps = last_summary_.steps;
+  LOG(INFO) << string::Sprintf(
+      "Communication overlap of the last %d steps, per step: step %.3f ms, "
+      "communication %.3f ms, exposed communication %.3f ms, overlap "
+      "efficiency %.1f%%.",
+      steps, last_summary_.step_us / steps / 1000,
+      last_summary_.comm_us / steps / 1000,
+      last_summary_.exposed_comm_us / steps / 1000,
+      last_summary_.OverlapEfficiency() * 100);
+}
+
+void CommOverlapStat::Measure(std::vector<Interval> comm,
+                              std::vector<Interval> compute, double *comm_us,
+                              double *exposed_comm_us) {
+  comm = Merge(std::move(comm));
+  compute = Merge(std::move(compute));
+  *comm_us = 0;
+  *exposed_comm_us = 0;
+  size_t j = 0;
+  for (auto &interval : comm) {
+    *comm_us += interval.second - interval.first;
+    double exposed = interval.second - interval.first;
+    // Skip the compute intervals ending before this one, which end before
+    // the next comm interval too.
+    while (j < compute.size() && compute[j].second <= interval.first) ++j;
+    for (size_t k = j; k < compute.size() && compute[k].first < interval.second;
+         ++k) {
+      exposed -= std::min(interval.second, compute[k].second) -
+                 std::max(interval.first, compute[k].first);
+    }
+    *exposed_comm_us += exposed;
+  }
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,100 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <chrono>  // NOLINT
+#include <mutex>   // NOLINT
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+class OpHandleBase;
+
+// The time spent by the communication ops, e.g. all reduce, in the steps of
+// an SSA graph executor, and how much of it is hidden by the computation ops
+// running at the same time. The communication is exposed when no
+// computation op runs, and the overlap efficiency is the ratio of the
+// communication time hidden.
+class CommOverlapStat {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // The begin and the end of an op, in us since the step starts.
+  using Interval = std::pair<double, double>;
+
+  struct Summary {
+    int steps{0};
+    double step_us{0};
+    double comm_us{0};
+    double exposed_comm_us{0};
+
+    double OverlapEfficiency() const {
+      return comm_us > 0 ? 1.0 - exposed_comm_us / comm_us : 0.0;
+    }
+  };
+
+  // Times the op run in its scope if the stat is enabled.
+  class OpTimer {
+   public:
+    OpTimer(CommOverlapStat *stat, OpHandleBase *op);
+    ~OpTimer();
+
+   private:
+    CommOverlapStat *stat_;
+    OpHandleBase *op_;
+    Clock::time_point start_;
+
+    DISABLE_COPY_AND_ASSIGN(OpTimer);
+  };
+
+  // Log the summary of every report_interval steps, 0 to disable the stat.
+  explicit CommOverlapStat(int report_interval)
+      : report_interval_(report_interval) {}
+
+  bool IsEnabled() const { return report_interval_ > 0; }
+
+  void StartStep();
+
+  // Called by the threads running the ops.
+  void Record(bool is_comm, Clock::time_point start, Clock::time_point end);
+
+  void EndStep();
+
+  // The summary of the last report_interval steps.
+  const Summary &LastSummary() const { return last_summary_; }
+
+  // The total length of the comm intervals, and of those not covered by any
+  // of the compute intervals.
+  static void Measure(std::vector<Interval> comm,
+                      std::vector<Interval> compute, double *comm_us,
+                      double *exposed_comm_us);
+
+ private:
+  int report_interval_;
+  Clock::time_point step_start_;
+  std::mutex mutex_;
+  std::vector<Interval> comm_;
+  std::vector<Interval> compute_;
+  Summary summary_;
+  Summary last_summary_;
+};
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,79 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/details/comm_overlap_stat.h"
+
+#include <chrono>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace paddle {
+namespace framework {
+namespace details {
+
+using Intervals = std::vector<CommOverlapStat::Interval>;
+
+static void ExpectMeasure(const Intervals &comm, const Intervals &compute,
+                          double expected_comm_us,
+                          double expected_exposed_comm_us) {
+  double comm_us = -1, exposed_comm_us = -1;
+  CommOverlapStat::Measure(comm, compute, &comm_us, &exposed_comm_us);
+  EXPECT_DOUBLE_EQ(comm_us, expected_comm_us);
+  EXPECT_DOUBLE_EQ(exposed_comm_us, expected_exposed_comm_us);
+}
+
+TEST(CommOverlapStat, measure) {
+  ExpectMeasure({}, {{0, 10}}, 0, 0);
+  // No computation to hide the communication.
+  ExpectMeasure({{0, 10}, {20, 25}}, {}, 15, 15);
+  // The communication after the computation.
+  ExpectMeasure({{10, 20}}, {{0, 10}}, 10, 10);
+  // Fully hidden.
+  ExpectMeasure({{2, 8}}, {{0, 10}}, 6, 0);
+  // Partially hidden by several computation ops.
+  ExpectMeasure({{0, 10}}, {{2, 4}, {6, 12}}, 10, 4);
+  // The overlapping intervals are counted once.
+  ExpectMeasure({{5, 15}, {0, 10}}, {{3, 6}, {4, 8}}, 15, 10);
+  // A computation op overlaps several communication ops.
+  ExpectMeasure({{0, 4}, {6, 10}, {12, 14}}, {{2, 13}}, 10, 3);
+}
+
+TEST(CommOverlapStat, summary) {
+  CommOverlapStat disabled(0);
+  EXPECT_FALSE(disabled.IsEnabled());
+  disabled.StartStep();
+  disabled.EndStep();
+  EXPECT_EQ(disabled.LastSummary().steps, 0);
+
+  CommOverlapStat stat(2);
+  EXPECT_TRUE(stat.IsEnabled());
+  for (int step = 0; step < 2; ++step) {
+    stat.StartStep();
+    auto now = CommOverlapStat::Clock::now();
+    // 4 ms of the communication, the first 2 ms hidden.
+    stat.Record(false, now, now + std::chrono::milliseconds(2));
+    stat.Record(true, now, now + std::chrono::milliseconds(4));
+    stat.EndStep();
+  }
+  auto &summary = stat.LastSummary();
+  EXPECT_EQ(summary.steps, 2);
+  EXPECT_NEAR(summary.comm_us, 8000, 1);
+  EXPECT_NEAR(summary.exposed_comm_us, 4000, 1);
+  EXPECT_NEAR(summary.OverlapEfficiency(), 0.5, 1e-3);
+}
+
+}  // namespace details
+}  // namespace framework
+}  // namespace paddle
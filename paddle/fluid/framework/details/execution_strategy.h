@@ -23,6 +23,16 @@ using DeviceType = paddle::platform::DeviceType;
 namespace p = paddle::platform;
 struct ExecutionStrategy {
   enum ExecutorType { kDefault = 0, kExperimental = 1 };
+  // The order the ready ops are run by the kExperimental executor.
+  // kDiscoveryOrder runs them as their inputs get ready. kCriticalPath runs
+  // the ready op of the longest path to the end of the graph first.
+  // kCommunicationFirst runs the ops feeding the communication ops first,
+  // e.g. the grads to all reduce, so the communication starts early.
+  enum OpScheduleType {
+    kDiscoveryOrder = 0,
+    kCriticalPath = 1,
+    kCommunicationFirst = 2
+  };
 
   // num_threads indicates the size of thread pool.
   size_t num_threads_{0};
@@ -39,6 +49,7 @@ struct ExecutionStrategy {
   // This debug option.
   bool dry_run_{false};
   bool thread_barrier_{false};
+  OpScheduleType op_schedule_type_{kDiscoveryOrder};
 
   // only use with async_ssa_graph_executor
   // and pyreader with data queue
@@ -13,9 +13,13 @@
 // limitations under the License.
 #include "paddle/fluid/framework/details/fast_threaded_ssa_graph_executor.h"
 
+#include <algorithm>
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <string>
+#include <tuple>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -26,10 +30,100 @@
 #include "paddle/fluid/framework/ir/graph_helper.h"
 #include "paddle/fluid/platform/profiler.h"
 
+DECLARE_int32(comm_overlap_report_interval);
+
 namespace paddle {
 namespace framework {
 namespace details {
 
+namespace {
+
+// The ready ops of the workers, each in a heap of the op of the highest
+// priority on top. A worker pops its own ops, and steals the top of the
+// others when it has none, or sleeps until an op is pushed.
+class PriorityReadyQueues {
+ public:
+  PriorityReadyQueues(
+      size_t num_workers, size_t num_ops,
+      const std::unordered_map<OpHandleBase *, int64_t> &priorities)
+      : queues_(num_workers), num_left_(num_ops), priorities_(priorities) {}
+
+  void Push(size_t worker, OpHandleBase *op) {
+    // The ops of the highest priority, e.g. sharing the buffers of the
+    // vars, precede all the others as in RunOpAsync.
+    bool highest = op->GetPriority() == OpHandleBase::Priority::kHighest;
+    auto it = priorities_.find(op);
+    Key key(highest, it == priorities_.end() ? 0 : it->second, op);
+    auto &queue = queues_[worker];
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.heap.push_back(key);
+      std::push_heap(queue.heap.begin(), queue.heap.end());
+    }
+    ++num_ready_;
+    if (num_idle_ > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv_.notify_one();
+    }
+  }
+
+  // Returns nullptr once all the ops are done or the queues are stopped.
+  OpHandleBase *Pop(size_t worker) {
+    while (true) {
+      for (size_t i = 0; i < queues_.size(); ++i) {
+        auto *op = TryPop((worker + i) % queues_.size());
+        if (op != nullptr) return op;
+      }
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++num_idle_;
+      cv_.wait(lock, [this] { return stopped_ || num_ready_ > 0; });
+      --num_idle_;
+      if (stopped_) return nullptr;
+    }
+  }
+
+  // Count an op done, and stop the queues after the last op.
+  void Done() {
+    if (--num_left_ == 0) Stop();
+  }
+
+  void Stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopped_ = true;
+    cv_.notify_all();
+  }
+
+ private:
+  using Key = std::tuple<bool, int64_t, OpHandleBase *>;
+
+  struct Queue {
+    std::mutex mutex;
+    std::vector<Key> heap;
+  };
+
+  OpHandleBase *TryPop(size_t worker) {
+    auto &queue = queues_[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.heap.empty()) return nullptr;
+    std::pop_heap(queue.heap.begin(), queue.heap.end());
+    auto *op = std::get<2>(queue.heap.back());
+    queue.heap.pop_back();
+    --num_ready_;
+    return op;
+  }
+
+  std::vector<Queue> queues_;
+  std::atomic<size_t> num_ready_{0};
+  std::atomic<size_t> num_left_;
+  std::atomic<size_t> num_idle_{0};
+  bool stopped_{false};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  const std::unordered_map<OpHandleBase *, int64_t> &priorities_;
+};
+
+}  // namespace
+
 FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
     const ExecutionStrategy &strategy, const std::vector<Scope *> &local_scopes,
     const std::vector<Scope *> &local_exec_scopes,
@@ -40,6 +134,7 @@ FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
       places_(places),
       graph_(graph),
       fetch_ctxs_(places),
+      overlap_stat_(FLAGS_comm_overlap_report_interval),
       pool_(strategy.num_threads_),
       // add one more thread for generate op_deps
       prepare_pool_(1) {
@@ -54,11 +149,15 @@ FastThreadedSSAGraphExecutor::FastThreadedSSAGraphExecutor(
                     platform::errors::PreconditionNotMet(
                         "The graph doesn't have operators."));
   PrepareAtomicOpDeps();
+  if (strategy_.op_schedule_type_ != ExecutionStrategy::kDiscoveryOrder) {
+    PrepareOpPriorities();
+  }
 }
 
 FetchResultType FastThreadedSSAGraphExecutor::Run(
     const std::vector<std::string> &fetch_tensors, bool return_merged) {
   VLOG(3) << "enter FastThreadedSSAGraphExecutor Run";
+  overlap_stat_.StartStep();
   std::unique_ptr<platform::RecordEvent> event(
       new platform::RecordEvent("FastThreadedSSAGraphExecutorPrepare"));
   std::unique_ptr<std::unordered_map<OpHandleBase *, std::atomic<int>>>
@@ -96,11 +195,15 @@ FetchResultType FastThreadedSSAGraphExecutor::Run(
     auto complete_q = std::make_shared<BlockingQueue<size_t>>();
     VLOG(3) << "number of bootstrap_ops_: " << bootstrap_ops_.size();
     VLOG(3) << "number of ready_fetch_ops: " << ready_fetch_ops.size();
-    for (auto op : bootstrap_ops_) {
-      RunOpAsync(op_deps.get(), op, complete_q);
-    }
-    for (auto op : ready_fetch_ops) {
-      RunOpAsync(op_deps.get(), op, complete_q);
+    if (op_priorities_.empty()) {
+      for (auto op : bootstrap_ops_) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
+      for (auto op : ready_fetch_ops) {
+        RunOpAsync(op_deps.get(), op, complete_q);
+      }
+    } else {
+      RunPrioritizedAsync(op_deps.get(), ready_fetch_ops, complete_q);
     }
 
     size_t num_complete = 0;
@@ -130,6 +233,7 @@ FetchResultType FastThreadedSSAGraphExecutor::Run(
   for (auto &place : places_) {
     fetch_ctxs_.Get(place)->Wait();
   }
+  overlap_stat_.EndStep();
 
   return fetches;
 }
@@ -285,6 +389,91 @@ void FastThreadedSSAGraphExecutor::RunOpAsync(
   });
 }
 
+void FastThreadedSSAGraphExecutor::RunPrioritizedAsync(
+    std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+    const std::vector<OpHandleBase *> &ready_fetch_ops,
+    const std::shared_ptr<BlockingQueue<size_t>> &complete_q) {
+  size_t num_workers = std::max<size_t>(strategy_.num_threads_, 1);
+  auto queues = std::make_shared<PriorityReadyQueues>(
+      num_workers, op_deps->size(), op_priorities_);
+  size_t worker = 0;
+  for (auto op : bootstrap_ops_) {
+    queues->Push(worker++ % num_workers, op);
+  }
+  for (auto op : ready_fetch_ops) {
+    queues->Push(worker++ % num_workers, op);
+  }
+
+  for (size_t i = 0; i < num_workers; ++i) {
+    ++remaining_;
+    this->pool_.enqueue([=] {
+      size_t complete = 0;
+      while (auto *op = queues->Pop(i)) {
+        VLOG(3) << "start to run op: " << op->Name();
+        if (!RunOp(op, complete_q, &complete)) {
+          queues->Stop();
+          return;
+        }
+        for (auto &output : op->Outputs()) {
+          for (auto &pending_op : output->PendingOps()) {
+            std::atomic<int> &deps = op_deps->at(pending_op);
+            if (deps.fetch_sub(1) == 1) {
+              queues->Push(i, pending_op);
+            }
+          }
+        }
+        queues->Done();
+      }
+      --remaining_;
+      complete_q->Push(complete);
+    });
+  }
+}
+
+void FastThreadedSSAGraphExecutor::PrepareOpPriorities() {
+  // The priority of an op is the cost of the longest path from it to the end
+  // of the graph, taking each op as a cost of 1. For kCommunicationFirst, a
+  // communication op costs more than all the other ops, so the ops feeding
+  // the communication precede the ones that do not, and among those, the
+  // ones feeding more communication come first.
+  int64_t comm_cost = 1;
+  if (strategy_.op_schedule_type_ == ExecutionStrategy::kCommunicationFirst) {
+    comm_cost = static_cast<int64_t>(op_deps_.size()) + 1;
+  }
+
+  // Visit the ops in the topological order.
+  std::unordered_map<OpHandleBase *, int> deps(op_deps_.begin(),
+                                               op_deps_.end());
+  std::vector<OpHandleBase *> sorted_ops(bootstrap_ops_);
+  for (size_t i = 0; i < sorted_ops.size(); ++i) {
+    for (auto &output : sorted_ops[i]->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto it = deps.find(pending_op);
+        if (it != deps.end() && --it->second == 0) {
+          sorted_ops.emplace_back(pending_op);
+        }
+      }
+    }
+  }
+
+  for (auto it = sorted_ops.rbegin(); it != sorted_ops.rend(); ++it) {
+    auto *op = *it;
+    int64_t longest = 0;
+    for (auto &output : op->Outputs()) {
+      for (auto &pending_op : output->PendingOps()) {
+        auto priority_it = op_priorities_.find(pending_op);
+        if (priority_it != op_priorities_.end()) {
+          longest = std::max(longest, priority_it->second);
+        }
+      }
+    }
+    op_priorities_[op] =
+        longest + (op->IsMultiDeviceTransfer() ? comm_cost : 1);
+  }
+  VLOG(3) << "The priorities of " << op_priorities_.size() << " ops are "
+          << "prepared by the schedule type " << strategy_.op_schedule_type_;
+}
+
 void FastThreadedSSAGraphExecutor::PrepareAtomicOpDeps() {
   atomic_op_deps_ = prepare_pool_.enqueue([&] {
     auto *op_deps = new std::unordered_map<OpHandleBase *, std::atomic<int>>;
@@ -330,6 +519,7 @@ bool FastThreadedSSAGraphExecutor::RunOpSync(OpHandleBase *op) {
   try {
     VLOG(10) << op << " " << op->Name() << " : " << op->DebugString();
     if (LIKELY(!strategy_.dry_run_)) {
+      CommOverlapStat::OpTimer timer(&overlap_stat_, op);
       op->Run(strategy_.use_device_);
     }
     VLOG(10) << op << " " << op->Name() << " Done ";
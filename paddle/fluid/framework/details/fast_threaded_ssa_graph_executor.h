@@ -19,6 +19,7 @@
 #include <unordered_map>
 #include <vector>
 #include "paddle/fluid/framework/blocking_queue.h"
+#include "paddle/fluid/framework/details/comm_overlap_stat.h"
 #include "paddle/fluid/framework/details/exception_holder.h"
 #include "paddle/fluid/framework/details/execution_strategy.h"
 #include "paddle/fluid/framework/details/ssa_graph_executor.h"
@@ -40,6 +41,8 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
                       bool return_merged) override;
   const ir::Graph &Graph() const override;
 
+  const CommOverlapStat &OverlapStat() const { return overlap_stat_; }
+
  private:
   // Note(zcd): the ThreadPool should be placed last so that ThreadPool should
   // be destroyed first.
@@ -51,6 +54,9 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
 
   std::unordered_map<OpHandleBase *, int> op_deps_;
   std::vector<OpHandleBase *> bootstrap_ops_;
+  // The priorities of the ops by the op_schedule_type of the strategy, the
+  // op of a greater priority is run first. Empty for kDiscoveryOrder.
+  std::unordered_map<OpHandleBase *, int64_t> op_priorities_;
 
   platform::DeviceContextPool fetch_ctxs_;
   std::atomic<int> remaining_;
@@ -59,6 +65,7 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
       std::unique_ptr<std::unordered_map<OpHandleBase *, std::atomic<int>>>>
       atomic_op_deps_;
   ExceptionHolder exception_;
+  CommOverlapStat overlap_stat_;
 
   ::ThreadPool pool_;
   ::ThreadPool prepare_pool_;
@@ -73,8 +80,18 @@ class FastThreadedSSAGraphExecutor : public SSAGraphExecutor {
                   OpHandleBase *op,
                   const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
 
+  // Run the ops ready by the priorities on the workers of the pool, each
+  // keeping the ready ops it discovers and stealing from the others when it
+  // has none.
+  void RunPrioritizedAsync(
+      std::unordered_map<OpHandleBase *, std::atomic<int>> *op_deps,
+      const std::vector<OpHandleBase *> &ready_fetch_ops,
+      const std::shared_ptr<BlockingQueue<size_t>> &complete_q);
+
   void PrepareAtomicOpDeps();
 
+  void PrepareOpPriorities();
+
   inline void RecordOps(OpHandleBase *op);
 
   inline void ExecutionFinal(std::vector<OpHandleBase *> *fetch_ops);
@@ -87,6 +87,9 @@ constexpr char kPinnedVars[] = "pinned_vars";
 typedef std::vector<std::vector<std::pair<std::string, std::string>>>
     GroupParamsAndGrads;
 constexpr char kGroupParamsAndDenseGrads[] = "group_params_dense_grads";
+// The size bound of the buckets the gradients are coalesced into, by the
+// order they are generated, in MB. Not set or 0 to group them by layers.
+constexpr char kGradBucketSizeInMB[] = "grad_bucket_size_in_MB";
 
 inline bool IsOpRole(const OpDesc &op, OpRole role) {
   const auto &attrs = op.GetAttrMap();
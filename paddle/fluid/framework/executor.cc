@@ -42,6 +42,15 @@ ExecutorPrepareContext::ExecutorPrepareContext(
     const framework::ProgramDesc& prog, size_t block_id)
     : prog_(prog), block_id_(block_id) {}
 
+void ExecutorPrepareContext::PrepareVarSlots() {
+  for (auto* var : prog_.Block(block_id_).AllVars()) {
+    var_names_.Intern(var->Name());
+  }
+  for (auto& op : ops_) {
+    op->BindVarSlots(&var_names_);
+  }
+}
+
 void ExecutorPrepareContext::PrepareUnusedVars(
     const std::vector<std::string>& keep_vars, bool force_disable_gc) {
   // If gc is enabled and block size > 1
@@ -380,6 +389,7 @@ std::unique_ptr<ExecutorPrepareContext> Executor::Prepare(
     ctx->ops_.push_back(OpRegistry::CreateOp(*op_desc));
   }
   ctx->PrepareUnusedVars(skip_ref_cnt_vars, force_disable_gc);
+  ctx->PrepareVarSlots();
   return ctx;
 }
 
@@ -411,6 +421,7 @@ std::vector<std::shared_ptr<ExecutorPrepareContext>> Executor::Prepare(
     } else {
       ctx->PrepareUnusedVars(skip_ref_cnt_vars[idx], force_disable_gc);
     }
+    ctx->PrepareVarSlots();
     result.push_back(std::shared_ptr<ExecutorPrepareContext>(ctx));
     ++idx;
   }
@@ -482,9 +493,11 @@ void Executor::RunPartialPreparedContext(ExecutorPrepareContext* ctx,
     }
   }
 
+  SlotScope slots(&ctx->var_names_, local_scope);
   for (int64_t i = start_op_index; i < end_op_index; ++i) {
     auto& op = ctx->ops_[i];
-    op->Run(*local_scope, place_);
+    slots.Sync();
+    op->Run(slots, place_);
     if (gc) {
       DeleteUnusedTensors(*local_scope, op.get(), ctx->unused_vars_, gc.get());
     }
@@ -25,6 +25,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/scope_slots.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/platform/device_context.h"
 
@@ -44,10 +45,15 @@ struct ExecutorPrepareContext {
   void PrepareUnusedVars(const std::vector<std::string>& keep_vars,
                          bool force_disable_gc = false);
 
+  // Intern the variable names of the block and bind the ops to the ids, so
+  // the ops can look up the variables in a SlotScope.
+  void PrepareVarSlots();
+
   const framework::ProgramDesc& prog_;
   const size_t block_id_;
 
   std::vector<std::unique_ptr<OperatorBase>> ops_;
+  VarNameTable var_names_;
 
   std::unordered_map<const OperatorBase*, std::vector<std::string>>
       unused_vars_;
@@ -10,6 +10,12 @@ See the License for the specific language governing permissions and
 limitations under the License. */
 
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+
 #include "paddle/fluid/framework/io/fs.h"
 #include "paddle/fluid/string/string_helper.h"
 
@@ -298,6 +304,9 @@ void GlooWrapper::Init() {
           std::make_shared<gloo::rendezvous::PrefixStore>(prefix_, *file_store);
       context->connectFullMesh(*prefix_store, dev);
       context_ = std::move(context);
+      if (topology_aware_) {
+        InitNodeGroup(*prefix_store, dev);
+      }
       break;
     }
     case GlooStoreType::HTTP: {
@@ -307,9 +316,12 @@ void GlooWrapper::Init() {
           http_ip_, http_port_, prefix_ + "_" + http_scope_, rank_);
       http_store->SetTimeoutSeconds(init_timeout_.count());
       context->connectFullMesh(*http_store, dev);
+      context_ = std::move(context);
+      if (topology_aware_) {
+        InitNodeGroup(*http_store, dev);
+      }
       http_store->Finalize();
       VLOG(3) << "after calling http_store->Finalize.";
-      context_ = std::move(context);
       break;
     }
     default:
@@ -321,6 +333,90 @@ void GlooWrapper::Init() {
   VLOG(3) << "gloo initialized done.";
 }
 
+#ifdef PADDLE_WITH_GLOO
+void GlooWrapper::InitNodeGroup(
+    gloo::rendezvous::Store& store,                  // NOLINT
+    std::shared_ptr<gloo::transport::Device>& dev) {  // NOLINT
+#ifndef _LINUX
+  LOG(WARNING) << "The topology aware gloo needs the shared memory of Linux, "
+                  "use the flat context instead.";
+#else
+  // The ranks are on the same host if they share the host name, the boot id,
+  // which tells apart the hosts of the same name, and the IPC namespace, out
+  // of which the shared memory is not visible, e.g. in the other containers.
+  struct RankInfo {
+    char node[128];
+    int32_t pid;
+  };
+  RankInfo info;
+  memset(&info, 0, sizeof(info));
+  std::string node(256, '\0');
+  gethostname(&node[0], node.size() - 1);
+  node.resize(strlen(node.c_str()));
+  std::ifstream boot_id("/proc/sys/kernel/random/boot_id");
+  std::string id;
+  if (boot_id >> id) {
+    node += "/" + id;
+  }
+  struct stat ipc_ns;
+  if (stat("/proc/self/ns/ipc", &ipc_ns) == 0) {
+    node += "/" + std::to_string(ipc_ns.st_ino);
+  }
+  strncpy(info.node, node.c_str(), sizeof(info.node) - 1);
+  info.pid = getpid();
+
+  std::vector<RankInfo> infos(size_);
+  gloo::AllgatherOptions opts(context_);
+  opts.setInput(reinterpret_cast<char*>(&info), sizeof(info));
+  opts.setOutput(reinterpret_cast<char*>(infos.data()),
+                 sizeof(info) * infos.size());
+  gloo::allgather(opts);
+
+  std::unordered_map<std::string, int> node_ids;
+  node_ranks_.clear();
+  for (int rank = 0; rank < size_; ++rank) {
+    auto it = node_ids.emplace(infos[rank].node, node_ranks_.size()).first;
+    if (it->second == static_cast<int>(node_ranks_.size())) {
+      node_ranks_.emplace_back();
+    }
+    node_ranks_[it->second].emplace_back(rank);
+  }
+  max_local_size_ = 1;
+  for (auto& ranks : node_ranks_) {
+    max_local_size_ = std::max(max_local_size_, static_cast<int>(ranks.size()));
+  }
+  int node_id = node_ids[info.node];
+  auto& local_ranks = node_ranks_[node_id];
+  int local_rank = static_cast<int>(
+      std::find(local_ranks.begin(), local_ranks.end(), rank_) -
+      local_ranks.begin());
+  int leader = local_ranks[0];
+  // Unique on the host by the pid of the leader, and for the contexts of
+  // the different prefixes in the same processes.
+  std::string name =
+      "/paddle_gloo_" + std::to_string(infos[leader].pid) + "_" +
+      std::to_string(leader) + "_" +
+      std::to_string(std::hash<std::string>()(prefix_ + "_" + http_scope_ +
+                                              "_" + hdfs_path_));
+  node_group_ = std::make_shared<ShmNodeGroup>(
+      name, local_rank, static_cast<int>(local_ranks.size()),
+      ShmNodeGroup::kDefaultChunkBytes, run_timeout_);
+  VLOG(3) << "gloo rank " << rank_ << " is the local rank " << local_rank
+          << " of " << local_ranks.size() << " on the node " << node_id
+          << " of " << node_ranks_.size();
+
+  if (node_ranks_.size() > 1 && node_group_->IsLeader()) {
+    auto context = std::make_shared<gloo::rendezvous::ParallelConnectContext>(
+        node_id, node_ranks_.size());
+    context->setTimeout(run_timeout_);
+    gloo::rendezvous::PrefixStore leaders_store("leaders", store);
+    context->connectFullMesh(leaders_store, dev);
+    leaders_context_ = std::move(context);
+  }
+#endif
+}
+#endif
+
 template std::vector<int64_t> GlooWrapper::AllReduce<int64_t>(
     std::vector<int64_t>& sendbuf,  // NOLINT
     const std::string& mode);
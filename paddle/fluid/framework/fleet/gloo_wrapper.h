@@ -17,9 +17,11 @@ limitations under the License. */
 #endif
 
 #ifdef _LINUX
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
+#include <functional>
 #include <iostream>
 #include <memory>
 #include <string>
@@ -36,6 +38,9 @@ limitations under the License. */
 #include <gloo/rendezvous/store.h>
 #include <gloo/transport/tcp/device.h>
 #endif
+#if defined(PADDLE_WITH_GLOO) && defined(_LINUX)
+#include "paddle/fluid/framework/fleet/shm_node_group.h"
+#endif
 #include "paddle/fluid/framework/variable_helper.h"
 
 namespace gloo {
@@ -140,6 +145,12 @@ class GlooWrapper {
 
   void SetPrefix(const std::string& prefix) { prefix_ = prefix; }
 
+  // Run Barrier, AllReduce and AllGather among the ranks on the same host
+  // through the shared memory, and between the hosts by a rank per host.
+  void SetTopologyAware(bool topology_aware) {
+    topology_aware_ = topology_aware;
+  }
+
   void SetHdfsStore(const std::string& path, const std::string& fs_name,
                     const std::string& fs_ugi) {
     store_type_ = GlooStoreType::HDFS;
@@ -158,6 +169,17 @@ class GlooWrapper {
   void Barrier() {
     CHECK_EQ(is_initialized_, true);
 #ifdef PADDLE_WITH_GLOO
+#ifdef _LINUX
+    if (node_group_ != nullptr) {
+      node_group_->Barrier();
+      if (leaders_context_ != nullptr) {
+        gloo::BarrierOptions opts(leaders_context_);
+        gloo::barrier(opts);
+      }
+      node_group_->Barrier();
+      return;
+    }
+#endif
     gloo::BarrierOptions opts(context_);
     gloo::barrier(opts);
 #else
@@ -177,6 +199,25 @@ class GlooWrapper {
     std::vector<T> recvbuf(sendbuf.size(), T());
     CHECK_EQ(sendbuf.size() == recvbuf.size(), true);
 #ifdef PADDLE_WITH_GLOO
+#ifdef _LINUX
+    if (node_group_ != nullptr) {
+      recvbuf = sendbuf;
+      if (mode == "sum") {
+        NodeAllReduce(&recvbuf, [](T a, T b) { return a + b; },
+                      &gloo::sum<T>);
+      } else if (mode == "max") {
+        NodeAllReduce(&recvbuf, [](T a, T b) { return a < b ? b : a; },
+                      &gloo::max<T>);
+      } else if (mode == "min") {
+        NodeAllReduce(&recvbuf, [](T a, T b) { return b < a ? b : a; },
+                      &gloo::min<T>);
+      } else {
+        PADDLE_ENFORCE_EQ(0, 1, paddle::platform::errors::InvalidArgument(
+                                    "AllReduce mode not known: " + mode));
+      }
+      return recvbuf;
+    }
+#endif
     gloo::AllreduceOptions opts(context_);
     opts.setInput(sendbuf.data(), sendbuf.size());
     opts.setOutput(recvbuf.data(), recvbuf.size());
@@ -208,6 +249,34 @@ class GlooWrapper {
     CHECK_EQ(is_initialized_, true);
     std::vector<T> ret(size_, T());
 #ifdef PADDLE_WITH_GLOO
+#ifdef _LINUX
+    if (node_group_ != nullptr) {
+      // The leader gathers the values of the node, exchanges them with the
+      // other leaders, and broadcasts all of them to the node.
+      std::vector<T> node_values(node_group_->local_size());
+      node_group_->Gather(&input, sizeof(T), node_values.data());
+      if (node_group_->IsLeader()) {
+        int num_nodes = static_cast<int>(node_ranks_.size());
+        std::vector<T> all_values(node_values);
+        if (leaders_context_ != nullptr) {
+          // Pad the values of each node to the most ranks on a node.
+          node_values.resize(max_local_size_);
+          all_values.resize(max_local_size_ * num_nodes);
+          gloo::AllgatherOptions opts(leaders_context_);
+          opts.setInput(node_values.data(), max_local_size_);
+          opts.setOutput(all_values.data(), all_values.size());
+          gloo::allgather(opts);
+        }
+        for (int node = 0; node < num_nodes; ++node) {
+          for (size_t i = 0; i < node_ranks_[node].size(); ++i) {
+            ret[node_ranks_[node][i]] = all_values[node * max_local_size_ + i];
+          }
+        }
+      }
+      node_group_->Broadcast(ret.data(), sizeof(T) * size_);
+      return std::move(ret);
+    }
+#endif
     gloo::AllgatherOptions opts(context_);
     opts.setInput(&input, 1);
     opts.setOutput(ret.data(), size_);
@@ -219,10 +288,46 @@ class GlooWrapper {
   }
 
  protected:
+#ifdef PADDLE_WITH_GLOO
+  // Group the ranks by their hosts, create the shared memory of the host,
+  // and connect the leaders of the hosts by the store. Only on Linux, the
+  // other platforms keep the flat context.
+  void InitNodeGroup(gloo::rendezvous::Store& store,                // NOLINT
+                     std::shared_ptr<gloo::transport::Device>& dev);  // NOLINT
+
+#ifdef _LINUX
+  template <typename T, typename Reduce>
+  void NodeAllReduce(std::vector<T>* data, Reduce reduce,
+                     void (*leaders_reduce)(void*, const void*, const void*,
+                                            size_t)) {
+    std::function<void(T*, size_t)> inter_node = nullptr;
+    if (node_ranks_.size() > 1) {
+      inter_node = [this, leaders_reduce](T* chunk, size_t n) {
+        gloo::AllreduceOptions opts(leaders_context_);
+        opts.setOutput(chunk, n);
+        opts.setReduceFunction(leaders_reduce);
+        gloo::allreduce(opts);
+      };
+    }
+    node_group_->AllReduce(data->data(), data->size(), reduce, inter_node);
+  }
+#endif
+#endif
+
   bool is_initialized_ = false;
 #ifdef PADDLE_WITH_GLOO
   std::shared_ptr<gloo::Context> context_ = nullptr;
+  // Only set in the topology aware mode, where the leaders_context_ connects
+  // the leaders of the hosts, and is null for the other ranks or one host.
+#ifdef _LINUX
+  std::shared_ptr<ShmNodeGroup> node_group_ = nullptr;
+#endif
+  std::shared_ptr<gloo::Context> leaders_context_ = nullptr;
+  // The global ranks on each host, by the order of the hosts.
+  std::vector<std::vector<int>> node_ranks_;
+  int max_local_size_ = 1;
 #endif
+  bool topology_aware_ = false;
   int rank_ = 0;
   int size_ = 0;
   std::chrono::seconds init_timeout_ = std::chrono::seconds(9999999);
@@ -0,0 +1,240 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/fleet/shm_node_group.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <new>
+#include <thread>  // NOLINT
+
+namespace paddle {
+namespace framework {
+
+namespace {
+
+constexpr uint32_t kReady = 0x5348474e;  // "SHGN"
+constexpr int kSpinCount = 1000;
+constexpr int kAttachTimeoutSeconds = 900;
+
+// Return false if cond does not hold by the deadline.
+template <typename Cond>
+bool SpinUntil(Cond cond, std::chrono::steady_clock::time_point deadline) {
+  for (int i = 0; !cond(); ++i) {
+    if (i >= kSpinCount) {
+      if (std::chrono::steady_clock::now() >= deadline) return false;
+      std::this_thread::yield();
+    }
+  }
+  return true;
+}
+
+size_t AlignUp(size_t n, size_t align) {
+  return (n + align - 1) / align * align;
+}
+
+}  // namespace
+
+// The counters of the segment, each on its own cache line. The barrier is
+// sense reversing: the last rank to arrive resets arrived and bumps the
+// generation, for which the others wait.
+struct ShmNodeGroup::Header {
+  alignas(64) std::atomic<uint32_t> ready;
+  alignas(64) std::atomic<int32_t> attached;
+  alignas(64) std::atomic<int32_t> arrived;
+  alignas(64) std::atomic<uint32_t> generation;
+};
+
+constexpr std::chrono::milliseconds ShmNodeGroup::kDefaultTimeout;
+
+ShmNodeGroup::ShmNodeGroup(const std::string& name, int local_rank,
+                           int local_size, size_t chunk_bytes,
+                           std::chrono::milliseconds timeout)
+    : name_(name),
+      local_rank_(local_rank),
+      local_size_(local_size),
+      chunk_bytes_(AlignUp(chunk_bytes, 64)),
+      timeout_(timeout) {
+  PADDLE_ENFORCE_GT(local_size, 0,
+                    platform::errors::InvalidArgument(
+                        "The local size %d should be positive.", local_size));
+  PADDLE_ENFORCE_EQ(
+      local_rank >= 0 && local_rank < local_size, true,
+      platform::errors::InvalidArgument(
+          "The local rank %d should be in [0, %d).", local_rank, local_size));
+  PADDLE_ENFORCE_GT(chunk_bytes, 0,
+                    platform::errors::InvalidArgument(
+                        "The chunk bytes of the shared memory should be "
+                        "positive."));
+  size_t header_bytes = AlignUp(sizeof(Header), 4096);
+  segment_bytes_ = header_bytes + (local_size + 1) * chunk_bytes_;
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::seconds(kAttachTimeoutSeconds);
+  int fd = -1;
+  if (IsLeader()) {
+    // Remove the segment left by a crashed job of the same name.
+    shm_unlink(name_.c_str());
+    fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    PADDLE_ENFORCE_NE(fd, -1, platform::errors::Unavailable(
+                                  "Failed to create the shared memory %s: %s.",
+                                  name_, strerror(errno)));
+    PADDLE_ENFORCE_EQ(
+        ftruncate(fd, segment_bytes_), 0,
+        platform::errors::ResourceExhausted(
+            "Failed to allocate %d bytes of the shared memory %s: %s.",
+            segment_bytes_, name_, strerror(errno)));
+  } else {
+    // Wait for the leader to create the segment at its full size.
+    while (true) {
+      fd = shm_open(name_.c_str(), O_RDWR, 0600);
+      if (fd != -1) {
+        struct stat st;
+        if (fstat(fd, &st) == 0 &&
+            static_cast<size_t>(st.st_size) == segment_bytes_) {
+          break;
+        }
+        close(fd);
+        fd = -1;
+      } else {
+        PADDLE_ENFORCE_EQ(errno, ENOENT,
+                          platform::errors::Unavailable(
+                              "Failed to open the shared memory %s: %s.",
+                              name_, strerror(errno)));
+      }
+      PADDLE_ENFORCE_LT(std::chrono::steady_clock::now(), deadline,
+                        platform::errors::ExecutionTimeout(
+                            "Timeout to open the shared memory %s created by "
+                            "the leader of the node.",
+                            name_));
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+  void* addr = mmap(nullptr, segment_bytes_, PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(addr, MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Failed to map the shared memory %s: %s.", name_,
+                        strerror(errno)));
+  slots_ = static_cast<char*>(addr) + header_bytes;
+
+  if (IsLeader()) {
+    header_ = new (addr) Header();
+    header_->attached.store(0, std::memory_order_relaxed);
+    header_->arrived.store(0, std::memory_order_relaxed);
+    header_->generation.store(0, std::memory_order_relaxed);
+    header_->ready.store(kReady, std::memory_order_release);
+    bool all_attached = SpinUntil(
+        [this] {
+          return header_->attached.load(std::memory_order_acquire) ==
+                 local_size_ - 1;
+        },
+        deadline);
+    // All the ranks hold the mapping, so the name is no longer needed, and
+    // the memory is freed when the last rank exits.
+    shm_unlink(name_.c_str());
+    if (!all_attached) {
+      int attached = header_->attached.load(std::memory_order_relaxed);
+      munmap(addr, segment_bytes_);
+      header_ = nullptr;
+      PADDLE_THROW(platform::errors::ExecutionTimeout(
+          "Timeout for the ranks of the node to attach the shared memory %s, "
+          "only %d of the %d ranks attached.",
+          name_, attached + 1, local_size_));
+    }
+  } else {
+    header_ = static_cast<Header*>(addr);
+    bool ready = SpinUntil(
+        [this] {
+          return header_->ready.load(std::memory_order_acquire) == kReady;
+        },
+        deadline);
+    if (!ready) {
+      munmap(addr, segment_bytes_);
+      header_ = nullptr;
+      PADDLE_THROW(platform::errors::ExecutionTimeout(
+          "Timeout to wait for the leader of the node to initialize the "
+          "shared memory %s.",
+          name_));
+    }
+    header_->attached.fetch_add(1, std::memory_order_acq_rel);
+  }
+}
+
+ShmNodeGroup::~ShmNodeGroup() {
+  if (header_ != nullptr) {
+    munmap(header_, segment_bytes_);
+  }
+}
+
+void ShmNodeGroup::Barrier() {
+  if (local_size_ == 1) return;
+  uint32_t generation = header_->generation.load(std::memory_order_acquire);
+  if (header_->arrived.fetch_add(1, std::memory_order_acq_rel) ==
+      local_size_ - 1) {
+    header_->arrived.store(0, std::memory_order_relaxed);
+    header_->generation.fetch_add(1, std::memory_order_release);
+  } else {
+    bool passed = SpinUntil(
+        [this, generation] {
+          return header_->generation.load(std::memory_order_acquire) !=
+                 generation;
+        },
+        std::chrono::steady_clock::now() + timeout_);
+    if (!passed) {
+      PADDLE_THROW(platform::errors::ExecutionTimeout(
+          "Timeout for the ranks of the node to arrive at the barrier of the "
+          "shared memory %s in %d ms, only %d of the %d ranks arrived.",
+          name_, timeout_.count(),
+          header_->arrived.load(std::memory_order_relaxed), local_size_));
+    }
+  }
+}
+
+void ShmNodeGroup::Gather(const void* in, size_t bytes, void* out) {
+  PADDLE_ENFORCE_LE(bytes, chunk_bytes_,
+                    platform::errors::InvalidArgument(
+                        "The %d bytes to gather should be no more than the "
+                        "chunk bytes %d of the shared memory.",
+                        bytes, chunk_bytes_));
+  if (local_size_ == 1) {
+    memcpy(out, in, bytes);
+    return;
+  }
+  memcpy(Slot(local_rank_), in, bytes);
+  Barrier();
+  if (IsLeader()) {
+    for (int r = 0; r < local_size_; ++r) {
+      memcpy(static_cast<char*>(out) + r * bytes, Slot(r), bytes);
+    }
+  }
+  Barrier();
+}
+
+void ShmNodeGroup::Broadcast(void* data, size_t bytes) {
+  if (local_size_ == 1) return;
+  for (size_t offset = 0; offset < bytes; offset += chunk_bytes_) {
+    size_t len = std::min(chunk_bytes_, bytes - offset);
+    char* chunk = static_cast<char*>(data) + offset;
+    if (IsLeader()) memcpy(Result(), chunk, len);
+    Barrier();
+    if (!IsLeader()) memcpy(chunk, Result(), len);
+    Barrier();
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,133 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * The processes on the same host communicating through a shared memory
+ * segment, which holds a slot of chunk_bytes for each local rank and one for
+ * the result. The local rank 0 is the leader of the node, which creates the
+ * segment, and joins the exchange between the nodes for the group. The calls
+ * must be made in the same order by all the local ranks.
+ */
+class ShmNodeGroup {
+ public:
+  // The name of the segment must be unique on the host, e.g. with the pid of
+  // the leader in it. The segment is unlinked once all the ranks attach. The
+  // calls after that throw ExecutionTimeout if the other local ranks do not
+  // make them within the timeout.
+  ShmNodeGroup(const std::string& name, int local_rank, int local_size,
+               size_t chunk_bytes = kDefaultChunkBytes,
+               std::chrono::milliseconds timeout = kDefaultTimeout);
+
+  ~ShmNodeGroup();
+
+  int local_rank() const { return local_rank_; }
+
+  int local_size() const { return local_size_; }
+
+  bool IsLeader() const { return local_rank_ == 0; }
+
+  void Barrier();
+
+  // All reduce the n elements at data of the local ranks by reduce(a, b),
+  // chunk by chunk. If inter_node is set, the leader calls it with each chunk
+  // reduced in the node to reduce it between the nodes in place, before the
+  // local ranks copy the chunk back. All the local ranks must set it or not.
+  template <typename T, typename Reduce>
+  void AllReduce(T* data, size_t n, Reduce reduce,
+                 const std::function<void(T*, size_t)>& inter_node = nullptr);
+
+  // Gather the bytes at in of the local ranks to out of the leader, in the
+  // order of the local ranks. out is not used by the others.
+  void Gather(const void* in, size_t bytes, void* out);
+
+  // Broadcast the bytes at data from the leader to the local ranks.
+  void Broadcast(void* data, size_t bytes);
+
+  static constexpr size_t kDefaultChunkBytes = 1 << 22;
+  static constexpr std::chrono::milliseconds kDefaultTimeout =
+      std::chrono::hours(1);
+
+ private:
+  struct Header;
+
+  char* Slot(int local_rank) {
+    return slots_ + static_cast<size_t>(local_rank) * chunk_bytes_;
+  }
+
+  // The slot after the ones of the local ranks.
+  char* Result() { return Slot(local_size_); }
+
+  std::string name_;
+  int local_rank_;
+  int local_size_;
+  size_t chunk_bytes_;
+  std::chrono::milliseconds timeout_;
+  size_t segment_bytes_;
+  Header* header_{nullptr};
+  char* slots_{nullptr};
+
+  DISABLE_COPY_AND_ASSIGN(ShmNodeGroup);
+};
+
+template <typename T, typename Reduce>
+void ShmNodeGroup::AllReduce(
+    T* data, size_t n, Reduce reduce,
+    const std::function<void(T*, size_t)>& inter_node) {
+  if (local_size_ == 1) {
+    if (inter_node) inter_node(data, n);
+    return;
+  }
+  size_t chunk = chunk_bytes_ / sizeof(T);
+  for (size_t offset = 0; offset < n; offset += chunk) {
+    size_t len = std::min(chunk, n - offset);
+    memcpy(Slot(local_rank_), data + offset, len * sizeof(T));
+    Barrier();
+    // Each local rank reduces its part of the chunk into the result.
+    size_t lo = len * local_rank_ / local_size_;
+    size_t hi = len * (local_rank_ + 1) / local_size_;
+    T* result = reinterpret_cast<T*>(Result());
+    memcpy(result + lo, Slot(0) + lo * sizeof(T), (hi - lo) * sizeof(T));
+    for (int r = 1; r < local_size_; ++r) {
+      const T* slot = reinterpret_cast<const T*>(Slot(r));
+      for (size_t i = lo; i < hi; ++i) {
+        result[i] = reduce(result[i], slot[i]);
+      }
+    }
+    Barrier();
+    if (inter_node) {
+      if (IsLeader()) inter_node(result, len);
+      Barrier();
+    }
+    // The result is not written again until all the local ranks pass the
+    // first barrier of the next chunk, after copying it back.
+    memcpy(data + offset, result, len * sizeof(T));
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
+#endif
@@ -0,0 +1,208 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+  http://www.apache.org/licenses/LICENSE-2.0
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/framework/fleet/shm_node_group.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/cpu_collective.h"
+
+namespace paddle {
+namespace framework {
+
+using VarType = proto::VarType;
+
+static std::string MakeName() {
+  static int next_id = 0;
+  return "/paddle_shm_node_group_test_" + std::to_string(getpid()) + "_" +
+         std::to_string(next_id++);
+}
+
+static std::vector<std::string> MakeEndpoints(int nranks) {
+  // Below the range of the ports bound by connect.
+  static int next_port = 20000 + getpid() % 100 * 100;
+  std::vector<std::string> endpoints;
+  for (int i = 0; i < nranks; ++i) {
+    endpoints.emplace_back("127.0.0.1:" + std::to_string(next_port++));
+  }
+  return endpoints;
+}
+
+// Run the func by nranks processes, each with its rank.
+static void RunRanks(int nranks, const std::function<void(int)>& func) {
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < nranks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      int status = 0;
+      try {
+        func(rank);
+        status = ::testing::Test::HasFailure() ? 1 : 0;
+      } catch (std::exception& e) {
+        LOG(ERROR) << "Rank " << rank << " fails: " << e.what();
+        status = 2;
+      }
+      _exit(status);
+    }
+    pids.emplace_back(pid);
+  }
+  for (int rank = 0; rank < nranks; ++rank) {
+    int status = -1;
+    waitpid(pids[rank], &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        << "rank " << rank << " of " << nranks << " ranks fails";
+  }
+}
+
+template <typename T, typename Reduce>
+static void TestAllReduce(int local_size, size_t n, Reduce reduce) {
+  auto name = MakeName();
+  RunRanks(local_size, [=](int rank) {
+    // A small chunk to all reduce the data by several chunks.
+    ShmNodeGroup group(name, rank, local_size, 4096);
+    auto value = [](int rank, size_t i) {
+      return static_cast<T>((rank + i) % 5 + 1);
+    };
+    std::vector<T> data(n);
+    for (size_t i = 0; i < n; ++i) data[i] = value(rank, i);
+    group.AllReduce(data.data(), n, reduce);
+    for (size_t i = 0; i < n; ++i) {
+      T expected = value(0, i);
+      for (int r = 1; r < local_size; ++r) {
+        expected = reduce(expected, value(r, i));
+      }
+      ASSERT_EQ(data[i], expected) << "element " << i;
+    }
+  });
+}
+
+TEST(ShmNodeGroup, all_reduce) {
+  for (int local_size = 1; local_size <= 4; ++local_size) {
+    for (size_t n : {1, 7, 1000, 5000}) {
+      TestAllReduce<float>(local_size, n,
+                           [](float a, float b) { return a + b; });
+    }
+  }
+  TestAllReduce<int64_t>(3, 3000, [](int64_t a, int64_t b) {
+    return std::max(a, b);
+  });
+}
+
+TEST(ShmNodeGroup, gather_broadcast_and_barrier) {
+  const int local_size = 3;
+  auto name = MakeName();
+  RunRanks(local_size, [=](int rank) {
+    ShmNodeGroup group(name, rank, local_size, 4096);
+    int64_t value = rank * 10;
+    std::vector<int64_t> values(local_size, -1);
+    group.Gather(&value, sizeof(value), values.data());
+    if (group.IsLeader()) {
+      for (int r = 0; r < local_size; ++r) ASSERT_EQ(values[r], r * 10);
+    }
+    // More than a chunk.
+    std::vector<int32_t> data(3000, rank);
+    group.Broadcast(data.data(), data.size() * sizeof(int32_t));
+    for (auto v : data) ASSERT_EQ(v, 0);
+    for (int i = 0; i < 100; ++i) group.Barrier();
+  });
+}
+
+TEST(ShmNodeGroup, barrier_timeout) {
+  const int local_size = 2;
+  auto name = MakeName();
+  RunRanks(local_size, [=](int rank) {
+    ShmNodeGroup group(name, rank, local_size, 4096,
+                       std::chrono::milliseconds(200));
+    group.Barrier();
+    // The other local rank exits without the second barrier.
+    if (group.IsLeader()) {
+      EXPECT_THROW(group.Barrier(), platform::EnforceNotMet);
+    }
+  });
+}
+
+// 2 nodes of 2 ranks, whose leaders all reduce between the nodes over TCP.
+TEST(ShmNodeGroup, inter_node_all_reduce) {
+  const int num_nodes = 2, local_size = 2;
+  std::vector<std::string> names{MakeName(), MakeName()};
+  auto endpoints = MakeEndpoints(num_nodes);
+  RunRanks(num_nodes * local_size, [=](int rank) {
+    int node = rank / local_size;
+    ShmNodeGroup group(names[node], rank % local_size, local_size, 4096);
+    std::unique_ptr<platform::CPUComm> comm;
+    if (group.IsLeader()) comm.reset(new platform::CPUComm(endpoints, node));
+    std::vector<float> data(3000);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = rank + i;
+    group.AllReduce<float>(
+        data.data(), data.size(), [](float a, float b) { return a + b; },
+        [&](float* chunk, size_t n) {
+          comm->AllReduce(chunk, n, VarType::FP32, platform::CPUReduceOp::kSum);
+        });
+    for (size_t i = 0; i < data.size(); ++i) {
+      ASSERT_EQ(data[i], 6.0f + 4 * i) << "element " << i;
+    }
+  });
+}
+
+// The latency and the bandwidth of all reducing the float32 of each size
+// among 4 processes on the host, through the shared memory and through the
+// TCP loopback.
+TEST(ShmNodeGroup, benchmark_all_reduce) {
+  const int local_size = 4;
+  auto name = MakeName();
+  auto endpoints = MakeEndpoints(local_size);
+  RunRanks(local_size, [=](int rank) {
+    ShmNodeGroup group(name, rank, local_size);
+    platform::CPUComm comm(endpoints, rank);
+    for (int64_t bytes :
+         {4, 64, 1 << 10, 16 << 10, 256 << 10, 4 << 20, 64 << 20, 256 << 20}) {
+      std::vector<float> data(bytes / sizeof(float), 1.0f);
+      int iters = static_cast<int>(
+          std::min<int64_t>(100, std::max<int64_t>(2, (64 << 20) / bytes)));
+      std::string results;
+      for (bool shm : {true, false}) {
+        comm.Barrier();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) {
+          if (shm) {
+            group.AllReduce(data.data(), data.size(),
+                            [](float a, float b) { return a + b; });
+          } else {
+            comm.AllReduce(data.data(), data.size(), VarType::FP32,
+                           platform::CPUReduceOp::kSum);
+          }
+        }
+        double us = std::chrono::duration<double, std::micro>(
+                        std::chrono::steady_clock::now() - start)
+                        .count() /
+                    iters;
+        results += " " + std::to_string(us) + " us " +
+                   std::to_string(bytes / us) + " MB/s,";
+      }
+      if (rank == 0) {
+        LOG(INFO) << "All reduce " << bytes
+                  << " bytes through shm and tcp:" << results;
+      }
+    }
+  });
+}
+
+}  // namespace framework
+}  // namespace paddle
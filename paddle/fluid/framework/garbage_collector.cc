@@ -12,16 +12,19 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
 #include <functional>
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 #include "paddle/fluid/platform/cuda_device_guard.h"
 #endif
 #include "gflags/gflags.h"
 #include "paddle/fluid/framework/garbage_collector.h"
+#include "paddle/fluid/platform/metrics.h"
 
 DECLARE_double(eager_delete_tensor_gb);
 DECLARE_double(memory_fraction_of_eager_deletion);
 DECLARE_bool(fast_eager_deletion_mode);
+DECLARE_double(cpu_deferred_gc_slack_mb);
 
 namespace paddle {
 namespace framework {
@@ -44,6 +47,166 @@ void CPUGarbageCollector::ClearCallback(const std::function<void()> &callback) {
   callback();
 }
 
+CPUDeferredGarbageCollector::CPUDeferredGarbageCollector(
+    const platform::CPUPlace &place, size_t max_memory_size,
+    size_t max_slack_bytes)
+    : GarbageCollector(place, max_memory_size),
+      max_slack_bytes_(max_slack_bytes),
+      batch_bytes_((std::max)(max_slack_bytes / 8, static_cast<size_t>(1))),
+      id_([] {
+        static std::atomic<uint64_t> next_id{0};
+        return next_id.fetch_add(1);
+      }()) {
+  auto &registry = platform::MetricsRegistry::Instance();
+  reclaimed_bytes_metric_ = registry.GetCounter(
+      "paddle_gc_reclaimed_bytes_total",
+      "The bytes released by the deferred garbage collectors on CPU.");
+  latency_metric_ = registry.GetHistogram(
+      "paddle_gc_reclaim_latency_seconds",
+      "The time from a batch of garbages handed to the reclaimer to it "
+      "released.");
+  reclaimer_ = std::thread([this] { ReclaimLoop(); });
+}
+
+CPUDeferredGarbageCollector::~CPUDeferredGarbageCollector() {
+  Wait();
+  {
+    std::lock_guard<std::mutex> guard(queue_mutex_);
+    stop_ = true;
+  }
+  queue_cv_.notify_one();
+  reclaimer_.join();
+}
+
+CPUDeferredGarbageCollector::Batch *
+CPUDeferredGarbageCollector::ThreadBatch() {
+  // The batches of the collectors used by the thread lately, the last used
+  // first. The batches are owned by the collectors.
+  static constexpr size_t kCachedBatches = 8;
+  thread_local std::vector<std::pair<uint64_t, Batch *>> cached;
+  for (size_t i = 0; i < cached.size(); ++i) {
+    if (cached[i].first == id_) {
+      auto *batch = cached[i].second;
+      std::rotate(cached.begin(), cached.begin() + i, cached.begin() + i + 1);
+      return batch;
+    }
+  }
+  Batch *batch = nullptr;
+  {
+    std::lock_guard<std::mutex> guard(batches_mutex_);
+    auto &owned = batches_[std::this_thread::get_id()];
+    if (owned == nullptr) owned.reset(new Batch());
+    batch = owned.get();
+  }
+  cached.insert(cached.begin(), std::make_pair(id_, batch));
+  if (cached.size() > kCachedBatches) cached.pop_back();
+  return batch;
+}
+
+void CPUDeferredGarbageCollector::ClearCallback(
+    const std::function<void()> &callback) {
+  ClearGarbageCallback(callback, 0);
+}
+
+void CPUDeferredGarbageCollector::ClearGarbageCallback(
+    const std::function<void()> &callback, size_t bytes) {
+  // Counted before the bytes may be handed over and subtracted by the
+  // reclaimer, which would wrap the counter around otherwise.
+  bool over_slack =
+      unreclaimed_bytes_.fetch_add(bytes) + bytes > max_slack_bytes_;
+  auto *batch = ThreadBatch();
+  bool full = false;
+  {
+    std::lock_guard<std::mutex> guard(batch->mutex);
+    batch->callbacks.push_back(callback);
+    batch->bytes += bytes;
+    full = batch->bytes >= batch_bytes_ ||
+           batch->callbacks.size() >= kMaxBatchCallbacks;
+  }
+  if (full) HandOver(batch);
+
+  if (over_slack) {
+    HandOverAll();
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    reclaimed_cv_.wait(
+        lock, [this] { return unreclaimed_bytes_ <= max_slack_bytes_; });
+  }
+}
+
+void CPUDeferredGarbageCollector::HandOver(Batch *batch) const {
+  HandedBatch handed;
+  {
+    std::lock_guard<std::mutex> guard(batch->mutex);
+    if (batch->callbacks.empty()) return;
+    handed.callbacks.swap(batch->callbacks);
+    handed.bytes = batch->bytes;
+    batch->bytes = 0;
+  }
+  handed.handed = std::chrono::steady_clock::now();
+  {
+    std::lock_guard<std::mutex> guard(queue_mutex_);
+    queue_.push_back(std::move(handed));
+  }
+  queue_cv_.notify_one();
+}
+
+void CPUDeferredGarbageCollector::HandOverAll() const {
+  std::lock_guard<std::mutex> guard(batches_mutex_);
+  for (auto &item : batches_) {
+    HandOver(item.second.get());
+  }
+}
+
+void CPUDeferredGarbageCollector::Wait() const {
+  HandOverAll();
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  reclaimed_cv_.wait(lock, [this] { return queue_.empty() && !reclaiming_; });
+}
+
+CPUDeferredGarbageCollector::Stats CPUDeferredGarbageCollector::GetStats()
+    const {
+  Stats stats;
+  stats.reclaimed_bytes = reclaimed_bytes_;
+  stats.reclaimed_batches = reclaimed_batches_;
+  stats.total_latency_ns = total_latency_ns_;
+  stats.max_latency_ns = max_latency_ns_;
+  return stats;
+}
+
+void CPUDeferredGarbageCollector::ReclaimLoop() {
+  while (true) {
+    HandedBatch handed;
+    {
+      std::unique_lock<std::mutex> lock(queue_mutex_);
+      queue_cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (queue_.empty()) return;
+      handed = std::move(queue_.front());
+      queue_.pop_front();
+      reclaiming_ = true;
+    }
+    for (auto &callback : handed.callbacks) {
+      callback();
+    }
+    // The callbacks may hold the garbages as well.
+    handed.callbacks.clear();
+    uint64_t latency_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - handed.handed)
+                              .count();
+    reclaimed_bytes_ += handed.bytes;
+    ++reclaimed_batches_;
+    total_latency_ns_ += latency_ns;
+    if (latency_ns > max_latency_ns_) max_latency_ns_ = latency_ns;
+    reclaimed_bytes_metric_->Increase(handed.bytes);
+    latency_metric_->Observe(latency_ns);
+    {
+      std::lock_guard<std::mutex> guard(queue_mutex_);
+      unreclaimed_bytes_ -= handed.bytes;
+      reclaiming_ = false;
+    }
+    reclaimed_cv_.notify_all();
+  }
+}
+
 #ifdef PADDLE_WITH_XPU
 XPUGarbageCollector::XPUGarbageCollector(const platform::XPUPlace &place,
                                          size_t max_memory_size)
@@ -157,6 +320,13 @@ int64_t GetEagerDeletionThreshold() {
 
 bool IsFastEagerDeletionModeEnabled() { return FLAGS_fast_eager_deletion_mode; }
 
+size_t GetCPUDeferredGCSlackBytes() {
+  return FLAGS_cpu_deferred_gc_slack_mb <= 0
+             ? 0
+             : static_cast<size_t>(FLAGS_cpu_deferred_gc_slack_mb *
+                                   (static_cast<int64_t>(1) << 20));
+}
+
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode) {
   FLAGS_eager_delete_tensor_gb = threshold;
   FLAGS_memory_fraction_of_eager_deletion = fraction;
@@ -14,11 +14,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
 #include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "gflags/gflags.h"
 #include "paddle/fluid/platform/device_context.h"
@@ -26,6 +32,8 @@
 namespace paddle {
 namespace platform {
 class DeviceContext;
+class MetricCounter;
+class MetricHistogram;
 }  // namespace platform
 }  // namespace paddle
 
@@ -55,6 +63,13 @@ class GarbageCollector {
  protected:
   virtual void ClearCallback(const std::function<void()> &callback) = 0;
 
+  // Release the garbages of the bytes by the callback. Only the collectors
+  // which account the bytes released override it.
+  virtual void ClearGarbageCallback(const std::function<void()> &callback,
+                                    size_t bytes) {
+    ClearCallback(callback);
+  }
+
   platform::DeviceContext *dev_ctx_;
   std::unique_ptr<GarbageQueue> garbages_;
   mutable std::unique_ptr<std::mutex> mutex_;
@@ -70,6 +85,91 @@ class CPUGarbageCollector : public GarbageCollector {
   void ClearCallback(const std::function<void()> &callback) override;
 };
 
+/*
+ * Defer the releases of the garbages on CPU to a background reclaimer, so
+ * that the threads running the ops do not contend on the allocator.
+ *
+ * The garbages cleared by a thread are appended to a batch of the thread,
+ * which is handed to the reclaimer when it holds 1/8 of max_slack_bytes or
+ * kMaxBatchCallbacks releases. The bytes cleared but not released yet are
+ * bounded by max_slack_bytes: the thread exceeding it hands the batches of
+ * all the threads to the reclaimer and waits until the bytes are below the
+ * bound again.
+ */
+class CPUDeferredGarbageCollector : public GarbageCollector {
+ public:
+  struct Stats {
+    uint64_t reclaimed_bytes{0};
+    uint64_t reclaimed_batches{0};
+    // The time from a batch handed to the reclaimer to it released.
+    uint64_t total_latency_ns{0};
+    uint64_t max_latency_ns{0};
+  };
+
+  CPUDeferredGarbageCollector(const platform::CPUPlace &place,
+                              size_t max_memory_size, size_t max_slack_bytes);
+
+  ~CPUDeferredGarbageCollector();
+
+  // Hand the batches of all the threads to the reclaimer, and wait until
+  // they are released.
+  void Wait() const override;
+
+  Stats GetStats() const;
+
+  static constexpr size_t kMaxBatchCallbacks = 256;
+
+ protected:
+  void ClearCallback(const std::function<void()> &callback) override;
+
+  void ClearGarbageCallback(const std::function<void()> &callback,
+                            size_t bytes) override;
+
+ private:
+  struct Batch {
+    std::mutex mutex;
+    std::vector<std::function<void()>> callbacks;
+    size_t bytes{0};
+  };
+
+  struct HandedBatch {
+    std::vector<std::function<void()>> callbacks;
+    size_t bytes{0};
+    std::chrono::steady_clock::time_point handed;
+  };
+
+  Batch *ThreadBatch();
+  void HandOver(Batch *batch) const;
+  void HandOverAll() const;
+  void ReclaimLoop();
+
+  const size_t max_slack_bytes_;
+  const size_t batch_bytes_;
+  // Identifies the collector in the thread local batch caches.
+  const uint64_t id_;
+
+  // The batches of the threads.
+  mutable std::mutex batches_mutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<Batch>> batches_;
+
+  mutable std::mutex queue_mutex_;
+  mutable std::condition_variable queue_cv_;
+  mutable std::condition_variable reclaimed_cv_;
+  mutable std::deque<HandedBatch> queue_;
+  bool reclaiming_{false};
+  bool stop_{false};
+  std::atomic<size_t> unreclaimed_bytes_{0};
+
+  std::atomic<uint64_t> reclaimed_bytes_{0};
+  std::atomic<uint64_t> reclaimed_batches_{0};
+  std::atomic<uint64_t> total_latency_ns_{0};
+  std::atomic<uint64_t> max_latency_ns_{0};
+  platform::MetricCounter *reclaimed_bytes_metric_;
+  platform::MetricHistogram *latency_metric_;
+
+  std::thread reclaimer_;
+};
+
 #ifdef PADDLE_WITH_XPU
 class XPUGarbageCollector : public GarbageCollector {
  public:
@@ -164,12 +264,17 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
   // It speeds up GC about 2~3%.
   if (max_memory_size_ <= 1) {
     callback();
+    size_t bytes = 0;
+    for (auto &obj : objs) {
+      if (obj) bytes += obj->size();
+    }
     auto *container = new Container(std::move(objs));
-    ClearCallback([container] { delete container; });
+    ClearGarbageCallback([container] { delete container; }, bytes);
     return;
   }
 
   GarbageQueue *garbage_queue = nullptr;
+  size_t bytes = 0;
   {
     std::lock_guard<std::mutex> guard(*mutex_);
     for (auto &obj : objs) {
@@ -178,6 +283,7 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
       garbages_->push_back(std::move(obj));
     }
     if (cur_memory_size_ >= max_memory_size_) {
+      bytes = cur_memory_size_;
       cur_memory_size_ = 0;
       garbage_queue = garbages_.release();
       garbages_.reset(new GarbageQueue());
@@ -186,12 +292,15 @@ void GarbageCollector::Add(Container &&objs, Callback &&callback) {
 
   if (garbage_queue) {
     callback();
-    ClearCallback([garbage_queue]() { delete garbage_queue; });
+    ClearGarbageCallback([garbage_queue]() { delete garbage_queue; }, bytes);
   }
 }
 
 int64_t GetEagerDeletionThreshold();
 bool IsFastEagerDeletionModeEnabled();
+// The bound of the garbages waiting to be released by
+// CPUDeferredGarbageCollector, 0 if the releases on CPU are not deferred.
+size_t GetCPUDeferredGCSlackBytes();
 
 void SetEagerDeletionMode(double threshold, double fraction, bool fast_mode);
 
@@ -0,0 +1,175 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/garbage_collector.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdlib>
+#include <future>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+using GarbageQueue = GarbageCollector::GarbageQueue;
+
+static std::atomic<int64_t> g_alive_bytes{0};
+
+// An allocation without memory, which counts the bytes alive.
+class CountedAllocation : public memory::Allocation {
+ public:
+  explicit CountedAllocation(size_t size)
+      : Allocation(nullptr, size, platform::CPUPlace()) {
+    g_alive_bytes += size;
+  }
+  ~CountedAllocation() { g_alive_bytes -= size(); }
+};
+
+TEST(CPUDeferredGarbageCollector, release) {
+  const size_t slack = 1 << 20;
+  CPUDeferredGarbageCollector gc(platform::CPUPlace(), 1, slack);
+  const int num_threads = 4;
+  const int num_adds = 1000;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([&] {
+      for (int j = 0; j < num_adds; ++j) {
+        GarbageQueue garbages;
+        garbages.emplace_back(std::make_shared<CountedAllocation>(1000));
+        garbages.emplace_back(std::make_shared<CountedAllocation>(24));
+        gc.Add(std::move(garbages));
+        // the bytes not released yet are bounded by the slack
+        EXPECT_LE(g_alive_bytes,
+                  static_cast<int64_t>(slack) + 2 * num_threads * 1024);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  gc.Wait();
+  EXPECT_EQ(g_alive_bytes, 0);
+  auto stats = gc.GetStats();
+  EXPECT_EQ(stats.reclaimed_bytes, 1024UL * num_threads * num_adds);
+  EXPECT_GT(stats.reclaimed_batches, 0UL);
+  EXPECT_GE(stats.total_latency_ns, stats.max_latency_ns);
+}
+
+// The threads adding over a slack of a few bytes, so that most of the adds
+// hand the batches over and wait for them, must not hang.
+TEST(CPUDeferredGarbageCollector, small_slack) {
+  CPUDeferredGarbageCollector gc(platform::CPUPlace(), 1, 16);
+  const int num_threads = 8;
+  const int num_adds = 20000;
+  std::promise<void> done;
+  std::thread runner([&] {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([&] {
+        for (int j = 0; j < num_adds; ++j) {
+          GarbageQueue garbages;
+          garbages.emplace_back(std::make_shared<CountedAllocation>(8 + j % 8));
+          gc.Add(std::move(garbages));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    done.set_value();
+  });
+  if (done.get_future().wait_for(std::chrono::seconds(120)) !=
+      std::future_status::ready) {
+    ADD_FAILURE() << "The adds hang waiting for the reclaimer.";
+    std::_Exit(1);
+  }
+  runner.join();
+  gc.Wait();
+  EXPECT_EQ(g_alive_bytes, 0);
+}
+
+TEST(CPUDeferredGarbageCollector, callback) {
+  CPUDeferredGarbageCollector gc(platform::CPUPlace(), 1, 1 << 20);
+  std::atomic<int> called{0};
+  for (int i = 0; i < 10; ++i) {
+    gc.DirectClearCallback([&called] { ++called; });
+  }
+  // the callbacks are batched until handed to the reclaimer
+  gc.Wait();
+  EXPECT_EQ(called, 10);
+
+  // a threshold of the collector as eager_delete_tensor_gb > 0
+  CPUDeferredGarbageCollector threshold_gc(platform::CPUPlace(), 4096, 1024);
+  GarbageQueue garbages;
+  garbages.emplace_back(std::make_shared<CountedAllocation>(3000));
+  threshold_gc.Add(std::move(garbages));
+  EXPECT_EQ(g_alive_bytes, 3000);
+  garbages.clear();
+  garbages.emplace_back(std::make_shared<CountedAllocation>(3000));
+  // exceeds the slack, so the garbages are released before returning
+  threshold_gc.Add(std::move(garbages));
+  EXPECT_EQ(g_alive_bytes, 0);
+}
+
+// The throughput of 8 threads allocating and collecting tensors of 1KB to
+// 256KB, with the garbages released by the threads and by the reclaimer.
+TEST(CPUDeferredGarbageCollector, benchmark) {
+  const int num_threads = 8;
+  const int num_adds = 20000;
+  auto run = [&](GarbageCollector* gc) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < num_threads; ++i) {
+      threads.emplace_back([gc, i] {
+        unsigned seed = i;
+        for (int j = 0; j < num_adds; ++j) {
+          GarbageQueue garbages;
+          size_t size = (rand_r(&seed) % 256 + 1) << 10;
+          garbages.emplace_back(
+              memory::AllocShared(platform::CPUPlace(), size));
+          gc->Add(std::move(garbages));
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    gc->Wait();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+  };
+  CPUGarbageCollector gc(platform::CPUPlace(), 1);
+  double sync_s = run(&gc);
+  CPUDeferredGarbageCollector deferred_gc(platform::CPUPlace(), 1, 64 << 20);
+  double deferred_s = run(&deferred_gc);
+  auto stats = deferred_gc.GetStats();
+  LOG(INFO) << "Released by the threads: "
+            << num_threads * num_adds / sync_s << " tensors/s";
+  LOG(INFO) << "Released by the reclaimer: "
+            << num_threads * num_adds / deferred_s << " tensors/s, "
+            << stats.reclaimed_bytes / 1048576.0 << " MB in "
+            << stats.reclaimed_batches << " batches, mean latency "
+            << stats.total_latency_ns / 1000.0 /
+                   std::max<uint64_t>(stats.reclaimed_batches, 1)
+            << " us, max latency " << stats.max_latency_ns / 1000.0 << " us";
+}
+
+}  // namespace framework
+}  // namespace paddle
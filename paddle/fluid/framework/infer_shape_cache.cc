@@ -0,0 +1,232 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/infer_shape_cache.h"
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/platform/metrics.h"
+
+namespace paddle {
+namespace framework {
+
+// The values of the integer tensors up to this size are a part of the
+// signature, in case InferShape reads them as shapes. The runs with the
+// larger ones skip the cache.
+static constexpr int64_t kMaxShapeTensorNumel = 8;
+
+// Markers in the signature
+static constexpr int64_t kNullVar = -1;
+static constexpr int64_t kEmptyVar = -2;
+static constexpr int64_t kEmptyTensor = -3;
+
+static int64_t PlaceSignature(const platform::Place& place) {
+  int64_t device = 0;
+  if (platform::is_gpu_place(place)) {
+    device = BOOST_GET_CONST(platform::CUDAPlace, place).GetDeviceId();
+  } else if (platform::is_xpu_place(place)) {
+    device = BOOST_GET_CONST(platform::XPUPlace, place).GetDeviceId();
+  } else if (platform::is_npu_place(place)) {
+    device = BOOST_GET_CONST(platform::NPUPlace, place).GetDeviceId();
+  }
+  return (static_cast<int64_t>(place.which()) << 16) | device;
+}
+
+template <typename T>
+static void AppendValues(const Tensor& tensor, std::vector<int64_t>* sig) {
+  const T* data = tensor.data<T>();
+  for (int64_t i = 0; i < tensor.numel(); ++i) {
+    sig->push_back(static_cast<int64_t>(data[i]));
+  }
+}
+
+static bool MakeSignature(const VariableValueMap& inputs,
+                          std::vector<int64_t>* sig) {
+  sig->clear();
+  sig->push_back(static_cast<int64_t>(inputs.size()));
+  for (auto& item : inputs) {
+    sig->push_back(static_cast<int64_t>(item.second.size()));
+    for (auto* var : item.second) {
+      if (var == nullptr) {
+        sig->push_back(kNullVar);
+        continue;
+      }
+      if (!var->IsInitialized()) {
+        sig->push_back(kEmptyVar);
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        return false;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      if (!tensor.lod().empty()) {
+        return false;
+      }
+      auto& dims = tensor.dims();
+      sig->push_back(dims.size());
+      for (int i = 0; i < dims.size(); ++i) {
+        sig->push_back(dims[i]);
+      }
+      if (!tensor.IsInitialized()) {
+        sig->push_back(kEmptyTensor);
+        continue;
+      }
+      auto type = tensor.type();
+      sig->push_back(static_cast<int64_t>(type));
+      sig->push_back(static_cast<int64_t>(tensor.layout()));
+      sig->push_back(PlaceSignature(tensor.place()));
+      if (type == proto::VarType::INT32 || type == proto::VarType::INT64) {
+        if (tensor.numel() > kMaxShapeTensorNumel ||
+            !platform::is_cpu_place(tensor.place())) {
+          return false;
+        }
+        if (type == proto::VarType::INT32) {
+          AppendValues<int32_t>(tensor, sig);
+        } else {
+          AppendValues<int64_t>(tensor, sig);
+        }
+      }
+    }
+  }
+  return true;
+}
+
+InferShapeCache::InferShapeCache(const std::string& op_type)
+    : op_type_(op_type) {
+  auto& registry = platform::MetricsRegistry::Instance();
+  hits_metric_ = registry.GetCounter(
+      "paddle_infer_shape_cache_hits_total",
+      "The number of runs of the operators which skip InferShape.",
+      {{"op_type", op_type}});
+  misses_metric_ = registry.GetCounter(
+      "paddle_infer_shape_cache_misses_total",
+      "The number of runs of the operators which miss the InferShape cache.",
+      {{"op_type", op_type}});
+}
+
+void InferShapeCache::OnMiss() {
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  misses_metric_->Increase();
+  uint64_t hits = Hits();
+  uint64_t lookups = hits + Misses();
+  if (lookups >= kMinLookupsToDisable && hits * 2 < lookups) {
+    if (enabled_.exchange(false)) {
+      VLOG(3) << "Disable the InferShape cache of " << op_type_
+              << ", hits: " << hits << ", lookups: " << lookups;
+      std::lock_guard<std::mutex> lock(mu_);
+      entries_.clear();
+    }
+  }
+}
+
+std::shared_ptr<const InferShapeCache::Entry> InferShapeCache::Lookup(
+    const VariableValueMap& inputs, std::vector<int64_t>* signature) {
+  if (!MakeSignature(inputs, signature)) {
+    signature->clear();
+    OnMiss();
+    return nullptr;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    for (auto& entry : entries_) {
+      if (entry->signature == *signature) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        hits_metric_->Increase();
+        return entry;
+      }
+    }
+  }
+  OnMiss();
+  return nullptr;
+}
+
+void InferShapeCache::Update(const std::vector<int64_t>& signature,
+                             bool need_transfer,
+                             const VariableValueMap& outputs) {
+  if (signature.empty() || !Enabled()) {
+    return;
+  }
+  std::shared_ptr<Entry> entry(new Entry());
+  entry->signature = signature;
+  entry->need_transfer = need_transfer;
+  for (auto& item : outputs) {
+    for (auto* var : item.second) {
+      if (var == nullptr || !var->IsInitialized()) {
+        entry->outputs.emplace_back(false, DDim());
+        continue;
+      }
+      if (!var->IsType<LoDTensor>()) {
+        return;
+      }
+      auto& tensor = var->Get<LoDTensor>();
+      if (!tensor.lod().empty()) {
+        return;
+      }
+      entry->outputs.emplace_back(true, tensor.dims());
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mu_);
+  for (auto& cached : entries_) {
+    if (cached->signature == signature) {
+      // updated by another thread
+      return;
+    }
+  }
+  if (entries_.size() < kMaxEntries) {
+    entries_.emplace_back(std::move(entry));
+  } else {
+    entries_[next_evicted_] = std::move(entry);
+    next_evicted_ = (next_evicted_ + 1) % kMaxEntries;
+  }
+}
+
+bool InferShapeCache::SetOutputDims(const Entry& entry,
+                                    const VariableValueMap& outputs) const {
+  size_t i = 0;
+  for (auto& item : outputs) {
+    for (auto* var : item.second) {
+      if (i >= entry.outputs.size()) {
+        return false;
+      }
+      if (!entry.outputs[i++].first) {
+        continue;
+      }
+      if (var == nullptr) {
+        return false;
+      }
+      if (var->IsInitialized() &&
+          (!var->IsType<LoDTensor>() || !var->Get<LoDTensor>().lod().empty())) {
+        return false;
+      }
+    }
+  }
+  if (i != entry.outputs.size()) {
+    return false;
+  }
+
+  i = 0;
+  for (auto& item : outputs) {
+    for (auto* var : item.second) {
+      auto& output = entry.outputs[i++];
+      if (output.first) {
+        var->GetMutable<LoDTensor>()->Resize(output.second);
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,95 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/type_defs.h"
+
+namespace paddle {
+namespace platform {
+class MetricCounter;
+}  // namespace platform
+}  // namespace paddle
+
+namespace paddle {
+namespace framework {
+
+// InferShapeCache memoizes the runtime InferShape and the data transform
+// decision of one operator, keyed by the signature of its inputs: the dims,
+// data type, layout and place of every input tensor, and the values of the
+// small integer tensors on CPU, which may be used as shapes.
+//
+// Only the ops whose inputs and outputs are all LoDTensors without LoD are
+// cached, since InferShape may share the LoD of the inputs to the outputs.
+// The cache keeps a few signatures for the models with a few distinct shapes,
+// and is disabled once the hit rate is low, e.g. for the dynamic-shape models.
+class InferShapeCache {
+ public:
+  struct Entry {
+    std::vector<int64_t> signature;
+    // whether any input needs to be transformed by PrepareData
+    bool need_transfer;
+    // the dims of every output variable in the order of the output map,
+    // false if the output is not created by InferShape
+    std::vector<std::pair<bool, DDim>> outputs;
+  };
+
+  static constexpr size_t kMaxEntries = 8;
+  static constexpr uint64_t kMinLookupsToDisable = 256;
+
+  explicit InferShapeCache(const std::string& op_type);
+
+  bool Enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+  // Return the cached entry of the inputs, or nullptr on miss. The signature
+  // of the inputs is written to signature to update the cache on miss, it is
+  // left empty if the inputs can not be cached.
+  std::shared_ptr<const Entry> Lookup(const VariableValueMap& inputs,
+                                      std::vector<int64_t>* signature);
+  // Record the outputs inferred by InferShape for the missed signature.
+  void Update(const std::vector<int64_t>& signature, bool need_transfer,
+              const VariableValueMap& outputs);
+  // Resize the outputs to the cached dims, return false without changing
+  // any output if the outputs do not match the entry, then InferShape should
+  // be run instead.
+  bool SetOutputDims(const Entry& entry, const VariableValueMap& outputs) const;
+
+  uint64_t Hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t Misses() const { return misses_.load(std::memory_order_relaxed); }
+
+ private:
+  void OnMiss();
+
+  std::string op_type_;
+  std::mutex mu_;
+  std::vector<std::shared_ptr<const Entry>> entries_;
+  size_t next_evicted_{0};
+
+  std::atomic<bool> enabled_{true};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  platform::MetricCounter* hits_metric_;
+  platform::MetricCounter* misses_metric_;
+};
+
+}  // namespace framework
+}  // namespace paddle
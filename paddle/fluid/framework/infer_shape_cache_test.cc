@@ -0,0 +1,307 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/infer_shape_cache.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+DECLARE_bool(enable_infer_shape_cache);
+
+namespace paddle {
+namespace framework {
+
+static int infer_shape_num = 0;
+
+class RowConcatOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of the test op").AsDuplicable();
+    AddOutput("Out", "the rows of all the inputs");
+    AddComment("Concatenate the rows of the inputs, to test InferShape cache.");
+  }
+};
+
+class RowConcatOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ++infer_shape_num;
+    auto dims = ctx->GetInputsDim("X");
+    int64_t rows = 0;
+    for (auto& d : dims) {
+      rows += d[0];
+    }
+    ctx->SetOutputDim("Out", {rows, dims[0][1]});
+    ctx->ShareLoD("X", "Out");
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class RowConcatKernel : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<LoDTensor>("X");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    float* dst = out->mutable_data<float>(ctx.GetPlace());
+    for (auto* in : ins) {
+      dst = std::copy_n(in->data<float>(), in->numel(), dst);
+    }
+  }
+};
+
+class ShapeFillOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("Shape", "the shape of the output, an int32 tensor");
+    AddOutput("Out", "the output of the shape");
+    AddComment("Fill the output of the shape, to test InferShape cache.");
+  }
+};
+
+class ShapeFillOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ++infer_shape_num;
+    auto* var = BOOST_GET(Variable*, ctx->GetInputVarPtrs("Shape")[0]);
+    auto& shape = var->Get<LoDTensor>();
+    std::vector<int64_t> dims(shape.data<int32_t>(),
+                              shape.data<int32_t>() + shape.numel());
+    ctx->SetOutputDim("Out", make_ddim(dims));
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class ShapeFillKernel : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto* out = ctx.Output<LoDTensor>("Out");
+    float* data = out->mutable_data<float>(ctx.GetPlace());
+    std::fill_n(data, out->numel(), 1.f);
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(row_concat_test,
+                             paddle::framework::RowConcatOp,
+                             paddle::framework::RowConcatOpMaker);
+REGISTER_OP_CPU_KERNEL(row_concat_test, paddle::framework::RowConcatKernel);
+REGISTER_OP_WITHOUT_GRADIENT(shape_fill_test, paddle::framework::ShapeFillOp,
+                             paddle::framework::ShapeFillOpMaker);
+REGISTER_OP_CPU_KERNEL(shape_fill_test, paddle::framework::ShapeFillKernel);
+
+namespace paddle {
+namespace framework {
+
+static std::unique_ptr<OperatorBase> CreateRowConcat(
+    const std::vector<std::string>& xs, const std::string& out) {
+  return OpRegistry::CreateOp("row_concat_test", {{"X", xs}}, {{"Out", {out}}},
+                              AttributeMap{});
+}
+
+static void FeedTensor(Scope* scope, const std::string& name, int64_t rows,
+                       int64_t cols, float value) {
+  auto* t = scope->Var(name)->GetMutable<LoDTensor>();
+  float* data = t->mutable_data<float>({rows, cols}, platform::CPUPlace());
+  std::fill_n(data, rows * cols, value);
+}
+
+class InferShapeCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    FLAGS_enable_infer_shape_cache = true;
+    infer_shape_num = 0;
+  }
+  void TearDown() override { FLAGS_enable_infer_shape_cache = false; }
+};
+
+TEST_F(InferShapeCacheTest, hit) {
+  Scope scope;
+  platform::CPUPlace place;
+  auto op = CreateRowConcat({"a", "b"}, "out");
+  scope.Var("out")->GetMutable<LoDTensor>();
+  FeedTensor(&scope, "a", 2, 3, 1.f);
+  FeedTensor(&scope, "b", 1, 3, 2.f);
+  for (int i = 0; i < 5; ++i) {
+    op->Run(scope, place);
+  }
+  EXPECT_EQ(infer_shape_num, 1);
+  auto& out = scope.FindVar("out")->Get<LoDTensor>();
+  EXPECT_EQ(out.dims(), make_ddim({3, 3}));
+  EXPECT_EQ(out.data<float>()[8], 2.f);
+
+  // a new shape of the inputs, then back to the cached one
+  FeedTensor(&scope, "b", 4, 3, 3.f);
+  op->Run(scope, place);
+  EXPECT_EQ(infer_shape_num, 2);
+  EXPECT_EQ(out.dims(), make_ddim({6, 3}));
+  FeedTensor(&scope, "b", 1, 3, 2.f);
+  op->Run(scope, place);
+  EXPECT_EQ(infer_shape_num, 2);
+  EXPECT_EQ(out.dims(), make_ddim({3, 3}));
+
+  // the outputs in a new scope
+  Scope other;
+  other.Var("out")->GetMutable<LoDTensor>();
+  FeedTensor(&other, "a", 2, 3, 1.f);
+  FeedTensor(&other, "b", 1, 3, 2.f);
+  op->Run(other, place);
+  EXPECT_EQ(infer_shape_num, 2);
+  EXPECT_EQ(other.FindVar("out")->Get<LoDTensor>().dims(), make_ddim({3, 3}));
+}
+
+TEST_F(InferShapeCacheTest, lod) {
+  Scope scope;
+  platform::CPUPlace place;
+  auto op = CreateRowConcat({"a"}, "out");
+  scope.Var("out")->GetMutable<LoDTensor>();
+  FeedTensor(&scope, "a", 4, 2, 1.f);
+  scope.FindVar("a")->GetMutable<LoDTensor>()->set_lod({{0, 1, 4}});
+  for (int i = 0; i < 3; ++i) {
+    op->Run(scope, place);
+  }
+  // InferShape shares the LoD, so the inputs with LoD are never cached
+  EXPECT_EQ(infer_shape_num, 3);
+  EXPECT_EQ(scope.FindVar("out")->Get<LoDTensor>().lod(),
+            LoD({{0, 1, 4}}));
+
+  scope.FindVar("a")->GetMutable<LoDTensor>()->set_lod({});
+  op->Run(scope, place);
+  op->Run(scope, place);
+  EXPECT_EQ(infer_shape_num, 4);
+  EXPECT_TRUE(scope.FindVar("out")->Get<LoDTensor>().lod().empty());
+
+  // InferShape is run again if the output has a stale LoD
+  scope.FindVar("out")->GetMutable<LoDTensor>()->set_lod({{0, 4}});
+  op->Run(scope, place);
+  EXPECT_EQ(infer_shape_num, 5);
+  EXPECT_TRUE(scope.FindVar("out")->Get<LoDTensor>().lod().empty());
+}
+
+TEST_F(InferShapeCacheTest, dynamic_shape) {
+  Scope scope;
+  platform::CPUPlace place;
+  auto op = CreateRowConcat({"a"}, "out");
+  scope.Var("out")->GetMutable<LoDTensor>();
+  const int n = InferShapeCache::kMinLookupsToDisable * 2;
+  for (int i = 0; i < n; ++i) {
+    FeedTensor(&scope, "a", i + 1, 2, 1.f);
+    op->Run(scope, place);
+    ASSERT_EQ(scope.FindVar("out")->Get<LoDTensor>().dims(),
+              make_ddim({i + 1, 2}));
+  }
+  EXPECT_EQ(infer_shape_num, n);
+  auto* op_with_kernel = static_cast<OperatorWithKernel*>(op.get());
+  EXPECT_EQ(op_with_kernel->GetInferShapeCache(), nullptr);
+}
+
+TEST_F(InferShapeCacheTest, shape_tensor) {
+  Scope scope;
+  platform::CPUPlace place;
+  auto op = OpRegistry::CreateOp("shape_fill_test", {{"Shape", {"shape"}}},
+                                 {{"Out", {"out"}}}, AttributeMap{});
+  scope.Var("out")->GetMutable<LoDTensor>();
+  auto* shape = scope.Var("shape")->GetMutable<LoDTensor>();
+  auto run = [&](int64_t numel, int32_t last) {
+    int32_t* data = shape->mutable_data<int32_t>({numel}, place);
+    std::fill_n(data, numel, 1);
+    data[numel - 1] = last;
+    op->Run(scope, place);
+    return scope.FindVar("out")->Get<LoDTensor>().dims();
+  };
+
+  // the values of a small shape tensor are in the signature
+  EXPECT_EQ(run(2, 3), make_ddim({1, 3}));
+  EXPECT_EQ(run(2, 3), make_ddim({1, 3}));
+  EXPECT_EQ(infer_shape_num, 1);
+  EXPECT_EQ(run(2, 5), make_ddim({1, 5}));
+  EXPECT_EQ(infer_shape_num, 2);
+
+  // a larger one skips the cache, for its values may change with its dims
+  std::vector<int64_t> dims(8, 1);
+  dims.push_back(4);
+  EXPECT_EQ(run(9, 4), make_ddim(dims));
+  dims.back() = 6;
+  EXPECT_EQ(run(9, 6), make_ddim(dims));
+  EXPECT_EQ(infer_shape_num, 4);
+}
+
+// The time of NaiveExecutor::Run of a program of many small ops, with and
+// without the InferShape cache.
+TEST_F(InferShapeCacheTest, benchmark) {
+  const int num_ops = 500;
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("x0")->SetType(proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < num_ops; ++i) {
+    std::string in = "x" + std::to_string(i);
+    std::string out = "x" + std::to_string(i + 1);
+    block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+    auto* op = block->AppendOp();
+    op->SetType("row_concat_test");
+    op->SetInput("X", {in});
+    op->SetOutput("Out", {out});
+  }
+
+  auto bench_us = [&](bool cache) {
+    FLAGS_enable_infer_shape_cache = cache;
+    Scope scope;
+    for (int i = 1; i <= num_ops; ++i) {
+      scope.Var("x" + std::to_string(i))->GetMutable<LoDTensor>();
+    }
+    FeedTensor(&scope, "x0", 4, 8, 1.f);
+    NaiveExecutor exe(platform::CPUPlace{});
+    exe.Prepare(&scope, program, 0, false);
+    exe.Run();
+    const int repeat = 100;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+      exe.Run();
+    }
+    std::chrono::duration<double, std::micro> elapsed =
+        std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(exe.FindTensor("x" + std::to_string(num_ops))->dims(),
+              make_ddim({4, 8}));
+    return elapsed.count() / repeat;
+  };
+  double without_cache = bench_us(false);
+  double with_cache = bench_us(true);
+  LOG(INFO) << "NaiveExecutor::Run of " << num_ops
+            << " ops: " << without_cache << " us without the InferShape cache, "
+            << with_cache << " us with the cache";
+}
+
+}  // namespace framework
+}  // namespace paddle
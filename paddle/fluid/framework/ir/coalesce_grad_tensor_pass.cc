@@ -254,6 +254,13 @@ class CoalesceGradTensorPass : public ir::Pass {
       const std::unordered_map<std::string, std::vector<ir::Node *>> &vars_info,
       const details::ParamsAndGrads &params_grads,
       details::GroupParamsAndGrads *group_params_grads) const {
+    if (Has(details::kGradBucketSizeInMB) &&
+        Get<double>(details::kGradBucketSizeInMB) > 0.0) {
+      SetGroupAccordingToBuckets(vars_info, params_grads,
+                                 Get<double>(details::kGradBucketSizeInMB),
+                                 group_params_grads);
+      return;
+    }
     SetGroupAccordingToLayers(vars_info, params_grads, group_params_grads);
     SetGroupAccordingToMemorySize(vars_info, group_params_grads);
     if (!IsUnifiedDtype(params_grads, vars_info)) {
@@ -297,6 +304,42 @@ class CoalesceGradTensorPass : public ir::Pass {
     }
   }
 
+  // Pack the gradients into the buckets of at most bucket_size MB by the order
+  // they are generated, i.e. the reverse topological order of the forward
+  // ops, so that the all reduce of a bucket can start once its gradients are
+  // generated, overlapping the backward ops left. A gradient larger than the
+  // bound takes a bucket of its own, and a bucket only holds one dtype.
+  void SetGroupAccordingToBuckets(
+      const std::unordered_map<std::string, std::vector<ir::Node *>> &vars_info,
+      const details::ParamsAndGrads &params_grads, double bucket_size,
+      details::GroupParamsAndGrads *group_params_grads) const {
+    size_t bucket_memory_size = 0;
+    auto bucket_dtype = static_cast<proto::VarType::Type>(0);
+    for (auto &p_g : params_grads) {
+      auto var_desc = GetVarDescFromVarsInfo(vars_info, p_g.second);
+      auto dtype = var_desc->GetDataType();
+      size_t size = framework::SizeOfType(dtype);
+      auto shape = var_desc->GetShape();
+      std::for_each(shape.begin(), shape.end(),
+                    [&size](const int64_t &n) { size *= n; });
+      if (group_params_grads->empty() || dtype != bucket_dtype ||
+          static_cast<double>(bucket_memory_size + size) / kMB >
+              bucket_size) {
+        group_params_grads->emplace_back();
+        bucket_memory_size = 0;
+        bucket_dtype = dtype;
+      }
+      group_params_grads->back().emplace_back(p_g);
+      bucket_memory_size += size;
+    }
+
+    if (VLOG_IS_ON(10)) {
+      VLOG(10) << string::Sprintf(
+          "SetGroupAccordingToBuckets(bucket_size: %f MB):", bucket_size);
+      PrintGroupInfo(vars_info, group_params_grads);
+    }
+  }
+
   void PrintGroupInfo(
       const std::unordered_map<std::string, std::vector<ir::Node *>> &vars_info,
       details::GroupParamsAndGrads *group_params_grads) const {
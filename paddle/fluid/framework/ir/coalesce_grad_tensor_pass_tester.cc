@@ -0,0 +1,290 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_proto_maker.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/parallel_executor.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/cpu_collective.h"
+
+USE_OP(mul);
+USE_OP(mean);
+USE_OP(sgd);
+USE_OP(fill_constant);
+USE_OP(coalesce_tensor);
+
+DECLARE_double(eager_delete_tensor_gb);
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+static std::vector<std::string> MakeEndpoints(int nranks) {
+  // Below the range of the ports bound by connect.
+  static int next_port = 30000 + getpid() % 100 * 100;
+  std::vector<std::string> endpoints;
+  for (int i = 0; i < nranks; ++i) {
+    endpoints.emplace_back("127.0.0.1:" + std::to_string(next_port++));
+  }
+  return endpoints;
+}
+
+// Run the func by nranks processes, each with its rank.
+static void RunTrainers(int nranks, const std::function<void(int)> &func) {
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < nranks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      int status = 0;
+      try {
+        func(rank);
+        status = ::testing::Test::HasFailure() ? 1 : 0;
+      } catch (std::exception &e) {
+        LOG(ERROR) << "Trainer " << rank << " fails: " << e.what();
+        status = 2;
+      }
+      _exit(status);
+    }
+    pids.emplace_back(pid);
+  }
+  for (int rank = 0; rank < nranks; ++rank) {
+    int status = -1;
+    waitpid(pids[rank], &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        << "trainer " << rank << " of " << nranks << " trainers fails";
+  }
+}
+
+static void AppendOp(BlockDesc *block, const std::string &type,
+                     const VariableNameMap &inputs,
+                     const VariableNameMap &outputs, AttributeMap attrs,
+                     OpRole role, const std::vector<std::string> &role_vars) {
+  // The grad ops take the default attrs of their forward ops.
+  auto forward_type = type;
+  auto pos = forward_type.rfind("_grad");
+  if (pos != std::string::npos) {
+    forward_type.erase(pos);
+  }
+  auto &op_info = OpInfoMap::Instance().Get(forward_type);
+  if (op_info.Checker()) {
+    op_info.Checker()->Check(&attrs);
+  }
+  attrs[OpProtoAndCheckerMaker::OpRoleAttrName()] = static_cast<int>(role);
+  attrs[OpProtoAndCheckerMaker::OpRoleVarAttrName()] = role_vars;
+
+  auto *op = block->AppendOp();
+  op->SetType(type);
+  for (auto &pair : inputs) {
+    op->SetInput(pair.first, pair.second);
+  }
+  for (auto &pair : outputs) {
+    op->SetOutput(pair.first, pair.second);
+    for (auto &name : pair.second) {
+      if (!block->FindVarRecursive(name)) {
+        block->Var(name)->SetDataType(proto::VarType::FP32);
+      }
+    }
+  }
+  op->SetAttrMap(attrs);
+  op->InferVarType(block);
+  op->InferShape(*block);
+}
+
+// loss = mean(x * w0 * w1 * w2) with the backward and the sgd written out,
+// as append_backward and the optimizer generate them.
+static ProgramDesc BuildLinearModel(const std::vector<int64_t> &widths,
+                                    int64_t batch_size) {
+  ProgramDesc program;
+  auto *block = program.MutableBlock(0);
+  auto *x = block->Var("x");
+  x->SetDataType(proto::VarType::FP32);
+  x->SetShape({batch_size, widths[0]});
+  auto *lr = block->Var("learning_rate");
+  lr->SetDataType(proto::VarType::FP32);
+  lr->SetShape({1});
+  lr->SetPersistable(true);
+
+  int num_layers = static_cast<int>(widths.size()) - 1;
+  auto w = [](int i) { return "w" + std::to_string(i); };
+  auto h = [](int i) {
+    return i == 0 ? std::string("x") : "h" + std::to_string(i);
+  };
+  for (int i = 0; i < num_layers; ++i) {
+    auto *param = block->Var(w(i));
+    param->SetDataType(proto::VarType::FP32);
+    param->SetShape({widths[i], widths[i + 1]});
+    param->SetPersistable(true);
+    AppendOp(block, "mul", {{"X", {h(i)}}, {"Y", {w(i)}}},
+             {{"Out", {h(i + 1)}}}, {}, OpRole::kForward, {});
+  }
+  AppendOp(block, "mean", {{"X", {h(num_layers)}}}, {{"Out", {"loss"}}}, {},
+           static_cast<OpRole>(static_cast<int>(OpRole::kForward) |
+                               static_cast<int>(OpRole::kLoss)),
+           {});
+
+  AppendOp(block, "fill_constant", {}, {{"Out", {GradVarName("loss")}}},
+           {{"shape", std::vector<int64_t>{1}},
+            {"value", 1.0f},
+            {"dtype", static_cast<int>(proto::VarType::FP32)}},
+           static_cast<OpRole>(static_cast<int>(OpRole::kBackward) |
+                               static_cast<int>(OpRole::kLoss)),
+           {});
+  AppendOp(block, "mean_grad",
+           {{"X", {h(num_layers)}},
+            {GradVarName("Out"), {GradVarName("loss")}}},
+           {{GradVarName("X"), {GradVarName(h(num_layers))}}}, {},
+           OpRole::kBackward, {});
+  for (int i = num_layers - 1; i >= 0; --i) {
+    VariableNameMap outputs{{GradVarName("Y"), {GradVarName(w(i))}}};
+    if (i > 0) outputs[GradVarName("X")] = {GradVarName(h(i))};
+    AppendOp(block, "mul_grad",
+             {{"X", {h(i)}},
+              {"Y", {w(i)}},
+              {GradVarName("Out"), {GradVarName(h(i + 1))}}},
+             outputs, {}, OpRole::kBackward, {w(i), GradVarName(w(i))});
+  }
+  for (int i = 0; i < num_layers; ++i) {
+    AppendOp(block, "sgd",
+             {{"Param", {w(i)}},
+              {"Grad", {GradVarName(w(i))}},
+              {"LearningRate", {"learning_rate"}}},
+             {{"ParamOut", {w(i)}}}, {}, OpRole::kOptimize,
+             {w(i), GradVarName(w(i))});
+  }
+  return program;
+}
+
+static void FillTensor(Scope *scope, const std::string &name,
+                       const std::vector<int64_t> &shape,
+                       const std::function<float(int64_t)> &value) {
+  auto *t = scope->Var(name)->GetMutable<LoDTensor>();
+  float *data =
+      t->mutable_data<float>(make_ddim(shape), platform::CPUPlace());
+  for (int64_t i = 0; i < t->numel(); ++i) {
+    data[i] = value(i);
+  }
+}
+
+// Train the model by the trainer for the steps, and return the losses. The
+// params trained are checked to be the same on all the trainers.
+static std::vector<float> Train(const ProgramDesc &program,
+                                const std::vector<int64_t> &widths,
+                                int64_t batch_size, int trainer_id,
+                                const std::vector<std::string> &endpoints,
+                                double bucket_size_in_MB, int num_steps,
+                                int *num_fused_all_reduces) {
+  BuildStrategy build_strategy;
+  build_strategy.num_trainers_ = endpoints.size();
+  build_strategy.trainer_id_ = trainer_id;
+  build_strategy.trainers_endpoints_ = endpoints;
+  build_strategy.enable_inplace_ = false;
+  build_strategy.memory_optimize_ = false;
+  if (bucket_size_in_MB > 0) {
+    build_strategy.cpu_grad_bucket_size_in_MB_ = bucket_size_in_MB;
+  } else {
+    build_strategy.fuse_all_reduce_ops_ = false;
+  }
+  ExecutionStrategy exec_strategy;
+  exec_strategy.use_device_ = p::kCPU;
+  exec_strategy.num_threads_ = 2;
+
+  Scope scope;
+  std::vector<std::string> params;
+  for (int64_t i = 0; i + 1 < static_cast<int64_t>(widths.size()); ++i) {
+    params.emplace_back("w" + std::to_string(i));
+    // Not the same on the trainers, broadcast from the trainer 0.
+    FillTensor(&scope, params.back(), {widths[i], widths[i + 1]},
+               [&](int64_t j) {
+                 return ((j * 7 + i) % 11 - 5) * 0.02f + trainer_id;
+               });
+  }
+  FillTensor(&scope, "learning_rate", {1}, [](int64_t) { return 0.01f; });
+
+  Graph graph(program);
+  ParallelExecutor executor({platform::CPUPlace()}, params, "loss", &scope, {},
+                            exec_strategy, build_strategy, &graph);
+  *num_fused_all_reduces = 0;
+  for (auto *node : executor.Graph().Nodes()) {
+    if (node->IsOp() && node->Name() == "fused_all_reduce") {
+      ++*num_fused_all_reduces;
+    }
+  }
+
+  std::vector<float> losses;
+  for (int step = 0; step < num_steps; ++step) {
+    LoDTensor x;
+    float *data = x.mutable_data<float>(make_ddim({batch_size, widths[0]}),
+                                        platform::CPUPlace());
+    for (int64_t i = 0; i < x.numel(); ++i) {
+      data[i] = ((i * 3 + step + trainer_id * 5) % 13) * 0.1f;
+    }
+    executor.FeedAndSplitTensorIntoLocalScopes({{"x", x}});
+    auto result = executor.Run({"loss"});
+    auto &loss = BOOST_GET(LoDTensor, BOOST_GET(FetchList, result)[0]);
+    losses.emplace_back(loss.data<float>()[0]);
+  }
+
+  // The comm of the all reduce op handles, created by the executor.
+  auto *comm = platform::CPUCommContext::Instance().Get(0);
+  for (auto &param : params) {
+    auto &t = scope.FindVar(param)->Get<LoDTensor>();
+    std::vector<float> min(t.data<float>(), t.data<float>() + t.numel());
+    std::vector<float> max = min;
+    comm->AllReduce(min.data(), min.size(), proto::VarType::FP32,
+                    platform::CPUReduceOp::kMin);
+    comm->AllReduce(max.data(), max.size(), proto::VarType::FP32,
+                    platform::CPUReduceOp::kMax);
+    EXPECT_EQ(min, max) << param << " differs among the trainers";
+  }
+  return losses;
+}
+
+// 2 trainers all reduce the grads through the CPU collective backend, packed
+// into buckets or one by one, which must train the same.
+TEST(CoalesceGradTensorPass, cpu_grad_buckets) {
+  FLAGS_eager_delete_tensor_gb = -1;
+  // The grads of w2, w1 and w0 are 64, 1024 and 512 bytes, generated in that
+  // order. The buckets of 0.0012MB hold the grads of w2 and w1, and of w0.
+  const std::vector<int64_t> widths{8, 16, 16, 1};
+  const int64_t batch_size = 4;
+  const int num_steps = 10;
+  auto program = BuildLinearModel(widths, batch_size);
+  auto endpoints = MakeEndpoints(2);
+  RunTrainers(2, [&](int trainer_id) {
+    int num_fused = 0;
+    auto losses = Train(program, widths, batch_size, trainer_id, endpoints, 0,
+                        num_steps, &num_fused);
+    EXPECT_EQ(num_fused, 0);
+    auto bucketed_losses = Train(program, widths, batch_size, trainer_id,
+                                 endpoints, 0.0012, num_steps, &num_fused);
+    EXPECT_EQ(num_fused, 2);
+    ASSERT_EQ(losses.size(), bucketed_losses.size());
+    for (size_t i = 0; i < losses.size(); ++i) {
+      EXPECT_NEAR(losses[i], bucketed_losses[i], 1e-6) << "step " << i;
+    }
+    EXPECT_NE(losses.front(), losses.back());
+  });
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
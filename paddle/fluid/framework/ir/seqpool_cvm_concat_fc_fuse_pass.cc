@@ -0,0 +1,139 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/framework/ir/seqpool_cvm_concat_fc_fuse_pass.h"
+
+#include <string>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/ir/graph_pattern_detector.h"
+#include "paddle/fluid/framework/ir/pass.h"
+#include "paddle/fluid/framework/op_version_registry.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+class Graph;
+class Node;
+
+SeqPoolCVMConcatFCFusePass::SeqPoolCVMConcatFCFusePass() {
+  AddOpCompat(OpCompat("fc"))
+      .AddInput("Input")
+      .IsTensor()
+      .End()
+      .AddInput("W")
+      .IsTensor()
+      .End()
+      .AddInput("Bias")
+      .IsTensor()
+      .End()
+      .AddOutput("Out")
+      .IsTensor()
+      .End()
+      .AddAttr("in_num_col_dims")
+      .IsNumEQ(1)
+      .End()
+      .AddAttr("activation_type")
+      .IsStringIn({"relu", ""})
+      .End();
+}
+
+void SeqPoolCVMConcatFCFusePass::ApplyImpl(ir::Graph* graph) const {
+  FusePassBase::Init(name_scope_, graph);
+
+  GraphPatternDetector gpd;
+  auto* pattern = gpd.mutable_pattern();
+  PDNode* concat_op_node =
+      pattern->NewNode("seqpool_cvm_concat_op")
+          ->assert_is_op("fusion_seqpool_cvm_concat")
+          ->assert_op_attr<bool>("use_cvm", true);
+  PDNode* concat_out_var_node =
+      pattern->NewNode("seqpool_cvm_concat_out_var")
+          ->assert_is_op_output("fusion_seqpool_cvm_concat", "Out")
+          ->assert_is_op_input("fc", "Input")
+          ->assert_has_n_outputs(1)
+          ->AsIntermediate();
+  PDNode* fc_op_node = pattern->NewNode("fc_op")->assert_is_op("fc");
+  PDNode* fc_w_var_node = pattern->NewNode("fc_w_var")
+                              ->assert_is_op_input("fc", "W")
+                              ->assert_is_persistable_var();
+  PDNode* fc_bias_var_node = pattern->NewNode("fc_bias_var")
+                                 ->assert_is_op_input("fc", "Bias")
+                                 ->assert_is_persistable_var();
+  PDNode* fc_out_var_node =
+      pattern->NewNode("fc_out_var")->assert_is_op_output("fc", "Out");
+
+  concat_op_node->LinksTo({concat_out_var_node});
+  fc_op_node->LinksFrom({concat_out_var_node, fc_w_var_node, fc_bias_var_node})
+      .LinksTo({fc_out_var_node});
+
+  int count = 0;
+  GraphPatternDetector::handle_t handler = [&](
+      const GraphPatternDetector::subgraph_t& subgraph, Graph* graph) {
+    if (!IsCompat(subgraph, graph)) {
+      LOG(WARNING) << "Pass in op compat failed.";
+      return;
+    }
+    Node* concat_op = subgraph.at(concat_op_node);
+    Node* concat_out_var = subgraph.at(concat_out_var_node);
+    Node* fc_op = subgraph.at(fc_op_node);
+    Node* fc_w_var = subgraph.at(fc_w_var_node);
+    Node* fc_bias_var = subgraph.at(fc_bias_var_node);
+    Node* fc_out_var = subgraph.at(fc_out_var_node);
+
+    // The padded weights and mkldnn fc are not supported.
+    if (fc_op->Op()->GetAttrIfExists<bool>("padding_weights") ||
+        fc_op->Op()->GetAttrIfExists<bool>("use_mkldnn")) {
+      return;
+    }
+
+    auto* concat_desc = concat_op->Op();
+    OpDesc op_desc;
+    op_desc.SetType("fusion_seqpool_cvm_concat_fc");
+    op_desc.SetInput("X", concat_desc->Input("X"));
+    op_desc.SetInput("CVM", concat_desc->Input("CVM"));
+    op_desc.SetInput("W", {fc_w_var->Name()});
+    op_desc.SetInput("Bias", {fc_bias_var->Name()});
+    op_desc.SetAttr("pooltype", concat_desc->GetAttr("pooltype"));
+    op_desc.SetAttr("use_cvm", true);
+    op_desc.SetAttr("activation_type",
+                    fc_op->Op()->GetAttr("activation_type"));
+    op_desc.SetOutput("Out", {fc_out_var->Name()});
+    auto* op = graph->CreateOpNode(&op_desc);
+
+    for (auto* in : concat_op->inputs) {
+      IR_NODE_LINK_TO(in, op);
+    }
+    IR_NODE_LINK_TO(fc_w_var, op);
+    IR_NODE_LINK_TO(fc_bias_var, op);
+    IR_NODE_LINK_TO(op, fc_out_var);
+
+    GraphSafeRemoveNodes(graph, {concat_op, concat_out_var, fc_op});
+    count++;
+  };
+  gpd(graph, handler);
+  AddStatis(count);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_PASS(seqpool_cvm_concat_fc_fuse_pass,
+              paddle::framework::ir::SeqPoolCVMConcatFCFusePass);
+REGISTER_PASS_CAPABILITY(seqpool_cvm_concat_fc_fuse_pass)
+    .AddCombination(
+        paddle::framework::compatible::OpVersionComparatorCombination().EQ(
+            "fc", 0));
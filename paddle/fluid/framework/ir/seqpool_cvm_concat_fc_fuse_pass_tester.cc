@@ -0,0 +1,176 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ir/seqpool_cvm_concat_fc_fuse_pass.h"
+#include <gtest/gtest.h>
+#include "paddle/fluid/framework/op_proto_maker.h"
+
+namespace paddle {
+namespace framework {
+namespace ir {
+
+void SetOp(ProgramDesc* prog, const std::string& type,
+           const std::vector<std::string>& inputs,
+           const std::vector<std::string>& outputs) {
+  auto* op = prog->MutableBlock(0)->AppendOp();
+  op->SetType(type);
+  if (type == "fusion_seqpool_cvm_concat") {
+    op->SetInput("X", std::vector<std::string>(inputs.begin() + 1,
+                                               inputs.end()));
+    op->SetInput("CVM", {inputs[0]});
+    op->SetAttr("pooltype", std::string("SUM"));
+    op->SetAttr("use_cvm", true);
+    op->SetAttr("axis", 1);
+    op->SetOutput("Out", {outputs[0]});
+  } else if (type == "fc") {
+    op->SetInput("Input", {inputs[0]});
+    op->SetInput("W", {inputs[1]});
+    op->SetInput("Bias", {inputs[2]});
+    op->SetAttr("in_num_col_dims", 1);
+    op->SetAttr("activation_type", std::string("relu"));
+    op->SetOutput("Out", outputs);
+  } else {
+    op->SetInput("X", inputs);
+    op->SetOutput("Out", outputs);
+  }
+  op->SetAttr(OpProtoAndCheckerMaker::OpRoleAttrName(),
+              static_cast<int>(OpRole::kForward));
+}
+
+int CountOpType(const ir::Graph* graph,
+                const std::string& op_type = "fusion_seqpool_cvm_concat_fc") {
+  int count = 0;
+  for (auto* node : graph->Nodes()) {
+    if (node->IsOp() && node->Op()->Type() == op_type) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+ProgramDesc BuildProgramDesc(const std::vector<std::string>& vars,
+                             const std::vector<std::string>& params) {
+  ProgramDesc prog;
+  for (auto& v : vars) {
+    auto* var = prog.MutableBlock(0)->Var(v);
+    var->SetType(proto::VarType::LOD_TENSOR);
+  }
+  for (auto& v : params) {
+    auto* var = prog.MutableBlock(0)->Var(v);
+    var->SetType(proto::VarType::LOD_TENSOR);
+    var->SetPersistable(true);
+  }
+  return prog;
+}
+
+std::unique_ptr<ir::Graph> ApplyPass(std::unique_ptr<ir::Graph> graph,
+                                     int* before, int* after) {
+  auto pass = PassRegistry::Instance().Get("seqpool_cvm_concat_fc_fuse_pass");
+  *before = graph->Nodes().size();
+  graph.reset(pass->Apply(graph.release()));
+  *after = graph->Nodes().size();
+  return graph;
+}
+
+/*
+ * Before fuse:
+ *    n   a   b   c
+ *     \  |   |  /
+ * fusion_seqpool_cvm_concat
+ *          |
+ *          d    w   bias
+ *           \   |   /
+ *              fc
+ *              |
+ *              e
+ *
+ * After fuse:
+ *    n   a   b   c   w   bias
+ *     \  |   |   |   |   /
+ *  fusion_seqpool_cvm_concat_fc
+ *              |
+ *              e
+ */
+TEST(SeqPoolCVMConcatFCFusePass, basic) {
+  ProgramDesc prog =
+      BuildProgramDesc({"a", "b", "c", "d", "e", "n"}, {"w", "bias"});
+  SetOp(&prog, "fusion_seqpool_cvm_concat",
+        std::vector<std::string>({"n", "a", "b", "c"}),
+        std::vector<std::string>({"d"}));
+  SetOp(&prog, "fc", std::vector<std::string>({"d", "w", "bias"}),
+        std::vector<std::string>({"e"}));
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+  int before, after;
+  graph = ApplyPass(std::move(graph), &before, &after);
+  // Remove 3 Nodes: fusion_seqpool_cvm_concat, d, fc
+  // Add 1 Node: fusion_seqpool_cvm_concat_fc
+  EXPECT_EQ(after, before - 2);
+  EXPECT_EQ(CountOpType(graph.get()), 1);
+  EXPECT_EQ(CountOpType(graph.get(), "fc"), 0);
+}
+
+/*
+ * The output of fusion_seqpool_cvm_concat is also used by op2, so it should
+ * be kept.
+ *    n   a   b
+ *     \  |  /
+ * fusion_seqpool_cvm_concat
+ *          |
+ *          d    w   bias
+ *        /  \   |   /
+ *      op2     fc
+ *       |      |
+ *       f      e
+ */
+TEST(SeqPoolCVMConcatFCFusePass, shared_output) {
+  ProgramDesc prog =
+      BuildProgramDesc({"a", "b", "d", "e", "f", "n"}, {"w", "bias"});
+  SetOp(&prog, "fusion_seqpool_cvm_concat",
+        std::vector<std::string>({"n", "a", "b"}),
+        std::vector<std::string>({"d"}));
+  SetOp(&prog, "fc", std::vector<std::string>({"d", "w", "bias"}),
+        std::vector<std::string>({"e"}));
+  SetOp(&prog, "op2", std::vector<std::string>({"d"}),
+        std::vector<std::string>({"f"}));
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+  int before, after;
+  graph = ApplyPass(std::move(graph), &before, &after);
+  EXPECT_EQ(after, before);
+  EXPECT_EQ(CountOpType(graph.get()), 0);
+}
+
+// the weight of fc is not a parameter
+TEST(SeqPoolCVMConcatFCFusePass, non_persistable_weight) {
+  ProgramDesc prog =
+      BuildProgramDesc({"a", "b", "d", "e", "n", "w"}, {"bias"});
+  SetOp(&prog, "fusion_seqpool_cvm_concat",
+        std::vector<std::string>({"n", "a", "b"}),
+        std::vector<std::string>({"d"}));
+  SetOp(&prog, "fc", std::vector<std::string>({"d", "w", "bias"}),
+        std::vector<std::string>({"e"}));
+
+  std::unique_ptr<ir::Graph> graph(new ir::Graph(prog));
+  int before, after;
+  graph = ApplyPass(std::move(graph), &before, &after);
+  EXPECT_EQ(after, before);
+  EXPECT_EQ(CountOpType(graph.get()), 0);
+}
+
+}  // namespace ir
+}  // namespace framework
+}  // namespace paddle
+
+USE_PASS(seqpool_cvm_concat_fc_fuse_pass);
@@ -0,0 +1,299 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/mmap_params.h"
+
+#include <string.h>
+#include <fstream>
+#include <utility>
+
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/memory/malloc.h"
+#ifndef _WIN32
+#include "paddle/fluid/memory/allocation/mmap_allocator.h"
+#endif
+
+namespace paddle {
+namespace framework {
+
+static constexpr char kMagic[8] = {'P', 'D', 'M', 'M', 'A', 'P', 'P', 'S'};
+static constexpr uint32_t kVersion = 1;
+
+struct MmapParamsHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t alignment;
+  uint64_t num_tensors;
+  uint64_t index_offset;
+  uint64_t index_size;
+};
+
+static uint64_t AlignUp(uint64_t offset) {
+  return (offset + kMmapParamsAlignment - 1) / kMmapParamsAlignment *
+         kMmapParamsAlignment;
+}
+
+bool IsMmapParamsFile(const std::string& path) {
+  std::ifstream fin(path, std::ios::binary);
+  char magic[sizeof(kMagic)];
+  fin.read(magic, sizeof(magic));
+  return fin && memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+bool IsMmapParamsBuffer(const std::string& buffer) {
+  return buffer.size() >= sizeof(kMagic) &&
+         memcmp(buffer.data(), kMagic, sizeof(kMagic)) == 0;
+}
+
+template <typename T>
+static void WritePod(std::ostream& os, const T& value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+static void WritePadding(std::ostream& os, uint64_t* offset) {
+  static const char zeros[kMmapParamsAlignment] = {0};
+  uint64_t aligned = AlignUp(*offset);
+  os.write(zeros, static_cast<std::streamsize>(aligned - *offset));
+  *offset = aligned;
+}
+
+void SerializeMmapParams(std::ostream& os,
+                         const std::vector<std::string>& names,
+                         const std::vector<const LoDTensor*>& tensors,
+                         const platform::DeviceContext& dev_ctx) {
+  PADDLE_ENFORCE_EQ(names.size(), tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of names (%d) and tensors (%d) to save "
+                        "should be equal.",
+                        names.size(), tensors.size()));
+  MmapParamsHeader header;
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.alignment = kMmapParamsAlignment;
+  header.num_tensors = tensors.size();
+  header.index_offset = 0;
+  header.index_size = 0;
+  // The index is written after the data, and the header is written again
+  // once the offset of the index is known, if the stream can seek.
+  auto begin = os.tellp();
+  WritePod(os, header);
+  uint64_t offset = sizeof(header);
+
+  std::ostringstream index;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const LoDTensor* tensor = tensors[i];
+    LoDTensor cpu_tensor;
+    if (!platform::is_cpu_place(tensor->place())) {
+      TensorCopy(*tensor, platform::CPUPlace(), dev_ctx, &cpu_tensor);
+      dev_ctx.Wait();
+      tensor = &cpu_tensor;
+    }
+    WritePadding(os, &offset);
+    uint64_t size = tensor->numel() * SizeOfType(tensor->type());
+    if (size > 0) {
+      os.write(static_cast<const char*>(tensor->data<void>()),
+               static_cast<std::streamsize>(size));
+    }
+
+    WritePod(index, static_cast<uint32_t>(names[i].size()));
+    index.write(names[i].data(), names[i].size());
+    WritePod(index, static_cast<int32_t>(tensor->type()));
+    auto dims = vectorize(tensor->dims());
+    WritePod(index, static_cast<uint32_t>(dims.size()));
+    for (auto dim : dims) {
+      WritePod(index, dim);
+    }
+    auto& lod = tensors[i]->lod();
+    WritePod(index, static_cast<uint64_t>(lod.size()));
+    for (auto& level : lod) {
+      WritePod(index, static_cast<uint64_t>(level.size()));
+      for (auto value : level) {
+        WritePod(index, static_cast<uint64_t>(value));
+      }
+    }
+    WritePod(index, offset);
+    WritePod(index, size);
+    offset += size;
+  }
+  WritePadding(os, &offset);
+  std::string index_str = index.str();
+  os.write(index_str.data(), index_str.size());
+
+  header.index_offset = offset;
+  header.index_size = index_str.size();
+  auto end = os.tellp();
+  os.seekp(begin);
+  WritePod(os, header);
+  os.seekp(end);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(os), true,
+                    platform::errors::Unavailable(
+                        "Failed to write the parameters in mmap format."));
+}
+
+// A tensor in the buffer of the parameters, which keeps the buffer alive.
+class MmapParamsAllocation : public memory::Allocation {
+ public:
+  MmapParamsAllocation(std::shared_ptr<memory::Allocation> buffer,
+                       size_t offset, size_t size)
+      : Allocation(static_cast<uint8_t*>(buffer->ptr()) + offset, size,
+                   buffer->place()),
+        buffer_(std::move(buffer)) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> buffer_;
+};
+
+class MmapParamsReader {
+ public:
+  MmapParamsReader(const uint8_t* data, uint64_t size)
+      : data_(data), size_(size) {}
+
+  template <typename T>
+  T Read() {
+    T value;
+    memcpy(&value, Consume(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  std::string ReadString(uint64_t size) {
+    return std::string(reinterpret_cast<const char*>(Consume(size)), size);
+  }
+
+ private:
+  const uint8_t* Consume(uint64_t size) {
+    PADDLE_ENFORCE_LE(size, size_ - pos_,
+                      platform::errors::InvalidArgument(
+                          "The parameter file in mmap format is truncated or "
+                          "damaged."));
+    const uint8_t* ptr = data_ + pos_;
+    pos_ += size;
+    return ptr;
+  }
+
+  const uint8_t* data_;
+  uint64_t size_;
+  uint64_t pos_{0};
+};
+
+struct MmapParamsEntry {
+  std::string name;
+  proto::VarType::Type type;
+  DDim dims;
+  LoD lod;
+  uint64_t offset;
+  uint64_t size;
+};
+
+void LoadMmapParams(std::shared_ptr<memory::Allocation> buffer,
+                    const std::vector<LoDTensor*>& tensors,
+                    const platform::Place& place) {
+  const uint8_t* data = static_cast<const uint8_t*>(buffer->ptr());
+  uint64_t size = buffer->size();
+  MmapParamsReader reader(data, size);
+  auto header = reader.Read<MmapParamsHeader>();
+  PADDLE_ENFORCE_EQ(memcmp(header.magic, kMagic, sizeof(kMagic)), 0,
+                    platform::errors::InvalidArgument(
+                        "The parameter file is not in mmap format."));
+  PADDLE_ENFORCE_EQ(header.version, kVersion,
+                    platform::errors::InvalidArgument(
+                        "The version %u of the parameter file in mmap format "
+                        "is not supported.",
+                        header.version));
+  PADDLE_ENFORCE_EQ(
+      header.index_offset <= size &&
+          header.index_size <= size - header.index_offset,
+      true, platform::errors::InvalidArgument(
+                "The parameter file in mmap format is truncated or damaged."));
+  PADDLE_ENFORCE_EQ(header.num_tensors, tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The parameter file in mmap format has %d tensors, but "
+                        "%d tensors are to be loaded. Not allowed to load "
+                        "partial data.",
+                        header.num_tensors, tensors.size()));
+
+  std::vector<MmapParamsEntry> entries(header.num_tensors);
+  MmapParamsReader index(data + header.index_offset, header.index_size);
+  for (auto& entry : entries) {
+    entry.name = index.ReadString(index.Read<uint32_t>());
+    entry.type = static_cast<proto::VarType::Type>(index.Read<int32_t>());
+    std::vector<int64_t> dims(index.Read<uint32_t>());
+    for (auto& dim : dims) {
+      dim = index.Read<int64_t>();
+    }
+    entry.dims = make_ddim(dims);
+    entry.lod.resize(index.Read<uint64_t>());
+    for (auto& level : entry.lod) {
+      level.resize(index.Read<uint64_t>());
+      for (auto& value : level) {
+        value = static_cast<size_t>(index.Read<uint64_t>());
+      }
+    }
+    entry.offset = index.Read<uint64_t>();
+    entry.size = index.Read<uint64_t>();
+    PADDLE_ENFORCE_EQ(
+        entry.offset <= size && entry.size <= size - entry.offset &&
+            static_cast<uint64_t>(product(entry.dims)) *
+                    SizeOfType(entry.type) ==
+                entry.size,
+        true, platform::errors::InvalidArgument(
+                  "The tensor %s in the parameter file in mmap format is "
+                  "damaged.",
+                  entry.name));
+  }
+
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto& entry = entries[i];
+    VLOG(4) << "loading tensor " << entry.name << " in mmap format";
+    LoDTensor* tensor = tensors[i];
+    std::shared_ptr<memory::Allocation> holder =
+        std::make_shared<MmapParamsAllocation>(buffer, entry.offset,
+                                               entry.size);
+    if (platform::is_cpu_place(place)) {
+      tensor->clear();
+      tensor->Resize(entry.dims);
+      tensor->ResetHolderWithType(holder, entry.type);
+    } else {
+      LoDTensor cpu_tensor;
+      cpu_tensor.Resize(entry.dims);
+      cpu_tensor.ResetHolderWithType(holder, entry.type);
+      TensorCopySync(cpu_tensor, place, tensor);
+    }
+    tensor->set_lod(entry.lod);
+  }
+}
+
+void LoadMmapParams(const std::string& path,
+                    const std::vector<LoDTensor*>& tensors,
+                    const platform::Place& place) {
+#ifndef _WIN32
+  std::shared_ptr<memory::Allocation> buffer =
+      memory::allocation::AllocateMemoryMapFileAllocation(path);
+#else
+  // There is no mmap on Windows, read the whole file into one buffer, which
+  // still saves the copies of deserializing the tensors one by one.
+  std::ifstream fin(path, std::ios::binary | std::ios::ate);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::Unavailable("Cannot open %s.", path));
+  size_t size = static_cast<size_t>(fin.tellg());
+  std::shared_ptr<memory::Allocation> buffer =
+      memory::AllocShared(platform::CPUPlace(), size);
+  fin.seekg(0);
+  fin.read(static_cast<char*>(buffer->ptr()), size);
+#endif
+  LoadMmapParams(buffer, tensors, place);
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,67 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/memory/allocation/allocator.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+
+/*
+ * The parameter file which can be mapped into memory, so the loaded CPU
+ * tensors share the pages of the file instead of copying them:
+ *
+ *   header | the data of the tensors, aligned | the index
+ *
+ * The header has the magic, the version, the alignment, the number of the
+ * tensors and the offset and size of the index. The index has the name, data
+ * type, dims and LoD of every tensor, and the offset and size of its data.
+ */
+constexpr size_t kMmapParamsAlignment = 64;
+
+// Whether the file or the buffer starts with the magic of the format.
+bool IsMmapParamsFile(const std::string& path);
+bool IsMmapParamsBuffer(const std::string& buffer);
+
+// Write the tensors in the format, the names are kept in the index. The
+// tensors on devices are copied to CPU first.
+void SerializeMmapParams(std::ostream& os,
+                         const std::vector<std::string>& names,
+                         const std::vector<const LoDTensor*>& tensors,
+                         const platform::DeviceContext& dev_ctx);
+
+// Load all the tensors in the file in order, like load_combine. The CPU
+// tensors share the memory of the mapped file, which is unmapped once all of
+// them are released. The tensors on the other places are copied from it.
+void LoadMmapParams(const std::string& path,
+                    const std::vector<LoDTensor*>& tensors,
+                    const platform::Place& place);
+
+// Load the tensors from a buffer in the format, e.g. a mapped file or the
+// model in memory. The buffer is kept alive by the CPU tensors.
+void LoadMmapParams(std::shared_ptr<memory::Allocation> buffer,
+                    const std::vector<LoDTensor*>& tensors,
+                    const platform::Place& place);
+
+}  // namespace framework
+}  // namespace paddle
@@ -13,10 +13,12 @@
 // limitations under the License.
 
 #include "paddle/fluid/framework/naive_executor.h"
+#include <sstream>
 #include <string>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/variable_helper.h"
 #include "paddle/fluid/platform/denormal.h"
+#include "paddle/fluid/platform/metrics.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
 #endif
@@ -33,6 +35,25 @@ void NaiveExecutor::Prepare(Scope *scope, const ProgramDesc &program_desc,
 
   VLOG(3) << "NaiveExecutor init with scope " << scope;
   CreateOps(program_desc, block_id, with_feed_fetch_ops);
+  for (auto *var : program_desc.Block(block_id).AllVars()) {
+    var_names_.Intern(var->Name());
+  }
+  for (auto &op : ops_) {
+    op->BindVarSlots(&var_names_);
+  }
+  slots_.reset(new SlotScope(&var_names_, scope_));
+}
+
+platform::MetricHistogram *NaiveExecutor::RunMetric() {
+  if (run_metric_ == nullptr) {
+    std::ostringstream place;
+    place << place_;
+    run_metric_ = platform::MetricsRegistry::Instance().GetHistogram(
+        "paddle_naive_executor_run_seconds",
+        "The run time of the whole program by the NaiveExecutor.",
+        {{"place", place.str()}});
+  }
+  return run_metric_;
 }
 
 void NaiveExecutor::Run() {
@@ -40,11 +61,14 @@ void NaiveExecutor::Run() {
   platform::AttachPointerHashToMKLDNNKey(this, place_);
 #endif
   platform::ScopedFlushDenormal flush;
+  platform::MetricTimer metric_timer(
+      UNLIKELY(FLAGS_enable_op_metrics) ? RunMetric() : nullptr);
   for (auto &op : ops_) {
     VLOG(4) << std::this_thread::get_id() << " run "
             << op->DebugStringEx(scope_) << " on scope " << scope_;
     op->SetIsCalledByExecutor(false);
-    op->Run(*scope_, place_);
+    slots_->Sync();
+    op->Run(*slots_, place_);
   }
 }
 
@@ -21,6 +21,7 @@
 #include "paddle/fluid/framework/operator.h"
 #include "paddle/fluid/framework/program_desc.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/scope_slots.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -68,10 +69,20 @@ class NaiveExecutor {
                  bool with_feed_fetch_ops);
 
  private:
+  // The histogram of the run time of the whole program, only used when
+  // FLAGS_enable_op_metrics is set.
+  platform::MetricHistogram* RunMetric();
+
   const platform::Place place_;
   // Catch the required resource to avoid recreate.
   std::vector<std::unique_ptr<OperatorBase>> ops_;
   Scope* scope_;
+  // The interned variable names of the ops, and the variables of scope_
+  // indexed by them.
+  VarNameTable var_names_;
+  std::unique_ptr<SlotScope> slots_;
+  // Looked up at the first run with FLAGS_enable_op_metrics set.
+  platform::MetricHistogram* run_metric_ = nullptr;
 };
 
 }  // namespace framework
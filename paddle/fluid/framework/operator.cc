@@ -28,6 +28,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/unused_var_check.h"
 #include "paddle/fluid/framework/var_type.h"
 #include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/metrics.h"
 #include "paddle/fluid/platform/profiler.h"
 
 namespace paddle {
@@ -46,6 +47,7 @@ class LoDTensor;
 DECLARE_bool(benchmark);
 DECLARE_bool(check_nan_inf);
 DECLARE_bool(enable_unused_var_check);
+DECLARE_bool(enable_infer_shape_cache);
 DEFINE_int32(inner_op_parallelism, 0, "number of threads for inner op");
 
 namespace paddle {
@@ -186,7 +188,38 @@ RuntimeContext::RuntimeContext(const VariableNameMap& innames,
   }
 }
 
+RuntimeContext::RuntimeContext(const OpVarSlots& var_slots,
+                               const SlotScope& scope) {
+  for (auto& item : var_slots.inputs) {
+    std::vector<Variable*>& input_vars = inputs[item.first];
+    input_vars.reserve(item.second.size());
+    for (int id : item.second) {
+      input_vars.push_back(scope.Var(id));
+    }
+  }
+  for (auto& item : var_slots.outputs) {
+    std::vector<Variable*>& output_vars = outputs[item.first];
+    output_vars.reserve(item.second.size());
+    for (int id : item.second) {
+      output_vars.push_back(scope.Var(id));
+    }
+  }
+}
+
 void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
+  RunInternal(scope, place, nullptr);
+}
+
+void OperatorBase::Run(const SlotScope& scope, const platform::Place& place) {
+  RunInternal(*scope.scope(), place, &scope);
+}
+
+void OperatorBase::BindVarSlots(VarNameTable* table) {
+  var_slots_.reset(new OpVarSlots(inputs_, outputs_, table));
+}
+
+void OperatorBase::RunInternal(const Scope& scope, const platform::Place& place,
+                               const SlotScope* slots) {
   try {
     VLOG(4) << place << " " << DebugStringEx(&scope);
     if (platform::is_gpu_place(place)) {
@@ -229,7 +262,11 @@ void OperatorBase::Run(const Scope& scope, const platform::Place& place) {
       auto op_name = platform::OpName(outputs_, Type());
       platform::RecordEvent op_name_record_event(
           op_name, platform::EventRole::kUniqueOp);
-      RunImpl(scope, place);
+      if (slots != nullptr) {
+        RunSlotsImpl(*slots, place);
+      } else {
+        RunImpl(scope, place);
+      }
     }
 
     VLOG(3) << GetExecutionPlace(place) << " " << DebugStringEx(&scope);
@@ -1072,8 +1109,7 @@ void OperatorWithKernel::RuntimeInferShape(const Scope& scope,
   this->InferShape(&infer_shape_ctx);
 }
 
-void OperatorWithKernel::RunImpl(const Scope& scope,
-                                 const platform::Place& place) const {
+void OperatorWithKernel::CheckRunAttrs() const {
   // To reduce the elapsed time of HasAttr, we use bool variable to record the
   // result of HasAttr.
   if (!enable_cache_runtime_context_ && HasAttr(kEnableCacheRuntimeContext))
@@ -1081,6 +1117,26 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (!all_kernels_must_compute_runtime_shape_ &&
       HasAttr(kAllKernelsMustComputeRuntimeShape))
     all_kernels_must_compute_runtime_shape_ = true;
+}
+
+void OperatorWithKernel::RunSlotsImpl(const SlotScope& slots,
+                                      const platform::Place& place) const {
+  CheckRunAttrs();
+  // The cached RuntimeContext is already free of lookups, and the slots of
+  // another table can not be used.
+  if (enable_cache_runtime_context_ || var_slots_ == nullptr ||
+      var_slots_->table != slots.table()) {
+    RunImpl(*slots.scope(), place);
+    return;
+  }
+  RuntimeContext ctx(*var_slots_, slots);
+  RunImpl(*slots.scope(), place, &ctx);
+  pre_scope_ = slots.scope();
+}
+
+void OperatorWithKernel::RunImpl(const Scope& scope,
+                                 const platform::Place& place) const {
+  CheckRunAttrs();
   const Scope* cur_scope = &scope;
   if (!enable_cache_runtime_context_) {
     RuntimeContext ctx(Inputs(), Outputs(), scope);
@@ -1107,6 +1163,22 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (kernel_type_.get() == nullptr || kernel_func_.get() == nullptr) {
     ChooseKernel(*runtime_ctx, scope, place);
   }
+  platform::MetricTimer metric_timer(
+      UNLIKELY(FLAGS_enable_op_metrics) ? RunMetric() : nullptr);
+
+  // Look up the cached InferShape and transfer decision by the signature of
+  // the inputs, before the inputs are replaced by PrepareData.
+  InferShapeCache* infer_shape_cache = nullptr;
+  std::shared_ptr<const InferShapeCache::Entry> cached_infer_shape;
+  thread_local std::vector<int64_t> input_signature;
+  if (FLAGS_enable_infer_shape_cache &&
+      !all_kernels_must_compute_runtime_shape_) {
+    infer_shape_cache = GetInferShapeCache();
+    if (infer_shape_cache) {
+      cached_infer_shape =
+          infer_shape_cache->Lookup(runtime_ctx->inputs, &input_signature);
+    }
+  }
 
   // do data transformScope &transfer_scope;
   std::vector<std::string> transfered_inplace_vars;
@@ -1114,7 +1186,8 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   {
     platform::RecordEvent record_event("prepare_data",
                                        platform::EventRole::kInnerOp);
-    if (need_prepare_data_) {
+    if (need_prepare_data_ &&
+        !(cached_infer_shape && !cached_infer_shape->need_transfer)) {
       transfer_scope = PrepareData(scope, *kernel_type_,
                                    &transfered_inplace_vars, runtime_ctx);
     }
@@ -1130,8 +1203,16 @@ void OperatorWithKernel::RunImpl(const Scope& scope,
   if (!all_kernels_must_compute_runtime_shape_) {
     platform::RecordEvent record_event("infer_shape",
                                        platform::EventRole::kInnerOp);
-    RuntimeInferShapeContext infer_shape_ctx(*this, *runtime_ctx);
-    this->InferShape(&infer_shape_ctx);
+    if (!(cached_infer_shape &&
+          infer_shape_cache->SetOutputDims(*cached_infer_shape,
+                                           runtime_ctx->outputs))) {
+      RuntimeInferShapeContext infer_shape_ctx(*this, *runtime_ctx);
+      this->InferShape(&infer_shape_ctx);
+      if (infer_shape_cache && !cached_infer_shape) {
+        infer_shape_cache->Update(input_signature, transfer_scope != nullptr,
+                                  runtime_ctx->outputs);
+      }
+    }
   }
 
   if (FLAGS_enable_unused_var_check) {
@@ -1284,6 +1365,47 @@ void OperatorWithKernel::ChooseKernel(const RuntimeContext& ctx,
   }
 }
 
+platform::MetricHistogram* OperatorWithKernel::RunMetric() const {
+  auto* metric = run_metric_.load(std::memory_order_acquire);
+  if (metric == nullptr) {
+    std::ostringstream place;
+    place << kernel_type_->place_;
+    metric = platform::MetricsRegistry::Instance().GetHistogram(
+        "paddle_op_run_seconds",
+        "The run time of the operators, including data transform and "
+        "InferShape. The time of the asynchronous device kernels is the "
+        "launch time.",
+        {{"op_type", type_},
+         {"kernel", DataTypeToString(kernel_type_->data_type_) + ":" +
+                        DataLayoutToString(kernel_type_->data_layout_) + ":" +
+                        LibraryTypeToString(kernel_type_->library_type_)},
+         {"place", place.str()}});
+    run_metric_.store(metric, std::memory_order_release);
+  }
+  return metric;
+}
+
+InferShapeCache* OperatorWithKernel::GetInferShapeCache() const {
+  if (!infer_shape_cache_checked_.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(cache_update_mutex_);
+    if (!infer_shape_cache_checked_.load(std::memory_order_relaxed)) {
+      // The MKLDNN kernels may change the shapes by the layout of the thread,
+      // and the ops behind conditional branch must always prepare data.
+      bool cacheable =
+          kernel_type_->library_type_ != LibraryType::kMKLDNN &&
+          kernel_type_->data_layout_ != DataLayout::kMKLDNN &&
+          !(HasAttr("inference_force_prepare_data") &&
+            Attr<bool>("inference_force_prepare_data"));
+      if (cacheable) {
+        infer_shape_cache_.reset(new InferShapeCache(type_));
+      }
+      infer_shape_cache_checked_.store(true, std::memory_order_release);
+    }
+  }
+  auto* cache = infer_shape_cache_.get();
+  return cache && cache->Enabled() ? cache : nullptr;
+}
+
 void OperatorWithKernel::TransferInplaceVarsBack(
     const Scope& scope, const std::vector<std::string>& inplace_vars,
     const Scope& transfer_scope) const {
@@ -27,10 +27,12 @@ limitations under the License. */
 #include "glog/logging.h"  // For VLOG
 #include "paddle/fluid/framework/attribute.h"
 #include "paddle/fluid/framework/block_desc.h"
+#include "paddle/fluid/framework/infer_shape_cache.h"
 #include "paddle/fluid/framework/lod_tensor.h"
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_kernel_type.h"
 #include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/scope_slots.h"
 #include "paddle/fluid/framework/selected_rows.h"
 #include "paddle/fluid/framework/tensor.h"
 #include "paddle/fluid/framework/unused_var_check.h"
@@ -45,6 +47,9 @@ class OpInfo;
 class Scope;
 class Variable;
 }  // namespace framework
+namespace platform {
+class MetricHistogram;
+}  // namespace platform
 }  // namespace paddle
 
 DECLARE_int32(inner_op_parallelism);
@@ -121,6 +126,9 @@ class RuntimeContext {
   RuntimeContext(const VariableNameMap& innames,
                  const VariableNameMap& outnames, const Scope& scope);
 
+  // Look up the variables by the interned ids instead of the names.
+  RuntimeContext(const OpVarSlots& var_slots, const SlotScope& scope);
+
   RuntimeContext(const VariableValueMap& invars,
                  const VariableValueMap& outvars)
       : inputs(invars), outputs(outvars) {}
@@ -146,6 +154,15 @@ class OperatorBase {
   //  The implementation should be written at RunImpl
   void Run(const Scope& scope, const platform::Place& place);
 
+  /// Intern the inputs and outputs in the name table of the prepared program,
+  /// so the op can be run on a SlotScope of the table.
+  void BindVarSlots(VarNameTable* table);
+  const OpVarSlots* VarSlots() const { return var_slots_.get(); }
+
+  /// Run the op on the scope of the slots. The ops with kernels look up their
+  /// inputs and outputs in the slots, the others use the string API.
+  void Run(const SlotScope& scope, const platform::Place& place);
+
   // FIXME(typhoonzero): this is only used for recv_op to stop event_loop.
   virtual void Stop() {}
 
@@ -233,11 +250,20 @@ class OperatorBase {
   // Whether this operator executes in an Executor.
   bool run_by_executor_{true};
 
+  // The ids of the inputs and outputs, set by BindVarSlots.
+  std::unique_ptr<OpVarSlots> var_slots_;
+
  private:
   void GenerateTemporaryNames();
   void CheckAllInputOutputSet() const;
+  void RunInternal(const Scope& scope, const platform::Place& place,
+                   const SlotScope* slots);
   virtual void RunImpl(const Scope& scope,
                        const platform::Place& place) const = 0;
+  virtual void RunSlotsImpl(const SlotScope& slots,
+                            const platform::Place& place) const {
+    RunImpl(*slots.scope(), place);
+  }
 };
 
 class ExecutionContext {
@@ -528,10 +554,18 @@ class OperatorWithKernel : public OperatorBase {
     return kernel_type_->place_;
   }
 
+  // The cache of the runtime InferShape of this op, nullptr if the op can not
+  // be cached or the cache is disabled for the low hit rate. It is only valid
+  // after the kernel is chosen.
+  InferShapeCache* GetInferShapeCache() const;
+
  private:
   void RunImpl(const Scope& scope, const platform::Place& place) const final;
+  void RunSlotsImpl(const SlotScope& slots,
+                    const platform::Place& place) const final;
   void RunImpl(const Scope& scope, const platform::Place& place,
                RuntimeContext* runtime_ctx) const;
+  void CheckRunAttrs() const;
 
   /**
    * Transfer data from scope to a transferred scope. If there is no data need
@@ -565,6 +599,9 @@ class OperatorWithKernel : public OperatorBase {
   // used for IndicateOrPromoteVarDataTypes
   Tensor* GetTensorFormInputSafely(const ExecutionContext& ctx,
                                    const std::string& name) const;
+  // The histogram of the run time of this op type with the chosen kernel,
+  // only used when FLAGS_enable_op_metrics is set.
+  platform::MetricHistogram* RunMetric() const;
 
  protected:
   mutable std::unique_ptr<OpKernelType> kernel_type_;
@@ -576,6 +613,10 @@ class OperatorWithKernel : public OperatorBase {
   mutable bool all_kernels_must_compute_runtime_shape_ = false;
   mutable std::mutex cache_update_mutex_;
   mutable bool enable_cache_transfer_scope_ = false;
+  mutable std::atomic<platform::MetricHistogram*> run_metric_{nullptr};
+  mutable std::unique_ptr<InferShapeCache> infer_shape_cache_;
+  // Published after infer_shape_cache_ is set, for the lock-free check.
+  mutable std::atomic<bool> infer_shape_cache_checked_{false};
 };
 
 extern bool OpSupportGPU(const std::string& op_type);
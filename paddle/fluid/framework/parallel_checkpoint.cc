@@ -0,0 +1,499 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/parallel_checkpoint.h"
+
+#include <stdio.h>
+#include <xxhash.h>
+#include <zlib.h>
+#include <algorithm>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "paddle/fluid/framework/checkpoint.pb.h"
+#include "paddle/fluid/framework/data_type.h"
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/framework/threadpool.h"
+#include "paddle/fluid/platform/port.h"
+
+namespace paddle {
+namespace framework {
+
+static constexpr uint32_t kCheckpointVersion = 1;
+static const char kManifestName[] = "manifest";
+
+static std::string JoinPath(const std::string& dir, const std::string& name) {
+  return dir + kSEP + name;
+}
+
+static uint64_t Checksum(const char* data, size_t size) {
+  return size > 0 ? XXH64(data, size, 0) : 0;
+}
+
+static void ReadManifest(const std::string& path,
+                         CheckpointManifest* manifest) {
+  std::ifstream fin(path, std::ios::binary);
+  PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                    platform::errors::NotFound(
+                        "Cannot open the manifest %s of the checkpoint.",
+                        path));
+  std::string content((std::istreambuf_iterator<char>(fin)),
+                      std::istreambuf_iterator<char>());
+  PADDLE_ENFORCE_EQ(manifest->ParseFromString(content), true,
+                    platform::errors::InvalidArgument(
+                        "Failed to parse the manifest %s of the checkpoint.",
+                        path));
+  PADDLE_ENFORCE_EQ(manifest->version(), kCheckpointVersion,
+                    platform::errors::InvalidArgument(
+                        "The version %u of the checkpoint %s is not supported.",
+                        manifest->version(), path));
+}
+
+// Write the manifest to a temporary file and rename it, so the directory
+// always has a complete manifest.
+static void WriteManifest(const std::string& dir,
+                          const CheckpointManifest& manifest) {
+  std::string path = JoinPath(dir, kManifestName);
+  std::string tmp_path = path + ".tmp";
+  {
+    std::string content;
+    manifest.SerializeToString(&content);
+    std::ofstream fout(tmp_path, std::ios::binary | std::ios::trunc);
+    fout.write(content.data(), content.size());
+    fout.close();
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                      platform::errors::Unavailable(
+                          "Failed to write the manifest %s.", tmp_path));
+  }
+#ifdef _WIN32
+  remove(path.c_str());
+#endif
+  PADDLE_ENFORCE_EQ(rename(tmp_path.c_str(), path.c_str()), 0,
+                    platform::errors::Unavailable(
+                        "Failed to rename the manifest %s to %s.", tmp_path,
+                        path));
+}
+
+template <typename Callback>
+static void RunInParallel(int num_threads, int num_tasks, Callback callback) {
+  if (num_tasks == 0) return;
+  ThreadPool pool(std::min(num_threads, num_tasks));
+  std::vector<std::future<void>> futures;
+  futures.reserve(num_tasks);
+  for (int i = 0; i < num_tasks; ++i) {
+    futures.emplace_back(pool.Run([i, &callback] { callback(i); }));
+  }
+  // wait for all the tasks before throwing the error of any of them
+  for (auto& future : futures) {
+    future.wait();
+  }
+  for (auto& future : futures) {
+    future.get();
+  }
+}
+
+static void CheckOptions(const ParallelCheckpointOptions& options) {
+  PADDLE_ENFORCE_GT(options.num_threads, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of threads of a checkpoint should be "
+                        "greater than 0, but received %d.",
+                        options.num_threads));
+  PADDLE_ENFORCE_GT(options.num_files, 0,
+                    platform::errors::InvalidArgument(
+                        "The number of files of a checkpoint should be "
+                        "greater than 0, but received %d.",
+                        options.num_files));
+  PADDLE_ENFORCE_GT(options.chunk_size, 0UL,
+                    platform::errors::InvalidArgument(
+                        "The chunk size of a checkpoint should be greater "
+                        "than 0."));
+}
+
+namespace {
+
+struct ChunkToSave {
+  size_t tensor;
+  const char* data;
+  size_t size;
+  // the same chunk in the last save, if it can be reused
+  const CheckpointChunk* previous;
+};
+
+struct SavedChunk {
+  std::string file;
+  uint64_t offset{0};
+  uint64_t size{0};
+  uint64_t checksum{0};
+  bool compressed{false};
+  bool reused{false};
+};
+
+struct ChunkToLoad {
+  const CheckpointChunk* meta;
+  char* data;
+  const std::string* name;
+};
+
+}  // namespace
+
+ParallelCheckpointStats SaveParallelCheckpoint(
+    const std::string& dir, const std::vector<std::string>& names,
+    const std::vector<const LoDTensor*>& tensors,
+    const ParallelCheckpointOptions& options) {
+  PADDLE_ENFORCE_EQ(names.size(), tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of names (%d) and tensors (%d) to save "
+                        "should be equal.",
+                        names.size(), tensors.size()));
+  CheckOptions(options);
+  MkDirRecursively(dir.c_str());
+
+  CheckpointManifest previous;
+  bool has_previous = FileExists(JoinPath(dir, kManifestName));
+  if (has_previous) {
+    ReadManifest(JoinPath(dir, kManifestName), &previous);
+  }
+  std::unordered_map<std::string, const CheckpointTensor*> previous_tensors;
+  if (options.incremental && has_previous &&
+      previous.chunk_size() == options.chunk_size) {
+    for (auto& tensor : previous.tensors()) {
+      previous_tensors[tensor.name()] = &tensor;
+    }
+  }
+
+  CheckpointManifest manifest;
+  manifest.set_version(kCheckpointVersion);
+  manifest.set_generation(has_previous ? previous.generation() + 1 : 0);
+  manifest.set_chunk_size(options.chunk_size);
+
+  std::vector<LoDTensor> cpu_tensors(tensors.size());
+  std::vector<ChunkToSave> chunks;
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    const LoDTensor* tensor = tensors[i];
+    PADDLE_ENFORCE_EQ(tensor->IsInitialized(), true,
+                      platform::errors::PreconditionNotMet(
+                          "The tensor %s to save is not initialized.",
+                          names[i]));
+    if (!platform::is_cpu_place(tensor->place())) {
+      TensorCopySync(*tensor, platform::CPUPlace(), &cpu_tensors[i]);
+      tensor = &cpu_tensors[i];
+    }
+    auto* meta = manifest.add_tensors();
+    meta->set_name(names[i]);
+    meta->set_data_type(static_cast<int>(tensor->type()));
+    for (auto dim : vectorize(tensor->dims())) {
+      meta->add_dims(dim);
+    }
+    for (auto& level : tensors[i]->lod()) {
+      auto* offsets = meta->add_lod()->mutable_offsets();
+      for (auto offset : level) {
+        offsets->Add(offset);
+      }
+    }
+
+    const CheckpointTensor* prev = nullptr;
+    auto it = previous_tensors.find(names[i]);
+    if (it != previous_tensors.end() &&
+        it->second->data_type() == meta->data_type() &&
+        std::equal(meta->dims().begin(), meta->dims().end(),
+                   it->second->dims().begin(), it->second->dims().end())) {
+      prev = it->second;
+    }
+    size_t bytes = tensor->numel() * SizeOfType(tensor->type());
+    const char* data =
+        bytes > 0 ? static_cast<const char*>(tensor->data<void>()) : nullptr;
+    for (size_t offset = 0, c = 0; offset < bytes;
+         offset += options.chunk_size, ++c) {
+      chunks.push_back({i, data + offset,
+                        std::min(options.chunk_size, bytes - offset),
+                        prev ? &prev->chunks(c) : nullptr});
+    }
+  }
+
+  // Spread the chunks over the files by their bytes, each file is written in
+  // order by one thread.
+  int num_files = std::min<int>(options.num_files, chunks.size());
+  std::vector<std::vector<size_t>> files(num_files);
+  std::vector<size_t> file_bytes(num_files, 0);
+  for (size_t j = 0; j < chunks.size(); ++j) {
+    int k = std::min_element(file_bytes.begin(), file_bytes.end()) -
+            file_bytes.begin();
+    files[k].push_back(j);
+    file_bytes[k] += chunks[j].size;
+  }
+
+  std::vector<SavedChunk> saved(chunks.size());
+  std::string prefix = "data." + std::to_string(manifest.generation()) + ".";
+  RunInParallel(options.num_threads, num_files, [&](int k) {
+    std::string file = prefix + std::to_string(k);
+    std::ofstream fout;
+    uint64_t offset = 0;
+    std::string buffer;
+    for (size_t j : files[k]) {
+      auto& chunk = chunks[j];
+      auto& result = saved[j];
+      result.checksum = Checksum(chunk.data, chunk.size);
+      if (chunk.previous != nullptr &&
+          chunk.previous->raw_size() == chunk.size &&
+          chunk.previous->checksum() == result.checksum) {
+        result.file = previous.files(chunk.previous->file());
+        result.offset = chunk.previous->offset();
+        result.size = chunk.previous->size();
+        result.compressed = chunk.previous->compressed();
+        result.reused = true;
+        continue;
+      }
+
+      const char* out = chunk.data;
+      size_t out_size = chunk.size;
+      if (options.compress) {
+        uLongf compressed_size = compressBound(chunk.size);
+        buffer.resize(compressed_size);
+        int ret = compress2(reinterpret_cast<Bytef*>(&buffer[0]),
+                            &compressed_size,
+                            reinterpret_cast<const Bytef*>(chunk.data),
+                            chunk.size, Z_BEST_SPEED);
+        PADDLE_ENFORCE_EQ(ret, Z_OK,
+                          platform::errors::External(
+                              "Failed to compress the tensor %s, the zlib "
+                              "error is %d.",
+                              names[chunk.tensor], ret));
+        if (compressed_size < chunk.size) {
+          out = buffer.data();
+          out_size = compressed_size;
+          result.compressed = true;
+        }
+      }
+      if (!fout.is_open()) {
+        fout.open(JoinPath(dir, file), std::ios::binary | std::ios::trunc);
+        PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                          platform::errors::Unavailable(
+                              "Cannot open %s to write.", JoinPath(dir, file)));
+      }
+      fout.write(out, out_size);
+      result.file = file;
+      result.offset = offset;
+      result.size = out_size;
+      offset += out_size;
+    }
+    if (fout.is_open()) {
+      fout.close();
+      PADDLE_ENFORCE_EQ(static_cast<bool>(fout), true,
+                        platform::errors::Unavailable("Failed to write %s.",
+                                                      JoinPath(dir, file)));
+    }
+  });
+
+  ParallelCheckpointStats stats;
+  std::unordered_map<std::string, int> file_ids;
+  std::vector<int> num_chunks(tensors.size(), 0);
+  for (size_t j = 0; j < chunks.size(); ++j) {
+    auto& result = saved[j];
+    auto it = file_ids.find(result.file);
+    if (it == file_ids.end()) {
+      it = file_ids.emplace(result.file, manifest.files_size()).first;
+      manifest.add_files(result.file);
+    }
+    auto* chunk = manifest.mutable_tensors(chunks[j].tensor)->add_chunks();
+    chunk->set_file(it->second);
+    chunk->set_offset(result.offset);
+    chunk->set_size(result.size);
+    chunk->set_raw_size(chunks[j].size);
+    chunk->set_compressed(result.compressed);
+    chunk->set_checksum(result.checksum);
+    if (result.reused) {
+      ++stats.chunks_reused;
+    } else {
+      ++stats.chunks_written;
+      stats.bytes_written += result.size;
+    }
+  }
+  WriteManifest(dir, manifest);
+
+  // The data files of the former saves can be removed once the new manifest
+  // is in place.
+  for (auto& file : previous.files()) {
+    if (file_ids.count(file) == 0) {
+      remove(JoinPath(dir, file).c_str());
+    }
+  }
+  VLOG(3) << "Save the checkpoint " << dir << " of generation "
+          << manifest.generation() << ", " << stats.chunks_written
+          << " chunks written, " << stats.chunks_reused << " chunks reused";
+  return stats;
+}
+
+void LoadParallelCheckpoint(const std::string& dir,
+                            const std::vector<std::string>& names,
+                            const std::vector<LoDTensor*>& tensors,
+                            const ParallelCheckpointOptions& options) {
+  PADDLE_ENFORCE_EQ(names.size(), tensors.size(),
+                    platform::errors::InvalidArgument(
+                        "The number of names (%d) and tensors (%d) to load "
+                        "should be equal.",
+                        names.size(), tensors.size()));
+  CheckOptions(options);
+  CheckpointManifest manifest;
+  ReadManifest(JoinPath(dir, kManifestName), &manifest);
+  std::unordered_map<std::string, const CheckpointTensor*> metas;
+  for (auto& meta : manifest.tensors()) {
+    metas[meta.name()] = &meta;
+  }
+
+  std::vector<std::vector<ChunkToLoad>> files(manifest.files_size());
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    auto it = metas.find(names[i]);
+    PADDLE_ENFORCE_EQ(it != metas.end(), true,
+                      platform::errors::NotFound(
+                          "The tensor %s is not in the checkpoint %s.",
+                          names[i], dir));
+    const CheckpointTensor& meta = *it->second;
+    LoDTensor* tensor = tensors[i];
+    tensor->Resize(make_ddim(std::vector<int64_t>(meta.dims().begin(),
+                                                  meta.dims().end())));
+    auto type = static_cast<proto::VarType::Type>(meta.data_type());
+    char* data = static_cast<char*>(
+        tensor->mutable_data(platform::CPUPlace(), type));
+    LoD lod;
+    for (auto& level : meta.lod()) {
+      lod.emplace_back();
+      for (auto offset : level.offsets()) {
+        lod.back().push_back(offset);
+      }
+    }
+    tensor->set_lod(lod);
+
+    uint64_t bytes = tensor->numel() * SizeOfType(type);
+    uint64_t offset = 0;
+    for (auto& chunk : meta.chunks()) {
+      PADDLE_ENFORCE_EQ(
+          chunk.file() >= 0 && chunk.file() < manifest.files_size() &&
+              chunk.raw_size() <= bytes - offset,
+          true, platform::errors::InvalidArgument(
+                    "The tensor %s in the checkpoint %s is damaged.", names[i],
+                    dir));
+      files[chunk.file()].push_back({&chunk, data + offset, &names[i]});
+      offset += chunk.raw_size();
+    }
+    PADDLE_ENFORCE_EQ(offset, bytes,
+                      platform::errors::InvalidArgument(
+                          "The tensor %s in the checkpoint %s is damaged.",
+                          names[i], dir));
+  }
+
+  std::vector<int> used_files;
+  for (int k = 0; k < manifest.files_size(); ++k) {
+    if (files[k].empty()) continue;
+    used_files.push_back(k);
+    std::sort(files[k].begin(), files[k].end(),
+              [](const ChunkToLoad& a, const ChunkToLoad& b) {
+                return a.meta->offset() < b.meta->offset();
+              });
+  }
+  int num_used_files = used_files.size();
+  RunInParallel(options.num_threads, num_used_files, [&](int i) {
+    int k = used_files[i];
+    std::string path = JoinPath(dir, manifest.files(k));
+    std::ifstream fin(path, std::ios::binary);
+    PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                      platform::errors::NotFound(
+                          "Cannot open the data file %s of the checkpoint.",
+                          path));
+    std::string buffer;
+    for (auto& chunk : files[k]) {
+      auto& meta = *chunk.meta;
+      fin.seekg(meta.offset());
+      if (meta.compressed()) {
+        buffer.resize(meta.size());
+        fin.read(&buffer[0], meta.size());
+      } else {
+        PADDLE_ENFORCE_EQ(meta.size(), meta.raw_size(),
+                          platform::errors::InvalidArgument(
+                              "The tensor %s in the checkpoint %s is damaged.",
+                              *chunk.name, dir));
+        fin.read(chunk.data, meta.size());
+      }
+      PADDLE_ENFORCE_EQ(static_cast<bool>(fin), true,
+                        platform::errors::InvalidArgument(
+                            "The data file %s of the checkpoint is truncated.",
+                            path));
+      if (meta.compressed()) {
+        uLongf raw_size = meta.raw_size();
+        int ret = uncompress(reinterpret_cast<Bytef*>(chunk.data), &raw_size,
+                             reinterpret_cast<const Bytef*>(buffer.data()),
+                             buffer.size());
+        PADDLE_ENFORCE_EQ(
+            ret == Z_OK && raw_size == meta.raw_size(), true,
+            platform::errors::InvalidArgument(
+                "Failed to uncompress the tensor %s in the checkpoint %s, "
+                "the zlib error is %d.",
+                *chunk.name, dir, ret));
+      }
+      if (options.verify_checksum) {
+        PADDLE_ENFORCE_EQ(Checksum(chunk.data, meta.raw_size()),
+                          meta.checksum(),
+                          platform::errors::InvalidArgument(
+                              "The checksum of the tensor %s in the "
+                              "checkpoint %s mismatches, the checkpoint is "
+                              "damaged.",
+                              *chunk.name, dir));
+      }
+    }
+  });
+}
+
+ParallelCheckpointStats SaveParallelCheckpoint(
+    const std::string& dir, const std::vector<std::string>& names,
+    const Scope& scope, const ParallelCheckpointOptions& options) {
+  std::vector<const LoDTensor*> tensors;
+  tensors.reserve(names.size());
+  for (auto& name : names) {
+    auto* var = scope.FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound("Variable %s is not found in the "
+                                        "scope.",
+                                        name));
+    PADDLE_ENFORCE_EQ(var->IsType<LoDTensor>(), true,
+                      platform::errors::InvalidArgument(
+                          "Only LoDTensor can be saved to a checkpoint, but "
+                          "variable %s is not.",
+                          name));
+    tensors.push_back(&var->Get<LoDTensor>());
+  }
+  return SaveParallelCheckpoint(dir, names, tensors, options);
+}
+
+void LoadParallelCheckpoint(const std::string& dir,
+                            const std::vector<std::string>& names,
+                            const Scope& scope,
+                            const ParallelCheckpointOptions& options) {
+  std::vector<LoDTensor*> tensors;
+  tensors.reserve(names.size());
+  for (auto& name : names) {
+    auto* var = scope.FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound("Variable %s is not found in the "
+                                        "scope.",
+                                        name));
+    tensors.push_back(var->GetMutable<LoDTensor>());
+  }
+  LoadParallelCheckpoint(dir, names, tensors, options);
+}
+
+}  // namespace framework
+}  // namespace paddle
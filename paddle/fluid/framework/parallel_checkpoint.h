@@ -0,0 +1,88 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+
+namespace paddle {
+namespace framework {
+
+class Scope;
+
+/*
+ * A parallel checkpoint is a directory of:
+ *
+ *   manifest         the CheckpointManifest in checkpoint.proto
+ *   data.<g>.<k>     the k-th data file written by the g-th save
+ *
+ * The tensors are split into chunks, which are spread over the data files and
+ * written by a thread pool, one thread per file. Every chunk keeps the XXH64
+ * of its raw data, and may be compressed by zlib.
+ *
+ * An incremental save into the same directory only writes the chunks whose
+ * checksums have changed; the manifest refers to the unchanged chunks in the
+ * data files of the former saves. The manifest is replaced atomically, then
+ * the data files no longer referred to are removed.
+ */
+struct ParallelCheckpointOptions {
+  // The threads to write or read the data files.
+  int num_threads{8};
+  // The data files written by a save.
+  int num_files{8};
+  // The bytes of every chunk.
+  size_t chunk_size{64UL << 20};
+  // Compress the chunks with zlib at the fastest level. A chunk is stored
+  // raw if it is not smaller compressed.
+  bool compress{false};
+  // Verify the checksums of the chunks when loading.
+  bool verify_checksum{true};
+  // Only write the chunks changed since the last save into the directory.
+  bool incremental{false};
+};
+
+struct ParallelCheckpointStats {
+  uint64_t chunks_written{0};
+  uint64_t chunks_reused{0};
+  uint64_t bytes_written{0};
+};
+
+// Save the tensors to the directory. The tensors on devices are copied to CPU
+// first.
+ParallelCheckpointStats SaveParallelCheckpoint(
+    const std::string& dir, const std::vector<std::string>& names,
+    const std::vector<const LoDTensor*>& tensors,
+    const ParallelCheckpointOptions& options);
+
+// Load the tensors of the names from the directory to CPU, in parallel. The
+// checkpoint may have more tensors than the names.
+void LoadParallelCheckpoint(const std::string& dir,
+                            const std::vector<std::string>& names,
+                            const std::vector<LoDTensor*>& tensors,
+                            const ParallelCheckpointOptions& options);
+
+// Save or load the LoDTensor variables of the names in the scope.
+ParallelCheckpointStats SaveParallelCheckpoint(
+    const std::string& dir, const std::vector<std::string>& names,
+    const Scope& scope, const ParallelCheckpointOptions& options);
+void LoadParallelCheckpoint(const std::string& dir,
+                            const std::vector<std::string>& names,
+                            const Scope& scope,
+                            const ParallelCheckpointOptions& options);
+
+}  // namespace framework
+}  // namespace paddle
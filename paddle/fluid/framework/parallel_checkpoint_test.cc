@@ -0,0 +1,220 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/parallel_checkpoint.h"
+
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/scope.h"
+#include "paddle/fluid/platform/port.h"
+
+namespace paddle {
+namespace framework {
+
+static void FillTensor(LoDTensor* tensor, int64_t numel, float start) {
+  float* data = tensor->mutable_data<float>({numel}, platform::CPUPlace());
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = start + i;
+  }
+}
+
+static void ExpectEqual(const LoDTensor& a, const LoDTensor& b) {
+  ASSERT_EQ(a.type(), b.type());
+  ASSERT_EQ(a.dims(), b.dims());
+  EXPECT_EQ(a.lod(), b.lod());
+  EXPECT_EQ(memcmp(a.data<void>(), b.data<void>(),
+                   a.numel() * SizeOfType(a.type())),
+            0);
+}
+
+TEST(ParallelCheckpoint, save_load) {
+  platform::CPUPlace place;
+  LoDTensor weight, ids, empty;
+  FillTensor(&weight, 10000, 0.5f);
+  weight.Resize({100, 100});
+  weight.set_lod({{0, 30, 100}});
+  int64_t* id = ids.mutable_data<int64_t>({7}, place);
+  for (int i = 0; i < 7; ++i) id[i] = i * 100;
+  empty.mutable_data<float>({0, 4}, place);
+
+  for (bool compress : {false, true}) {
+    ParallelCheckpointOptions options;
+    options.num_threads = 3;
+    options.num_files = 4;
+    options.chunk_size = 1000;
+    options.compress = compress;
+    const std::string dir = "parallel_checkpoint_test";
+    auto stats = SaveParallelCheckpoint(dir, {"w", "ids", "empty"},
+                                        {&weight, &ids, &empty}, options);
+    EXPECT_EQ(stats.chunks_written, 41UL);
+    EXPECT_EQ(stats.chunks_reused, 0UL);
+    if (compress) {
+      EXPECT_LT(stats.bytes_written, 40056UL);
+    }
+
+    LoDTensor w_out, ids_out, empty_out;
+    LoadParallelCheckpoint(dir, {"empty", "w", "ids"},
+                           {&empty_out, &w_out, &ids_out}, options);
+    ExpectEqual(w_out, weight);
+    ExpectEqual(ids_out, ids);
+    EXPECT_EQ(empty_out.dims(), make_ddim({0, 4}));
+
+    LoDTensor missing;
+    EXPECT_THROW(LoadParallelCheckpoint(dir, {"missing"}, {&missing}, options),
+                 platform::EnforceNotMet);
+  }
+}
+
+TEST(ParallelCheckpoint, incremental) {
+  Scope scope;
+  for (int i = 0; i < 4; ++i) {
+    FillTensor(scope.Var("param_" + std::to_string(i))->GetMutable<LoDTensor>(),
+               1000, i * 1000.f);
+  }
+  std::vector<std::string> names = {"param_0", "param_1", "param_2",
+                                    "param_3"};
+  ParallelCheckpointOptions options;
+  options.chunk_size = 1000;
+  options.incremental = true;
+  const std::string dir = "parallel_checkpoint_incremental";
+  auto stats = SaveParallelCheckpoint(dir, names, scope, options);
+  EXPECT_EQ(stats.chunks_written, 16UL);
+  EXPECT_TRUE(FileExists(dir + "/data.0.0"));
+
+  // change one chunk of param_1 and resize param_3
+  scope.FindVar("param_1")->GetMutable<LoDTensor>()->data<float>()[300] = -1.f;
+  FillTensor(scope.FindVar("param_3")->GetMutable<LoDTensor>(), 500, 0.f);
+  stats = SaveParallelCheckpoint(dir, names, scope, options);
+  EXPECT_EQ(stats.chunks_written, 3UL);
+  EXPECT_EQ(stats.chunks_reused, 11UL);
+
+  Scope loaded;
+  for (auto& name : names) {
+    loaded.Var(name);
+  }
+  LoadParallelCheckpoint(dir, names, loaded, options);
+  for (auto& name : names) {
+    ExpectEqual(loaded.FindVar(name)->Get<LoDTensor>(),
+                scope.FindVar(name)->Get<LoDTensor>());
+  }
+
+  // a full save removes the data files of the former saves
+  options.incremental = false;
+  stats = SaveParallelCheckpoint(dir, names, scope, options);
+  EXPECT_EQ(stats.chunks_written, 14UL);
+  EXPECT_FALSE(FileExists(dir + "/data.0.0"));
+  EXPECT_FALSE(FileExists(dir + "/data.1.0"));
+  LoadParallelCheckpoint(dir, names, loaded, options);
+  ExpectEqual(loaded.FindVar("param_1")->Get<LoDTensor>(),
+              scope.FindVar("param_1")->Get<LoDTensor>());
+}
+
+TEST(ParallelCheckpoint, damaged) {
+  LoDTensor weight;
+  FillTensor(&weight, 1000, 0.f);
+  ParallelCheckpointOptions options;
+  options.num_files = 1;
+  const std::string dir = "parallel_checkpoint_damaged";
+  SaveParallelCheckpoint(dir, {"w"}, {&weight}, options);
+  {
+    std::fstream file(dir + "/data.0.0",
+                      std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(100);
+    file.put('x');
+  }
+  LoDTensor out;
+  EXPECT_THROW(LoadParallelCheckpoint(dir, {"w"}, {&out}, options),
+               platform::EnforceNotMet);
+  options.verify_checksum = false;
+  LoadParallelCheckpoint(dir, {"w"}, {&out}, options);
+}
+
+// The throughput to save and load 256 MB of parameters on the local disk, by
+// serializing the tensors into one stream as save_combine does and by the
+// parallel checkpoint.
+TEST(ParallelCheckpoint, benchmark) {
+  const int num_tensors = 16;
+  const int64_t numel = 4 << 20;
+  std::vector<LoDTensor> tensors(num_tensors);
+  std::vector<const LoDTensor*> inputs;
+  std::vector<std::string> names;
+  for (int i = 0; i < num_tensors; ++i) {
+    FillTensor(&tensors[i], numel, i);
+    inputs.push_back(&tensors[i]);
+    names.push_back("param_" + std::to_string(i));
+  }
+  double mb = num_tensors * numel * sizeof(float) / 1048576.0;
+  auto elapsed_s = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+  };
+  auto& dev_ctx =
+      *platform::DeviceContextPool::Instance().Get(platform::CPUPlace());
+  std::vector<LoDTensor> loaded(num_tensors);
+  std::vector<LoDTensor*> outputs;
+  for (auto& tensor : loaded) {
+    outputs.push_back(&tensor);
+  }
+
+  const std::string stream_path = "parallel_checkpoint_bench.stream";
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::ofstream fout(stream_path, std::ios::binary);
+    for (auto* tensor : inputs) {
+      SerializeToStream(fout, *tensor, dev_ctx);
+    }
+  }
+  double stream_save = elapsed_s(start);
+  start = std::chrono::steady_clock::now();
+  {
+    std::ifstream fin(stream_path, std::ios::binary);
+    for (auto* tensor : outputs) {
+      DeserializeFromStream(fin, tensor, dev_ctx);
+    }
+  }
+  double stream_load = elapsed_s(start);
+  LOG(INFO) << "One stream: save " << mb / stream_save << " MB/s, load "
+            << mb / stream_load << " MB/s";
+
+  for (bool compress : {false, true}) {
+    ParallelCheckpointOptions options;
+    options.chunk_size = 8 << 20;
+    options.compress = compress;
+    const std::string dir = "parallel_checkpoint_bench";
+    start = std::chrono::steady_clock::now();
+    SaveParallelCheckpoint(dir, names, inputs, options);
+    double save = elapsed_s(start);
+    start = std::chrono::steady_clock::now();
+    LoadParallelCheckpoint(dir, names, outputs, options);
+    double load = elapsed_s(start);
+    ExpectEqual(loaded[7], tensors[7]);
+    options.incremental = true;
+    start = std::chrono::steady_clock::now();
+    SaveParallelCheckpoint(dir, names, inputs, options);
+    double unchanged = elapsed_s(start);
+    LOG(INFO) << "Parallel checkpoint of " << options.num_threads
+              << " threads" << (compress ? " compressed" : "") << ": save "
+              << mb / save << " MB/s, load " << mb / load
+              << " MB/s, incremental save of unchanged tensors "
+              << mb / unchanged << " MB/s";
+  }
+}
+
+}  // namespace framework
+}  // namespace paddle
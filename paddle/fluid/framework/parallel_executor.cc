@@ -34,6 +34,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/ir/memory_optimize_pass/reference_count_pass_helper.h"
 #include "paddle/fluid/framework/ir/multi_devices_graph_pass/set_reader_device_info_utils.h"
 #include "paddle/fluid/framework/variable_helper.h"
+#include "paddle/fluid/platform/cpu_collective.h"
 #include "paddle/fluid/platform/event.h"
 #include "paddle/fluid/platform/profiler.h"
 
@@ -508,8 +509,15 @@ ir::Graph *ParallelExecutorPrivate::ApplyMemoryOptimizePass(ir::Graph *graph) {
           "Please recompile or reinstall Paddle with XPU support."));
 #endif
     } else if (platform::is_cpu_place(place)) {
-      gc.reset(new CPUGarbageCollector(
-          BOOST_GET_CONST(platform::CPUPlace, place), max_memory_size));
+      size_t slack_bytes = GetCPUDeferredGCSlackBytes();
+      if (slack_bytes > 0) {
+        gc.reset(new CPUDeferredGarbageCollector(
+            BOOST_GET_CONST(platform::CPUPlace, place), max_memory_size,
+            slack_bytes));
+      } else {
+        gc.reset(new CPUGarbageCollector(
+            BOOST_GET_CONST(platform::CPUPlace, place), max_memory_size));
+      }
       VLOG(10) << "Created GarbageCollector at " << place;
     } else {
       PADDLE_THROW(platform::errors::PreconditionNotMet(
@@ -843,6 +851,14 @@ void ParallelExecutor::BCastParamsToDevices(
 #endif
     } else {
       platform::CPUPlace cpu;
+#ifndef _WIN32
+      auto &cpu_comm_ctx = platform::CPUCommContext::Instance();
+      if (member_->build_strategy_.num_trainers_ > 1 && cpu_comm_ctx.Has(0)) {
+        cpu_comm_ctx.Get(0)->Broadcast(
+            const_cast<void *>(main_tensor.data<void>()),
+            main_tensor.numel() * SizeOfType(main_tensor.type()), 0);
+      }
+#endif
       for (size_t i = 1; i < member_->places_.size(); ++i) {
         auto local_scope = member_->local_scopes_[i];
         auto *t = local_scope->Var(var)->GetMutable<LoDTensor>();
@@ -1309,6 +1325,22 @@ void ParallelExecutor::PrepareNCCLCommunicator(Scope *global_scope) {
         platform::errors::PreconditionNotMet("Not compiled with XPU."));
 #endif
   }
+#ifndef _WIN32
+  // The all reduce op handles on the CPU reduce the grads of the trainers by
+  // the comm of ring 0.
+  auto &bst = member_->build_strategy_;
+  if (member_->use_device_ == p::kCPU && bst.num_trainers_ > 1 &&
+      !platform::CPUCommContext::Instance().Has(0)) {
+    PADDLE_ENFORCE_EQ(
+        bst.trainers_endpoints_.size(), bst.num_trainers_,
+        platform::errors::InvalidArgument(
+            "The number of trainers endpoints %d should be equal to the "
+            "number of trainers %d in the collective training on the CPU.",
+            bst.trainers_endpoints_.size(), bst.num_trainers_));
+    platform::CPUCommContext::Instance().CreateComm(bst.trainers_endpoints_,
+                                                    bst.trainer_id_, 0);
+  }
+#endif
 }
 
 std::vector<ir::Graph *> ParallelExecutor::CompileGraphWithBuildStrategy(
@@ -0,0 +1,343 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace framework {
+
+static constexpr size_t kRingCacheLineSize = 64;
+
+// An index of a ring padded to a cache line, so that the producers and the
+// consumers do not write the same cache line.
+struct RingIndex {
+  std::atomic<size_t> value{0};
+  // The index of the other side last read, used by SPSCRing.
+  size_t cached{0};
+  char padding[kRingCacheLineSize - sizeof(std::atomic<size_t>) -
+               sizeof(size_t)];
+};
+
+/*
+ * A bounded lock-free ring of one producer thread and one consumer thread.
+ * The producer and the consumer keep a copy of the index of each other, and
+ * read the index again only when the ring looks full or empty.
+ */
+template <typename T>
+class SPSCRing {
+ public:
+  explicit SPSCRing(size_t capacity)
+      : capacity_(capacity), buffer_(new T[capacity]) {}
+
+  template <typename U>
+  bool TryPush(U &&item) {
+    size_t tail = tail_.value.load(std::memory_order_relaxed);
+    if (tail - tail_.cached == capacity_) {
+      tail_.cached = head_.value.load(std::memory_order_acquire);
+      if (tail - tail_.cached == capacity_) return false;
+    }
+    buffer_[tail % capacity_] = std::forward<U>(item);
+    tail_.value.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T *item) {
+    size_t head = head_.value.load(std::memory_order_relaxed);
+    if (head == head_.cached) {
+      head_.cached = tail_.value.load(std::memory_order_acquire);
+      if (head == head_.cached) return false;
+    }
+    auto &slot = buffer_[head % capacity_];
+    *item = std::move(slot);
+    // Release what the item holds, e.g. the memory of the tensors.
+    slot = T();
+    head_.value.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  size_t Cap() const { return capacity_; }
+
+  // The number of the items, which may be outdated once returned.
+  size_t Size() const {
+    size_t head = head_.value.load(std::memory_order_acquire);
+    return tail_.value.load(std::memory_order_acquire) - head;
+  }
+
+ private:
+  // The head is written by the consumer, which caches the tail, and the
+  // tail by the producer, which caches the head.
+  RingIndex head_;
+  RingIndex tail_;
+  const size_t capacity_;
+  std::unique_ptr<T[]> buffer_;
+};
+
+/*
+ * A bounded lock-free ring of multiple producers and consumers. Each slot
+ * has a sequence number telling whether it is free to push at the position
+ * of the tail, or filled to pop at the position of the head, so that the
+ * producers and the consumers claim the positions by CAS and never wait for
+ * each other except on a full or an empty ring.
+ *
+ * The sequence of a slot free for the position pos is 2 * pos, and the one
+ * filled at pos is 2 * pos + 1, so the two never meet even if the capacity
+ * is 1.
+ */
+template <typename T>
+class MPMCRing {
+ public:
+  explicit MPMCRing(size_t capacity)
+      : capacity_(capacity), slots_(new Slot[capacity]) {
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].seq.store(2 * i, std::memory_order_relaxed);
+    }
+  }
+
+  template <typename U>
+  bool TryPush(U &&item) {
+    size_t pos = tail_.value.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+      slot = &slots_[pos % capacity_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      auto diff = static_cast<int64_t>(seq) - static_cast<int64_t>(2 * pos);
+      if (diff == 0) {
+        if (tail_.value.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = tail_.value.load(std::memory_order_relaxed);
+      }
+    }
+    slot->item = std::forward<U>(item);
+    slot->seq.store(2 * pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool TryPop(T *item) {
+    size_t pos = head_.value.load(std::memory_order_relaxed);
+    Slot *slot;
+    while (true) {
+      slot = &slots_[pos % capacity_];
+      size_t seq = slot->seq.load(std::memory_order_acquire);
+      auto diff =
+          static_cast<int64_t>(seq) - static_cast<int64_t>(2 * pos + 1);
+      if (diff == 0) {
+        if (head_.value.compare_exchange_weak(pos, pos + 1,
+                                              std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = head_.value.load(std::memory_order_relaxed);
+      }
+    }
+    *item = std::move(slot->item);
+    slot->item = T();
+    slot->seq.store(2 * (pos + capacity_), std::memory_order_release);
+    return true;
+  }
+
+  size_t Cap() const { return capacity_; }
+
+  size_t Size() const {
+    size_t head = head_.value.load(std::memory_order_acquire);
+    size_t tail = tail_.value.load(std::memory_order_acquire);
+    return tail > head ? std::min(tail - head, capacity_) : 0;
+  }
+
+ private:
+  struct Slot {
+    std::atomic<size_t> seq;
+    T item;
+  };
+
+  RingIndex head_;
+  RingIndex tail_;
+  const size_t capacity_;
+  std::unique_ptr<Slot[]> slots_;
+};
+
+/*
+ * A bounded blocking queue on a lock-free ring, with the interface of
+ * operators::reader::BlockingQueue. The senders and the receivers spin on
+ * the ring for a while when it is full or empty, for the other side is
+ * usually quick, then sleep on a condition variable until notified. The
+ * spins are doubled when the spinning succeeds, and halved when it fails,
+ * so the threads stop burning the CPU on the rings fed slowly.
+ *
+ * The mutex is only taken by the threads going to sleep and the ones waking
+ * them, so the items passed by the threads spinning never take the lock.
+ * ReOpen must not be called with the senders or the receivers running.
+ */
+template <typename T, typename Ring = MPMCRing<T>>
+class RingBlockingQueue {
+ public:
+  explicit RingBlockingQueue(size_t capacity) : ring_(capacity) {
+    PADDLE_ENFORCE_GT(capacity, static_cast<size_t>(0),
+                      platform::errors::InvalidArgument(
+                          "The capacity of a RingBlockingQueue must be "
+                          "greater than 0, but received capacity is %d.",
+                          capacity));
+  }
+
+  bool Send(const T &elem) { return SendImpl(elem); }
+
+  bool Send(T &&elem) { return SendImpl(std::move(elem)); }
+
+  bool Receive(T *elem) {
+    PADDLE_ENFORCE_NOT_NULL(
+        elem, platform::errors::InvalidArgument(
+                  "The holder to receive queue data is null pointer."));
+    bool received = false;
+    Wait(&receive_spins_, &receive_waiters_, &receive_cv_, [&] {
+      received = ring_.TryPop(elem);
+      return received || closed_.load() || killed_.load();
+    });
+    EnforceNotKilled();
+    // Drain the items sent before the queue was closed.
+    if (!received) received = ring_.TryPop(elem);
+    if (received) {
+      Notify(&send_waiters_, &send_cv_);
+    } else {
+      VLOG(3) << "queue is closed! return nothing.";
+    }
+    return received;
+  }
+
+  void ReOpen() {
+    EnforceNotKilled();
+    VLOG(1) << "reopen queue";
+    T elem;
+    while (ring_.TryPop(&elem)) {
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = false;
+    send_cv_.notify_all();
+    receive_cv_.notify_all();
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    VLOG(1) << "close queue";
+    closed_ = true;
+    send_cv_.notify_all();
+    receive_cv_.notify_all();
+  }
+
+  bool IsClosed() const { return closed_.load(); }
+
+  size_t Cap() const { return ring_.Cap(); }
+
+  size_t Size() const { return ring_.Size(); }
+
+  void Kill() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    VLOG(1) << "kill queue";
+    closed_ = true;
+    killed_ = true;
+    send_cv_.notify_all();
+    receive_cv_.notify_all();
+  }
+
+ private:
+  enum { kMinSpins = 16, kMaxSpins = 4096 };
+
+  template <typename U>
+  bool SendImpl(U &&elem) {
+    bool sent = false;
+    Wait(&send_spins_, &send_waiters_, &send_cv_, [&] {
+      if (killed_.load() || closed_.load()) return true;
+      sent = ring_.TryPush(std::forward<U>(elem));
+      return sent;
+    });
+    if (!sent) {
+      VLOG(3) << "WARNING: Sending an element to a closed or killed "
+                 "RingBlockingQueue.";
+      return false;
+    }
+    Notify(&receive_waiters_, &receive_cv_);
+    return true;
+  }
+
+  template <typename F>
+  void Wait(std::atomic<int> *spins, std::atomic<int> *waiters,
+            std::condition_variable *cv, F &&ready) {
+    int limit = spins->load(std::memory_order_relaxed);
+    for (int i = 0; i < limit; ++i) {
+      if (ready()) {
+        if (i > 0) {
+          spins->store(std::min<int>(limit * 2, kMaxSpins),
+                       std::memory_order_relaxed);
+        }
+        return;
+      }
+      std::this_thread::yield();
+    }
+    spins->store(std::max<int>(limit / 2, kMinSpins),
+                 std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mutex_);
+    // Seen by the other side after it passes an item, see Notify.
+    waiters->fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    cv->wait(lock, ready);
+    waiters->fetch_sub(1);
+  }
+
+  void Notify(std::atomic<int> *waiters, std::condition_variable *cv) {
+    // Order the item passed before reading the waiters, as the waiters are
+    // counted before they check the ring again.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters->load() > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv->notify_one();
+    }
+  }
+
+  inline void EnforceNotKilled() {
+    PADDLE_ENFORCE_NE(killed_.load(), true,
+                      platform::errors::Fatal(
+                          "Blocking queue is killed because the "
+                          "data reader raises an exception."));
+  }
+
+  Ring ring_;
+  std::atomic<bool> closed_{false};
+  std::atomic<bool> killed_{false};
+
+  std::atomic<int> send_spins_{kMaxSpins};
+  std::atomic<int> receive_spins_{kMaxSpins};
+  std::atomic<int> send_waiters_{0};
+  std::atomic<int> receive_waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable send_cv_;
+  std::condition_variable receive_cv_;
+};
+
+}  // namespace framework
+}  // namespace paddle
@@ -0,0 +1,148 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/ring_queue.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <memory>
+#include <thread>  // NOLINT
+#include <vector>
+
+namespace paddle {
+namespace framework {
+
+template <typename Ring>
+static void TestRingBound() {
+  Ring ring(3);
+  EXPECT_EQ(ring.Cap(), 3UL);
+  size_t item = 0;
+  EXPECT_FALSE(ring.TryPop(&item));
+  // wrap around the ring a few times
+  for (size_t round = 0; round < 5; ++round) {
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_TRUE(ring.TryPush(round * 3 + i));
+    }
+    EXPECT_FALSE(ring.TryPush(100));
+    EXPECT_EQ(ring.Size(), 3UL);
+    for (size_t i = 0; i < 3; ++i) {
+      EXPECT_TRUE(ring.TryPop(&item));
+      EXPECT_EQ(item, round * 3 + i);
+    }
+    EXPECT_FALSE(ring.TryPop(&item));
+  }
+}
+
+TEST(RingQueue, bound) {
+  TestRingBound<SPSCRing<size_t>>();
+  TestRingBound<MPMCRing<size_t>>();
+}
+
+TEST(RingQueue, release_item) {
+  auto item = std::make_shared<int>(1);
+  MPMCRing<std::shared_ptr<int>> ring(2);
+  ring.TryPush(item);
+  std::shared_ptr<int> popped;
+  ring.TryPop(&popped);
+  popped.reset();
+  // the ring holds no copy of the item popped
+  EXPECT_EQ(item.use_count(), 1);
+}
+
+// Every item sent by the senders is received once, in the order sent by
+// each sender.
+template <typename Ring>
+static void TestSendReceive(size_t num_senders, size_t num_receivers,
+                            size_t capacity) {
+  const size_t num_items = 20000;
+  RingBlockingQueue<size_t, Ring> queue(capacity);
+  std::vector<std::vector<size_t>> received(num_receivers);
+  std::vector<std::thread> receivers;
+  for (size_t r = 0; r < num_receivers; ++r) {
+    receivers.emplace_back([&, r] {
+      size_t item;
+      while (queue.Receive(&item)) {
+        received[r].push_back(item);
+      }
+    });
+  }
+  std::vector<std::thread> senders;
+  for (size_t s = 0; s < num_senders; ++s) {
+    senders.emplace_back([&, s] {
+      for (size_t i = 0; i < num_items; ++i) {
+        EXPECT_TRUE(queue.Send(s * num_items + i));
+      }
+    });
+  }
+  for (auto &sender : senders) {
+    sender.join();
+  }
+  queue.Close();
+  for (auto &receiver : receivers) {
+    receiver.join();
+  }
+  EXPECT_FALSE(queue.Send(0));
+
+  std::vector<size_t> all;
+  for (auto &items : received) {
+    std::vector<size_t> last(num_senders, 0);
+    for (size_t item : items) {
+      size_t s = item / num_items;
+      EXPECT_GE(item, last[s]);
+      last[s] = item + 1;
+    }
+    all.insert(all.end(), items.begin(), items.end());
+  }
+  std::sort(all.begin(), all.end());
+  ASSERT_EQ(all.size(), num_senders * num_items);
+  for (size_t i = 0; i < all.size(); ++i) {
+    EXPECT_EQ(all[i], i);
+  }
+}
+
+TEST(RingQueue, spsc) { TestSendReceive<SPSCRing<size_t>>(1, 1, 4); }
+
+TEST(RingQueue, mpmc) {
+  TestSendReceive<MPMCRing<size_t>>(4, 1, 2);
+  TestSendReceive<MPMCRing<size_t>>(4, 4, 8);
+  TestSendReceive<MPMCRing<size_t>>(1, 4, 1);
+}
+
+TEST(RingQueue, close_and_kill) {
+  RingBlockingQueue<size_t> queue(4);
+  EXPECT_TRUE(queue.Send(1));
+  EXPECT_TRUE(queue.Send(2));
+  queue.Close();
+  EXPECT_TRUE(queue.IsClosed());
+  // the items sent before closed are received
+  size_t item;
+  EXPECT_TRUE(queue.Receive(&item));
+  EXPECT_EQ(item, 1UL);
+  EXPECT_TRUE(queue.Receive(&item));
+  EXPECT_FALSE(queue.Receive(&item));
+
+  queue.ReOpen();
+  EXPECT_FALSE(queue.IsClosed());
+  // a receiver sleeping is woken by the kill
+  std::thread receiver(
+      [&] { EXPECT_THROW(queue.Receive(&item), platform::EnforceNotMet); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  queue.Kill();
+  receiver.join();
+  EXPECT_FALSE(queue.Send(3));
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -142,6 +142,7 @@ void Scope::DeleteScope(Scope* scope) const {
 void Scope::EraseVars(const std::vector<std::string>& var_names) {
   std::set<std::string> var_set(var_names.begin(), var_names.end());
   SCOPE_VARS_WRITER_LOCK
+  ++version_;
   for (auto it = vars_.begin(); it != vars_.end();) {
     if (var_set.find(it->first) != var_set.end()) {
       it = vars_.erase(it);
@@ -169,6 +170,7 @@ Variable* Scope::VarInternal(const std::string& name) {
   if (v != nullptr) return v;
   v = new Variable();
   vars_.emplace(name, std::unique_ptr<Variable>(v));
+  ++version_;
   VLOG(3) << "Create variable " << name;
   return v;
 }
@@ -204,6 +206,7 @@ void Scope::RenameInternal(const std::string& origin_name,
           "The variable with name %s already exists in the scope.", new_name));
   vars_[new_name].reset(origin_it->second.release());
   vars_.erase(origin_it);
+  ++version_;
 }
 
 Variable* Scope::FindVarInternal(const std::string& name) const {
@@ -224,6 +227,7 @@ Variable* Scope::FindVarLocally(const std::string& name) const {
 
 void Scope::EraseVarsExcept(const std::unordered_set<Variable*>& vars) {
   SCOPE_VARS_WRITER_LOCK
+  ++version_;
   for (auto iter = vars_.begin(); iter != vars_.end();) {
     if (vars.count(iter->second.get()) != 0) {
       ++iter;
@@ -18,6 +18,7 @@ extern "C" {
 #include <xxhash.h>
 }
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <string>
@@ -118,6 +119,11 @@ class Scope {
   // Rename variable to a new name and return the new name
   std::string Rename(const std::string& origin_name) const;
 
+  /// The version is increased whenever a variable is created, erased or
+  /// renamed in this scope, so the cached pointers of the variables, e.g. in
+  /// SlotScope, know when to look up the variables again.
+  uint64_t Version() const { return version_.load(std::memory_order_acquire); }
+
  protected:
   struct KeyHasher {
     std::size_t operator()(const std::string& key) const {
@@ -154,6 +160,7 @@ class Scope {
   // Scope in `kids_` are owned by this class.
   mutable std::list<Scope*> kids_;
   const Scope* parent_{nullptr};
+  mutable std::atomic<uint64_t> version_{0};
 
   DISABLE_COPY_AND_ASSIGN(Scope);
 
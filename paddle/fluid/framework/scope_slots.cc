@@ -0,0 +1,121 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/scope_slots.h"
+
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace framework {
+
+constexpr int VarNameTable::kInvalidId;
+
+int VarNameTable::Intern(const std::string& name) {
+  auto it = ids_.find(name);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+  int id = static_cast<int>(names_.size());
+  ids_.emplace(name, id);
+  names_.push_back(name);
+  return id;
+}
+
+int VarNameTable::Find(const std::string& name) const {
+  auto it = ids_.find(name);
+  return it == ids_.end() ? kInvalidId : it->second;
+}
+
+static void InternArguments(
+    const VariableNameMap& name_map, VarNameTable* table,
+    std::vector<std::pair<std::string, std::vector<int>>>* slots) {
+  slots->reserve(name_map.size());
+  for (auto& item : name_map) {
+    std::vector<int> ids;
+    ids.reserve(item.second.size());
+    for (auto& name : item.second) {
+      ids.push_back(name == kEmptyVarName ? VarNameTable::kInvalidId
+                                          : table->Intern(name));
+    }
+    slots->emplace_back(item.first, std::move(ids));
+  }
+}
+
+OpVarSlots::OpVarSlots(const VariableNameMap& inputs,
+                       const VariableNameMap& outputs, VarNameTable* table)
+    : table(table) {
+  PADDLE_ENFORCE_NOT_NULL(table, platform::errors::InvalidArgument(
+                                     "The VarNameTable is nullptr."));
+  InternArguments(inputs, table, &this->inputs);
+  InternArguments(outputs, table, &this->outputs);
+}
+
+SlotScope::SlotScope(const VarNameTable* table, const Scope* scope)
+    : table_(table), scope_(scope) {
+  PADDLE_ENFORCE_NOT_NULL(table, platform::errors::InvalidArgument(
+                                     "The VarNameTable is nullptr."));
+  PADDLE_ENFORCE_NOT_NULL(
+      scope, platform::errors::InvalidArgument("The Scope is nullptr."));
+  Resolve();
+}
+
+bool SlotScope::Changed() const {
+  if (slots_.size() != table_->Size()) {
+    return true;
+  }
+  for (auto& item : versions_) {
+    if (item.first->Version() != item.second) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SlotScope::Sync() {
+  if (Changed()) {
+    Resolve();
+  }
+}
+
+void SlotScope::Resolve() {
+  // Record the versions before the lookups, so a change during the lookups
+  // is seen by the next Sync.
+  versions_.clear();
+  for (auto* s = scope_; s != nullptr; s = s->parent()) {
+    versions_.emplace_back(s, s->Version());
+  }
+  slots_.resize(table_->Size());
+  for (size_t i = 0; i < slots_.size(); ++i) {
+    slots_[i] = scope_->FindVar(table_->Name(static_cast<int>(i)));
+  }
+  VLOG(4) << "Resolve " << slots_.size() << " variable slots in scope "
+          << scope_;
+}
+
+Variable* SlotScope::FindVarByName(int id) const {
+  return scope_->FindVar(table_->Name(id));
+}
+
+Variable* SlotScope::FindVar(const std::string& name) const {
+  int id = table_->Find(name);
+  if (id == VarNameTable::kInvalidId ||
+      static_cast<size_t>(id) >= slots_.size()) {
+    return scope_->FindVar(name);
+  }
+  return Var(id);
+}
+
+}  // namespace framework
+}  // namespace paddle
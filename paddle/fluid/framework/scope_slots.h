@@ -0,0 +1,104 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/type_defs.h"
+
+namespace paddle {
+namespace framework {
+
+class Scope;
+class Variable;
+
+// VarNameTable interns the variable names of a prepared program into dense
+// integer ids, so the executors can find the variables by the ids instead of
+// hashing the names in every scope of the chain.
+class VarNameTable {
+ public:
+  static constexpr int kInvalidId = -1;
+
+  VarNameTable() = default;
+
+  // Return the id of the name, add the name if it is not interned.
+  int Intern(const std::string& name);
+  // Return the id of the name, or kInvalidId if it is not interned.
+  int Find(const std::string& name) const;
+
+  const std::string& Name(int id) const { return names_[id]; }
+  size_t Size() const { return names_.size(); }
+
+ private:
+  std::unordered_map<std::string, int> ids_;
+  std::vector<std::string> names_;
+};
+
+// The ids of the inputs and outputs of an operator in a VarNameTable, in the
+// same order as its VariableNameMap. kEmptyVarName is mapped to kInvalidId.
+struct OpVarSlots {
+  OpVarSlots(const VariableNameMap& inputs, const VariableNameMap& outputs,
+             VarNameTable* table);
+
+  const VarNameTable* table;
+  std::vector<std::pair<std::string, std::vector<int>>> inputs;
+  std::vector<std::pair<std::string, std::vector<int>>> outputs;
+};
+
+// SlotScope is a flat view of a Scope and its ancestors: an array of the
+// variables indexed by the ids of a VarNameTable. The lookups are an array
+// index, without locks or hashing.
+//
+// The Scope keeps the string API and owns the variables. The slots are looked
+// up again by Sync once a variable is created, erased or renamed in any scope
+// of the chain, so Sync must be called before running each operator.
+class SlotScope {
+ public:
+  SlotScope(const VarNameTable* table, const Scope* scope);
+
+  const VarNameTable* table() const { return table_; }
+  const Scope* scope() const { return scope_; }
+
+  // Look up the slots again if the scope chain has changed.
+  void Sync();
+
+  // Return the variable of the id. The variables not found at the last Sync,
+  // e.g. created by an operator in the same step, are looked up by name.
+  Variable* Var(int id) const {
+    if (id == VarNameTable::kInvalidId) return nullptr;
+    Variable* var = slots_[id];
+    return var != nullptr ? var : FindVarByName(id);
+  }
+
+  // The string API, for the names which may not be interned.
+  Variable* FindVar(const std::string& name) const;
+
+ private:
+  void Resolve();
+  bool Changed() const;
+  Variable* FindVarByName(int id) const;
+
+  const VarNameTable* table_;
+  const Scope* scope_;
+  std::vector<Variable*> slots_;
+  // The version of every scope in the chain at the last Resolve.
+  std::vector<std::pair<const Scope*, uint64_t>> versions_;
+};
+
+}  // namespace framework
+}  // namespace paddle
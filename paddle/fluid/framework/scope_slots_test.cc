@@ -0,0 +1,276 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/framework/scope_slots.h"
+
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/platform/metrics.h"
+
+DECLARE_bool(enable_op_metrics);
+
+namespace paddle {
+namespace framework {
+
+class SlotTestOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of the test op");
+    AddOutput("Out", "X + 1");
+    AddComment("Add one to the input, to test the variable slots.");
+  }
+};
+
+class SlotTestOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ctx->SetOutputDim("Out", ctx->GetInputDim("X"));
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class SlotTestKernel : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto* x = ctx.Input<LoDTensor>("X");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    const float* src = x->data<float>();
+    float* dst = out->mutable_data<float>(ctx.GetPlace());
+    for (int64_t i = 0; i < x->numel(); ++i) {
+      dst[i] = src[i] + 1;
+    }
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(scope_slots_test, paddle::framework::SlotTestOp,
+                             paddle::framework::SlotTestOpMaker);
+REGISTER_OP_CPU_KERNEL(scope_slots_test, paddle::framework::SlotTestKernel);
+
+namespace paddle {
+namespace framework {
+
+static void FeedTensor(Scope* scope, const std::string& name, float value) {
+  auto* t = scope->Var(name)->GetMutable<LoDTensor>();
+  *t->mutable_data<float>({1}, platform::CPUPlace()) = value;
+}
+
+TEST(VarNameTable, intern) {
+  VarNameTable table;
+  EXPECT_EQ(table.Intern("a"), 0);
+  EXPECT_EQ(table.Intern("b"), 1);
+  EXPECT_EQ(table.Intern("a"), 0);
+  EXPECT_EQ(table.Find("b"), 1);
+  EXPECT_EQ(table.Find("c"), VarNameTable::kInvalidId);
+  EXPECT_EQ(table.Name(1), "b");
+  EXPECT_EQ(table.Size(), 2UL);
+
+  OpVarSlots slots({{"X", {"b", kEmptyVarName}}}, {{"Out", {"c"}}}, &table);
+  EXPECT_EQ(slots.inputs[0].second,
+            std::vector<int>({1, VarNameTable::kInvalidId}));
+  EXPECT_EQ(slots.outputs[0].second, std::vector<int>({2}));
+  EXPECT_EQ(table.Size(), 3UL);
+}
+
+TEST(SlotScope, sync) {
+  VarNameTable table;
+  int a = table.Intern("a");
+  int b = table.Intern("b");
+  int c = table.Intern("c");
+
+  Scope parent;
+  auto* parent_a = parent.Var("a");
+  Scope& child = parent.NewScope();
+  auto* child_b = child.Var("b");
+  SlotScope slots(&table, &child);
+  EXPECT_EQ(slots.Var(a), parent_a);
+  EXPECT_EQ(slots.Var(b), child_b);
+  EXPECT_EQ(slots.Var(c), nullptr);
+  EXPECT_EQ(slots.Var(VarNameTable::kInvalidId), nullptr);
+  EXPECT_EQ(slots.FindVar("b"), child_b);
+
+  // created after the slots are resolved, found by name before Sync
+  auto* child_c = child.Var("c");
+  EXPECT_EQ(slots.Var(c), child_c);
+  // shadow the variable of the parent
+  auto* child_a = child.Var("a");
+  slots.Sync();
+  EXPECT_EQ(slots.Var(a), child_a);
+
+  child.EraseVars({"a"});
+  slots.Sync();
+  EXPECT_EQ(slots.Var(a), parent_a);
+  parent.Rename("a", "d");
+  slots.Sync();
+  EXPECT_EQ(slots.Var(a), nullptr);
+  EXPECT_EQ(slots.FindVar("d"), parent_a);
+
+  // interned after the slots are created
+  int d = table.Intern("d");
+  slots.Sync();
+  EXPECT_EQ(slots.Var(d), parent_a);
+}
+
+TEST(SlotScope, run_op) {
+  VarNameTable table;
+  auto op = OpRegistry::CreateOp("scope_slots_test", {{"X", {"x"}}},
+                                 {{"Out", {"y"}}}, AttributeMap{});
+  op->BindVarSlots(&table);
+  EXPECT_EQ(table.Size(), 2UL);
+
+  Scope scope;
+  FeedTensor(&scope, "x", 1.f);
+  scope.Var("y")->GetMutable<LoDTensor>();
+  SlotScope slots(&table, &scope);
+  op->Run(slots, platform::CPUPlace());
+  EXPECT_EQ(scope.FindVar("y")->Get<LoDTensor>().data<float>()[0], 2.f);
+
+  // the slots of another table fall back to the names
+  VarNameTable other_table;
+  other_table.Intern("y");
+  SlotScope other_slots(&other_table, &scope);
+  FeedTensor(&scope, "x", 3.f);
+  op->Run(other_slots, platform::CPUPlace());
+  EXPECT_EQ(scope.FindVar("y")->Get<LoDTensor>().data<float>()[0], 4.f);
+}
+
+// The run time is recorded once FLAGS_enable_op_metrics is set, even after
+// Prepare.
+TEST(NaiveExecutor, run_metric) {
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("x")->SetType(proto::VarType::LOD_TENSOR);
+  block->Var("y")->SetType(proto::VarType::LOD_TENSOR);
+  auto* op = block->AppendOp();
+  op->SetType("scope_slots_test");
+  op->SetInput("X", {"x"});
+  op->SetOutput("Out", {"y"});
+
+  Scope scope;
+  FeedTensor(&scope, "x", 1.f);
+  scope.Var("y")->GetMutable<LoDTensor>();
+  NaiveExecutor exe(platform::CPUPlace{});
+  exe.Prepare(&scope, program, 0, false);
+  auto* run_metric = platform::MetricsRegistry::Instance().GetHistogram(
+      "paddle_naive_executor_run_seconds", "", {{"place", "CPUPlace"}});
+  uint64_t count = run_metric->Count();
+  exe.Run();
+  EXPECT_EQ(run_metric->Count(), count);
+  FLAGS_enable_op_metrics = true;
+  exe.Run();
+  FLAGS_enable_op_metrics = false;
+  EXPECT_EQ(run_metric->Count(), count + 1);
+  EXPECT_EQ(exe.FindTensor("y")->data<float>()[0], 2.f);
+}
+
+// The cost of the variable lookups, and of a step of NaiveExecutor on a
+// program of 2000 small ops, with the names and with the slots.
+TEST(SlotScope, benchmark) {
+  const int num_ops = 2000;
+  ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("x0")->SetType(proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < num_ops; ++i) {
+    std::string out = "x" + std::to_string(i + 1);
+    block->Var(out)->SetType(proto::VarType::LOD_TENSOR);
+    auto* op = block->AppendOp();
+    op->SetType("scope_slots_test");
+    op->SetInput("X", {"x" + std::to_string(i)});
+    op->SetOutput("Out", {out});
+  }
+
+  Scope root;
+  Scope& scope = root.NewScope();
+  FeedTensor(&root, "x0", 0.f);
+  for (int i = 1; i <= num_ops; ++i) {
+    scope.Var("x" + std::to_string(i))->GetMutable<LoDTensor>();
+  }
+  NaiveExecutor exe(platform::CPUPlace{});
+  exe.Prepare(&scope, program, 0, false);
+  exe.Run();
+  EXPECT_EQ(exe.FindTensor("x2000")->data<float>()[0], 2000.f);
+
+  const int repeat = 20;
+  auto elapsed_us = [](std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - start)
+        .count();
+  };
+
+  VarNameTable table;
+  for (auto* var : block->AllVars()) {
+    table.Intern(var->Name());
+  }
+  SlotScope slots(&table, &scope);
+  std::vector<std::string> names;
+  for (int i = 0; i <= num_ops; ++i) {
+    names.push_back("x" + std::to_string(i));
+  }
+  size_t found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r) {
+    for (auto& name : names) {
+      found += scope.FindVar(name) != nullptr;
+    }
+  }
+  double find_var_us = elapsed_us(start) / repeat;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r) {
+    slots.Sync();
+    for (int id = 0; id <= num_ops; ++id) {
+      found += slots.Var(id) != nullptr;
+    }
+  }
+  double slot_us = elapsed_us(start) / repeat;
+  EXPECT_EQ(found, 2UL * repeat * names.size());
+
+  std::vector<std::unique_ptr<OperatorBase>> ops;
+  for (auto* op_desc : block->AllOps()) {
+    ops.emplace_back(OpRegistry::CreateOp(*op_desc));
+  }
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r) {
+    for (auto& op : ops) {
+      op->Run(scope, platform::CPUPlace());
+    }
+  }
+  double step_by_name_us = elapsed_us(start) / repeat;
+  start = std::chrono::steady_clock::now();
+  for (int r = 0; r < repeat; ++r) {
+    exe.Run();
+  }
+  double step_by_slot_us = elapsed_us(start) / repeat;
+
+  LOG(INFO) << "Look up " << names.size() << " variables: " << find_var_us
+            << " us by name, " << slot_us << " us by slot";
+  LOG(INFO) << "A step of " << num_ops << " ops: " << step_by_name_us
+            << " us by name, " << step_by_slot_us << " us by slot";
+}
+
+}  // namespace framework
+}  // namespace paddle
@@ -14,6 +14,8 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/tensor.h"
 
+#include <cstring>
+
 namespace paddle {
 namespace memory {
 namespace allocation {
@@ -75,6 +77,15 @@ void* Tensor::mutable_data(const platform::Place& place,
     holder_.reset();
     holder_ = memory::AllocShared(place, size);
     offset_ = 0;
+  } else if (UNLIKELY(IsSharedCopyOnWrite())) {
+    // Copy the block out before written, for the others sharing it.
+    auto holder = memory::AllocShared(place, size);
+    std::memcpy(holder->ptr(),
+                reinterpret_cast<void*>(
+                    reinterpret_cast<uintptr_t>(holder_->ptr()) + offset_),
+                size);
+    holder_ = std::move(holder);
+    offset_ = 0;
   }
   return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(holder_->ptr()) +
                                  offset_);
@@ -92,6 +103,60 @@ Tensor& Tensor::ShareDataWith(const Tensor& src) {
   *this = src;
   return *this;
 }
+
+Tensor& Tensor::ShareDataCopyOnWrite(const Tensor& src) {
+  src.check_memory_size();
+  PADDLE_ENFORCE_EQ(
+      platform::is_cpu_place(src.place()), true,
+      platform::errors::Unimplemented(
+          "Only the tensors on CPU can be shared copy-on-write, but the "
+          "tensor is on %s.",
+          src.place()));
+  // The views of a view share the block it views.
+  auto base = src.holder_;
+  if (base->IsCopyOnWriteView()) {
+    base = static_cast<memory::allocation::CopyOnWriteAllocation*>(base.get())
+               ->base();
+  }
+  // The inplace version of this tensor is its own, for src may be written
+  // without changing this tensor.
+  auto inplace_version_counter = inplace_version_counter_;
+  *this = src;
+  holder_ = std::make_shared<memory::allocation::CopyOnWriteAllocation>(
+      std::move(base));
+  inplace_version_counter_ = std::move(inplace_version_counter);
+  return *this;
+}
+
+bool Tensor::CanShareDataCopyOnWrite(const Tensor& src) const {
+  if (this == &src || !src.IsInitialized() ||
+      !platform::is_cpu_place(src.place())) {
+    return false;
+  }
+  // The block of this tensor may be shared in place, e.g. as a part of a
+  // fused buffer, so the data has to be copied into it.
+  if (holder_ != nullptr && !holder_->IsCopyOnWriteView()) {
+    return false;
+  }
+  // Neither may the block of src be shared in place, for src would copy it
+  // out when written while viewed, leaving the others behind. The views
+  // hold the block too.
+  if (src.holder_->IsCopyOnWriteView()) {
+    return src.holder_.use_count() == 1;
+  }
+  return src.holder_.use_count() - src.holder_->CopyOnWriteViews() == 1;
+}
+
+bool Tensor::IsSharedCopyOnWrite() const {
+  if (holder_->IsCopyOnWriteView()) {
+    // Shared with src or the other views of it.
+    return static_cast<memory::allocation::CopyOnWriteAllocation*>(
+               holder_.get())
+               ->base()
+               .use_count() > 1;
+  }
+  return holder_->CopyOnWriteViews() > 0;
+}
 Tensor& Tensor::ShareInplaceVersionCounterWith(const Tensor& src) {
   PADDLE_ENFORCE_NOT_NULL(
       inplace_version_counter_,
@@ -174,6 +174,24 @@ class Tensor {
   /*! The internal of two tensors share the same memory block. */
   Tensor& ShareDataWith(const Tensor& src);
 
+  /**
+   * @brief Share the memory block of src copy-on-write, so that this tensor
+   *        reads the data of src without a copy, and either of them copies
+   *        the block out before writing it while shared. Only for CPU.
+   *
+   * @note  Only the writes through mutable_data copy the block, the kernels
+   *        must not write the inputs through const_cast. Check
+   *        CanShareDataCopyOnWrite first.
+   */
+  Tensor& ShareDataCopyOnWrite(const Tensor& src);
+
+  /**
+   * @brief Whether this tensor can share src copy-on-write: src is on CPU,
+   *        and neither its memory block nor the one of this tensor, if any,
+   *        is shared in place by the other tensors.
+   */
+  bool CanShareDataCopyOnWrite(const Tensor& src) const;
+
   /*! The internal of two tensors share the same inplace version counter. */
   Tensor& ShareInplaceVersionCounterWith(const Tensor& src);
 
@@ -278,6 +296,10 @@ class Tensor {
   }
 
  private:
+  // Whether the memory block is shared copy-on-write, so that it has to be
+  // copied out before written.
+  bool IsSharedCopyOnWrite() const;
+
   /*! holds the memory block if allocated. */
   std::shared_ptr<memory::Allocation> holder_;
   proto::VarType::Type type_;
@@ -289,6 +289,18 @@ void TensorCopy(const Tensor& src, const platform::Place& dst_place,
   TensorCopy(src, dst_place, *dev_ctx, dst);
 }
 
+void TensorCopyOnWrite(const Tensor& src, const platform::Place& dst_place,
+                       const platform::DeviceContext& ctx, Tensor* dst) {
+  // dst keeps the memory block it has, which may be a part of a fused buffer
+  // or shared in place, and gets the data copied.
+  if (!platform::is_cpu_place(dst_place) ||
+      !dst->CanShareDataCopyOnWrite(src)) {
+    TensorCopy(src, dst_place, ctx, dst);
+    return;
+  }
+  dst->ShareDataCopyOnWrite(src);
+}
+
 void TensorCopySync(const Tensor& src, const platform::Place& dst_place,
                     Tensor* dst) {
   if (&src == dst) {
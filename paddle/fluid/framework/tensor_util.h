@@ -72,6 +72,15 @@ void TensorCopy(const Tensor& src, const platform::Place& dst_place,
 void TensorCopySync(const Tensor& src, const platform::Place& dst_place,
                     Tensor* dst);
 
+// Copy src to dst without copying the data on CPU: dst shares the memory
+// block of src copy-on-write, which is copied only when either of them is
+// written while shared. It falls back to TensorCopy on the other places, or
+// when dst has a memory block of its own, e.g. a part of a fused buffer, or
+// src is shared in place. The layout-only kernels like reshape use it to make
+// their outputs views of their inputs.
+void TensorCopyOnWrite(const Tensor& src, const platform::Place& dst_place,
+                       const platform::DeviceContext& ctx, Tensor* dst);
+
 template <typename T>
 void TensorFromVector(const std::vector<T>& src,
                       const platform::DeviceContext& ctx, Tensor* dst);
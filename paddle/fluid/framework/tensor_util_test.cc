@@ -15,6 +15,7 @@
 #include "paddle/fluid/framework/tensor_util.h"
 
 #include <gtest/gtest.h>
+#include <chrono>  // NOLINT
 #include <cmath>
 
 namespace paddle {
@@ -513,5 +514,151 @@ TEST(Tensor, FromAndToStream) {
 #endif
 }
 
+TEST(TensorCopyOnWrite, Tensor) {
+  platform::CPUDeviceContext cpu_ctx((platform::CPUPlace()));
+  Tensor src_tensor;
+  int* src_ptr =
+      src_tensor.mutable_data<int>(make_ddim({3, 3}), platform::CPUPlace());
+  for (int i = 0; i < 9; ++i) {
+    src_ptr[i] = i;
+  }
+
+  // the view shares the data, and has its own shape and inplace version
+  Tensor view;
+  TensorCopyOnWrite(src_tensor, platform::CPUPlace(), cpu_ctx, &view);
+  view.Resize({9});
+  EXPECT_EQ(view.data<int>(), src_ptr);
+  EXPECT_EQ(src_tensor.dims(), make_ddim({3, 3}));
+  view.InplaceVersionCounter().Bump();
+  EXPECT_EQ(src_tensor.InplaceVersionCounter().CurrentVersion(), 0U);
+
+  // the view written copies the data out
+  int* view_ptr = view.mutable_data<int>(platform::CPUPlace());
+  EXPECT_NE(view_ptr, src_ptr);
+  view_ptr[0] = 100;
+  EXPECT_EQ(src_ptr[0], 0);
+  for (int i = 1; i < 9; ++i) {
+    EXPECT_EQ(view_ptr[i], i);
+  }
+
+  // a slice shares the buffer in place, so it is copied
+  Tensor slice_copy;
+  TensorCopyOnWrite(src_tensor.Slice(1, 2), platform::CPUPlace(), cpu_ctx,
+                    &slice_copy);
+  EXPECT_NE(slice_copy.data<int>(), src_ptr + 3);
+
+  // the source written copies the data out, as the views of a slice, which
+  // split makes once it checks the source
+  Tensor slice_view;
+  ASSERT_TRUE(slice_view.CanShareDataCopyOnWrite(src_tensor));
+  slice_view.ShareDataCopyOnWrite(src_tensor.Slice(1, 2));
+  EXPECT_EQ(slice_view.data<int>(), src_ptr + 3);
+  int* new_src_ptr = src_tensor.mutable_data<int>(platform::CPUPlace());
+  EXPECT_NE(new_src_ptr, src_ptr);
+  new_src_ptr[3] = 100;
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(slice_view.data<int>()[i], i + 3);
+  }
+
+  // the view no longer shared is written in place
+  EXPECT_EQ(slice_view.mutable_data<int>(platform::CPUPlace()), src_ptr + 3);
+
+  // the buffer shared in place is not copied
+  Tensor inplace;
+  inplace.ShareBufferWith(src_tensor);
+  TensorCopyOnWrite(src_tensor, platform::CPUPlace(), cpu_ctx, &inplace);
+  EXPECT_EQ(inplace.mutable_data<int>(platform::CPUPlace()), new_src_ptr);
+}
+
+TEST(TensorCopyOnWrite, SharedInPlace) {
+  platform::CPUDeviceContext cpu_ctx((platform::CPUPlace()));
+  Tensor fused;
+  int* fused_ptr = fused.mutable_data<int>({12}, platform::CPUPlace());
+  Tensor part = fused.Slice(0, 6);
+
+  // dst in the fused buffer gets the data copied
+  Tensor src;
+  int* src_ptr = src.mutable_data<int>({2, 3}, platform::CPUPlace());
+  for (int i = 0; i < 6; ++i) {
+    src_ptr[i] = i;
+  }
+  TensorCopyOnWrite(src, platform::CPUPlace(), cpu_ctx, &part);
+  EXPECT_EQ(part.data<int>(), fused_ptr);
+  for (int i = 0; i < 6; ++i) {
+    EXPECT_EQ(fused_ptr[i], i);
+  }
+
+  // src in the fused buffer is copied rather than viewed, so it is written
+  // in place
+  Tensor copy;
+  TensorCopyOnWrite(part, platform::CPUPlace(), cpu_ctx, &copy);
+  EXPECT_NE(copy.data<int>(), fused_ptr);
+  EXPECT_EQ(part.mutable_data<int>(platform::CPUPlace()), fused_ptr);
+
+  // src is written in place again once its views are released
+  {
+    Tensor view;
+    TensorCopyOnWrite(src, platform::CPUPlace(), cpu_ctx, &view);
+    EXPECT_EQ(view.data<int>(), src_ptr);
+    Tensor view_of_view;
+    TensorCopyOnWrite(view, platform::CPUPlace(), cpu_ctx, &view_of_view);
+    EXPECT_EQ(view_of_view.data<int>(), src_ptr);
+    EXPECT_EQ(src.Holder()->CopyOnWriteViews(), 2);
+  }
+  EXPECT_EQ(src.Holder()->CopyOnWriteViews(), 0);
+  EXPECT_EQ(src.mutable_data<int>(platform::CPUPlace()), src_ptr);
+
+  // a view of the last run is replaced by the new view
+  Tensor out;
+  TensorCopyOnWrite(src, platform::CPUPlace(), cpu_ctx, &out);
+  TensorCopyOnWrite(src, platform::CPUPlace(), cpu_ctx, &out);
+  EXPECT_EQ(out.data<int>(), src_ptr);
+  EXPECT_EQ(src.Holder()->CopyOnWriteViews(), 1);
+}
+
+// The time of a chain of 8 layout-only ops on 16MB, with the outputs copied
+// and with the outputs as the copy-on-write views.
+TEST(TensorCopyOnWrite, benchmark) {
+  platform::CPUDeviceContext cpu_ctx((platform::CPUPlace()));
+  const int64_t numel = 4 << 20;
+  const int num_ops = 8;
+  Tensor input;
+  float* data = input.mutable_data<float>({numel}, platform::CPUPlace());
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = i;
+  }
+  auto run = [&](bool copy_on_write) {
+    const int repeat = 10;
+    size_t copied = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeat; ++r) {
+      std::vector<Tensor> outs(num_ops);
+      const Tensor* in = &input;
+      for (auto& out : outs) {
+        if (copy_on_write) {
+          TensorCopyOnWrite(*in, platform::CPUPlace(), cpu_ctx, &out);
+        } else {
+          TensorCopy(*in, platform::CPUPlace(), cpu_ctx, &out);
+        }
+        out.Resize({numel / 1024, 1024});
+        if (out.data<float>() != in->data<float>()) {
+          copied += numel * sizeof(float);
+        }
+        in = &out;
+      }
+      EXPECT_EQ(in->data<float>()[numel - 1], numel - 1);
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                repeat;
+    LOG(INFO) << (copy_on_write ? "Copy-on-write" : "Copy") << ": " << ms
+              << " ms, " << copied / repeat / 1048576.0 << " MB copied per "
+              << num_ops << " ops";
+  };
+  run(false);
+  run(true);
+}
+
 }  // namespace framework
 }  // namespace paddle
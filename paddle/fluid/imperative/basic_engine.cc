@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <sstream>
 #include <string>
@@ -32,6 +33,7 @@
 #include "paddle/fluid/platform/profiler.h"
 
 DECLARE_bool(sort_sum_gradient);
+DECLARE_int32(dygraph_backward_num_threads);
 
 namespace paddle {
 namespace imperative {
@@ -248,6 +250,7 @@ void BasicEngine::PrepareDeps() {
 
   std::queue<GradOpNode*> q;
   std::unordered_set<GradOpNode*> visited;
+  cpu_only_ = true;
 
   for (size_t i = 0; i < init_nodes_.size(); ++i) {
     q.push(init_nodes_[i].get());
@@ -263,6 +266,9 @@ void BasicEngine::PrepareDeps() {
     for (auto& cur_op : *cur_node) {
       cur_op.EnforceHasInOut();
       PrepareGradAccumulators(cur_op, grad_pending_nodes);
+      if (!platform::is_cpu_place(cur_op.place())) {
+        cpu_only_ = false;
+      }
     }
 
     for (auto& grad_pending_node : grad_pending_nodes) {
@@ -302,225 +308,253 @@ static std::shared_ptr<NameVarMap<VariableWrapper>> CallGradientHooks(
   return tmp_ins_ptr;
 }
 
-void BasicEngine::Execute() {
-  if (init_nodes_.empty()) {
-    return;
-  }
-
-  PrepareDeps();
-  // Start execute Computation graph
-  std::queue<std::shared_ptr<GradOpNode>> q;
-  for (size_t i = 0; i < init_nodes_.size(); ++i) {
-    q.push(std::move(init_nodes_[i]));
-  }
-
+size_t BasicEngine::RunGradNode(const std::shared_ptr<GradOpNode>& node) {
   size_t op_num = 0;
+  auto& inplace_grad_name_map = node->InplaceGradNameMap();
+
+  for (auto& cur_op : *node) {
+    platform::RecordEvent op_type_record_event(cur_op.Type());
+
+    ++op_num;
+
+    // The output grad var of Inplace grad op. Because Inplace grad op does
+    // not use the Inplace strategy, a new output grad var needs to be
+    // created.
+    std::vector<std::pair<std::shared_ptr<VariableWrapper>,
+                          std::shared_ptr<VariableWrapper>>>
+        inplace_output_grad_var_list;
+    std::vector<
+        std::pair<GradientAccumulator*, std::shared_ptr<VariableWrapper>>>
+        need_accu_var_list;
+    // leaf_accumulators is only for leaf tensor(hooks/accumulate grad)
+    // It should be orderly and not repeated, because multiple cards must
+    // ensure that the order of vars is the same.
+    std::vector<GradientAccumulator*> leaf_accumulators;
+
+    // CheckBackWardInput
+    CheckBackwardInputs(cur_op);
+
+    // Step 1: Run Backward OP
+    auto& bwd_ins = cur_op.GetInsMap();
+    auto& bwd_outs = cur_op.GetOutsMap();
+
+    /**
+     * [ Why need temporary outputs here? ]
+     *
+     * - construct the temp output map, avoid to disrupt graph
+     * - replace the element in the map by temp var, because a
+     *   var may be coresponding to several grad var in one op
+     */
+    NameVarMap<VariableWrapper> tmp_outs(bwd_outs);
+
+    for (auto& pair : tmp_outs) {
+      if (!pair.second.IsGrad()) {
+        continue;
+      }
 
-  while (!q.empty()) {
-    auto shared_cur_node = std::move(q.front());
-    q.pop();
-
-    auto& inplace_grad_name_map = shared_cur_node->InplaceGradNameMap();
-
-    for (auto& cur_op : *shared_cur_node) {
-      platform::RecordEvent op_type_record_event(cur_op.Type());
-
-      ++op_num;
-
-      // CheckBackWardInput
-      CheckBackwardInputs(cur_op);
-
-      // Step 1: Run Backward OP
-      auto& bwd_ins = cur_op.GetInsMap();
-      auto& bwd_outs = cur_op.GetOutsMap();
-
-      /**
-       * [ Why need temporary outputs here? ]
-       *
-       * - construct the temp output map, avoid to disrupt graph
-       * - replace the element in the map by temp var, because a
-       *   var may be coresponding to several grad var in one op
-       */
-      NameVarMap<VariableWrapper> tmp_outs(bwd_outs);
-
-      for (auto& pair : tmp_outs) {
-        if (!pair.second.IsGrad()) {
+      for (auto& var : pair.second) {
+        if (!var) {
           continue;
         }
 
-        for (auto& var : pair.second) {
-          if (!var) {
-            continue;
-          }
-
-          std::unordered_map<VariableWrapper*,
-                             std::unique_ptr<GradientAccumulator>>::iterator
-              iter;
-          if (!var->HasGradNode()) {
-            VLOG(10) << "Find gradient of var (" << var->Name()
-                     << ") with no grad_node.";
-            iter = accumulators_.find(var.get());
-            PADDLE_ENFORCE_EQ(
-                iter != accumulators_.end(), true,
-                platform::errors::NotFound(
-                    "Cannot find gradient of variable %s", var->Name()));
-          } else {
-            bool flag_find_grad = false;
-            VLOG(10) << "Find gradient of var (" << var->Name()
-                     << ") with grad_node.";
-            for (auto& grad_pending_node :
-                 shared_cur_node->GradPendingNodes()) {
-              const auto& iter_grad_node =
-                  accumulators_with_grad_node_.find(grad_pending_node);
-              if (iter_grad_node != accumulators_with_grad_node_.end()) {
-                iter = iter_grad_node->second.find(var.get());
-                if (iter != iter_grad_node->second.end()) {
-                  flag_find_grad = true;
-                  break;
-                }
+        std::unordered_map<VariableWrapper*,
+                           std::unique_ptr<GradientAccumulator>>::iterator
+            iter;
+        if (!var->HasGradNode()) {
+          VLOG(10) << "Find gradient of var (" << var->Name()
+                   << ") with no grad_node.";
+          iter = accumulators_.find(var.get());
+          PADDLE_ENFORCE_EQ(
+              iter != accumulators_.end(), true,
+              platform::errors::NotFound(
+                  "Cannot find gradient of variable %s", var->Name()));
+        } else {
+          bool flag_find_grad = false;
+          VLOG(10) << "Find gradient of var (" << var->Name()
+                   << ") with grad_node.";
+          for (auto& grad_pending_node :
+               node->GradPendingNodes()) {
+            const auto& iter_grad_node =
+                accumulators_with_grad_node_.find(grad_pending_node);
+            if (iter_grad_node != accumulators_with_grad_node_.end()) {
+              iter = iter_grad_node->second.find(var.get());
+              if (iter != iter_grad_node->second.end()) {
+                flag_find_grad = true;
+                break;
               }
             }
-            PADDLE_ENFORCE_EQ(
-                flag_find_grad, true,
-                platform::errors::NotFound(
-                    "Cannot find gradient of variable %s", var->Name()));
           }
+          PADDLE_ENFORCE_EQ(
+              flag_find_grad, true,
+              platform::errors::NotFound(
+                  "Cannot find gradient of variable %s", var->Name()));
+        }
 
-          // leaf_accumulators_ : hooks and accumulate-grad for leaf tensor,
-          // it should be orderly and not reapeated.
-          if (var->IsLeafGrad()) {
-            if (std::find(leaf_accumulators_.begin(), leaf_accumulators_.end(),
-                          iter->second.get()) == leaf_accumulators_.end()) {
-              leaf_accumulators_.push_back(iter->second.get());
-            }
+        // leaf_accumulators : hooks and accumulate-grad for leaf tensor,
+        // it should be orderly and not reapeated.
+        if (var->IsLeafGrad()) {
+          if (std::find(leaf_accumulators.begin(), leaf_accumulators.end(),
+                        iter->second.get()) == leaf_accumulators.end()) {
+            leaf_accumulators.push_back(iter->second.get());
+          }
 
-            if (iter->second->HasInnerVar()) {
-              var = iter->second->InnerVar();
-            }
+          if (iter->second->HasInnerVar()) {
+            var = iter->second->InnerVar();
           }
+        }
 
-          if (var->OverridedStopGradient() || iter->second->RefCnt() > 1) {
-            auto tmp_var = std::make_shared<VariableWrapper>(var->Name());
-            tmp_var->SetType(var->Type());
-            tmp_var->SetForwardDataType(var->ForwardDataType());
-            var = tmp_var;
-            need_accu_var_list_.emplace_back(iter->second.get(), var);
-            VLOG(10) << "create temporary var of " << var->Name()
-                     << " for sum gradient within this graph!";
-          } else if (!inplace_grad_name_map.empty() &&
-                     inplace_grad_name_map.count(pair.first) &&
-                     bwd_ins.count(inplace_grad_name_map.at(pair.first))) {
-            // When calculate Inplace grad op, create a new output var.
-            // If a tmp var has been created, there is no need to create it
-            // again.
-            for (auto& in_var :
-                 bwd_ins.at(inplace_grad_name_map.at(pair.first))) {
-              if (in_var == var) {
-                auto tmp_var = std::make_shared<VariableWrapper>(var->Name());
-                tmp_var->SetType(var->Type());
-                tmp_var->SetForwardDataType(var->ForwardDataType());
-                inplace_output_grad_var_list_.emplace_back(var, tmp_var);
-                var = tmp_var;
-                VLOG(10) << "Inplace grad op does not use the Inplace "
-                            "strategy, a temporary output var ("
-                         << var->Name() << ") will be created.";
-                break;
-              }
+        if (var->OverridedStopGradient() || iter->second->RefCnt() > 1) {
+          auto tmp_var = std::make_shared<VariableWrapper>(var->Name());
+          tmp_var->SetType(var->Type());
+          tmp_var->SetForwardDataType(var->ForwardDataType());
+          var = tmp_var;
+          need_accu_var_list.emplace_back(iter->second.get(), var);
+          VLOG(10) << "create temporary var of " << var->Name()
+                   << " for sum gradient within this graph!";
+        } else if (!inplace_grad_name_map.empty() &&
+                   inplace_grad_name_map.count(pair.first) &&
+                   bwd_ins.count(inplace_grad_name_map.at(pair.first))) {
+          // When calculate Inplace grad op, create a new output var.
+          // If a tmp var has been created, there is no need to create it
+          // again.
+          for (auto& in_var :
+               bwd_ins.at(inplace_grad_name_map.at(pair.first))) {
+            if (in_var == var) {
+              auto tmp_var = std::make_shared<VariableWrapper>(var->Name());
+              tmp_var->SetType(var->Type());
+              tmp_var->SetForwardDataType(var->ForwardDataType());
+              inplace_output_grad_var_list.emplace_back(var, tmp_var);
+              var = tmp_var;
+              VLOG(10) << "Inplace grad op does not use the Inplace "
+                          "strategy, a temporary output var ("
+                       << var->Name() << ") will be created.";
+              break;
             }
           }
         }
       }
+    }
 
-      VLOG(4) << "Check whether there is any inplace operation affecting "
-                 "gradient calculation.";
-      for (auto& pair : bwd_ins) {
-        for (auto& var_wrapper : pair.second) {
-          auto wrapper_version_snapshot = var_wrapper->InplaceVersionSnapshot();
-          auto tensor_version =
-              var_wrapper->MutableVar()->CurrentInplaceVersion();
-          PADDLE_ENFORCE_EQ(
-              tensor_version, wrapper_version_snapshot,
-              platform::errors::PermissionDenied(
-                  "Tensor '%s' used in gradient computation in grad op '%s' "
-                  "has been "
-                  "modified by an inplace operation. "
-                  "Its version is %s but the expected version is %s. "
-                  "Please fix your code to void calling an inplace operator "
-                  "after using the Tensor which will used in gradient "
-                  "computation.",
-                  var_wrapper->Name(), cur_op.Type(), tensor_version,
-                  wrapper_version_snapshot));
-
-          VLOG(6) << " The version of Tensor '" << var_wrapper->Name()
-                  << "' is [ " << wrapper_version_snapshot << " ]";
-        }
+    VLOG(4) << "Check whether there is any inplace operation affecting "
+               "gradient calculation.";
+    for (auto& pair : bwd_ins) {
+      for (auto& var_wrapper : pair.second) {
+        auto wrapper_version_snapshot = var_wrapper->InplaceVersionSnapshot();
+        auto tensor_version =
+            var_wrapper->MutableVar()->CurrentInplaceVersion();
+        PADDLE_ENFORCE_EQ(
+            tensor_version, wrapper_version_snapshot,
+            platform::errors::PermissionDenied(
+                "Tensor '%s' used in gradient computation in grad op '%s' "
+                "has been "
+                "modified by an inplace operation. "
+                "Its version is %s but the expected version is %s. "
+                "Please fix your code to void calling an inplace operator "
+                "after using the Tensor which will used in gradient "
+                "computation.",
+                var_wrapper->Name(), cur_op.Type(), tensor_version,
+                wrapper_version_snapshot));
+
+        VLOG(6) << " The version of Tensor '" << var_wrapper->Name()
+                << "' is [ " << wrapper_version_snapshot << " ]";
       }
+    }
 
-      /**
-       * [ Why need temporary inputs here? ]
-       *
-       * - Hook execution should not change original input tensor.
-       *   User can register hook for Tensor's gradient, It is expected
-       *   that the hook only affects the gradient of the backward
-       *   propagation, and does not affect the gradient value input
-       *   as the hook.
-       * - use `tmp_ins_ptr`, only copy bwd_ins when the var in bwd_ins
-       *   hold hooks
-       */
-      auto tmp_ins_ptr = CallGradientHooks(bwd_ins, cur_op.Type());
-
-      {
-        VLOG(3) << "Start to execute grad op " << cur_op.Type();
-        try {
-          if (tmp_ins_ptr == nullptr) {
-            OpBase::Run(cur_op.InnerOp(), bwd_ins, tmp_outs, cur_op.Attrs(),
-                        cur_op.DefaultAttrsMap(), cur_op.place());
-          } else {
-            OpBase::Run(cur_op.InnerOp(), *tmp_ins_ptr, tmp_outs,
-                        cur_op.Attrs(), cur_op.DefaultAttrsMap(),
-                        cur_op.place());
-          }
-        } catch (platform::EnforceNotMet& exception) {
-          Clear();
-          throw std::move(exception);
-        } catch (std::exception& ex) {
-          Clear();
-          PADDLE_THROW(platform::errors::External("%s", ex.what()));
+    /**
+     * [ Why need temporary inputs here? ]
+     *
+     * - Hook execution should not change original input tensor.
+     *   User can register hook for Tensor's gradient, It is expected
+     *   that the hook only affects the gradient of the backward
+     *   propagation, and does not affect the gradient value input
+     *   as the hook.
+     * - use `tmp_ins_ptr`, only copy bwd_ins when the var in bwd_ins
+     *   hold hooks
+     */
+    auto tmp_ins_ptr = CallGradientHooks(bwd_ins, cur_op.Type());
+
+    {
+      VLOG(3) << "Start to execute grad op " << cur_op.Type();
+      try {
+        if (tmp_ins_ptr == nullptr) {
+          OpBase::Run(cur_op.InnerOp(), bwd_ins, tmp_outs, cur_op.Attrs(),
+                      cur_op.DefaultAttrsMap(), cur_op.place());
+        } else {
+          OpBase::Run(cur_op.InnerOp(), *tmp_ins_ptr, tmp_outs,
+                      cur_op.Attrs(), cur_op.DefaultAttrsMap(),
+                      cur_op.place());
         }
+      } catch (platform::EnforceNotMet& exception) {
+        throw std::move(exception);
+      } catch (std::exception& ex) {
+        PADDLE_THROW(platform::errors::External("%s", ex.what()));
       }
+    }
 
-      for (auto& pair : inplace_output_grad_var_list_) {
-        *pair.first = std::move(*pair.second);
-      }
+    for (auto& pair : inplace_output_grad_var_list) {
+      *pair.first = std::move(*pair.second);
+    }
 
-      // Step 2: Sum Gradient of This graph
-      for (auto& pair : need_accu_var_list_) {
-        pair.first->SumGrad(std::move(pair.second), cur_op.id());
+    // Step 2: Sum Gradient of This graph
+    for (auto& pair : need_accu_var_list) {
+      std::lock_guard<std::mutex> guard(pair.first->Mutex());
+      pair.first->SumGrad(std::move(pair.second), cur_op.id());
+    }
+
+    // Step 3: Call Hooks && Sum Gradient with Pre-Graph && Call BackwardHooks
+    for (auto* accumulator : leaf_accumulators) {
+      std::lock_guard<std::mutex> guard(accumulator->Mutex());
+      // The inner var is released once the gradient is accumulated, which
+      // is checked for the grad ops summing their gradients in parallel.
+      if (!accumulator->SumGradCompleted() || !accumulator->HasInnerVar()) {
+        continue;
       }
+      // 1. Call Hooks for `inner_var_`
+      accumulator->CallGradientHooks();
 
-      // Step 3: Call Hooks && Sum Gradient with Pre-Graph && Call BackwardHooks
-      for (auto* accumulator : leaf_accumulators_) {
-        if (!accumulator->SumGradCompleted()) {
-          continue;
-        }
-        // 1. Call Hooks for `inner_var_`
-        accumulator->CallGradientHooks();
+      // 2. Sum Gradient `inner_var_` to `var_` of Current or Previous Graph
+      accumulator->AccumulateGrad();
 
-        // 2. Sum Gradient `inner_var_` to `var_` of Current or Previous Graph
-        accumulator->AccumulateGrad();
+      // 3. Call backward Hooks for `var_`
+      accumulator->CallReduceHooks();
+    }
 
-        // 3. Call backward Hooks for `var_`
-        accumulator->CallReduceHooks();
-      }
+    if (!retain_graph_) {
+      VLOG(3) << "Remove op after op " << cur_op.Type() << " runs";
+      cur_op.ClearBackwardTrace();
+    }
+  }
+  return op_num;
+}
 
-      need_accu_var_list_.clear();
-      inplace_output_grad_var_list_.clear();
-      leaf_accumulators_.clear();
+void BasicEngine::Execute() {
+  if (init_nodes_.empty()) {
+    return;
+  }
 
-      if (!retain_graph_) {
-        VLOG(3) << "Remove op after op " << cur_op.Type() << " runs";
-        cur_op.ClearBackwardTrace();
-      }
+  PrepareDeps();
+  if (CanRunInParallel()) {
+    ExecuteParallel();
+    return;
+  }
+
+  // Start execute Computation graph
+  std::queue<std::shared_ptr<GradOpNode>> q;
+  for (size_t i = 0; i < init_nodes_.size(); ++i) {
+    q.push(std::move(init_nodes_[i]));
+  }
+
+  size_t op_num = 0;
+
+  while (!q.empty()) {
+    auto shared_cur_node = std::move(q.front());
+    q.pop();
+
+    try {
+      op_num += RunGradNode(shared_cur_node);
+    } catch (...) {
+      Clear();
+      throw;
     }
 
     // Step 3: Collect ready ops
@@ -543,13 +577,106 @@ void BasicEngine::Execute() {
   VLOG(1) << "Backward op number: " << op_num;
 }
 
+bool BasicEngine::CanRunInParallel() const {
+  if (FLAGS_dygraph_backward_num_threads <= 1 || !cpu_only_ ||
+      node_deps_.empty()) {
+    return false;
+  }
+  // The reduce hooks of the data parallel training must be called in the
+  // same order on all the cards.
+  for (auto& pair : accumulators_) {
+    if (pair.first->HasVoidHook()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * [ How are the grad nodes run in parallel? ]
+ *
+ * - The nodes are scheduled by their dependencies counted in atomics, as in
+ *   the FastThreadedSSAGraphExecutor: a task of the pool runs a node, then
+ *   continues with one of the nodes it makes ready, and the others are run
+ *   by the new tasks.
+ * - The gradients of a var summed by the grad ops of several nodes are
+ *   summed under the lock of its accumulator, so the sums of
+ *   EagerGradientAccumulator are in the order the ops finish, and those of
+ *   SortedGradientAccumulator (FLAGS_sort_sum_gradient) are deterministic.
+ * - Once an op fails, no more nodes are scheduled, and the exception is
+ *   thrown after the running ones finish.
+ */
+void BasicEngine::ExecuteParallel() {
+  size_t num_threads = FLAGS_dygraph_backward_num_threads;
+  if (pool_ == nullptr || pool_size_ != num_threads) {
+    pool_.reset(new ::ThreadPool(num_threads));
+    pool_size_ = num_threads;
+  }
+
+  for (auto& pair : node_deps_) {
+    atomic_node_deps_[pair.first] = pair.second;
+  }
+  num_tasks_ = 0;
+  op_num_ = 0;
+  exception_.Clear();
+
+  auto complete_q = std::make_shared<framework::BlockingQueue<size_t>>();
+  for (auto& init_node : init_nodes_) {
+    RunGradNodeAsync(std::move(init_node), complete_q);
+  }
+  // The tasks are added by the running tasks before they complete.
+  size_t num_complete = 0;
+  while (num_complete != num_tasks_) {
+    num_complete += complete_q->Pop();
+  }
+  atomic_node_deps_.clear();
+  Clear();
+  if (exception_.IsCaught()) {
+    exception_.ReThrow();
+  }
+
+  VLOG(1) << "Backward op number: " << op_num_ << " on " << num_threads
+          << " threads";
+}
+
+void BasicEngine::RunGradNodeAsync(
+    std::shared_ptr<GradOpNode> node,
+    const std::shared_ptr<framework::BlockingQueue<size_t>>& complete_q) {
+  ++num_tasks_;
+  pool_->enqueue([this, node, complete_q]() mutable {
+    auto cur_node = std::move(node);
+    while (cur_node != nullptr && !exception_.IsCaught()) {
+      try {
+        op_num_ += RunGradNode(cur_node);
+      } catch (...) {
+        exception_.Catch(std::current_exception());
+        break;
+      }
+
+      std::shared_ptr<GradOpNode> next_node;
+      for (auto& grad_pending_node : cur_node->GradPendingNodes()) {
+        auto iter = atomic_node_deps_.find(grad_pending_node.get());
+        if (iter == atomic_node_deps_.end() ||
+            iter->second.fetch_sub(1) != 1) {
+          continue;
+        }
+        if (next_node == nullptr) {
+          next_node = grad_pending_node;
+        } else {
+          RunGradNodeAsync(grad_pending_node, complete_q);
+        }
+      }
+      cur_node = std::move(next_node);
+    }
+    complete_q->Push(1);
+  });
+}
+
 void BasicEngine::Clear() {
   init_nodes_.clear();
   node_deps_.clear();
   accumulators_.clear();
   accumulators_with_grad_node_.clear();
-  need_accu_var_list_.clear();
-  leaf_accumulators_.clear();
 }
 
 }  // namespace imperative
@@ -14,11 +14,15 @@
 
 #pragma once
 
+#include <ThreadPool.h>
+#include <atomic>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
+#include "paddle/fluid/framework/blocking_queue.h"
+#include "paddle/fluid/framework/details/exception_holder.h"
 #include "paddle/fluid/imperative/engine.h"
 #include "paddle/fluid/imperative/gradient_accumulator.h"
 
@@ -45,11 +49,29 @@ class BasicEngine : public Engine {
       const OpBase& op,
       const std::vector<std::shared_ptr<GradOpNode>>& grad_pending_nodes);
 
+  // Run the grad ops of the node, and sum their output gradients. Returns
+  // the number of the ops run.
+  size_t RunGradNode(const std::shared_ptr<GradOpNode>& node);
+
+  // Whether the grad nodes can run on the pool of
+  // FLAGS_dygraph_backward_num_threads threads.
+  bool CanRunInParallel() const;
+
+  void ExecuteParallel();
+
+  // Run the node on the pool, then the nodes it makes ready, one of them on
+  // the same thread and the others on the pool.
+  void RunGradNodeAsync(
+      std::shared_ptr<GradOpNode> node,
+      const std::shared_ptr<framework::BlockingQueue<size_t>>& complete_q);
+
   void Clear();
 
  private:
   std::vector<std::shared_ptr<GradOpNode>> init_nodes_;
   std::unordered_map<GradOpNode*, size_t> node_deps_;
+  // Whether all the grad ops run on CPU, found by PrepareDeps.
+  bool cpu_only_{true};
   // The input and output of Inplace op are the same. If only `var` is used
   // as the key, then the input and output of inplace op must be gradient
   // accumulated. Therefore, add the `grad_node` as the key to prevent the
@@ -63,19 +85,17 @@ class BasicEngine : public Engine {
   // `var` as the key.
   std::unordered_map<VariableWrapper*, std::unique_ptr<GradientAccumulator>>
       accumulators_;
-  // The output grad var of Inplace grad op. Because Inplace grad op does not
-  // use the Inplace strategy, a new output grad var needs to be created.
-  std::vector<std::pair<std::shared_ptr<VariableWrapper>,
-                        std::shared_ptr<VariableWrapper>>>
-      inplace_output_grad_var_list_;
-  std::vector<std::pair<GradientAccumulator*, std::shared_ptr<VariableWrapper>>>
-      need_accu_var_list_;
-  // leaf_accumulators_ is only for leaf tensor(hooks/accumulate grad)
-  // It should be orderly and not repeated, because multiple cards must ensure
-  // that the order of vars is the same.
-  std::vector<GradientAccumulator*> leaf_accumulators_;
 
   bool retain_graph_;
+
+  // The state of the parallel backward, see ExecuteParallel.
+  std::unordered_map<GradOpNode*, std::atomic<size_t>> atomic_node_deps_;
+  std::atomic<size_t> num_tasks_{0};
+  std::atomic<size_t> op_num_{0};
+  framework::details::ExceptionHolder exception_;
+  // NOTE: the pool is placed last, so that it is destroyed first.
+  std::unique_ptr<::ThreadPool> pool_;
+  size_t pool_size_{0};
 };
 
 }  // namespace imperative
@@ -0,0 +1,86 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#if defined(PADDLE_WITH_GLOO)
+#include "paddle/fluid/imperative/cpu_parallel_context.h"
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/tensor_util.h"
+#include "paddle/fluid/framework/variable.h"
+#include "paddle/fluid/platform/cpu_collective.h"
+#include "paddle/fluid/platform/device_context.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace imperative {
+
+void CPUParallelContext::Init() {
+  for (int ring_id = 0; ring_id < strategy_.nrings_; ++ring_id) {
+    InitWithRingID(ring_id);
+  }
+}
+
+void CPUParallelContext::InitWithRingID(int ring_id) {
+  PADDLE_ENFORCE_EQ(
+      strategy_.trainer_endpoints_.size(),
+      static_cast<size_t>(strategy_.nranks_),
+      platform::errors::InvalidArgument(
+          "The number of trainer endpoints %d should be equal to nranks %d.",
+          strategy_.trainer_endpoints_.size(), strategy_.nranks_));
+  VLOG(0) << "init CPU context nranks: " << strategy_.nranks_
+          << " local rank: " << strategy_.local_rank_
+          << " ring id: " << ring_id;
+  platform::CPUCommContext::Instance().CreateComm(
+      strategy_.trainer_endpoints_, strategy_.local_rank_, ring_id);
+}
+
+void CPUParallelContext::AllReduceByStream(const framework::Variable &src,
+                                           framework::Variable *dst,
+                                           int ring_id, bool use_calc_stream) {
+  PADDLE_ENFORCE_EQ(
+      platform::is_cpu_place(place_), true,
+      platform::errors::InvalidArgument(
+          "CPUParallelContext only supports CPUPlace, but got %s.", place_));
+  if (!src.IsType<framework::LoDTensor>()) {
+    PADDLE_THROW(platform::errors::Unimplemented(
+        "Unsupported variable type %s for the imperative allreduce on the "
+        "CPU, only LoDTensor is supported.",
+        platform::demangle(framework::ToTypeName(src.Type()))));
+  }
+  if (!dst->IsType<framework::LoDTensor>()) {
+    dst->Clear();
+  }
+  const auto &src_tensor = src.Get<framework::LoDTensor>();
+  auto *dst_tensor = dst->GetMutable<framework::LoDTensor>();
+  if (dst_tensor != &src_tensor) {
+    framework::TensorCopySync(src_tensor, place_, dst_tensor);
+  }
+  platform::CPUCommContext::Instance().Get(ring_id)->AllReduceGradient(
+      dst_tensor->data<void>(), dst_tensor->numel(), dst_tensor->type());
+}
+
+paddle::platform::DeviceContext *CPUParallelContext::GetDeviceContext(
+    int ring_id) {
+  return platform::DeviceContextPool::Instance().Get(place_);
+}
+
+void CPUParallelContext::WaitCompute(int ring_id) {}
+
+void CPUParallelContext::WaitComm(int ring_id) {}
+
+void CPUParallelContext::SynchronizeCompute() {}
+
+}  //  namespace imperative
+}  //  namespace paddle
+#endif
@@ -0,0 +1,53 @@
+//   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#pragma once
+
+#if defined(PADDLE_WITH_GLOO)
+#include "paddle/fluid/imperative/parallel_context.h"
+
+namespace paddle {
+namespace imperative {
+
+// The collective training on the CPU by platform::CPUComm, one comm per
+// ring connecting the trainers. The all reduce runs on the calling thread,
+// so there are no streams to wait for.
+class CPUParallelContext : public ParallelContext {
+ public:
+  explicit CPUParallelContext(const ParallelStrategy& strategy,
+                              const platform::Place& place)
+      : ParallelContext(strategy, place) {}
+
+  ~CPUParallelContext() override = default;
+
+  void Init() override;
+
+  void InitWithRingID(int ring_id) override;
+
+  void AllReduceByStream(const framework::Variable& src,
+                         framework::Variable* dst, int ring_id,
+                         bool use_calc_stream) override;
+
+  paddle::platform::DeviceContext* GetDeviceContext(int ring_id) override;
+
+  void WaitCompute(int ring_id) override;
+
+  void WaitComm(int ring_id) override;
+
+  void SynchronizeCompute() override;
+};
+
+}  //  namespace imperative
+}  //  namespace paddle
+
+#endif
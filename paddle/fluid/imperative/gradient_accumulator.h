@@ -15,6 +15,7 @@
 #pragma once
 
 #include <memory>
+#include <mutex>  // NOLINT
 #include <utility>
 #include <vector>
 
@@ -90,6 +91,10 @@ class GradientAccumulator {
 
   inline bool HasInnerVar() const { return inner_var_ != nullptr; }
 
+  // Held by BasicEngine around SumGrad and the hooks, for the grad ops may
+  // sum their gradients to the var in parallel.
+  std::mutex& Mutex() { return mutex_; }
+
   // function that Sum Gradient with Previous Graph
   void AccumulateGrad();
 
@@ -130,6 +135,7 @@ class GradientAccumulator {
   std::shared_ptr<VariableWrapper> inner_var_;
   size_t ref_cnt_{0};
   size_t cur_cnt_{0};
+  std::mutex mutex_;
 };
 
 class EagerGradientAccumulator : public GradientAccumulator {
@@ -0,0 +1,143 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/imperative/jit/step_capture.h"
+
+#include <unordered_set>
+
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/imperative/basic_engine.h"
+#include "paddle/fluid/imperative/layer.h"
+#include "paddle/fluid/imperative/op_base.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace imperative {
+namespace jit {
+
+void StepCapture::InsertOp(const std::string &type, const NameVarBaseMap &ins,
+                           const NameVarBaseMap &outs,
+                           const framework::AttributeMap &attrs,
+                           const framework::AttributeMap &default_attrs,
+                           const platform::Place &place) {
+  PADDLE_ENFORCE_EQ(finished_, false,
+                    platform::errors::PreconditionNotMet(
+                        "The step capture is finished, and can not capture "
+                        "the op %s.",
+                        type));
+  auto &op = operators_[type];
+  if (op == nullptr) {
+    op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  }
+  entries_.emplace_back();
+  entries_.back().op.reset(
+      new CapturedOp{op.get(), ins, outs, attrs, &default_attrs, place});
+}
+
+void StepCapture::Backward(
+    BasicEngine *engine, const std::vector<std::shared_ptr<VarBase>> &tensors,
+    const std::vector<std::shared_ptr<VarBase>> &grad_tensors) {
+  PADDLE_ENFORCE_EQ(finished_, false,
+                    platform::errors::PreconditionNotMet(
+                        "The step capture is finished, and can not capture "
+                        "the backward."));
+  engine->Init(tensors, grad_tensors, /*retain_graph=*/true);
+  engine->Execute();
+  entries_.emplace_back();
+  entries_.back().backward.reset(
+      new CapturedBackward{engine, tensors, grad_tensors});
+}
+
+void StepCapture::Finish() {
+  std::unordered_set<VarBase *> visited;
+  for (auto &entry : entries_) {
+    if (entry.op == nullptr) continue;
+    for (auto &pair : entry.op->ins) {
+      for (auto &var : pair.second) {
+        if (var == nullptr || !visited.insert(var.get()).second) continue;
+        if (var->Var().IsType<framework::LoDTensor>()) {
+          inputs_.emplace_back(var,
+                               var->Var().Get<framework::LoDTensor>().dims());
+        }
+      }
+    }
+    for (auto &pair : entry.op->outs) {
+      for (auto &var : pair.second) {
+        if (var != nullptr) visited.insert(var.get());
+      }
+    }
+  }
+  finished_ = true;
+  VLOG(3) << "Captured " << OpNum() << " ops and " << entries_.size() - OpNum()
+          << " backward of " << inputs_.size() << " inputs";
+}
+
+bool StepCapture::Replay() {
+  PADDLE_ENFORCE_EQ(finished_, true,
+                    platform::errors::PreconditionNotMet(
+                        "The step capture is not finished before replaying."));
+  for (auto &pair : inputs_) {
+    auto &var = pair.first->Var();
+    if (!var.IsType<framework::LoDTensor>() ||
+        var.Get<framework::LoDTensor>().dims() != pair.second) {
+      VLOG(3) << "The dims of the input " << pair.first->Name()
+              << " differ from the captured step";
+      return false;
+    }
+  }
+
+  for (auto &entry : entries_) {
+    if (entry.backward != nullptr) {
+      auto &backward = *entry.backward;
+      backward.engine->Init(backward.tensors, backward.grad_tensors,
+                            /*retain_graph=*/true);
+      backward.engine->Execute();
+      continue;
+    }
+    auto &op = *entry.op;
+    platform::RecordEvent op_type_record_event(op.op->Type());
+#if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
+    if (platform::is_gpu_place(op.place)) {
+      platform::SetDeviceId(
+          BOOST_GET_CONST(platform::CUDAPlace, op.place).device);
+    }
+#endif
+    try {
+      OpBase::Run(*op.op, op.ins, op.outs, op.attrs, *op.default_attrs,
+                  op.place);
+    } catch (platform::EnforceNotMet &exception) {
+      framework::AppendErrorOpHint(op.op->Type(), &exception);
+      throw std::move(exception);
+    }
+  }
+  return true;
+}
+
+size_t StepCapture::OpNum() const {
+  size_t op_num = 0;
+  for (auto &entry : entries_) {
+    if (entry.op != nullptr) ++op_num;
+  }
+  return op_num;
+}
+
+void StepCapture::Reset() {
+  finished_ = false;
+  entries_.clear();
+  inputs_.clear();
+}
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
@@ -0,0 +1,119 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/imperative/type_defs.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace imperative {
+class BasicEngine;
+class VarBase;
+}  // namespace imperative
+}  // namespace paddle
+
+namespace paddle {
+namespace imperative {
+namespace jit {
+
+/*
+ * Capture the ops and the backward of a dygraph step, and replay them on the
+ * same vars in the later steps, without the Python code, the tracing and the
+ * creation of the grad graph.
+ *
+ * The ops are captured with the vars they ran on, so a replay reads the
+ * inputs fed to those vars and writes the outputs to them, e.g. the loss.
+ * The backward is run with the grad graph retained, which is run again by
+ * the replays. The calls not traced, such as clear_grad, are left to the
+ * caller between the replays.
+ *
+ * A replay holds for the input dims of the captured step, and is refused if
+ * they differ. A change of the control flow in Python can not be seen here,
+ * so the caller must capture again if a step would take other branches.
+ */
+class StepCapture {
+  DISABLE_COPY_AND_ASSIGN(StepCapture);
+
+ public:
+  StepCapture() = default;
+
+  // Capture an op run by the tracer.
+  void InsertOp(const std::string &type, const NameVarBaseMap &ins,
+                const NameVarBaseMap &outs,
+                const framework::AttributeMap &attrs,
+                const framework::AttributeMap &default_attrs,
+                const platform::Place &place);
+
+  // Run the backward from the tensors by the engine, and capture it.
+  void Backward(BasicEngine *engine,
+                const std::vector<std::shared_ptr<VarBase>> &tensors,
+                const std::vector<std::shared_ptr<VarBase>> &grad_tensors);
+
+  // Stop capturing. The dims of the inputs of the step, the vars read before
+  // written by the ops, are kept to check the replays.
+  void Finish();
+
+  bool IsFinished() const { return finished_; }
+
+  // Run the captured step. Returns false without running anything if the
+  // dims of the inputs differ from the captured ones.
+  bool Replay();
+
+  size_t OpNum() const;
+
+  void Reset();
+
+ private:
+  struct CapturedOp {
+    const framework::OperatorBase *op;
+    NameVarBaseMap ins;
+    NameVarBaseMap outs;
+    framework::AttributeMap attrs;
+    const framework::AttributeMap *default_attrs;
+    platform::Place place;
+  };
+
+  struct CapturedBackward {
+    BasicEngine *engine;
+    std::vector<std::shared_ptr<VarBase>> tensors;
+    std::vector<std::shared_ptr<VarBase>> grad_tensors;
+  };
+
+  // An op, or a backward if op is nullptr.
+  struct CapturedEntry {
+    std::unique_ptr<CapturedOp> op;
+    std::unique_ptr<CapturedBackward> backward;
+  };
+
+  bool finished_{false};
+  std::vector<CapturedEntry> entries_;
+  // The operators of the op types, which hold no state in dygraph.
+  std::unordered_map<std::string, std::unique_ptr<framework::OperatorBase>>
+      operators_;
+  std::vector<std::pair<std::shared_ptr<VarBase>, framework::DDim>> inputs_;
+};
+
+}  // namespace jit
+}  // namespace imperative
+}  // namespace paddle
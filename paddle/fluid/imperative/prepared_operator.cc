@@ -14,6 +14,9 @@
 
 #include "paddle/fluid/imperative/prepared_operator.h"
 
+#include <unordered_map>
+#include <vector>
+
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/details/nan_inf_utils.h"
 #include "paddle/fluid/imperative/infer_shape_context.h"
@@ -86,35 +89,32 @@ PreparedOp::PreparedOp(const framework::OperatorBase& op,
       func_(func),
       dev_ctx_(dev_ctx) {}
 
-template <typename VarType>
-PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
-                       const NameVarMap<VarType>& outs,
-                       const framework::OperatorWithKernel& op,
-                       const platform::Place& place,
-                       const framework::AttributeMap& attrs,
-                       const framework::AttributeMap& default_attrs) {
-  platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
-  auto* dev_ctx = pool.Get(place);
-
-  framework::RuntimeContext ctx({}, {});
+// The kernel resolved for an expected kernel type of an op type, which may
+// fall back to another place.
+struct ResolvedKernel {
+  framework::OpKernelType expected_kernel_key;
+  framework::OpKernelType kernel_key;
+  const framework::OperatorWithKernel::OpKernelFunc* func;
+};
 
-#ifdef PADDLE_WITH_MKLDNN
-  // MKLDNN variant of code reads attributes in some of GetKernelTypeForVar and
-  // GetKernelType functions, so we need to copy the attributes there.
-  // Const qualifier of Attrs had to be discarded to overwrite it.
-  if (FLAGS_use_mkldnn) {
-    auto& mutable_op_attrs = const_cast<framework::AttributeMap&>(op.Attrs());
-    mutable_op_attrs = attrs;
+// The kernels are resolved once by the op types and the expected kernel
+// types, i.e. the data types, places and layouts of the inputs, instead of
+// looking up the registry by the op type strings every time. An op type runs
+// with a few kernel types, so they are searched linearly.
+static ResolvedKernel ResolveKernel(
+    const framework::OperatorWithKernel& op,
+    const framework::OpKernelType& expected_kernel_type) {
+  thread_local std::unordered_map<const framework::OpInfo*,
+                                  std::vector<ResolvedKernel>>
+      resolved_kernels;
+  auto& resolved = resolved_kernels[&op.Info()];
+  for (auto& kernel : resolved) {
+    if (kernel.expected_kernel_key == expected_kernel_type) {
+      return kernel;
+    }
   }
-#endif
 
-  // 1. get expected kernel key
-  auto expected_kernel_key = op.GetExpectedKernelType(
-      DygraphExecutionContext<VarType>(op, framework::Scope(), *dev_ctx, ctx,
-                                       ins, outs, attrs, default_attrs));
-  VLOG(3) << "expected_kernel_key:" << expected_kernel_key;
-
-  // 2. check if op[type] has kernel registered.
+  auto expected_kernel_key = expected_kernel_type;
   auto& all_op_kernels = op.AllOpKernels();
   auto kernels_iter = all_op_kernels.find(op.Type());
   PADDLE_ENFORCE_NE(
@@ -151,11 +151,48 @@ PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
                         "Operator %s does not have kernel for %s.", op.Type(),
                         KernelTypeToString(expected_kernel_key)));
 
+  resolved.push_back(
+      {expected_kernel_type, expected_kernel_key, &kernel_iter->second});
+  return resolved.back();
+}
+
+template <typename VarType>
+PreparedOp PrepareImpl(const NameVarMap<VarType>& ins,
+                       const NameVarMap<VarType>& outs,
+                       const framework::OperatorWithKernel& op,
+                       const platform::Place& place,
+                       const framework::AttributeMap& attrs,
+                       const framework::AttributeMap& default_attrs) {
+  platform::DeviceContextPool& pool = platform::DeviceContextPool::Instance();
+  auto* dev_ctx = pool.Get(place);
+
+  framework::RuntimeContext ctx({}, {});
+
+#ifdef PADDLE_WITH_MKLDNN
+  // MKLDNN variant of code reads attributes in some of GetKernelTypeForVar and
+  // GetKernelType functions, so we need to copy the attributes there.
+  // Const qualifier of Attrs had to be discarded to overwrite it.
+  if (FLAGS_use_mkldnn) {
+    auto& mutable_op_attrs = const_cast<framework::AttributeMap&>(op.Attrs());
+    mutable_op_attrs = attrs;
+  }
+#endif
+
+  // 1. get expected kernel key
+  auto expected_kernel_key = op.GetExpectedKernelType(
+      DygraphExecutionContext<VarType>(op, framework::Scope(), *dev_ctx, ctx,
+                                       ins, outs, attrs, default_attrs));
+  VLOG(3) << "expected_kernel_key:" << expected_kernel_key;
+
+  // 2. check if op[type] has kernel registered.
+  auto kernel = ResolveKernel(op, expected_kernel_key);
+  expected_kernel_key = kernel.kernel_key;
+
   if (!(expected_kernel_key.place_ == place)) {
     dev_ctx = pool.Get(expected_kernel_key.place_);
   }
 
-  return PreparedOp(op, ctx, expected_kernel_key, kernel_iter->second, dev_ctx);
+  return PreparedOp(op, ctx, expected_kernel_key, *kernel.func, dev_ctx);
 }
 
 PreparedOp PreparedOp::Prepare(const NameVarMap<VarBase>& ins,
@@ -165,6 +165,20 @@ TEST(TestGroup, TestConcatSplitException) {
 }
 #endif
 
+#if defined(PADDLE_WITH_GLOO)
+TEST(TestGroup, TestCPUConcatSplit) {
+  platform::CPUPlace cpu_place;
+
+  int size = 3;
+  GroupConcatSplit<float>(cpu_place, size);
+  GroupConcatSplit<double>(cpu_place, size);
+
+  size = 15;
+  GroupConcatSplit<float>(cpu_place, size);
+  GroupConcatSplit<double>(cpu_place, size);
+}
+#endif
+
 #if defined(PADDLE_WITH_XPU_BKCL)
 TEST(TestGroup, TestXPUConcatSplit) {
   platform::XPUPlace xpu_place(0);
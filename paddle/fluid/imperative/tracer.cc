@@ -14,6 +14,7 @@
 #include "paddle/fluid/imperative/tracer.h"
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include "paddle/fluid/framework/op_registry.h"
@@ -141,6 +142,23 @@ paddle::framework::GarbageCollector* Tracer::MutableGarbageCollectorIfNotExists(
   return gcs_.at(place).get();
 }
 
+// The operators created by the op types are reused by the ops traced later,
+// for they hold no state in dygraph, and their creation costs more than the
+// kernels on small tensors. They are cached by threads, as ops may be traced
+// by threads at the same time.
+static framework::OperatorBase* GetTracedOp(const std::string& type) {
+  thread_local std::unordered_map<std::string,
+                                  std::unique_ptr<framework::OperatorBase>>
+      ops;
+  auto it = ops.find(type);
+  if (it == ops.end()) {
+    it = ops.emplace(type, framework::OpRegistry::CreateOp(type, {}, {}, {},
+                                                           false))
+             .first;
+  }
+  return it->second.get();
+}
+
 void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
                      const NameVarBaseMap& outs, framework::AttributeMap attrs,
                      const platform::Place& place, bool trace_backward,
@@ -161,7 +179,7 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
       attrs["use_mkldnn"] = !is_off;
     }
   }
-  auto op = framework::OpRegistry::CreateOp(type, {}, {}, {}, false);
+  auto* op = GetTracedOp(type);
   const auto& op_info = op->Info();
   auto* attr_checker = op_info.Checker();
   if (attr_checker) {
@@ -173,11 +191,13 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
       attr_checker == nullptr ? empty_attrs_map
                               : attr_checker->GetDefaultAttrMap();
 
-  NameVarBaseMap new_ins = ins;
+  // The inputs are copied only if cast.
+  NameVarBaseMap casted_ins;
   if (enable_autocast_) {
     VLOG(5) << "Auto mixed precision run operator: " << type;
-    new_ins = AutoCastInputs(type, ins);
+    casted_ins = AutoCastInputs(type, ins);
   }
+  const NameVarBaseMap& new_ins = enable_autocast_ ? casted_ins : ins;
 
   try {
     if (platform::is_gpu_place(place)) {
@@ -227,6 +247,10 @@ void Tracer::TraceOp(const std::string& type, const NameVarBaseMap& ins,
     program_desc_tracer_->InsertOp(type, new_ins, outs, attrs);
   }
 
+  if (step_capture_ != nullptr) {
+    step_capture_->InsertOp(type, new_ins, outs, attrs, default_attrs, place);
+  }
+
   if (ComputeRequiredGrad(new_ins, outs, trace_backward)) {
     CreateGradOpNode(*op, new_ins, outs, attrs, default_attrs, place,
                      inplace_map);
@@ -25,6 +25,7 @@
 #include "paddle/fluid/framework/garbage_collector.h"
 #include "paddle/fluid/imperative/basic_engine.h"
 #include "paddle/fluid/imperative/jit/program_desc_tracer.h"
+#include "paddle/fluid/imperative/jit/step_capture.h"
 #include "paddle/fluid/imperative/layer.h"
 #include "paddle/fluid/platform/macros.h"
 
@@ -84,6 +85,14 @@ class Tracer {
     return program_desc_tracer_.get();
   }
 
+  // Capture the ops traced into the step capture, until it is set to
+  // nullptr.
+  void SetStepCapture(jit::StepCapture* step_capture) {
+    step_capture_ = step_capture;
+  }
+
+  jit::StepCapture* GetStepCapture() const { return step_capture_; }
+
   // Note(Aurelius84): The `tmp` is used as prefix key while naming a temporary
   // intermediate var both in imperative and static mode. But the
   // `UniqueNameGenerator` in C++ and `unique_name.py` in Python doesn't share
@@ -116,6 +125,7 @@ class Tracer {
   std::unique_ptr<BasicEngine> basic_engine_;
   std::unique_ptr<jit::ProgramDescTracer> program_desc_tracer_;
   bool enable_program_desc_tracing_{false};
+  jit::StepCapture* step_capture_{nullptr};
   std::unique_ptr<UniqueNameGenerator> generator_;
   platform::Place expected_place_;
   bool has_grad_{true};
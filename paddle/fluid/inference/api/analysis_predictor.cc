@@ -177,6 +177,19 @@ bool AnalysisPredictor::Init(
   // Get the feed_target_names and fetch_target_names
   PrepareFeedFetch();
 
+  if (config_.static_memory_plan_enabled()) {
+    std::vector<std::string> input_names, output_names;
+    for (auto &item : idx2feeds_) input_names.push_back(item.second);
+    for (auto &item : idx2fetches_) output_names.push_back(item.second);
+    static_memory_planner_.reset(new details::StaticMemoryPlanner(
+        *inference_program_, input_names, output_names, place_));
+    if (!static_memory_planner_->enabled()) {
+      LOG(WARNING) << "The static memory plan is disabled, for the program "
+                      "has control flow blocks.";
+      static_memory_planner_.reset();
+    }
+  }
+
   return true;
 }
 
@@ -914,7 +927,11 @@ bool AnalysisPredictor::ZeroCopyRun() {
   }
 #endif
 
+  // Bind the temporary tensors to the arena if the input shapes are the
+  // planned ones, and plan the arena after the first run.
+  if (static_memory_planner_) static_memory_planner_->Bind();
   executor_->Run();
+  if (static_memory_planner_) static_memory_planner_->Plan(sub_scope_);
   // Fix TensorArray reuse not cleaned bug.
   tensor_array_batch_cleaner_.CollectTensorArrays(sub_scope_);
   tensor_array_batch_cleaner_.ResetTensorArray();
@@ -23,6 +23,7 @@
 #include "paddle/fluid/inference/analysis/analyzer.h"
 #include "paddle/fluid/inference/api/api_impl.h"
 #include "paddle/fluid/inference/api/details/reset_tensor_array.h"
+#include "paddle/fluid/inference/api/details/static_memory_plan.h"
 #include "paddle/fluid/inference/api/helper.h"
 #include "paddle/fluid/inference/api/paddle_inference_api.h"
 #include "paddle/fluid/string/printf.h"
@@ -403,6 +404,9 @@ class AnalysisPredictor : public PaddlePredictor {
   // concurrency problems, wrong results and memory leak, so cache them.
   std::vector<framework::LoDTensor> feed_tensors_;
   details::TensorArrayBatchCleaner tensor_array_batch_cleaner_;
+  // The arena of the temporary tensors for ZeroCopyRun, if the static memory
+  // plan is enabled.
+  std::unique_ptr<details::StaticMemoryPlanner> static_memory_planner_;
   // A mutex help to make Clone thread safe.
   std::mutex clone_mutex_;
 
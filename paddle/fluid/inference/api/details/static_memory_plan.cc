@@ -0,0 +1,221 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/static_memory_plan.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+#include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/operator.h"
+#include "paddle/fluid/framework/program_desc.h"
+#include "paddle/fluid/framework/scope.h"
+
+namespace paddle {
+namespace details {
+
+// Large enough for the vectorized kernels on CPU and GPU.
+static constexpr size_t kArenaAlignment = 256;
+
+static size_t AlignUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// A range of the arena, which keeps the arena alive.
+class ArenaSlice : public memory::Allocation {
+ public:
+  ArenaSlice(std::shared_ptr<memory::Allocation> arena, size_t offset,
+             size_t size)
+      : Allocation(static_cast<uint8_t *>(arena->ptr()) + offset, size,
+                   arena->place()),
+        arena_(std::move(arena)) {}
+
+ private:
+  std::shared_ptr<memory::Allocation> arena_;
+};
+
+size_t PackTensorLifetimes(std::vector<TensorLifetime> *tensors,
+                           size_t alignment) {
+  std::vector<TensorLifetime *> order;
+  for (auto &tensor : *tensors) {
+    order.push_back(&tensor);
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [](const TensorLifetime *a, const TensorLifetime *b) {
+                     return a->size > b->size;
+                   });
+
+  // The tensors placed, sorted by the offsets.
+  std::vector<TensorLifetime *> placed;
+  size_t arena_size = 0;
+  for (auto *tensor : order) {
+    size_t best_offset = std::numeric_limits<size_t>::max();
+    size_t best_gap = std::numeric_limits<size_t>::max();
+    size_t prev_end = 0;
+    for (auto *other : placed) {
+      if (other->last_op < tensor->first_op ||
+          tensor->last_op < other->first_op) {
+        continue;
+      }
+      if (other->offset > prev_end) {
+        size_t gap = other->offset - prev_end;
+        if (gap >= tensor->size && gap < best_gap) {
+          best_offset = prev_end;
+          best_gap = gap;
+        }
+      }
+      prev_end =
+          std::max(prev_end, AlignUp(other->offset + other->size, alignment));
+    }
+    tensor->offset =
+        best_offset == std::numeric_limits<size_t>::max() ? prev_end
+                                                          : best_offset;
+    arena_size = std::max(arena_size, tensor->offset + tensor->size);
+    placed.insert(std::upper_bound(placed.begin(), placed.end(), tensor,
+                                   [](const TensorLifetime *a,
+                                      const TensorLifetime *b) {
+                                     return a->offset < b->offset;
+                                   }),
+                  tensor);
+  }
+  return AlignUp(arena_size, alignment);
+}
+
+StaticMemoryPlanner::StaticMemoryPlanner(
+    const framework::ProgramDesc &program,
+    const std::vector<std::string> &input_names,
+    const std::vector<std::string> &output_names,
+    const platform::Place &place)
+    : input_names_(input_names),
+      excluded_vars_(output_names.begin(), output_names.end()),
+      place_(place) {
+  // The lifetimes in the sub blocks are not known from the block 0.
+  if (program.Size() > 1) {
+    enabled_ = false;
+    return;
+  }
+  auto &block = program.Block(0);
+  std::unordered_map<std::string, size_t> index;
+  auto use = [&](const std::string &name, int op_idx, bool is_output) {
+    if (name == framework::kEmptyVarName) return;
+    auto it = index.find(name);
+    if (it != index.end()) {
+      lifetimes_[it->second].last_op = op_idx;
+      return;
+    }
+    index.emplace(name, lifetimes_.size());
+    TensorLifetime lifetime;
+    lifetime.name = name;
+    lifetime.first_op = op_idx;
+    lifetime.last_op = op_idx;
+    lifetimes_.push_back(lifetime);
+    // The tensors read before written keep their data between runs.
+    auto *var = block.FindVar(name);
+    if (!is_output || var == nullptr || var->Persistable() ||
+        var->GetType() != framework::proto::VarType::LOD_TENSOR) {
+      excluded_vars_.insert(name);
+    }
+  };
+
+  auto ops = block.AllOps();
+  for (size_t i = 0; i < ops.size(); ++i) {
+    bool is_feed_fetch = ops[i]->Type() == "feed" || ops[i]->Type() == "fetch";
+    for (auto &name : ops[i]->InputArgumentNames()) {
+      use(name, i, false);
+      if (is_feed_fetch) excluded_vars_.insert(name);
+    }
+    for (auto &name : ops[i]->OutputArgumentNames()) {
+      use(name, i, true);
+      if (is_feed_fetch) excluded_vars_.insert(name);
+    }
+  }
+}
+
+void StaticMemoryPlanner::Plan(framework::Scope *scope) {
+  if (!enabled_ || planned()) return;
+
+  // The tensors sharing the memory with other tensors, such as the outputs of
+  // reshape, live as long as the others, so they are left to the allocator.
+  std::unordered_map<memory::Allocation *, int> holders;
+  for (const framework::Scope *s = scope; s != nullptr; s = s->parent()) {
+    for (auto &name : s->LocalVarNames()) {
+      auto *var = s->FindLocalVar(name);
+      if (var != nullptr && var->IsType<framework::LoDTensor>() &&
+          var->Get<framework::LoDTensor>().IsInitialized()) {
+        ++holders[var->Get<framework::LoDTensor>().Holder().get()];
+      }
+    }
+  }
+
+  std::vector<TensorLifetime> lifetimes;
+  std::vector<framework::LoDTensor *> tensors;
+  for (auto &lifetime : lifetimes_) {
+    if (excluded_vars_.count(lifetime.name)) continue;
+    auto *var = scope->FindVar(lifetime.name);
+    if (var == nullptr || !var->IsType<framework::LoDTensor>()) continue;
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    if (!tensor->IsInitialized() ||
+        !platform::is_same_place(tensor->place(), place_) ||
+        tensor->offset() != 0 || holders[tensor->Holder().get()] != 1) {
+      continue;
+    }
+    size_t size = tensor->numel() * framework::SizeOfType(tensor->type());
+    if (size == 0) continue;
+    lifetimes.push_back(lifetime);
+    lifetimes.back().size = size;
+    tensors.push_back(tensor);
+  }
+  if (lifetimes.empty()) {
+    enabled_ = false;
+    return;
+  }
+
+  arena_size_ = PackTensorLifetimes(&lifetimes, kArenaAlignment);
+  arena_ = memory::AllocShared(place_, arena_size_);
+  for (auto &lifetime : lifetimes) {
+    unplanned_size_ += lifetime.size;
+    slices_.emplace_back(
+        std::make_shared<ArenaSlice>(arena_, lifetime.offset, lifetime.size));
+  }
+  tensors_ = std::move(tensors);
+  for (auto &name : input_names_) {
+    auto *var = scope->FindVar(name);
+    PADDLE_ENFORCE_NOT_NULL(
+        var, platform::errors::NotFound("The input %s is not found.", name));
+    inputs_.push_back(var->GetMutable<framework::LoDTensor>());
+    planned_dims_.push_back(inputs_.back()->dims());
+  }
+  LOG(INFO) << "Planned " << tensors_.size() << " tensors in an arena of "
+            << arena_size_ << " bytes, which are " << unplanned_size_
+            << " bytes allocated separately.";
+}
+
+bool StaticMemoryPlanner::Bind() {
+  if (!planned()) return false;
+  for (size_t i = 0; i < inputs_.size(); ++i) {
+    if (inputs_[i]->dims() != planned_dims_[i]) return false;
+  }
+  for (size_t i = 0; i < tensors_.size(); ++i) {
+    if (tensors_[i]->Holder() != slices_[i]) {
+      tensors_[i]->clear();
+      tensors_[i]->ResetHolder(slices_[i]);
+    }
+  }
+  return true;
+}
+
+}  // namespace details
+}  // namespace paddle
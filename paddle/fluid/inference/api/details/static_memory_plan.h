@@ -0,0 +1,113 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/memory/malloc.h"
+#include "paddle/fluid/platform/place.h"
+
+namespace paddle {
+namespace framework {
+class LoDTensor;
+class ProgramDesc;
+class Scope;
+}  // namespace framework
+}  // namespace paddle
+
+namespace paddle {
+namespace details {
+
+struct TensorLifetime {
+  std::string name;
+  size_t size{0};
+  // The indices of the first and the last operators using the tensor.
+  int first_op{0};
+  int last_op{0};
+  // The offset in the arena assigned by PackTensorLifetimes.
+  size_t offset{0};
+};
+
+// Assign the offsets of the tensors in one arena, so that the tensors alive
+// at the same time do not overlap. The tensors are placed from the largest,
+// each into the smallest gap between the tensors placed and alive with it
+// that fits, or above them. The offsets are aligned to the alignment.
+// Returns the size of the arena.
+size_t PackTensorLifetimes(std::vector<TensorLifetime> *tensors,
+                           size_t alignment);
+
+/*
+ * Bind the temporary tensors of an inference program to the offsets of one
+ * arena, planned ahead of time from the lifetimes of the tensors, so that the
+ * operators find their outputs allocated and never call the allocator.
+ *
+ * The lifetimes are the spans of the operators in the block 0 using the
+ * tensors; the sizes are taken from the tensors after the first run. The
+ * plan holds for the input shapes of that run. Runs of other input shapes
+ * are not bound: a tensor bound in the arena is reallocated by mutable_data
+ * if it no longer fits, otherwise it stays in its own range of the arena.
+ */
+class StaticMemoryPlanner {
+ public:
+  // The input tensors are read from the scope to tell the shapes of a run,
+  // and the output tensors are never planned, for they are read after runs.
+  StaticMemoryPlanner(const framework::ProgramDesc &program,
+                      const std::vector<std::string> &input_names,
+                      const std::vector<std::string> &output_names,
+                      const platform::Place &place);
+
+  // Whether the program can be planned. Programs of control flow blocks are
+  // not.
+  bool enabled() const { return enabled_; }
+  bool planned() const { return arena_ != nullptr; }
+
+  // Plan the arena from the tensors in the scope after a run, if not
+  // planned yet. The tensors are kept to be bound before the later runs.
+  void Plan(framework::Scope *scope);
+
+  // Bind the tensors to the arena before a run. Returns false if not
+  // planned, or the input shapes differ from the planned ones, then the
+  // tensors are not bound.
+  bool Bind();
+
+  // The size of the arena, and the total size of the tensors planned, which
+  // are allocated separately without the plan.
+  size_t arena_size() const { return arena_size_; }
+  size_t unplanned_size() const { return unplanned_size_; }
+  size_t num_tensors() const { return tensors_.size(); }
+
+ private:
+  bool enabled_{true};
+  std::vector<std::string> input_names_;
+  std::unordered_set<std::string> excluded_vars_;
+  std::vector<TensorLifetime> lifetimes_;
+  platform::Place place_;
+
+  std::vector<framework::LoDTensor *> inputs_;
+  std::vector<framework::DDim> planned_dims_;
+  std::shared_ptr<memory::Allocation> arena_;
+  size_t arena_size_{0};
+  size_t unplanned_size_{0};
+  // The planned tensors and their ranges of the arena.
+  std::vector<framework::LoDTensor *> tensors_;
+  std::vector<std::shared_ptr<memory::Allocation>> slices_;
+};
+
+}  // namespace details
+}  // namespace paddle
@@ -0,0 +1,248 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/inference/api/details/static_memory_plan.h"
+
+#include <gtest/gtest.h>
+#include <chrono>  // NOLINT
+#include <random>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/naive_executor.h"
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/framework/program_desc.h"
+
+namespace paddle {
+namespace framework {
+
+class PlanTestOpMaker : public OpProtoAndCheckerMaker {
+ public:
+  void Make() {
+    AddInput("X", "input of the test op");
+    AddOutput("Out", "X + 1");
+    AddComment("Add one to the input, to test the static memory plan.");
+  }
+};
+
+class PlanTestOp : public OperatorWithKernel {
+ public:
+  using OperatorWithKernel::OperatorWithKernel;
+
+ protected:
+  void InferShape(InferShapeContext* ctx) const override {
+    ctx->SetOutputDim("Out", ctx->GetInputDim("X"));
+  }
+  OpKernelType GetExpectedKernelType(
+      const ExecutionContext& ctx) const override {
+    return OpKernelType(proto::VarType::FP32, ctx.GetPlace());
+  }
+};
+
+class PlanTestKernel : public OpKernel<float> {
+ public:
+  void Compute(const ExecutionContext& ctx) const override {
+    auto* x = ctx.Input<LoDTensor>("X");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    const float* src = x->data<float>();
+    float* dst = out->mutable_data<float>(ctx.GetPlace());
+    for (int64_t i = 0; i < x->numel(); ++i) {
+      dst[i] = src[i] + 1;
+    }
+  }
+};
+
+}  // namespace framework
+}  // namespace paddle
+
+REGISTER_OP_WITHOUT_GRADIENT(static_memory_plan_test,
+                             paddle::framework::PlanTestOp,
+                             paddle::framework::PlanTestOpMaker);
+REGISTER_OP_CPU_KERNEL(static_memory_plan_test,
+                       paddle::framework::PlanTestKernel);
+
+namespace paddle {
+namespace details {
+
+using framework::LoDTensor;
+
+static bool Overlap(const TensorLifetime& a, const TensorLifetime& b) {
+  return a.first_op <= b.last_op && b.first_op <= a.last_op;
+}
+
+TEST(PackTensorLifetimes, best_fit) {
+  std::vector<TensorLifetime> tensors(3);
+  tensors[0].size = 1000;
+  tensors[0].first_op = 0;
+  tensors[0].last_op = 1;
+  tensors[1].size = 1000;
+  tensors[1].first_op = 2;
+  tensors[1].last_op = 3;
+  tensors[2].size = 500;
+  tensors[2].first_op = 1;
+  tensors[2].last_op = 2;
+  EXPECT_EQ(PackTensorLifetimes(&tensors, 256), 1536UL);
+  EXPECT_EQ(tensors[0].offset, 0UL);
+  EXPECT_EQ(tensors[1].offset, 0UL);
+  EXPECT_EQ(tensors[2].offset, 1024UL);
+}
+
+TEST(PackTensorLifetimes, random) {
+  std::mt19937 rng(0);
+  std::vector<TensorLifetime> tensors(500);
+  size_t total = 0;
+  for (auto& tensor : tensors) {
+    tensor.size = rng() % 100000 + 1;
+    tensor.first_op = rng() % 1000;
+    tensor.last_op = tensor.first_op + rng() % 50;
+    total += tensor.size;
+  }
+  size_t arena_size = PackTensorLifetimes(&tensors, 64);
+  EXPECT_LT(arena_size, total);
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    EXPECT_EQ(tensors[i].offset % 64, 0UL);
+    EXPECT_LE(tensors[i].offset + tensors[i].size, arena_size);
+    for (size_t j = i + 1; j < tensors.size(); ++j) {
+      if (Overlap(tensors[i], tensors[j])) {
+        EXPECT_TRUE(
+            tensors[i].offset + tensors[i].size <= tensors[j].offset ||
+            tensors[j].offset + tensors[j].size <= tensors[i].offset);
+      }
+    }
+  }
+}
+
+// A chain of num_ops ops from x0 to x<num_ops>, adding one each.
+static framework::ProgramDesc ChainProgram(int num_ops) {
+  framework::ProgramDesc program;
+  auto* block = program.MutableBlock(0);
+  block->Var("x0")->SetType(framework::proto::VarType::LOD_TENSOR);
+  for (int i = 0; i < num_ops; ++i) {
+    std::string out = "x" + std::to_string(i + 1);
+    block->Var(out)->SetType(framework::proto::VarType::LOD_TENSOR);
+    auto* op = block->AppendOp();
+    op->SetType("static_memory_plan_test");
+    op->SetInput("X", {"x" + std::to_string(i)});
+    op->SetOutput("Out", {out});
+  }
+  return program;
+}
+
+static void Feed(framework::NaiveExecutor* exe, int64_t numel) {
+  float* data = exe->FindTensor("x0")->mutable_data<float>(
+      {numel}, platform::CPUPlace());
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = i;
+  }
+}
+
+static void ExpectOutput(framework::NaiveExecutor* exe, const std::string& out,
+                         int64_t numel, float added) {
+  auto* tensor = exe->FindTensor(out);
+  ASSERT_EQ(tensor->numel(), numel);
+  for (int64_t i = 0; i < numel; i += 97) {
+    ASSERT_EQ(tensor->data<float>()[i], i + added);
+  }
+}
+
+TEST(StaticMemoryPlanner, bind) {
+  const int num_ops = 10;
+  const int64_t numel = 1000;
+  auto program = ChainProgram(num_ops);
+  framework::Scope scope;
+  for (int i = 0; i <= num_ops; ++i) {
+    scope.Var("x" + std::to_string(i))->GetMutable<LoDTensor>();
+  }
+  framework::NaiveExecutor exe(platform::CPUPlace{});
+  exe.Prepare(&scope, program, 0, false);
+  StaticMemoryPlanner planner(program, {"x0"}, {"x10"}, platform::CPUPlace());
+  ASSERT_TRUE(planner.enabled());
+  EXPECT_FALSE(planner.Bind());
+
+  Feed(&exe, numel);
+  exe.Run();
+  planner.Plan(&scope);
+  ASSERT_TRUE(planner.planned());
+  // x1 to x9, of which two at most are alive at the same time
+  EXPECT_EQ(planner.num_tensors(), 9UL);
+  EXPECT_EQ(planner.unplanned_size(), 9 * numel * sizeof(float));
+  EXPECT_EQ(planner.arena_size(), 2 * 4096UL);
+
+  ASSERT_TRUE(planner.Bind());
+  auto* x1 = exe.FindTensor("x1");
+  auto* x2 = exe.FindTensor("x2");
+  auto* x3 = exe.FindTensor("x3");
+  EXPECT_EQ(x1->data<float>(), x3->data<float>());
+  EXPECT_NE(x1->data<float>(), x2->data<float>());
+  auto holder = x1->Holder();
+  exe.Run();
+  EXPECT_EQ(x1->Holder(), holder);
+  ExpectOutput(&exe, "x10", numel, num_ops);
+
+  // other shapes are not bound, and the tensors too small are reallocated
+  Feed(&exe, 2 * numel);
+  EXPECT_FALSE(planner.Bind());
+  exe.Run();
+  EXPECT_NE(x1->Holder(), holder);
+  ExpectOutput(&exe, "x10", 2 * numel, num_ops);
+
+  Feed(&exe, numel);
+  ASSERT_TRUE(planner.Bind());
+  EXPECT_EQ(x1->Holder(), holder);
+  exe.Run();
+  ExpectOutput(&exe, "x10", numel, num_ops);
+}
+
+// The time of a run of a chain of 64 ops on 256K floats, with every tensor
+// allocated separately and with the tensors bound to the planned arena.
+TEST(StaticMemoryPlanner, benchmark) {
+  const int num_ops = 64;
+  const int64_t numel = 256 << 10;
+  auto program = ChainProgram(num_ops);
+  auto run = [&](bool plan) {
+    framework::Scope scope;
+    for (int i = 0; i <= num_ops; ++i) {
+      scope.Var("x" + std::to_string(i))->GetMutable<LoDTensor>();
+    }
+    framework::NaiveExecutor exe(platform::CPUPlace{});
+    exe.Prepare(&scope, program, 0, false);
+    StaticMemoryPlanner planner(program, {"x0"},
+                                {"x" + std::to_string(num_ops)},
+                                platform::CPUPlace());
+    Feed(&exe, numel);
+    exe.Run();
+    if (plan) planner.Plan(&scope);
+
+    const int repeat = 50;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; ++i) {
+      planner.Bind();
+      exe.Run();
+    }
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count() /
+                repeat;
+    ExpectOutput(&exe, "x" + std::to_string(num_ops), numel, num_ops);
+    size_t bytes = plan ? planner.arena_size()
+                        : (num_ops - 1) * numel * sizeof(float);
+    LOG(INFO) << (plan ? "Planned arena" : "Separate tensors") << ": "
+              << bytes / 1048576.0 << " MB, " << ms << " ms per run";
+  };
+  run(false);
+  run(true);
+}
+
+}  // namespace details
+}  // namespace paddle
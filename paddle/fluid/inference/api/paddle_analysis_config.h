@@ -569,6 +569,23 @@ struct PD_INFER_DECL AnalysisConfig {
   ///
   bool enable_memory_optim() const;
 
+  ///
+  /// \brief Turn on the static memory plan. After the first ZeroCopyRun, the
+  /// temporary tensors are planned in one arena by their lifetimes, and the
+  /// later runs of the same input shapes bind the tensors to the arena
+  /// instead of allocating them.
+  ///
+  /// \param x Whether the static memory plan is turned on.
+  ///
+  void EnableStaticMemoryPlan(bool x = true);
+  ///
+  /// \brief A boolean state telling whether the static memory plan is
+  /// turned on.
+  ///
+  /// \return bool Whether the static memory plan is turned on.
+  ///
+  bool static_memory_plan_enabled() const { return static_memory_plan_; }
+
   ///
   /// \brief Turn on profiling report.
   /// If not turned on, no profiling report will be generated.
@@ -687,6 +704,7 @@ struct PD_INFER_DECL AnalysisConfig {
 
   // memory reuse related.
   bool enable_memory_optim_{false};
+  bool static_memory_plan_{false};
 
   bool use_mkldnn_{false};
   std::unordered_set<std::string> mkldnn_enabled_op_types_;
@@ -202,6 +202,7 @@ CpuPassStrategy::CpuPassStrategy() : PassStrategy({}) {
                   "flatten2_matmul_fuse_pass",               //
                   "map_matmul_to_mul_pass",                  //
                   "fc_fuse_pass",                            //
+                  "seqpool_cvm_concat_fc_fuse_pass",         //
                   "repeated_fc_relu_fuse_pass",              //
                   "squared_mat_sub_fuse_pass",               //
                   "conv_bn_fuse_pass",                       //
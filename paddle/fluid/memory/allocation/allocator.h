@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #pragma once
+#include <atomic>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -111,6 +112,15 @@ class Allocation {
 
   inline const platform::Place& place() const { return place_; }
 
+  // Whether this is a CopyOnWriteAllocation, i.e. a view of another one.
+  inline bool IsCopyOnWriteView() const { return is_copy_on_write_view_; }
+
+  // The number of the CopyOnWriteAllocation views of this allocation alive.
+  // A tensor writing this allocation copies it out first if it is not 0.
+  inline int CopyOnWriteViews() const {
+    return copy_on_write_views_.load(std::memory_order_acquire);
+  }
+
   virtual ~Allocation() {}
 
  private:
@@ -128,6 +138,8 @@ class Allocation {
   void* ptr_;
   size_t size_;
   platform::Place place_;
+  bool is_copy_on_write_view_{false};
+  std::atomic<int> copy_on_write_views_{0};
 
   /**
    * NOTE(zjl): Since decorated_allocators_ is usually a small vector.
@@ -145,6 +157,30 @@ class Allocation {
   DecoratedAllocatorStack decorated_allocators_;
 
   friend class Allocator;
+  friend class CopyOnWriteAllocation;
+};
+
+// A view of the memory of the base allocation, shared by the tensors as if
+// each had its own copy, see Tensor::ShareDataCopyOnWrite. The tensors copy
+// the memory out before writing it while it is shared. The base counts its
+// views alive, so it is written in place again once they are all released.
+class CopyOnWriteAllocation : public Allocation {
+ public:
+  explicit CopyOnWriteAllocation(std::shared_ptr<Allocation> base)
+      : Allocation(base->ptr(), base->size(), base->place()),
+        base_(std::move(base)) {
+    is_copy_on_write_view_ = true;
+    base_->copy_on_write_views_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  ~CopyOnWriteAllocation() {
+    base_->copy_on_write_views_.fetch_sub(1, std::memory_order_release);
+  }
+
+  inline const std::shared_ptr<Allocation>& base() const { return base_; }
+
+ private:
+  std::shared_ptr<Allocation> base_;
 };
 
 // Base interface class of memory Allocator.
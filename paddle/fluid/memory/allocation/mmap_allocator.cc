@@ -17,26 +17,129 @@
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
 #include <fcntl.h>
+#include <signal.h>
 #include <stdlib.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <map>
 #include <random>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "paddle/fluid/platform/enforce.h"
 
+DECLARE_uint64(dataloader_shm_pool_mb);
+
 namespace paddle {
 namespace memory {
 namespace allocation {
 
+static constexpr size_t kSegmentMaxSlots = 64;
+static constexpr size_t kSegmentHeaderSize = 4096;
+static constexpr size_t kMinSlotSize = 4096;
+// The slots of a segment take 16MB at most, unless it has only one slot.
+static constexpr size_t kSegmentSlotsSize = 16 << 20;
+
+// The head of a segment, shared by the writer and the readers.
+struct MemoryMapSegmentHeader {
+  uint64_t slot_size;
+  uint64_t num_slots;
+  int64_t writer_pid;
+  // 1 if the slot is in use, written by the writer acquiring the slot and
+  // the reader releasing it.
+  std::atomic<uint32_t> slot_states[kSegmentMaxSlots];
+};
+
+static_assert(sizeof(MemoryMapSegmentHeader) <= kSegmentHeaderSize,
+              "The head of the segment exceeds its size.");
+
+class MemoryMapSegment {
+ public:
+  MemoryMapSegment(void *ptr, size_t size, std::string ipc_name)
+      : ptr_(ptr), size_(size), ipc_name_(std::move(ipc_name)) {}
+
+  ~MemoryMapSegment() {
+    if (munmap(ptr_, size_) != 0) {
+      LOG(WARNING) << "Could not unmap the shared memory segment "
+                   << ipc_name_;
+    }
+  }
+
+  const std::string &ipc_name() const { return ipc_name_; }
+
+  MemoryMapSegmentHeader *header() {
+    return static_cast<MemoryMapSegmentHeader *>(ptr_);
+  }
+
+  void *ptr(size_t offset) { return static_cast<uint8_t *>(ptr_) + offset; }
+
+  size_t size() const { return size_; }
+
+  // Returns the offset of a free slot marked in use, or 0 if all the slots
+  // are in use. The slots are searched from the one after the last acquired,
+  // so that they are reused in turn.
+  size_t AcquireSlot() {
+    auto *head = header();
+    for (size_t i = 0; i < head->num_slots; ++i) {
+      size_t slot = (cursor_ + i) % head->num_slots;
+      uint32_t expected = 0;
+      if (head->slot_states[slot].compare_exchange_strong(
+              expected, 1, std::memory_order_acquire)) {
+        cursor_ = slot + 1;
+        return kSegmentHeaderSize + slot * head->slot_size;
+      }
+    }
+    return 0;
+  }
+
+  void ReleaseSlot(size_t offset) {
+    auto *head = header();
+    size_t slot = (offset - kSegmentHeaderSize) / head->slot_size;
+    head->slot_states[slot].store(0, std::memory_order_release);
+  }
+
+ private:
+  void *ptr_;
+  size_t size_;
+  std::string ipc_name_;
+  size_t cursor_{0};
+};
+
+MemoryMapWriterAllocation::MemoryMapWriterAllocation(
+    std::shared_ptr<MemoryMapSegment> segment, size_t offset, size_t size)
+    : Allocation(segment->ptr(offset), size, platform::CPUPlace()),
+      ipc_name_(segment->ipc_name()),
+      segment_(std::move(segment)),
+      offset_(offset) {}
+
 MemoryMapWriterAllocation::~MemoryMapWriterAllocation() {
+  // The slot of the pool is released by the reader.
+  if (pooled()) return;
   PADDLE_ENFORCE_NE(
       munmap(this->ptr(), this->size()), -1,
       platform::errors::Unavailable("could not unmap the shared memory file %s",
                                     this->ipc_name()));
 }
 
+MemoryMapReaderAllocation::MemoryMapReaderAllocation(
+    std::shared_ptr<MemoryMapSegment> segment, size_t offset, size_t size)
+    : Allocation(segment->ptr(offset), size, platform::CPUPlace()),
+      ipc_name_(segment->ipc_name()),
+      segment_(std::move(segment)),
+      offset_(offset) {}
+
 MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
+  if (segment_ != nullptr) {
+    segment_->ReleaseSlot(offset_);
+    return;
+  }
   PADDLE_ENFORCE_NE(
       munmap(this->ptr(), this->size()), -1,
       platform::errors::Unavailable("could not unmap the shared memory file %s",
@@ -49,6 +152,13 @@ MemoryMapReaderAllocation::~MemoryMapReaderAllocation() {
   VLOG(3) << "~MemoryMapReaderAllocation: " << this->ipc_name();
 }
 
+MemoryMapFileAllocation::~MemoryMapFileAllocation() {
+  PADDLE_ENFORCE_NE(munmap(this->ptr(), this->size()), -1,
+                    platform::errors::Unavailable(
+                        "could not unmap the memory mapped file %s", path_));
+  VLOG(3) << "~MemoryMapFileAllocation: " << path_;
+}
+
 std::string GetIPCName() {
   static std::random_device rd;
   std::string handle = "/paddle_";
@@ -62,9 +172,7 @@ std::string GetIPCName() {
   return std::move(handle);
 }
 
-std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
-    size_t size) {
-  const std::string &ipc_name = GetIPCName();
+static void *CreateSharedMemory(const std::string &ipc_name, size_t size) {
   int flags = O_RDWR | O_CREAT;
 
   int fd = shm_open(ipc_name.c_str(), flags, 0644);
@@ -80,7 +188,13 @@ std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
                     platform::errors::Unavailable(
                         "Memory map failed when create shared memory."));
   close(fd);
+  return ptr;
+}
 
+std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
+    size_t size) {
+  const std::string &ipc_name = GetIPCName();
+  void *ptr = CreateSharedMemory(ipc_name, size);
   return std::make_shared<MemoryMapWriterAllocation>(ptr, size, ipc_name);
 }
 
@@ -99,6 +213,177 @@ std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
   return std::make_shared<MemoryMapReaderAllocation>(ptr, size, ipc_name);
 }
 
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  PADDLE_ENFORCE_NE(fd, -1, platform::errors::Unavailable(
+                                "File %s open failed.", path.c_str()));
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    PADDLE_THROW(platform::errors::Unavailable("Cannot get the size of %s.",
+                                               path.c_str()));
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  if (size == 0) {
+    close(fd);
+    PADDLE_THROW(platform::errors::InvalidArgument(
+        "Cannot memory map the empty file %s.", path.c_str()));
+  }
+  void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  PADDLE_ENFORCE_NE(ptr, MAP_FAILED,
+                    platform::errors::Unavailable(
+                        "Memory map failed when mapping the file %s.", path));
+  return std::make_shared<MemoryMapFileAllocation>(ptr, size, path);
+}
+
+// The segments of the slots allocated by the writer process.
+class MemoryMapSegmentPool {
+ public:
+  static MemoryMapSegmentPool &Instance() {  // NOLINT
+    static MemoryMapSegmentPool pool;
+    return pool;
+  }
+
+  // Returns nullptr if the slots of the size are all in use, and the pool
+  // is full.
+  std::shared_ptr<MemoryMapWriterAllocation> Allocate(size_t size) {
+    size_t slot_size = kMinSlotSize;
+    while (slot_size < size) {
+      slot_size <<= 1;
+    }
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto &segments = segments_[slot_size];
+    for (auto &segment : segments) {
+      size_t offset = segment->AcquireSlot();
+      if (offset != 0) {
+        return std::make_shared<MemoryMapWriterAllocation>(segment, offset,
+                                                           size);
+      }
+    }
+
+    size_t pool_limit = FLAGS_dataloader_shm_pool_mb << 20;
+    if (pool_size_ + kSegmentHeaderSize + slot_size > pool_limit) {
+      return nullptr;
+    }
+    size_t num_slots = std::max<size_t>(
+        1, std::min({kSegmentMaxSlots, kSegmentSlotsSize / slot_size,
+                     (pool_limit - pool_size_ - kSegmentHeaderSize) /
+                         slot_size}));
+    size_t segment_size = kSegmentHeaderSize + num_slots * slot_size;
+    const std::string &ipc_name = GetIPCName();
+    auto segment = std::make_shared<MemoryMapSegment>(
+        CreateSharedMemory(ipc_name, segment_size), segment_size, ipc_name);
+    auto *head = segment->header();
+    head->slot_size = slot_size;
+    head->num_slots = num_slots;
+    head->writer_pid = getpid();
+    for (size_t i = 0; i < num_slots; ++i) {
+      head->slot_states[i].store(0, std::memory_order_relaxed);
+    }
+    pool_size_ += segment_size;
+    segments.push_back(segment);
+    // The segment is unlinked by the reader once mapped, or by Clear of the
+    // set when the writer exits, for the slots of the tensors sent but never
+    // read are not released until then.
+    MemoryMapFdSet::Instance().Insert(ipc_name);
+    VLOG(3) << "Create the shared memory segment " << segment->ipc_name()
+            << " of " << num_slots << " slots of " << slot_size << " bytes";
+    return std::make_shared<MemoryMapWriterAllocation>(
+        segment, segment->AcquireSlot(), size);
+  }
+
+ private:
+  MemoryMapSegmentPool() = default;
+
+  std::mutex mtx_;
+  std::map<size_t, std::vector<std::shared_ptr<MemoryMapSegment>>> segments_;
+  size_t pool_size_{0};
+};
+
+// The segments mapped by the reader process.
+class MemoryMapSegmentCache {
+ public:
+  static MemoryMapSegmentCache &Instance() {  // NOLINT
+    static MemoryMapSegmentCache cache;
+    return cache;
+  }
+
+  std::shared_ptr<MemoryMapSegment> Get(const std::string &ipc_name) {
+    std::lock_guard<std::mutex> guard(mtx_);
+    auto it = segments_.find(ipc_name);
+    if (it != segments_.end()) {
+      return it->second;
+    }
+
+    // The segments of the writers exited, e.g. the workers of the former
+    // epochs, are unmapped once their slots are all released.
+    for (auto iter = segments_.begin(); iter != segments_.end();) {
+      if (iter->second.use_count() == 1 &&
+          kill(iter->second->header()->writer_pid, 0) != 0 &&
+          errno == ESRCH) {
+        iter = segments_.erase(iter);
+      } else {
+        ++iter;
+      }
+    }
+
+    int fd = shm_open(ipc_name.c_str(), O_RDWR, 0644);
+    PADDLE_ENFORCE_NE(
+        fd, -1, platform::errors::Unavailable("File descriptor %s open failed",
+                                              ipc_name.c_str()));
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      PADDLE_THROW(platform::errors::Unavailable(
+          "Cannot get the size of the shared memory segment %s.", ipc_name));
+    }
+    size_t size = static_cast<size_t>(st.st_size);
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    PADDLE_ENFORCE_NE(ptr, MAP_FAILED,
+                      platform::errors::Unavailable(
+                          "Memory map failed when rebuild shared memory."));
+    // The segment is not opened by name any more, for the writer keeps it
+    // mapped to reuse the slots.
+    shm_unlink(ipc_name.c_str());
+    auto segment = std::make_shared<MemoryMapSegment>(ptr, size, ipc_name);
+    segments_.emplace(ipc_name, segment);
+    return segment;
+  }
+
+ private:
+  MemoryMapSegmentCache() = default;
+
+  std::mutex mtx_;
+  std::unordered_map<std::string, std::shared_ptr<MemoryMapSegment>>
+      segments_;
+};
+
+std::shared_ptr<MemoryMapWriterAllocation>
+AllocatePooledMemoryMapWriterAllocation(size_t size) {
+  if (FLAGS_dataloader_shm_pool_mb > 0) {
+    auto allocation = MemoryMapSegmentPool::Instance().Allocate(size);
+    if (allocation != nullptr) {
+      return allocation;
+    }
+  }
+  return AllocateMemoryMapWriterAllocation(size);
+}
+
+std::shared_ptr<MemoryMapReaderAllocation>
+RebuildPooledMemoryMapReaderAllocation(const std::string &ipc_name,
+                                       size_t offset, size_t size) {
+  auto segment = MemoryMapSegmentCache::Instance().Get(ipc_name);
+  PADDLE_ENFORCE_LE(offset + size, segment->size(),
+                    platform::errors::InvalidArgument(
+                        "The slot at %d of %d bytes exceeds the shared memory "
+                        "segment %s.",
+                        offset, size, ipc_name));
+  return std::make_shared<MemoryMapReaderAllocation>(segment, offset, size);
+}
+
 MemoryMapFdSet &MemoryMapFdSet::Instance() {  // NOLINT
   static MemoryMapFdSet set;
   return set;
@@ -28,6 +28,8 @@ namespace paddle {
 namespace memory {
 namespace allocation {
 
+class MemoryMapSegment;
+
 class MemoryMapWriterAllocation : public Allocation {
  public:
   explicit MemoryMapWriterAllocation(void *ptr, size_t size,
@@ -35,12 +37,21 @@ class MemoryMapWriterAllocation : public Allocation {
       : Allocation(ptr, size, platform::CPUPlace()),
         ipc_name_(std::move(ipc_name)) {}
 
+  // A slot of a segment of the pool at the offset.
+  MemoryMapWriterAllocation(std::shared_ptr<MemoryMapSegment> segment,
+                            size_t offset, size_t size);
+
   inline const std::string &ipc_name() const { return ipc_name_; }
 
+  inline bool pooled() const { return segment_ != nullptr; }
+  inline size_t offset() const { return offset_; }
+
   ~MemoryMapWriterAllocation() override;
 
  private:
   std::string ipc_name_;
+  std::shared_ptr<MemoryMapSegment> segment_;
+  size_t offset_{0};
 };
 
 class MemoryMapReaderAllocation : public Allocation {
@@ -50,12 +61,19 @@ class MemoryMapReaderAllocation : public Allocation {
       : Allocation(ptr, size, platform::CPUPlace()),
         ipc_name_(std::move(ipc_name)) {}
 
+  // A slot of a segment of the pool at the offset, which is released to the
+  // writer when the allocation is destroyed.
+  MemoryMapReaderAllocation(std::shared_ptr<MemoryMapSegment> segment,
+                            size_t offset, size_t size);
+
   inline const std::string &ipc_name() const { return ipc_name_; }
 
   ~MemoryMapReaderAllocation() override;
 
  private:
   std::string ipc_name_;
+  std::shared_ptr<MemoryMapSegment> segment_;
+  size_t offset_{0};
 };
 
 std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
@@ -64,6 +82,51 @@ std::shared_ptr<MemoryMapWriterAllocation> AllocateMemoryMapWriterAllocation(
 std::shared_ptr<MemoryMapReaderAllocation> RebuildMemoryMapReaderAllocation(
     const std::string &ipc_name, size_t size);
 
+/*
+ * Allocate the shared memory of a tensor sent to another process, e.g. by
+ * the workers of the DataLoader, from the pool of the process if
+ * FLAGS_dataloader_shm_pool_mb > 0, otherwise a shared memory file of the
+ * tensor is created as AllocateMemoryMapWriterAllocation.
+ *
+ * The pool maps the segments of the slots of a size, a power of 2, once, and
+ * the slots are released by the reader, so that the slots are reused by the
+ * later tensors without creating, mapping and faulting in the new files. The
+ * states of the slots are kept in the head of the segments shared by the
+ * processes. If the slots are all in use and the pool is full, the tensors
+ * are allocated in their own files. The segments not mapped by the reader
+ * are unlinked by MemoryMapFdSet::Clear as the writer exits.
+ *
+ * The tensor must be read once by RebuildPooledMemoryMapReaderAllocation,
+ * and not by the writer after sent, for the slot is reused once the reader
+ * releases it.
+ */
+std::shared_ptr<MemoryMapWriterAllocation>
+AllocatePooledMemoryMapWriterAllocation(size_t size);
+
+// The segments are mapped once by the reader, and unlinked once mapped.
+std::shared_ptr<MemoryMapReaderAllocation>
+RebuildPooledMemoryMapReaderAllocation(const std::string &ipc_name,
+                                       size_t offset, size_t size);
+
+// A private mapping of a regular file, e.g. the parameters of a model. The
+// pages are backed by the page cache and shared by all the processes mapping
+// the same file until they are written, then the written pages are copied.
+class MemoryMapFileAllocation : public Allocation {
+ public:
+  explicit MemoryMapFileAllocation(void *ptr, size_t size, std::string path)
+      : Allocation(ptr, size, platform::CPUPlace()), path_(std::move(path)) {}
+
+  inline const std::string &path() const { return path_; }
+
+  ~MemoryMapFileAllocation() override;
+
+ private:
+  std::string path_;
+};
+
+std::shared_ptr<MemoryMapFileAllocation> AllocateMemoryMapFileAllocation(
+    const std::string &path);
+
 class MemoryMapFdSet {
  public:
   static MemoryMapFdSet &Instance();  // NOLINT
@@ -16,8 +16,19 @@
 
 #include "paddle/fluid/memory/allocation/mmap_allocator.h"
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <vector>
+
+#include "gflags/gflags.h"
 #include "gtest/gtest.h"
 
+DECLARE_uint64(dataloader_shm_pool_mb);
+
 namespace paddle {
 namespace memory {
 namespace allocation {
@@ -39,10 +50,177 @@ TEST(MemoryMapAllocation, test_allocation_base) {
     auto mmap_reader_holder =
         RebuildMemoryMapReaderAllocation(ipc_name, data_size);
     auto* reader_ptr = static_cast<int32_t*>(mmap_reader_holder->ptr());
+    bool equal = true;
+    for (int32_t i = 0; i < 1024; ++i) {
+      equal = equal && reader_ptr[i] == i;
+    }
+    _exit(equal ? 0 : 1);
+  }
+  int status = 0;
+  ASSERT_EQ(waitpid(fpid, &status, 0), fpid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+  shm_unlink(ipc_name.c_str());
+}
+
+TEST(MemoryMapAllocation, test_pooled_allocation) {
+  FLAGS_dataloader_shm_pool_mb = 0;
+  auto file_writer = AllocatePooledMemoryMapWriterAllocation(4096);
+  EXPECT_FALSE(file_writer->pooled());
+  MemoryMapFdSet::Instance().Insert(file_writer->ipc_name());
+
+  // a pool of 7 slots of 128KB
+  FLAGS_dataloader_shm_pool_mb = 1;
+  size_t data_size = 100UL * 1024;
+  std::vector<std::shared_ptr<MemoryMapWriterAllocation>> writers;
+  for (int i = 0; i < 7; ++i) {
+    writers.emplace_back(AllocatePooledMemoryMapWriterAllocation(data_size));
+    ASSERT_TRUE(writers.back()->pooled());
+    EXPECT_EQ(writers.back()->size(), data_size);
+  }
+  // the pool is full, so the tensor has its own file
+  auto writer = AllocatePooledMemoryMapWriterAllocation(data_size);
+  EXPECT_FALSE(writer->pooled());
+  MemoryMapFdSet::Instance().Insert(writer->ipc_name());
+
+  auto* writer_ptr = static_cast<int32_t*>(writers[0]->ptr());
+  for (int32_t i = 0; i < 1024; ++i) {
+    writer_ptr[i] = i;
+  }
+  std::string ipc_name = writers[0]->ipc_name();
+  size_t offset = writers[0]->offset();
+  pid_t fpid = fork();
+  if (fpid == 0) {
+    auto reader =
+        RebuildPooledMemoryMapReaderAllocation(ipc_name, offset, data_size);
+    auto* reader_ptr = static_cast<int32_t*>(reader->ptr());
+    bool equal = true;
     for (int32_t i = 0; i < 1024; ++i) {
-      ASSERT_EQ(reader_ptr[i], i);
+      equal = equal && reader_ptr[i] == i;
     }
+    // release the slot to the writer
+    reader.reset();
+    _exit(equal ? 0 : 1);
   }
+  int status = 0;
+  ASSERT_EQ(waitpid(fpid, &status, 0), fpid);
+  ASSERT_TRUE(WIFEXITED(status));
+  EXPECT_EQ(WEXITSTATUS(status), 0);
+
+  // the slot released is reused
+  writers[0].reset();
+  auto reused = AllocatePooledMemoryMapWriterAllocation(data_size);
+  ASSERT_TRUE(reused->pooled());
+  EXPECT_EQ(reused->ipc_name(), ipc_name);
+  EXPECT_EQ(reused->offset(), offset);
+  FLAGS_dataloader_shm_pool_mb = 0;
+}
+
+TEST(MemoryMapAllocation, test_pooled_segment_unlinked_on_clear) {
+  FLAGS_dataloader_shm_pool_mb = 1;
+  // a slot of a new segment, sent but never read
+  auto writer = AllocatePooledMemoryMapWriterAllocation(8UL * 1024);
+  ASSERT_TRUE(writer->pooled());
+  int fd = shm_open(writer->ipc_name().c_str(), O_RDONLY, 0644);
+  ASSERT_NE(fd, -1);
+  close(fd);
+
+  // as the worker exits
+  MemoryMapFdSet::Instance().Clear();
+  EXPECT_EQ(shm_open(writer->ipc_name().c_str(), O_RDONLY, 0644), -1);
+  EXPECT_EQ(errno, ENOENT);
+  FLAGS_dataloader_shm_pool_mb = 0;
+}
+
+// The batches per second sent by a writer process to the reader process,
+// with 2 batches in flight as the DataLoader prefetches, in the files of
+// the tensors and in the pool.
+TEST(MemoryMapAllocation, benchmark_pooled_allocation) {
+  struct Message {
+    char ipc_name[64];
+    uint64_t offset;
+    uint64_t size;
+    int32_t pooled;
+  };
+  const int num_batches = 500;
+  const int batch_size = 4;
+  const size_t data_size = 1UL << 20;
+  auto run = [&](bool pooled) {
+    int data_pipe[2], ack_pipe[2];
+    PADDLE_ENFORCE_EQ(pipe(data_pipe), 0, platform::errors::Unavailable(
+                                              "Cannot create the pipe."));
+    PADDLE_ENFORCE_EQ(pipe(ack_pipe), 0, platform::errors::Unavailable(
+                                             "Cannot create the pipe."));
+    auto start = std::chrono::steady_clock::now();
+    pid_t fpid = fork();
+    if (fpid == 0) {
+      FLAGS_dataloader_shm_pool_mb = pooled ? 64 : 0;
+      for (int i = 0; i < num_batches; ++i) {
+        if (i >= 2) {
+          char ack;
+          if (read(ack_pipe[0], &ack, 1) != 1) _exit(1);
+        }
+        for (int j = 0; j < batch_size; ++j) {
+          auto writer = AllocatePooledMemoryMapWriterAllocation(data_size);
+          memset(writer->ptr(), i, data_size);
+          Message message;
+          snprintf(message.ipc_name, sizeof(message.ipc_name), "%s",
+                   writer->ipc_name().c_str());
+          message.offset = writer->offset();
+          message.size = data_size;
+          message.pooled = writer->pooled();
+          if (write(data_pipe[1], &message, sizeof(message)) !=
+              sizeof(message)) {
+            _exit(1);
+          }
+        }
+      }
+      _exit(0);
+    }
+    int64_t sum = 0;
+    for (int i = 0; i < num_batches; ++i) {
+      for (int j = 0; j < batch_size; ++j) {
+        Message message;
+        PADDLE_ENFORCE_EQ(
+            read(data_pipe[0], &message, sizeof(message)),
+            static_cast<ssize_t>(sizeof(message)),
+            platform::errors::Unavailable("Cannot read the message."));
+        std::shared_ptr<MemoryMapReaderAllocation> reader;
+        if (message.pooled) {
+          reader = RebuildPooledMemoryMapReaderAllocation(
+              message.ipc_name, message.offset, message.size);
+        } else {
+          reader =
+              RebuildMemoryMapReaderAllocation(message.ipc_name, message.size);
+          shm_unlink(message.ipc_name);
+        }
+        auto* reader_ptr = static_cast<uint8_t*>(reader->ptr());
+        for (size_t k = 0; k < message.size; k += 4096) {
+          sum += reader_ptr[k];
+        }
+      }
+      char ack = 0;
+      PADDLE_ENFORCE_EQ(
+          write(ack_pipe[1], &ack, 1), 1,
+          platform::errors::Unavailable("Cannot write the acknowledgement."));
+    }
+    int status = 0;
+    waitpid(fpid, &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    for (int fd : {data_pipe[0], data_pipe[1], ack_pipe[0], ack_pipe[1]}) {
+      close(fd);
+    }
+    EXPECT_GT(sum, 0);
+    return num_batches /
+           std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+               .count();
+  };
+  double file_rate = run(false);
+  double pooled_rate = run(true);
+  LOG(INFO) << "Batches of " << batch_size << " tensors of " << data_size
+            << " bytes sent in the files: " << file_rate
+            << " batches/s, in the pool: " << pooled_rate << " batches/s";
 }
 
 }  // namespace allocation
@@ -60,7 +60,7 @@ class AssignFunctor {
     out_rows.set_height(rows.height());
     auto &t = rows.value();
     auto *m = out_rows.mutable_value();
-    framework::TensorCopy(t, t.place(), m);
+    copy_data(t, m);
   }
 
   template <typename T>
@@ -76,10 +76,19 @@ class AssignFunctor {
                    framework::LoDTensor *out) const {
     if (lod_tensor.numel() == 0) return;
     auto &out_tensor = *out;
-    TensorCopy(lod_tensor, lod_tensor.place(), &out_tensor);
+    copy_data(lod_tensor, &out_tensor);
     out_tensor.set_lod(lod_tensor.lod());
   }
 
+  // The tensors on CPU are shared copy-on-write instead of copied.
+  void copy_data(const framework::Tensor &src, framework::Tensor *dst) const {
+    if (platform::is_cpu_place(src.place())) {
+      framework::TensorCopyOnWrite(src, src.place(), dev_ctx_, dst);
+    } else {
+      framework::TensorCopy(src, src.place(), dst);
+    }
+  }
+
   framework::Variable *out_;
   const platform::DeviceContext &dev_ctx_;
 };
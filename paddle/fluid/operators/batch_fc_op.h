@@ -15,6 +15,7 @@ limitations under the License. */
 #pragma once
 #include "paddle/fluid/framework/eigen.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 
 namespace paddle {
 namespace operators {
@@ -23,9 +24,31 @@ template <typename DeviceContext, typename T>
 class BatchFCKernel : public framework::OpKernel<T> {
  public:
   void Compute(const framework::ExecutionContext& ctx) const override {
-    PADDLE_ENFORCE_EQ(
-        platform::is_gpu_place(ctx.GetPlace()), true,
-        platform::errors::Unimplemented("BatchFC only supports GPU now."));
+    // X.dim = slot_pairs_num * ins_num * in_dim
+    // W.dim = slot_pairs_num * in_dim * out_dim
+    // b.dim = slot_pairs_num * out_dim
+    // output.dim = slot_pairs_num * ins_num * out_dim
+    auto* input = ctx.Input<framework::LoDTensor>("Input");
+    auto* w = ctx.Input<framework::Tensor>("W");
+    auto* bias = ctx.Input<framework::Tensor>("Bias");
+    auto* output = ctx.Output<framework::LoDTensor>("Out");
+    auto input_dims = input->dims();
+    auto w_dims = w->dims();
+    auto slot_pairs_num = input_dims[0];
+    auto ins_num = input_dims[1];
+    auto in_dim = input_dims[2];
+    auto out_dim = w_dims[2];
+
+    output->Resize({slot_pairs_num, ins_num, out_dim});
+    T* out_data = output->mutable_data<T>(ctx.GetPlace());
+
+    // every slot pair is a small gemm with its own weight and bias
+    const jit::batched_matmul_attr_t attr(ins_num, out_dim, in_dim,
+                                          slot_pairs_num, true);
+    auto compute = jit::KernelFuncs<jit::BatchedMatMulTuple<T>,
+                                    platform::CPUPlace>::Cache()
+                       .At(attr);
+    compute(input->data<T>(), w->data<T>(), bias->data<T>(), out_data, &attr);
   }
 };
 }  // namespace operators
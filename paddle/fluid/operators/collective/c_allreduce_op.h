@@ -14,6 +14,7 @@ limitations under the License. */
 
 #pragma once
 
+#include <algorithm>
 #include <string>
 
 #include "paddle/fluid/framework/data_type.h"
@@ -38,6 +39,7 @@ limitations under the License. */
 #if defined(PADDLE_WITH_GLOO)
 #include <gloo/allreduce.h>
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/platform/cpu_collective.h"
 #endif
 
 #if defined(PADDLE_WITH_ASCEND_CL)
@@ -77,6 +79,37 @@ class CAllReduceOpCPUKernel : public framework::OpKernel<T> {
     int64_t send_numel = in->numel();
     const T* send_buff = in->data<T>();
     T* recv_buff = out->mutable_data<T>(in->dims(), place);
+
+    // The ring created by CPUParallelContext or ParallelExecutor
+    int ring_id = ctx.Attr<int>("ring_id");
+    auto& cpu_comm_ctx = platform::CPUCommContext::Instance();
+    if (cpu_comm_ctx.Has(ring_id)) {
+      if (recv_buff != send_buff) {
+        std::copy(send_buff, send_buff + send_numel, recv_buff);
+      }
+      platform::CPUReduceOp op;
+      switch (red_type) {
+        case kRedSum:
+          op = platform::CPUReduceOp::kSum;
+          break;
+        case kRedMax:
+          op = platform::CPUReduceOp::kMax;
+          break;
+        case kRedMin:
+          op = platform::CPUReduceOp::kMin;
+          break;
+        case kRedProd:
+          op = platform::CPUReduceOp::kProd;
+          break;
+        default:
+          PADDLE_THROW(platform::errors::InvalidArgument(
+              "Invalid reduce type: %d.", red_type));
+      }
+      cpu_comm_ctx.Get(ring_id)->AllReduce(recv_buff, send_numel, in->type(),
+                                           op);
+      return;
+    }
+
     auto gloo = paddle::framework::GlooWrapper::GetInstance();
     PADDLE_ENFORCE_EQ(
         gloo->IsInitialized(), true,
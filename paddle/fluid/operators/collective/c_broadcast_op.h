@@ -25,6 +25,7 @@ limitations under the License. */
 #if defined(PADDLE_WITH_GLOO)
 #include <gloo/broadcast.h>
 #include "paddle/fluid/framework/fleet/gloo_wrapper.h"
+#include "paddle/fluid/platform/cpu_collective.h"
 #endif
 
 namespace paddle {
@@ -42,6 +43,20 @@ class CBroadcastOpCPUKernel : public framework::OpKernel<T> {
     auto place = ctx.GetPlace();
     int64_t send_numel = in->numel();
     T* recv_buff = out->mutable_data<T>(in->dims(), place);
+
+    // The ring created by CPUParallelContext or ParallelExecutor
+    int ring_id = ctx.Attr<int>("ring_id");
+    auto& cpu_comm_ctx = platform::CPUCommContext::Instance();
+    if (cpu_comm_ctx.Has(ring_id)) {
+      auto* comm = cpu_comm_ctx.Get(ring_id);
+      const T* send_buff = in->data<T>();
+      if (comm->rank() == root && recv_buff != send_buff) {
+        std::copy(send_buff, send_buff + send_numel, recv_buff);
+      }
+      comm->Broadcast(recv_buff, send_numel * sizeof(T), root);
+      return;
+    }
+
     auto gloo = paddle::framework::GlooWrapper::GetInstance();
     PADDLE_ENFORCE_EQ(
         gloo->IsInitialized(), true,
@@ -0,0 +1,128 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/framework/op_registry.h"
+
+USE_OP(coalesce_tensor);
+USE_OP(reshape2);
+USE_OP(assign);
+
+namespace f = paddle::framework;
+namespace p = paddle::platform;
+
+static f::LoDTensor* InitTensor(f::Scope* scope, const std::string& name,
+                                const f::DDim& dims, float value) {
+  auto* tensor = scope->Var(name)->GetMutable<f::LoDTensor>();
+  float* data = tensor->mutable_data<float>(dims, p::CPUPlace());
+  for (int64_t i = 0; i < tensor->numel(); ++i) {
+    data[i] = value + i;
+  }
+  return tensor;
+}
+
+// Coalesce the grads g0 of [2, 3] and g1 of [6] into the fused buffer, as
+// the coalesce_grad_tensor_pass does.
+static void CoalesceGrads(f::Scope* scope) {
+  InitTensor(scope, "g0", {2, 3}, 0);
+  InitTensor(scope, "g1", {6}, 0);
+  scope->Var("fused")->GetMutable<f::LoDTensor>();
+  f::AttributeMap attrs;
+  attrs["dtype"] = static_cast<int>(f::proto::VarType::FP32);
+  attrs["copy_data"] = false;
+  attrs["set_constant"] = true;
+  attrs["constant"] = 0.0f;
+  attrs["check_name"] = true;
+  attrs["use_align"] = false;
+  auto op = f::OpRegistry::CreateOp(
+      "coalesce_tensor", {{"Input", {"g0", "g1"}}},
+      {{"Output", {"g0", "g1"}}, {"FusedOutput", {"fused"}}}, attrs);
+  op->Run(*scope, p::CPUPlace());
+}
+
+static void ExpectFused(const f::Scope& scope, int64_t begin,
+                        const f::LoDTensor& expected) {
+  auto& fused = scope.FindVar("fused")->Get<f::LoDTensor>();
+  for (int64_t i = 0; i < expected.numel(); ++i) {
+    EXPECT_EQ(fused.data<float>()[begin + i], expected.data<float>()[i]);
+  }
+}
+
+TEST(CopyOnWriteOp, reshape2_grad_into_fused_buffer) {
+  f::Scope scope;
+  CoalesceGrads(&scope);
+  scope.Var("xshape")->GetMutable<f::LoDTensor>()->Resize({0, 2, 3});
+  auto* d_out = InitTensor(&scope, "d_out", {6}, 1);
+
+  auto op = f::OpRegistry::CreateOp(
+      "reshape2_grad",
+      {{"XShape", {"xshape"}}, {f::GradVarName("Out"), {"d_out"}}},
+      {{f::GradVarName("X"), {"g0"}}}, {});
+  op->Run(scope, p::CPUPlace());
+
+  auto& g0 = scope.FindVar("g0")->Get<f::LoDTensor>();
+  auto& fused = scope.FindVar("fused")->Get<f::LoDTensor>();
+  EXPECT_EQ(g0.dims(), f::make_ddim({2, 3}));
+  EXPECT_EQ(g0.data<float>(), fused.data<float>());
+  ExpectFused(scope, 0, *d_out);
+}
+
+TEST(CopyOnWriteOp, assign_into_fused_buffer) {
+  f::Scope scope;
+  CoalesceGrads(&scope);
+  auto* x = InitTensor(&scope, "x", {6}, 1);
+
+  auto op =
+      f::OpRegistry::CreateOp("assign", {{"X", {"x"}}}, {{"Out", {"g1"}}}, {});
+  op->Run(scope, p::CPUPlace());
+
+  auto& g1 = scope.FindVar("g1")->Get<f::LoDTensor>();
+  auto& fused = scope.FindVar("fused")->Get<f::LoDTensor>();
+  EXPECT_EQ(g1.data<float>(), fused.data<float>() + 6);
+  ExpectFused(scope, 6, *x);
+}
+
+TEST(CopyOnWriteOp, reshape2_views_plain_input_only) {
+  f::Scope scope;
+  CoalesceGrads(&scope);
+  auto* x = InitTensor(&scope, "x", {2, 3}, 1);
+  f::AttributeMap attrs;
+  attrs["shape"] = std::vector<int>{6};
+
+  for (std::string in : {"x", "g0"}) {
+    auto out = in + "_out";
+    scope.Var(out)->GetMutable<f::LoDTensor>();
+    scope.Var(in + "_xshape")->GetMutable<f::LoDTensor>();
+    auto op = f::OpRegistry::CreateOp(
+        "reshape2", {{"X", {in}}},
+        {{"Out", {out}}, {"XShape", {in + "_xshape"}}}, attrs);
+    op->Run(scope, p::CPUPlace());
+  }
+
+  // The output views the plain input.
+  auto& x_out = scope.FindVar("x_out")->Get<f::LoDTensor>();
+  EXPECT_EQ(x_out.dims(), f::make_ddim({6}));
+  EXPECT_EQ(x_out.data<float>(), x->data<float>());
+
+  // The input in the fused buffer is copied, so that writing it later keeps
+  // it in the buffer.
+  auto* g0 = scope.FindVar("g0")->GetMutable<f::LoDTensor>();
+  auto& g0_out = scope.FindVar("g0_out")->Get<f::LoDTensor>();
+  EXPECT_NE(g0_out.data<float>(), g0->data<float>());
+  auto& fused = scope.FindVar("fused")->Get<f::LoDTensor>();
+  EXPECT_EQ(g0->mutable_data<float>(p::CPUPlace()), fused.data<float>());
+}
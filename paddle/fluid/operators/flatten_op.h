@@ -34,8 +34,7 @@ class FlattenKernel : public framework::OpKernel<T> {
     auto x_dims = in->dims();
     auto out_dims = framework::make_ddim(GetOutputShape(axes, x_dims));
 
-    out->mutable_data(context.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, context.GetPlace(),
         context.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -67,8 +66,7 @@ class FlattenGradKernel : public framework::OpKernel<T> {
         ctx.Input<framework::LoDTensor>(framework::GradVarName("Out"));
     auto in_dims = ctx.Input<framework::LoDTensor>("X")->dims();
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *d_out, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(in_dims);
@@ -89,8 +87,7 @@ class Flatten2Kernel : public framework::OpKernel<T> {
     auto out_dims = framework::make_ddim(
         FlattenKernel<DeviceContext, T>::GetOutputShape(axes, x_dims));
 
-    out->mutable_data(context.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, context.GetPlace(),
         context.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -108,8 +105,7 @@ class Flatten2GradKernel : public framework::OpKernel<T> {
     auto xshape_dims = ctx.Input<framework::LoDTensor>("XShape")->dims();
     auto x_dims = framework::slice_ddim(xshape_dims, 1, xshape_dims.size());
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *d_out, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(x_dims);
@@ -124,8 +120,7 @@ class FlattenContiguousRangeKernel : public framework::OpKernel<T> {
     auto *out = context.Output<framework::LoDTensor>("Out");
     auto out_dims = out->dims();
 
-    out->mutable_data(context.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, context.GetPlace(),
         context.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -143,8 +138,7 @@ class FlattenContiguousRangeGradKernel : public framework::OpKernel<T> {
     auto xshape_dims = ctx.Input<framework::LoDTensor>("XShape")->dims();
     auto x_dims = framework::slice_ddim(xshape_dims, 1, xshape_dims.size());
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *d_out, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(x_dims);
@@ -0,0 +1,279 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/fused/fusion_seqpool_cvm_concat_fc_op.h"
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
+
+namespace paddle {
+namespace operators {
+
+void FusionSeqPoolCVMConcatFCOp::InferShape(
+    framework::InferShapeContext* ctx) const {
+  PADDLE_ENFORCE_GE(
+      ctx->Inputs("X").size(), 1UL,
+      paddle::platform::errors::InvalidArgument(
+          "Inputs(X) of FusionSeqPoolCVMConcatFCOp should not be empty."));
+  OP_INOUT_CHECK(ctx->HasInput("W"), "Input", "W",
+                 "FusionSeqPoolCVMConcatFCOp");
+  OP_INOUT_CHECK(ctx->HasOutput("Out"), "Output", "Out",
+                 "FusionSeqPoolCVMConcatFCOp");
+  bool use_cvm = ctx->Attrs().Get<bool>("use_cvm");
+  PADDLE_ENFORCE_EQ(use_cvm, true,
+                    paddle::platform::errors::InvalidArgument(
+                        "FusionSeqPoolCVMConcatFCOp only supports "
+                        "use_cvm is true yet, but received %d.",
+                        use_cvm));
+  auto& act = ctx->Attrs().Get<std::string>("activation_type");
+  PADDLE_ENFORCE_EQ(act.empty() || act == "relu", true,
+                    paddle::platform::errors::InvalidArgument(
+                        "The activation_type of FusionSeqPoolCVMConcatFCOp "
+                        "should be relu or empty, but received %s.",
+                        act));
+
+  auto ins_dims = ctx->GetInputsDim("X");
+  const size_t n = ins_dims.size();
+  PADDLE_ENFORCE_EQ(ins_dims[0].size(), 2,
+                    paddle::platform::errors::InvalidArgument(
+                        "The dims size of first input should be 2."));
+  auto w_dims = ctx->GetInputDim("W");
+  PADDLE_ENFORCE_EQ(w_dims.size(), 2,
+                    paddle::platform::errors::InvalidArgument(
+                        "The dims size of W should be 2, but received %d.",
+                        w_dims.size()));
+  if (ctx->IsRuntime() || ins_dims[0][1] > 0) {
+    PADDLE_ENFORCE_EQ(
+        w_dims[0], ins_dims[0][1] * static_cast<int64_t>(n),
+        paddle::platform::errors::InvalidArgument(
+            "The height of W should be the width of the concatenated "
+            "features %d, but received %d.",
+            ins_dims[0][1] * static_cast<int64_t>(n), w_dims[0]));
+  }
+  if (ctx->HasInput("Bias")) {
+    auto b_dims = ctx->GetInputDim("Bias");
+    PADDLE_ENFORCE_EQ(framework::product(b_dims), w_dims[1],
+                      paddle::platform::errors::InvalidArgument(
+                          "The size of Bias should be the width of W %d, but "
+                          "received %d.",
+                          w_dims[1], framework::product(b_dims)));
+  }
+
+  // The output height should be confirmed in Compute,
+  // since input lod is not accessible here.
+  ctx->SetOutputDim("Out", {-1, w_dims[1]});
+}
+
+framework::OpKernelType FusionSeqPoolCVMConcatFCOp::GetExpectedKernelType(
+    const framework::ExecutionContext& ctx) const {
+  return framework::OpKernelType(
+      OperatorWithKernel::IndicateVarDataType(ctx, "X"), ctx.GetPlace());
+}
+
+void FusionSeqPoolCVMConcatFCOpMaker::Make() {
+  AddInput("X", "(LoDTensor) Input tensors of this operator.").AsDuplicable();
+  AddInput("CVM",
+           "(Tensor),  a 2-D Tensor with shape [N x 2], where N is the batch "
+           "size, 2 is show and click.");
+  AddInput("W",
+           "(Tensor) The weight of fc with shape [K x D], where K is the total "
+           "width of the concatenated features.");
+  AddInput("Bias", "(Tensor, optional) The bias of fc with shape [1 x D].")
+      .AsDispensable();
+  AddOutput("Out", "(LoDTensor) Output tensor with shape [N x D].");
+  AddAttr<std::string>("pooltype",
+                       "(string, default 'SUM') some of the pooling "
+                       "pooltype of SequencePoolOp.")
+      .SetDefault("SUM")
+      .InEnum({"AVERAGE", "SUM", "SQRT"});
+  AddAttr<bool>("use_cvm", "bool, use cvm or not").SetDefault(true);
+  AddAttr<std::string>("activation_type",
+                       "Activation type used in fc, only relu or empty "
+                       "are supported.")
+      .SetDefault("");
+  AddComment(R"DOC(
+Fusion Sequence Pool of pooltype(sum, average and sqrt), CVM, Concat and FC
+Operator.
+
+The concatenated features are never materialized: the pooled features are
+computed block by block and accumulated into the output of fc directly.
+)DOC");
+}
+
+// Rows of one GEMM and elements of the pooled buffer, the buffer should stay
+// in L2 cache while the GEMM reads it.
+static constexpr int kRowBlock = 64;
+static constexpr int kBufferSize = 16384;
+
+template <typename T>
+void SeqPoolCVMConcatFC(const platform::CPUDeviceContext& dev_ctx,
+                        const std::vector<const LoDTensor*>& ins,
+                        jit::SeqPoolType pool_type, const T* w, const T* bias,
+                        int n_out, bool relu, T* out) {
+  const int n = static_cast<int>(ins.size());
+  const int bs = static_cast<int>(ins[0]->lod()[0].size() - 1);
+  if (bs == 0) {
+    return;
+  }
+  const int width = static_cast<int>(ins[0]->numel() / ins[0]->dims()[0]);
+  const int rows = std::min(bs, kRowBlock);
+  const int slots = std::min(n, std::max(1, kBufferSize / (rows * width)));
+
+  jit::seq_pool_attr_t attr(width, pool_type);
+  auto seqpool =
+      jit::KernelFuncs<jit::SeqPoolTuple<T>, platform::CPUPlace>::Cache().At(
+          attr);
+  auto blas = math::GetBlas<platform::CPUDeviceContext, T>(dev_ctx);
+  framework::Tensor buffer;
+  T* buf = buffer.mutable_data<T>({rows * slots * width}, platform::CPUPlace());
+
+  for (int row_begin = 0; row_begin < bs; row_begin += rows) {
+    const int m = std::min(rows, bs - row_begin);
+    T* out_block = out + static_cast<int64_t>(row_begin) * n_out;
+    for (int slot_begin = 0; slot_begin < n; slot_begin += slots) {
+      const int k_slots = std::min(slots, n - slot_begin);
+      const int k = k_slots * width;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+      for (int r = 0; r < m; ++r) {
+        jit::seq_pool_attr_t row_attr(width, pool_type);
+        T* dst = buf + r * k;
+        for (int s = slot_begin; s < slot_begin + k_slots; ++s) {
+          auto& lod = ins[s]->lod()[0];
+          const size_t j = row_begin + r;
+          row_attr.h = static_cast<int>(lod[j + 1] - lod[j]);
+          seqpool(ins[s]->data<T>() + lod[j] * width, dst, &row_attr);
+
+          // Currently only use_cvm is true.
+          dst[0] = log(dst[0] + 1);
+          dst[1] = log(dst[1] + 1) - dst[0];
+          dst += width;
+        }
+      }
+      blas.GEMM(false, false, m, n_out, k, static_cast<T>(1.0), buf, k,
+                w + static_cast<int64_t>(slot_begin) * width * n_out, n_out,
+                static_cast<T>(slot_begin == 0 ? 0.0 : 1.0), out_block,
+                n_out);
+    }
+  }
+
+  if (bias == nullptr && !relu) {
+    return;
+  }
+  if (bias == nullptr) {
+    auto compute =
+        jit::KernelFuncs<jit::VReluTuple<T>, platform::CPUPlace>::Cache().At(
+            n_out);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+    for (int i = 0; i < bs; ++i) {
+      T* dst = out + static_cast<int64_t>(i) * n_out;
+      compute(dst, dst, n_out);
+    }
+    return;
+  }
+  auto compute =
+      relu ? jit::KernelFuncs<jit::VAddReluTuple<T>,
+                              platform::CPUPlace>::Cache()
+                 .At(n_out)
+           : jit::KernelFuncs<jit::VAddTuple<T>, platform::CPUPlace>::Cache()
+                 .At(n_out);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for
+#endif
+  for (int i = 0; i < bs; ++i) {
+    T* dst = out + static_cast<int64_t>(i) * n_out;
+    compute(bias, dst, dst, n_out);
+  }
+}
+
+template <typename T>
+class FusionSeqPoolCVMConcatFCKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext& ctx) const override {
+    auto ins = ctx.MultiInput<LoDTensor>("X");
+    auto* w = ctx.Input<Tensor>("W");
+    auto* bias = ctx.Input<Tensor>("Bias");
+    auto* out = ctx.Output<LoDTensor>("Out");
+    std::string pooltype = ctx.Attr<std::string>("pooltype");
+    auto x0_lod = ins[0]->lod();
+    auto x0_dims = ins[0]->dims();
+    size_t bs = x0_lod[0].size() - 1;
+    int n_out = static_cast<int>(w->dims()[1]);
+    out->Resize({static_cast<int64_t>(bs), n_out});
+    framework::LoD y_lod(1);
+    y_lod[0].resize(bs + 1);
+    for (size_t i = 0; i <= bs; ++i) {
+      y_lod[0][i] = i;
+    }
+    out->set_lod(y_lod);
+    T* y_data = out->mutable_data<T>(ctx.GetPlace());
+
+    int64_t width = ins[0]->numel() / x0_dims[0];
+    PADDLE_ENFORCE_GE(width, 2,
+                      paddle::platform::errors::InvalidArgument(
+                          "The width of inputs should contain show and click, "
+                          "but received %d.",
+                          width));
+    for (size_t i = 0; i < ins.size(); ++i) {
+      PADDLE_ENFORCE_EQ(ins[i]->numel() / ins[i]->dims()[0], width,
+                        paddle::platform::errors::InvalidArgument(
+                            "Width of all inputs should be equal."));
+      PADDLE_ENFORCE_EQ(ins[i]->lod()[0].size(), bs + 1,
+                        paddle::platform::errors::InvalidArgument(
+                            "Batchsize of all inputs should be equal."));
+    }
+    jit::SeqPoolType pool_type = jit::SeqPoolType::kSum;
+    if (pooltype == "AVERAGE") {
+      pool_type = jit::SeqPoolType::kAvg;
+    } else if (pooltype == "SQRT") {
+      pool_type = jit::SeqPoolType::kSqrt;
+    }
+    auto& dev_ctx = ctx.template device_context<platform::CPUDeviceContext>();
+    SeqPoolCVMConcatFC<T>(dev_ctx,
+                          std::vector<const LoDTensor*>(ins.begin(), ins.end()),
+                          pool_type, w->data<T>(),
+                          bias ? bias->data<T>() : nullptr, n_out,
+                          ctx.Attr<std::string>("activation_type") == "relu",
+                          y_data);
+  }
+};
+
+template void SeqPoolCVMConcatFC<float>(
+    const platform::CPUDeviceContext& dev_ctx,
+    const std::vector<const LoDTensor*>& ins, jit::SeqPoolType pool_type,
+    const float* w, const float* bias, int n_out, bool relu, float* out);
+template void SeqPoolCVMConcatFC<double>(
+    const platform::CPUDeviceContext& dev_ctx,
+    const std::vector<const LoDTensor*>& ins, jit::SeqPoolType pool_type,
+    const double* w, const double* bias, int n_out, bool relu, double* out);
+
+}  // namespace operators
+}  // namespace paddle
+
+namespace ops = paddle::operators;
+REGISTER_OPERATOR(
+    fusion_seqpool_cvm_concat_fc, ops::FusionSeqPoolCVMConcatFCOp,
+    ops::FusionSeqPoolCVMConcatFCOpMaker,
+    paddle::framework::EmptyGradOpMaker<paddle::framework::OpDesc>,
+    paddle::framework::EmptyGradOpMaker<paddle::imperative::OpBase>);
+
+REGISTER_OP_CPU_KERNEL(fusion_seqpool_cvm_concat_fc,
+                       ops::FusionSeqPoolCVMConcatFCKernel<float>,
+                       ops::FusionSeqPoolCVMConcatFCKernel<double>);
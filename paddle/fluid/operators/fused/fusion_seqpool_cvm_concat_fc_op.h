@@ -0,0 +1,56 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+#include <vector>
+#include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+
+using LoDTensor = framework::LoDTensor;
+using Tensor = framework::Tensor;
+
+class FusionSeqPoolCVMConcatFCOp : public framework::OperatorWithKernel {
+ public:
+  using framework::OperatorWithKernel::OperatorWithKernel;
+
+  void InferShape(framework::InferShapeContext* ctx) const override;
+
+ protected:
+  framework::OpKernelType GetExpectedKernelType(
+      const framework::ExecutionContext& ctx) const override;
+};
+
+class FusionSeqPoolCVMConcatFCOpMaker
+    : public framework::OpProtoAndCheckerMaker {
+ public:
+  void Make() override;
+};
+
+// Out = act(concat(cvm(seqpool(X_i))) * W + Bias) without the concat output.
+// The rows are split into blocks, and the pooled features of a block of
+// slots are written to a small buffer then accumulated into Out by GEMM, so
+// the buffer keeps in cache. All inputs should have the same width and batch
+// size, and the CVM of the first two columns is always applied.
+template <typename T>
+void SeqPoolCVMConcatFC(const platform::CPUDeviceContext& dev_ctx,
+                        const std::vector<const LoDTensor*>& ins,
+                        jit::SeqPoolType pool_type, const T* w, const T* bias,
+                        int n_out, bool relu, T* out);
+
+}  // namespace operators
+}  // namespace paddle
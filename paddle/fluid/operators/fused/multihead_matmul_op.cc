@@ -12,8 +12,11 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cstring>
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/operators/math/blas.h"
 #include "paddle/fluid/platform/errors.h"
 
 namespace paddle {
@@ -111,9 +114,108 @@ Example of matrix multiplication with head_number of B
   }
 };
 
+template <typename DeviceContext, typename T>
+class MultiHeadMatMulV2CPUKernel : public framework::OpKernel<T> {
+ public:
+  void Compute(const framework::ExecutionContext &context) const override {
+    using Tensor = framework::Tensor;
+    auto *input = context.Input<framework::Tensor>("Input");
+    auto *w = context.Input<framework::Tensor>("W");
+    auto *bias = context.Input<framework::Tensor>("Bias");
+    auto &bias_qk = GET_DATA_SAFELY(context.Input<framework::Tensor>("BiasQK"),
+                                    "Input", "BiasQK", "MultiHeadMatMulV2");
+
+    auto *input_d = input->data<T>();
+    auto *w_d = w->data<T>();
+    auto *bias_d = bias->data<T>();
+    auto *bias_qk_d = bias_qk.template data<T>();
+    float scale = context.Attr<float>("alpha");
+    int head_number = context.Attr<int>("head_number");
+
+    // should be (B * S * hidden)
+    auto input_dims = input->dims();
+    // shouble be (hidden * 3 * all_head_size)
+    auto w_dims = w->dims();
+    int batch = input_dims[0];
+    int seq_len = input_dims[1];
+    int hidden = input_dims[2];
+    int all_head_size = w_dims[2];
+    int head_size = all_head_size / head_number;
+
+    auto *out = context.Output<framework::Tensor>("Out");
+    out->Resize({batch, seq_len, all_head_size});
+    auto *output_d = out->mutable_data<T>(context.GetPlace());
+
+    // (B * S, hidden) * (hidden, 3 * N * H) + bias -> (B * S, 3, N, H)
+    const int qkv_width = 3 * all_head_size;
+    Tensor qkv_tensor;
+    qkv_tensor.Resize({batch * seq_len, qkv_width});
+    auto *qkv_d = qkv_tensor.mutable_data<T>(context.GetPlace());
+    for (int i = 0; i < batch * seq_len; ++i) {
+      std::memcpy(qkv_d + i * qkv_width, bias_d, qkv_width * sizeof(T));
+    }
+    auto &dev_ctx = context.template device_context<DeviceContext>();
+    auto blas = math::GetBlas<DeviceContext, T>(dev_ctx);
+    blas.GEMM(CblasNoTrans, CblasNoTrans, batch * seq_len, qkv_width, hidden,
+              static_cast<T>(1), input_d, w_d, static_cast<T>(1), qkv_d);
+
+    // (B, S, 3, N, H) -> (3, B, N, S, H), so that every head is contiguous
+    Tensor trans_tensor;
+    trans_tensor.Resize({3, batch, head_number, seq_len, head_size});
+    auto *trans_d = trans_tensor.mutable_data<T>(context.GetPlace());
+    for (int b = 0; b < batch; ++b) {
+      for (int s = 0; s < seq_len; ++s) {
+        for (int m = 0; m < 3; ++m) {
+          for (int n = 0; n < head_number; ++n) {
+            const T *src = qkv_d + (b * seq_len + s) * qkv_width +
+                           m * all_head_size + n * head_size;
+            T *dst = trans_d +
+                     (((m * batch + b) * head_number + n) * seq_len + s) *
+                         head_size;
+            std::memcpy(dst, src, head_size * sizeof(T));
+          }
+        }
+      }
+    }
+
+    const int head_len = seq_len * head_size;
+    const int qkv_len = batch * head_number * head_len;
+    const jit::attention_attr_t attr(seq_len, seq_len, head_size, scale);
+    auto attention =
+        jit::KernelFuncs<jit::AttentionTuple<T>, platform::CPUPlace>::Cache()
+            .At(attr);
+    Tensor context_tensor;
+    context_tensor.Resize({batch, head_number, seq_len, head_size});
+    auto *context_d = context_tensor.mutable_data<T>(context.GetPlace());
+    for (int i = 0; i < batch * head_number; ++i) {
+      const T *q = trans_d + i * head_len;
+      const T *k = q + qkv_len;
+      const T *v = k + qkv_len;
+      attention(q, k, v, bias_qk_d + i * seq_len * seq_len,
+                context_d + i * head_len, &attr);
+    }
+
+    // (B, N, S, H) -> (B, S, N, H)
+    for (int b = 0; b < batch; ++b) {
+      for (int n = 0; n < head_number; ++n) {
+        for (int s = 0; s < seq_len; ++s) {
+          std::memcpy(output_d + (b * seq_len + s) * all_head_size +
+                          n * head_size,
+                      context_d + ((b * head_number + n) * seq_len + s) *
+                                      head_size,
+                      head_size * sizeof(T));
+        }
+      }
+    }
+  }
+};
+
 }  // namespace operators
 }  // namespace paddle
 
 namespace ops = paddle::operators;
 REGISTER_OP_WITHOUT_GRADIENT(multihead_matmul, ops::MultiHeadMatMulV2Op,
                              ops::MultiHeadMatMulV2OpMaker);
+REGISTER_OP_CPU_KERNEL(
+    multihead_matmul,
+    ops::MultiHeadMatMulV2CPUKernel<paddle::platform::CPUDeviceContext, float>);
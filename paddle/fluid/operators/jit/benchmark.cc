@@ -12,13 +12,17 @@
  * See the License for the specific language governing permissions and
  * limitations under the License. */
 
+#include <stdlib.h>  // for mkdtemp
 #include <iostream>
 #include <random>
+#include <thread>  // NOLINT
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/operators/jit/jitcode_cache.h"
 #include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/device_tracer.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/place.h"
@@ -79,6 +83,19 @@ void RandomVec(const int n, T* a, const T lower = static_cast<T>(-20.f),
   }
 }
 
+template <>
+void RandomVec<paddle::platform::bfloat16>(
+    const int n, paddle::platform::bfloat16* a,
+    const paddle::platform::bfloat16 lower,
+    const paddle::platform::bfloat16 upper, unsigned int seed) {
+  std::mt19937 rng(seed);
+  std::uniform_real_distribution<float> uniform_dist(
+      static_cast<float>(lower), static_cast<float>(upper));
+  for (int i = 0; i < n; ++i) {
+    a[i] = paddle::platform::bfloat16(uniform_dist(rng));
+  }
+}
+
 std::vector<int> TestSizes() {
   std::vector<int> s;
   for (int i = 1; i <= FLAGS_max_size; ++i) {
@@ -270,7 +287,8 @@ void BenchKernelSeqPool() {
         Tensor x, y;
         x.Resize({h * w});
         y.Resize({w});
-        RandomVec<T>(h * w, x.mutable_data<T>(PlaceType()), -2.f, 2.f);
+        RandomVec<T>(h * w, x.mutable_data<T>(PlaceType()),
+                     static_cast<T>(-2.f), static_cast<T>(2.f));
         const T* x_data = x.data<T>();
         T* y_data = y.mutable_data<T>(PlaceType());
         BenchAllImpls<KernelTuple, PlaceType>(attr, x_data, y_data, &attr);
@@ -384,6 +402,67 @@ void BenchKernelMatMul() {
   }
 }
 
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelBatchedMatMul() {
+  using T = typename KernelTuple::data_type;
+  for (int batch : {1, 16}) {
+    for (int m : {1, 4, 16, 64}) {
+      for (int n : {16, 32, 64, 128}) {
+        for (int k : {16, 64, 128}) {
+          for (auto act : {jit::kVIdentity, jit::kVRelu}) {
+            Tensor a, b, bias, c;
+            a.Resize({batch * m * k});
+            b.Resize({batch * k * n});
+            bias.Resize({batch * n});
+            c.Resize({batch * m * n});
+            RandomVec<T>(batch * m * k, a.mutable_data<T>(PlaceType()), -2.f,
+                         2.f);
+            RandomVec<T>(batch * k * n, b.mutable_data<T>(PlaceType()), -2.f,
+                         2.f);
+            RandomVec<T>(batch * n, bias.mutable_data<T>(PlaceType()), -2.f,
+                         2.f);
+            const T* a_data = a.data<T>();
+            const T* b_data = b.data<T>();
+            const T* bias_data = bias.data<T>();
+            T* c_data = c.mutable_data<T>(PlaceType());
+            const jit::batched_matmul_attr_t attr(m, n, k, batch, true, act);
+            BenchAllImpls<KernelTuple, PlaceType>(attr, a_data, b_data,
+                                                  bias_data, c_data, &attr);
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename KernelTuple, typename PlaceType>
+void BenchKernelAttention() {
+  using T = typename KernelTuple::data_type;
+  for (int seq_len : {16, 32, 64, 128}) {
+    for (int d : {32, 64}) {
+      Tensor q, k, v, bias_qk, out;
+      q.Resize({seq_len * d});
+      k.Resize({seq_len * d});
+      v.Resize({seq_len * d});
+      bias_qk.Resize({seq_len * seq_len});
+      out.Resize({seq_len * d});
+      RandomVec<T>(seq_len * d, q.mutable_data<T>(PlaceType()), -2.f, 2.f);
+      RandomVec<T>(seq_len * d, k.mutable_data<T>(PlaceType()), -2.f, 2.f);
+      RandomVec<T>(seq_len * d, v.mutable_data<T>(PlaceType()), -2.f, 2.f);
+      RandomVec<T>(seq_len * seq_len, bias_qk.mutable_data<T>(PlaceType()),
+                   -2.f, 2.f);
+      const T* q_data = q.data<T>();
+      const T* k_data = k.data<T>();
+      const T* v_data = v.data<T>();
+      const T* bias_data = bias_qk.data<T>();
+      T* out_data = out.mutable_data<T>(PlaceType());
+      const jit::attention_attr_t attr(seq_len, seq_len, d, 0.125f);
+      BenchAllImpls<KernelTuple, PlaceType>(attr, q_data, k_data, v_data,
+                                            bias_data, out_data, &attr);
+    }
+  }
+}
+
 template <typename KernelTuple, typename PlaceType>
 void BenchKernelSoftmax() {
   using T = typename KernelTuple::data_type;
@@ -518,6 +597,12 @@ using CPUPlace = paddle::platform::CPUPlace;
     BenchKernel##name<jit::name##Tuple<float>, CPUPlace>(); \
   }
 
+#define BENCH_BF16_CPU(name)                                        \
+  BENCH_JITKERNEL(name, BF16, CPU) {                                \
+    BenchKernel##name<jit::name##Tuple<paddle::platform::bfloat16>, \
+                      CPUPlace>();                                  \
+  }
+
 // xyzn
 BENCH_FP32_CPU(VMul);
 BENCH_FP32_CPU(VAdd);
@@ -556,10 +641,84 @@ BENCH_FP32_CPU(CRFDecoding);
 BENCH_FP32_CPU(SeqPool);
 BENCH_FP32_CPU(EmbSeqPool);
 BENCH_FP32_CPU(MatMul);
+BENCH_FP32_CPU(BatchedMatMul);
 BENCH_FP32_CPU(Softmax);
+BENCH_FP32_CPU(Attention);
 BENCH_FP32_CPU(Sgd);
 BENCH_FP32_CPU(VBroadcast);
 
+// bfloat16, jitcode only generated on avx512f
+BENCH_BF16_CPU(VRelu);
+BENCH_BF16_CPU(VIdentity);
+BENCH_BF16_CPU(VSquare);
+BENCH_BF16_CPU(VExp);
+BENCH_BF16_CPU(VSigmoid);
+BENCH_BF16_CPU(VTanh);
+BENCH_BF16_CPU(SeqPool);
+
+// The jitcodes used by a representative sequence model, like text
+// classification with embedding, GRU, sequence pooling and fc, whose
+// activations are on the variable sequence lengths.
+int GetSequenceModelJitCodes() {
+  using CPU = CPUPlace;
+  int num = 0;
+  auto count = [&num](const jit::Kernel* k) { num += (k != nullptr); };
+  for (int len = 1; len <= 128; ++len) {
+    count(jit::GetJitCode<jit::VSigmoidTuple<float>, CPU>(len));
+    count(jit::GetJitCode<jit::VTanhTuple<float>, CPU>(len));
+    count(jit::GetJitCode<jit::VReluTuple<float>, CPU>(len));
+  }
+  for (int d : {64, 128, 256, 512}) {
+    const jit::gru_attr_t gru_attr(d, jit::kVSigmoid, jit::kVTanh);
+    count(jit::GetJitCode<jit::GRUH1Tuple<float>, CPU>(gru_attr));
+    count(jit::GetJitCode<jit::GRUHtPart1Tuple<float>, CPU>(gru_attr));
+    count(jit::GetJitCode<jit::GRUHtPart2Tuple<float>, CPU>(gru_attr));
+    count(jit::GetJitCode<jit::VAddBiasTuple<float>, CPU>(d));
+    for (auto type : {jit::SeqPoolType::kSum, jit::SeqPoolType::kSqrt}) {
+      const jit::seq_pool_attr_t pool_attr(d, type);
+      count(jit::GetJitCode<jit::SeqPoolTuple<float>, CPU>(pool_attr));
+    }
+  }
+  return num;
+}
+
+// The jitcode pools are thread local, so each run in a new thread is a cold
+// start, like a new process.
+double BenchColdStart(int* num) {
+  double elapsed = 0;
+  std::thread t([&] {
+    auto start = paddle::platform::PosixInNsec() * 1e-3;
+    *num = GetSequenceModelJitCodes();
+    elapsed = paddle::platform::PosixInNsec() * 1e-3 - start;
+  });
+  t.join();
+  return elapsed;
+}
+
+BENCH_JITKERNEL(JitCodeStartup, FP32, CPU) {
+  const std::string cache_dir = FLAGS_jitcode_cache_dir;
+  int num = 0;
+  FLAGS_jitcode_cache_dir = "";
+  double generate = BenchColdStart(&num);
+
+  if (cache_dir.empty()) {
+    char dir[] = "/tmp/paddle_jitcode_cache_XXXXXX";
+    PADDLE_ENFORCE_NOT_NULL(
+        mkdtemp(dir), paddle::platform::errors::Unavailable(
+                          "Failed to create the jitcode cache directory."));
+    FLAGS_jitcode_cache_dir = dir;
+  } else {
+    FLAGS_jitcode_cache_dir = cache_dir;
+  }
+  double save = BenchColdStart(&num);
+  double load = BenchColdStart(&num);
+  LOG(INFO) << "Startup of " << num << " jitcodes with cache directory "
+            << FLAGS_jitcode_cache_dir << ": generate takes " << generate
+            << " us; generate and save takes " << save
+            << " us; load takes " << load << " us";
+  FLAGS_jitcode_cache_dir = cache_dir;
+}
+
 // Benchmark all jit kernels including jitcode, mkl and refer.
 // To use this tool, run command: ./benchmark [options...]
 // Options:
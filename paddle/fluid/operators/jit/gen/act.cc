@@ -14,7 +14,10 @@
 
 #include "paddle/fluid/operators/jit/gen/act.h"
 
+#include <type_traits>
+
 #include "paddle/fluid/operators/jit/registry.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/cpu_info.h"
 
 namespace paddle {
@@ -44,7 +47,15 @@ const float ALIGN32_BEG exp_float_consts[] ALIGN32_END = {
 const int ALIGN32_BEG exp_int_0x7f[] ALIGN32_END = {REPEAT_8TIMES(0x7f)};
 int ALIGN32_BEG g_tmp_mem[16] ALIGN32_END = {0};
 
+REGISTER_JITCODE_SYMBOL(exp_float_consts);
+REGISTER_JITCODE_SYMBOL(exp_int_0x7f);
+REGISTER_JITCODE_SYMBOL(g_tmp_mem);
+
 void VActJitCode::genCode() {
+  if (isa_ == platform::avx512f) {
+    genCodeAVX512();
+    return;
+  }
   int offset = 0;
   for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
     vmovups(ymm_src, ptr[param1 + offset]);
@@ -79,6 +90,43 @@ void VActJitCode::genCode() {
   ret();
 }
 
+void VActJitCode::genCodeAVX512() {
+  const int elem_size = bf16_ ? sizeof(int16_t) : sizeof(float);
+  auto load = [&](int offset, bool tail) {
+    if (bf16_) {
+      load_bf16(zmm_src, ptr[param1 + offset], tail);
+    } else if (tail) {
+      vmovups(zmm_src | k_tail_mask | T_z, ptr[param1 + offset]);
+    } else {
+      vmovups(zmm_src, ptr[param1 + offset]);
+    }
+  };
+  auto save = [&](int offset, bool tail) {
+    if (bf16_) {
+      store_bf16(ptr[param2 + offset], zmm_dst, tail);
+    } else if (tail) {
+      vmovups(ptr[param2 + offset] | k_tail_mask, zmm_dst);
+    } else {
+      vmovups(ptr[param2 + offset], zmm_dst);
+    }
+  };
+  int offset = 0;
+  for (int i = 0; i < num_ / ZMM_FLOAT_BLOCK; ++i) {
+    load(offset, false);
+    act<zmm_t>(zmm_dst, zmm_src, type_);
+    save(offset, false);
+    offset += elem_size * ZMM_FLOAT_BLOCK;
+  }
+  int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (rest > 0) {
+    set_tail_mask(rest, reg32_tmp);
+    load(offset, true);
+    act<zmm_t>(zmm_dst, zmm_src, type_);
+    save(offset, true);
+  }
+  ret();
+}
+
 #define DECLARE_ACT_CREATOR(name)                                            \
   class name##Creator : public JitCodeCreator<int> {                         \
    public:                                                                   \
@@ -149,6 +197,40 @@ size_t VTanhCreator::CodeSize(const int& d) const {
 
 #undef DECLARE_ACT_CREATOR
 
+// The float and bfloat16 codes with zmm, T is the data type.
+template <typename JitCodeType, typename T>
+class VActAVX512Creator : public JitCodeCreator<int, T> {
+ public:
+  bool CanBeUsed(const int& d) const override {
+    // like VExpCreator, mkl is better with larger size of float exp
+    bool is_float_exp = std::is_same<JitCodeType, VExpJitCode>::value &&
+                        std::is_same<T, float>::value;
+    return platform::MayIUse(platform::avx512f) && (!is_float_exp || d < 32);
+  }
+  size_t CodeSize(const int& d) const override {
+    return 96 + (d / ZMM_FLOAT_BLOCK + 2) * 100 * 8;
+  }
+  std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override {
+    return make_unique<JitCodeType>(
+        attr, CodeSize(attr), platform::avx512f,
+        std::is_same<T, platform::bfloat16>::value);
+  }
+};
+
+#define DECLARE_ACT_AVX512_CREATOR(name)                               \
+  using name##AVX512Creator = VActAVX512Creator<name##JitCode, float>; \
+  using name##BF16Creator =                                            \
+      VActAVX512Creator<name##JitCode, platform::bfloat16>
+
+DECLARE_ACT_AVX512_CREATOR(VRelu);
+DECLARE_ACT_AVX512_CREATOR(VSquare);
+DECLARE_ACT_AVX512_CREATOR(VIdentity);
+DECLARE_ACT_AVX512_CREATOR(VExp);
+DECLARE_ACT_AVX512_CREATOR(VSigmoid);
+DECLARE_ACT_AVX512_CREATOR(VTanh);
+
+#undef DECLARE_ACT_AVX512_CREATOR
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -156,9 +238,16 @@ size_t VTanhCreator::CodeSize(const int& d) const {
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVRelu, gen::VReluCreator);
-REGISTER_JITKERNEL_GEN(kVSquare, gen::VSquareCreator);
-REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityCreator);
-REGISTER_JITKERNEL_GEN(kVExp, gen::VExpCreator);
-REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidCreator);
-REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhCreator);
+// AVX512 creators are in front, so they are chosen first if available
+REGISTER_JITKERNEL_GEN(kVRelu, gen::VReluAVX512Creator, gen::VReluCreator,
+                       gen::VReluBF16Creator);
+REGISTER_JITKERNEL_GEN(kVSquare, gen::VSquareAVX512Creator,
+                       gen::VSquareCreator, gen::VSquareBF16Creator);
+REGISTER_JITKERNEL_GEN(kVIdentity, gen::VIdentityAVX512Creator,
+                       gen::VIdentityCreator, gen::VIdentityBF16Creator);
+REGISTER_JITKERNEL_GEN(kVExp, gen::VExpAVX512Creator, gen::VExpCreator,
+                       gen::VExpBF16Creator);
+REGISTER_JITKERNEL_GEN(kVSigmoid, gen::VSigmoidAVX512Creator,
+                       gen::VSigmoidCreator, gen::VSigmoidBF16Creator);
+REGISTER_JITKERNEL_GEN(kVTanh, gen::VTanhAVX512Creator, gen::VTanhCreator,
+                       gen::VTanhBF16Creator);
@@ -68,21 +68,39 @@ class VActFunc : public JitCode {
   virtual void genCode() = 0;
 
  protected:
-  // compute RELU with ymm, xmm
+  // vxorps of zmm needs avx512dq, use vpxord instead
+  void zero_jmm(const Xbyak::Xmm& jmm) {
+    if (jmm.isZMM()) {
+      vpxord(jmm, jmm, jmm);
+    } else {
+      vxorps(jmm, jmm, jmm);
+    }
+  }
+
+  // the consts are saved as 8 floats, so broadcast the first one for zmm
+  void load_const_jmm(const Xbyak::Xmm& jmm, const Xbyak::Address& addr) {
+    if (jmm.isZMM()) {
+      vbroadcastss(jmm, addr);
+    } else {
+      vmovaps(jmm, addr);
+    }
+  }
+
+  // compute RELU with zmm, ymm, xmm
   template <typename JMM>
   void relu_jmm(JMM& dst, JMM& src, int zero_idx = 15) {  // NOLINT
     JMM zero = JMM(zero_idx);
-    vxorps(zero, zero, zero);
+    zero_jmm(zero);
     vmaxps(dst, src, zero);
   }
 
-  // compute SQUARE with ymm, xmm
+  // compute SQUARE with zmm, ymm, xmm
   template <typename JMM>
   void square_jmm(JMM& dst, JMM& src) {  // NOLINT
     vmulps(dst, src, src);
   }
 
-  // compute EXP with ymm, xmm
+  // compute EXP with zmm, ymm, xmm
   template <typename JMM>
   void exp_jmm(JMM& dst, JMM& src, int src_idx = 11, int fx_idx = 12,  // NOLINT
                int fy_idx = 13, int mask_idx = 14, int tmp_idx = 15) {
@@ -96,49 +114,63 @@ class VActFunc : public JitCode {
     reg64_t reg_ptr_global = rax;
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
-    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_HIG]);
+    mov_global(reg_ptr_global, exp_float_consts);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_HIG]);
     vminps(jmm_src, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOW]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOW]);
     vmaxps(jmm_src, jmm_src, jmm_tmp);
     // express exp(x) as exp(g + n*log(2))
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOG2EF]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_LOG2EF]);
     vmulps(jmm_fx, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_0P5]);
     vaddps(jmm_fx, jmm_fx, jmm_tmp);
-    vroundps(jmm_fy, jmm_fx, 0x01);
     // if greater, substract 1
-    vcmpgtps(jmm_mask, jmm_fy, jmm_fx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global]);
-    vandps(jmm_mask, jmm_mask, jmm_tmp);
-    vsubps(jmm_fx, jmm_fy, jmm_mask);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C1]);
+    if (jmm_fx.isZMM()) {
+      // zmm has no vroundps and the compare result is an opmask
+      zmm_t zmm_fx = zmm_t(jmm_fx.getIdx());
+      vrndscaleps(jmm_fy, jmm_fx, 0x01);
+      vcmpps(k_exp_mask, jmm_fy, jmm_fx, 0x0e /* _CMP_GT_OS */);
+      load_const_jmm(jmm_tmp, ptr[reg_ptr_global]);
+      vmovaps(jmm_fx, jmm_fy);
+      vsubps(zmm_fx | k_exp_mask, jmm_fy, jmm_tmp);
+    } else {
+      vroundps(jmm_fy, jmm_fx, 0x01);
+      vcmpgtps(jmm_mask, jmm_fy, jmm_fx);
+      vmovaps(jmm_tmp, ptr[reg_ptr_global]);
+      vandps(jmm_mask, jmm_mask, jmm_tmp);
+      vsubps(jmm_fx, jmm_fy, jmm_mask);
+    }
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C1]);
     vmulps(jmm_fy, jmm_fx, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C2]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_C2]);
     JMM ymm_z = JMM(jmm_mask.getIdx());
     vmulps(ymm_z, jmm_fx, jmm_tmp);
     vsubps(jmm_src, jmm_src, jmm_fy);
     vsubps(jmm_src, jmm_src, ymm_z);
     vmulps(ymm_z, jmm_src, jmm_src);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P0]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P0]);
     vmulps(dst, jmm_src, jmm_tmp);
     for (size_t i = OFFSET_EXP_P1; i < OFFSET_EXP_P5;
          i += (YMM_FLOAT_BLOCK * sizeof(float))) {
-      vmovaps(jmm_tmp, ptr[reg_ptr_global + i]);  // P1~P4
+      load_const_jmm(jmm_tmp, ptr[reg_ptr_global + i]);  // P1~P4
       vaddps(dst, dst, jmm_tmp);
       vmulps(dst, dst, jmm_src);
     }
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P5]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_P5]);
     vaddps(dst, dst, jmm_tmp);
     vmulps(dst, dst, ymm_z);
     vaddps(dst, dst, jmm_src);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global]);
     vaddps(dst, dst, jmm_tmp);
     // build 2^n
     JMM ymm_int = jmm_fx;
     vcvttps2dq(ymm_int, jmm_fx);
-    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_int_0x7f));
-    vmovdqa(jmm_tmp, ptr[reg_ptr_global]);
+    mov_global(reg_ptr_global, exp_int_0x7f);
+    if (jmm_tmp.isZMM()) {
+      vpbroadcastd(jmm_tmp, ptr[reg_ptr_global]);
+    } else {
+      vmovdqa(jmm_tmp, ptr[reg_ptr_global]);
+    }
     if (MayIUse(avx2) || std::is_same<JMM, xmm_t>::value) {
       vpaddd(ymm_int, ymm_int, jmm_tmp);
       vpslld(ymm_int, ymm_int, 23);
@@ -146,7 +178,7 @@ class VActFunc : public JitCode {
       xmm_t xtmp1 = xmm_t(ymm_int.getIdx());
       xmm_t xtmp2 = xmm_t(jmm_tmp.getIdx());
       reg64_t reg_ptr_tmp = reg_ptr_global;
-      mov(reg_ptr_tmp, reinterpret_cast<size_t>(g_tmp_mem));
+      mov_global(reg_ptr_tmp, g_tmp_mem);
       vmovdqa(ptr[reg_ptr_tmp], ymm_int);
       vmovdqa(ptr[reg_ptr_tmp + YMM_FLOAT_BLOCK * sizeof(float)], jmm_tmp);
       vpaddd(xtmp1, xtmp1, xtmp2);
@@ -166,7 +198,7 @@ class VActFunc : public JitCode {
     pop(reg_ptr_global);
   }
 
-  // compute SIGMOID with ymm, xmm
+  // compute SIGMOID with zmm, ymm, xmm
   template <typename JMM>
   void sigmoid_jmm(JMM& dst, JMM& src, int src_idx = 11,  // NOLINT
                    int fx_idx = 12, int fy_idx = 13, int mask_idx = 14,
@@ -177,21 +209,21 @@ class VActFunc : public JitCode {
     reg64_t reg_ptr_global = rax;
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
-    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MAX]);
+    mov_global(reg_ptr_global, exp_float_consts);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MAX]);
     vminps(jmm_src, jmm_src, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MIN]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_SIGMOID_MIN]);
     vmaxps(jmm_src, jmm_src, jmm_tmp);
-    vxorps(jmm_tmp, jmm_tmp, jmm_tmp);
+    zero_jmm(jmm_tmp);
     vsubps(jmm_src, jmm_tmp, jmm_src);
     exp_jmm<JMM>(dst, jmm_src, src_idx, fx_idx, fy_idx, mask_idx, tmp_idx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
     vaddps(dst, dst, jmm_tmp);
     vdivps(dst, jmm_tmp, dst);
     pop(reg_ptr_global);
   }
 
-  // compute TANH with ymm, xmm
+  // compute TANH with zmm, ymm, xmm
   template <typename JMM>
   void tanh_jmm(JMM& dst, JMM& src, int src_idx = 11,  // NOLINT
                 int fx_idx = 12, int fy_idx = 13, int mask_idx = 14,
@@ -203,26 +235,26 @@ class VActFunc : public JitCode {
     reg64_t reg_ptr_global = rax;
     push(reg_ptr_global);
     vmovaps(jmm_src, src);
-    mov(reg_ptr_global, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
-    vxorps(jmm_zero, jmm_zero, jmm_zero);
+    mov_global(reg_ptr_global, exp_float_consts);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    zero_jmm(jmm_zero);
     vsubps(jmm_tmp, jmm_zero, jmm_tmp);
     vmulps(jmm_src, jmm_src, jmm_tmp);
     exp_jmm<JMM>(dst, jmm_src, src_idx, fx_idx, fy_idx, mask_idx, tmp_idx);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
     vaddps(dst, dst, jmm_tmp);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_TWO]);
     vdivps(dst, jmm_tmp, dst);
-    vmovaps(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
+    load_const_jmm(jmm_tmp, ptr[reg_ptr_global + OFFSET_EXP_ONE]);
     vsubps(dst, dst, jmm_tmp);
     pop(reg_ptr_global);
   }
 
-  // compute IDENTITY with ymm, xmm
+  // compute IDENTITY with zmm, ymm, xmm
   template <typename JMM>
   void identity_jmm(JMM& dst, JMM& src, int zero_idx) {  // NOLINT
     JMM zero = JMM(zero_idx);
-    vxorps(zero, zero, zero);
+    zero_jmm(zero);
     vaddps(dst, src, zero);
     // TODO(TJ): use below
     // dst.setIdx(src.getIdx());
@@ -256,19 +288,31 @@ class VActFunc : public JitCode {
         break;
     }
   }
+
+  // k1 is used as k_tail_mask
+  const Xbyak::Opmask k_exp_mask = k2;
 };
 
 class VActJitCode : public VActFunc {
  public:
   explicit VActJitCode(int d, operand_type type, size_t code_size,
-                       void* code_ptr = nullptr)
-      : VActFunc(code_size, code_ptr), num_(d), type_(type) {
+                       platform::cpu_isa_t isa = platform::avx,
+                       bool bf16 = false, void* code_ptr = nullptr)
+      : VActFunc(code_size, code_ptr),
+        num_(d),
+        type_(type),
+        isa_(isa),
+        bf16_(bf16) {
     if (!(type_ == operand_type::RELU || type_ == operand_type::EXP ||
           type_ == operand_type::SIGMOID || type_ == operand_type::TANH ||
           type_ == operand_type::IDENTITY || type_ == operand_type::SQUARE)) {
       PADDLE_THROW(platform::errors::Unimplemented(
           "Do not support operand type code: %d.", type));
     }
+    PADDLE_ENFORCE_EQ(
+        !bf16_ || isa_ == platform::avx512f, true,
+        platform::errors::InvalidArgument(
+            "The bfloat16 VActJitCode can only be generated with avx512f."));
     this->genCode();
   }
 
@@ -296,28 +340,44 @@ class VActJitCode : public VActFunc {
       default:
         break;
     }
+    if (isa_ == platform::avx512f) {
+      base += "_AVX512";
+    }
+    if (bf16_) {
+      base += "_BF16";
+    }
     return base;
   }
   void genCode() override;
 
  protected:
+  // zmm with masked tail, loads and saves bfloat16 if bf16_
+  void genCodeAVX512();
+
   int num_;
   operand_type type_;
+  platform::cpu_isa_t isa_;
+  bool bf16_;
   reg64_t param1{abi_param1};
   reg64_t param2{abi_param2};
+  reg32_t reg32_tmp{r8d};
 
   xmm_t xmm_src = xmm_t(0);
   ymm_t ymm_src = ymm_t(0);
+  zmm_t zmm_src = zmm_t(0);
 
   xmm_t xmm_dst = xmm_t(1);
   ymm_t ymm_dst = ymm_t(1);
+  zmm_t zmm_dst = zmm_t(1);
 };
 
-#define DECLARE_ACT_JITCODE(name, op_type)                                    \
-  class name##JitCode : public VActJitCode {                                  \
-   public:                                                                    \
-    explicit name##JitCode(int d, size_t code_size, void* code_ptr = nullptr) \
-        : VActJitCode(d, op_type, code_size, code_ptr) {}                     \
+#define DECLARE_ACT_JITCODE(name, op_type)                              \
+  class name##JitCode : public VActJitCode {                            \
+   public:                                                              \
+    explicit name##JitCode(int d, size_t code_size,                     \
+                           platform::cpu_isa_t isa = platform::avx,     \
+                           bool bf16 = false, void* code_ptr = nullptr) \
+        : VActJitCode(d, op_type, code_size, isa, bf16, code_ptr) {}    \
   };
 
 DECLARE_ACT_JITCODE(VRelu, operand_type::RELU);
@@ -25,6 +25,10 @@ namespace gen {
 
 void VXXJitCode::genCode() {
   // do not need push stack, and do not need save avx512reg if do not use avx512
+  if (isa_ == platform::avx512f) {
+    genCodeAVX512();
+    return;
+  }
   int offset = 0;
   if (with_relu_) {
     vxorps(ymm_zero, ymm_zero, ymm_zero);
@@ -111,6 +115,59 @@ void VXXJitCode::genCode() {
   ret();
 }
 
+void VXXJitCode::genCodeAVX512() {
+  if (with_relu_) {
+    vpxord(zmm_zero, zmm_zero, zmm_zero);
+  }
+  if (scalar_index_ == 1) {
+    vbroadcastss(zmm_src1, ptr[param1]);
+  } else if (scalar_index_ == 2) {
+    vbroadcastss(zmm_src2, ptr[param2]);
+  }
+  auto compute = [&](int offset, bool tail) {
+    if (scalar_index_ != 1) {
+      if (tail) {
+        vmovups(zmm_src1 | k_tail_mask | T_z, ptr[param1 + offset]);
+      } else {
+        vmovups(zmm_src1, ptr[param1 + offset]);
+      }
+    }
+    if (scalar_index_ != 2) {
+      if (tail) {
+        vmovups(zmm_src2 | k_tail_mask | T_z, ptr[param2 + offset]);
+      } else {
+        vmovups(zmm_src2, ptr[param2 + offset]);
+      }
+    }
+    if (type_ == operand_type::MUL) {
+      vmulps(zmm_dst, zmm_src1, zmm_src2);
+    } else if (type_ == operand_type::ADD) {
+      vaddps(zmm_dst, zmm_src1, zmm_src2);
+    } else if (type_ == operand_type::SUB) {
+      vsubps(zmm_dst, zmm_src1, zmm_src2);
+    }
+    if (with_relu_) {
+      vmaxps(zmm_dst, zmm_zero, zmm_dst);
+    }
+    if (tail) {
+      vmovups(ptr[param3 + offset] | k_tail_mask, zmm_dst);
+    } else {
+      vmovups(ptr[param3 + offset], zmm_dst);
+    }
+  };
+  int offset = 0;
+  for (int i = 0; i < num_ / ZMM_FLOAT_BLOCK; ++i) {
+    compute(offset, false);
+    offset += sizeof(float) * ZMM_FLOAT_BLOCK;
+  }
+  int rest = num_ % ZMM_FLOAT_BLOCK;
+  if (rest > 0) {
+    set_tail_mask(rest, reg32_tmp);
+    compute(offset, true);
+  }
+  ret();
+}
+
 void NCHW16CMulNCJitCode::genCode() {
   // RDI is ptr x_input
   // RSI is ptr y_input
@@ -176,6 +233,30 @@ DECLARE_BLAS_CREATOR(VAddBias);
 
 #undef DECLARE_BLAS_CREATOR
 
+#define DECLARE_BLAS_AVX512_CREATOR(name)                                    \
+  class name##AVX512Creator : public JitCodeCreator<int> {                   \
+   public:                                                                   \
+    bool CanBeUsed(const int& attr) const override {                         \
+      return platform::MayIUse(platform::avx512f) && attr <= 1024;           \
+    }                                                                        \
+    size_t CodeSize(const int& d) const override {                           \
+      return 96 + (d / ZMM_FLOAT_BLOCK + 1) * 6 * 8;                         \
+    }                                                                        \
+    std::unique_ptr<GenBase> CreateJitCode(const int& attr) const override { \
+      return make_unique<name##JitCode>(attr, CodeSize(attr),                \
+                                        platform::avx512f);                  \
+    }                                                                        \
+  }
+
+DECLARE_BLAS_AVX512_CREATOR(VMul);
+DECLARE_BLAS_AVX512_CREATOR(VAdd);
+DECLARE_BLAS_AVX512_CREATOR(VSub);
+DECLARE_BLAS_AVX512_CREATOR(VAddRelu);
+DECLARE_BLAS_AVX512_CREATOR(VScal);
+DECLARE_BLAS_AVX512_CREATOR(VAddBias);
+
+#undef DECLARE_BLAS_AVX512_CREATOR
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -183,10 +264,13 @@ DECLARE_BLAS_CREATOR(VAddBias);
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kVMul, gen::VMulCreator);
-REGISTER_JITKERNEL_GEN(kVAdd, gen::VAddCreator);
-REGISTER_JITKERNEL_GEN(kVSub, gen::VSubCreator);
-REGISTER_JITKERNEL_GEN(kVAddRelu, gen::VAddReluCreator);
-REGISTER_JITKERNEL_GEN(kVScal, gen::VScalCreator);
-REGISTER_JITKERNEL_GEN(kVAddBias, gen::VAddBiasCreator);
+// AVX512 creators are in front, so they are chosen first if available
+REGISTER_JITKERNEL_GEN(kVMul, gen::VMulAVX512Creator, gen::VMulCreator);
+REGISTER_JITKERNEL_GEN(kVAdd, gen::VAddAVX512Creator, gen::VAddCreator);
+REGISTER_JITKERNEL_GEN(kVSub, gen::VSubAVX512Creator, gen::VSubCreator);
+REGISTER_JITKERNEL_GEN(kVAddRelu, gen::VAddReluAVX512Creator,
+                       gen::VAddReluCreator);
+REGISTER_JITKERNEL_GEN(kVScal, gen::VScalAVX512Creator, gen::VScalCreator);
+REGISTER_JITKERNEL_GEN(kVAddBias, gen::VAddBiasAVX512Creator,
+                       gen::VAddBiasCreator);
 REGISTER_JITKERNEL_GEN(kNCHW16CMulNC, gen::NCHW16CMulNCCreator);
@@ -30,12 +30,14 @@ class VXXJitCode : public JitCode {
  public:
   explicit VXXJitCode(int d, operand_type type, int scalar_index,
                       bool with_relu, size_t code_size = 256 * 1024,
+                      platform::cpu_isa_t isa = platform::avx,
                       void* code_ptr = nullptr)
       : JitCode(code_size, code_ptr),
         num_(d),
         type_(type),
         scalar_index_(scalar_index),
-        with_relu_(with_relu) {
+        with_relu_(with_relu),
+        isa_(isa) {
     if (!(type_ == operand_type::MUL || type_ == operand_type::ADD ||
           type_ == operand_type::SUB)) {
       PADDLE_THROW(platform::errors::Unimplemented(
@@ -64,19 +66,25 @@ class VXXJitCode : public JitCode {
       base += "_Vec";
     }
     base += (with_relu_ ? "_Relu" : "");
+    base += (isa_ == platform::avx512f ? "_AVX512" : "");
     base += "_D" + std::to_string(num_);
     return base;
   }
   void genCode() override;
 
  private:
+  // zmm with masked tail
+  void genCodeAVX512();
+
   int num_;
   operand_type type_;
   int scalar_index_;
   bool with_relu_;
+  platform::cpu_isa_t isa_;
   reg64_t param1{abi_param1};
   reg64_t param2{abi_param2};
   reg64_t param3{abi_param3};
+  reg32_t reg32_tmp{r8d};
 
   xmm_t xmm_src1 = xmm_t(0);
   xmm_t xmm_src2 = xmm_t(1);
@@ -87,14 +95,21 @@ class VXXJitCode : public JitCode {
   ymm_t ymm_src2 = ymm_t(1);
   ymm_t ymm_dst = ymm_t(2);
   ymm_t ymm_zero = ymm_t(3);
+
+  zmm_t zmm_src1 = zmm_t(0);
+  zmm_t zmm_src2 = zmm_t(1);
+  zmm_t zmm_dst = zmm_t(2);
+  zmm_t zmm_zero = zmm_t(3);
 };
 
-#define DECLARE_BLAS_JITCODE(name, op_type, scalar_idx, with_relu)             \
-  class name##JitCode : public VXXJitCode {                                    \
-   public:                                                                     \
-    explicit name##JitCode(int d, size_t code_size, void* code_ptr = nullptr)  \
-        : VXXJitCode(d, op_type, scalar_idx, with_relu, code_size, code_ptr) { \
-    }                                                                          \
+#define DECLARE_BLAS_JITCODE(name, op_type, scalar_idx, with_relu)      \
+  class name##JitCode : public VXXJitCode {                             \
+   public:                                                              \
+    explicit name##JitCode(int d, size_t code_size,                     \
+                           platform::cpu_isa_t isa = platform::avx,     \
+                           void* code_ptr = nullptr)                    \
+        : VXXJitCode(d, op_type, scalar_idx, with_relu, code_size, isa, \
+                     code_ptr) {}                                       \
   };
 
 DECLARE_BLAS_JITCODE(VMul, operand_type::MUL, 0, false);
@@ -27,8 +27,10 @@ namespace gen {
 
 void EmbSeqPoolJitCode::genCode() {
   preCode();
-  constexpr int block = YMM_FLOAT_BLOCK;
-  constexpr int max_num_regs = 8;
+  // zmm has 32 registers, half for the sum and half for the loads
+  const bool use_zmm = isa_ == platform::avx512f;
+  const int block = use_zmm ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+  const int max_num_regs = use_zmm ? 16 : 8;
   const int num_block = tbl_w_ / block;
   const int num_groups = num_block / max_num_regs;
   const size_t block_size = sizeof(float) * block;
@@ -67,7 +69,7 @@ void EmbSeqPoolJitCode::genCode() {
       add(reg_ptr_tbl_i, param_tbl);  // reg is ptr_i now
       size_t w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ymm_t(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
+        vmovups(jmm(reg_i + num_regs), ptr[reg_ptr_tbl_i + w_offset]);
         w_offset += block_size;
       }
       add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -92,9 +94,8 @@ void EmbSeqPoolJitCode::genCode() {
         add(reg_ptr_tbl_i, param_tbl);
         size_t w_offset = 0;
         for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-          vmovups(ymm_t(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
-          vaddps(ymm_t(reg_i + num_regs), ymm_t(reg_i + num_regs),
-                 ymm_t(reg_i));
+          vmovups(jmm(reg_i), ptr[reg_ptr_tbl_i + w_offset]);
+          vaddps(jmm(reg_i + num_regs), jmm(reg_i + num_regs), jmm(reg_i));
           w_offset += block_size;
         }
         add(reg_ptr_idx_i, reg_idx_width_in_byte);
@@ -105,7 +106,7 @@ void EmbSeqPoolJitCode::genCode() {
       // avg or sqrt here, if needed
       w_offset = 0;
       for (int reg_i = 0; reg_i < num_regs; ++reg_i) {
-        vmovups(ptr[reg_ptr_dst_i + w_offset], ymm_t(reg_i + num_regs));
+        vmovups(ptr[reg_ptr_dst_i + w_offset], jmm(reg_i + num_regs));
         w_offset += block_size;
       }
       add(reg_ptr_dst_i, tbl_width_in_byte);
@@ -120,14 +121,15 @@ void EmbSeqPoolJitCode::genCode() {
   postCode();
 }
 
-class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
+// isa is avx or avx512f
+template <platform::cpu_isa_t isa>
+class EmbSeqPoolCreatorImpl : public JitCodeCreator<emb_seq_pool_attr_t> {
  public:
   bool CanBeUsed(const emb_seq_pool_attr_t& attr) const override {
-    return platform::MayIUse(platform::avx) &&
-           attr.table_width % YMM_FLOAT_BLOCK == 0;
+    return platform::MayIUse(isa) && attr.table_width % Block() == 0;
   }
   size_t CodeSize(const emb_seq_pool_attr_t& attr) const override {
-    return 96 + (attr.table_width / YMM_FLOAT_BLOCK) * 96 * 8;
+    return 96 + (attr.table_width / Block()) * 96 * 8;
   }
   std::unique_ptr<GenBase> CreateJitCode(
       const emb_seq_pool_attr_t& attr) const override {
@@ -156,10 +158,18 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
                           "The attribute out_width of EmbSeqPool should be "
                           "larger than 0. But it is %d.",
                           attr.out_width));
-    return make_unique<EmbSeqPoolJitCode>(attr, CodeSize(attr));
+    return make_unique<EmbSeqPoolJitCode>(attr, CodeSize(attr), isa);
+  }
+
+ private:
+  static int Block() {
+    return isa == platform::avx512f ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
   }
 };
 
+using EmbSeqPoolCreator = EmbSeqPoolCreatorImpl<platform::avx>;
+using EmbSeqPoolAVX512Creator = EmbSeqPoolCreatorImpl<platform::avx512f>;
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -167,4 +177,5 @@ class EmbSeqPoolCreator : public JitCodeCreator<emb_seq_pool_attr_t> {
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kEmbSeqPool, gen::EmbSeqPoolCreator);
+REGISTER_JITKERNEL_GEN(kEmbSeqPool, gen::EmbSeqPoolAVX512Creator,
+                       gen::EmbSeqPoolCreator);
@@ -29,10 +29,12 @@ class EmbSeqPoolJitCode : public JitCode {
  public:
   explicit EmbSeqPoolJitCode(const emb_seq_pool_attr_t& attr,
                              size_t code_size = 256 * 1024,
+                             platform::cpu_isa_t isa = platform::avx,
                              void* code_ptr = nullptr)
       : JitCode(code_size, code_ptr),
         tbl_w_(attr.table_width),
-        type_(attr.pool_type) {
+        type_(attr.pool_type),
+        isa_(isa) {
     if (type_ != SeqPoolType::kSum) {
       PADDLE_THROW(
           platform::errors::Unimplemented("Only supports sum pool yet."));
@@ -50,13 +52,25 @@ class EmbSeqPoolJitCode : public JitCode {
       base += "_Sqrt";
     }
     base += ("_W" + std::to_string(tbl_w_));
+    if (isa_ == platform::avx512f) {
+      base += "_AVX512";
+    }
     return base;
   }
   void genCode() override;
 
  private:
+  // zmm or ymm by the isa
+  Xbyak::Xmm jmm(int idx) const {
+    if (isa_ == platform::avx512f) {
+      return zmm_t(idx);
+    }
+    return ymm_t(idx);
+  }
+
   int tbl_w_;
   SeqPoolType type_;
+  platform::cpu_isa_t isa_;
   reg64_t param_tbl{abi_param1};
   reg64_t param_idx{abi_param2};
   reg64_t param_dst{abi_param3};
@@ -25,61 +25,73 @@ namespace operators {
 namespace jit {
 namespace gen {
 
+template <typename JMM>
+void GRUJitCode::genBlock(int offset) {
+  int d = num_ * sizeof(float);
+  JMM jmm_u = JMM(1);
+  JMM jmm_r = JMM(2);
+  JMM jmm_s = JMM(3);
+  JMM jmm_ht_1 = JMM(4);
+  // W: {W_update, W_reset; W_state}
+  if (id_ == 0 || id_ == 2) {
+    vmovups(jmm_u, ptr[reg_ptr_gates + offset]);
+    vmovups(jmm_s, ptr[reg_ptr_gates + offset + 2 * d]);
+  }
+  if (id_ == 1) {
+    vmovups(jmm_r, ptr[reg_ptr_gates + offset + d]);
+  }
+  if (id_ == 1 || id_ == 2) {
+    vmovups(jmm_ht_1, ptr[reg_ptr_ht_1 + offset]);
+  }
+
+  if (id_ == 0) {
+    // ht = act_gate(u) * act_cand(s)
+    act<JMM>(jmm_u, jmm_u, act_gate_);
+    act<JMM>(jmm_s, jmm_s, act_cand_);
+    vmulps(jmm_s, jmm_s, jmm_u);
+    vmovups(ptr[reg_ptr_ht + offset], jmm_s);
+  } else if (id_ == 1) {
+    // ht = act_gate(r) * ht_1
+    act<JMM>(jmm_r, jmm_r, act_gate_);
+    vmulps(jmm_r, jmm_r, jmm_ht_1);
+    vmovups(ptr[reg_ptr_ht + offset], jmm_r);
+  } else if (id_ == 2) {
+    // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
+    JMM jmm_one = JMM(one_idx_);
+    act<JMM>(jmm_u, jmm_u, act_gate_);
+    act<JMM>(jmm_s, jmm_s, act_cand_);
+    vmulps(jmm_s, jmm_s, jmm_u);
+    vsubps(jmm_u, jmm_one, jmm_u);
+    vmulps(jmm_u, jmm_ht_1, jmm_u);
+    vaddps(jmm_u, jmm_s, jmm_u);
+    vmovups(ptr[reg_ptr_ht + offset], jmm_u);
+  }
+}
+
 void GRUJitCode::genCode() {
-  reg64_t reg_ptr_gates = rax;
-  reg64_t reg_ptr_ht_1 = r9;
-  reg64_t reg_ptr_ht = r10;
   mov(reg_ptr_gates, ptr[param1 + offsetof(gru_t, gates)]);
   mov(reg_ptr_ht_1, ptr[param1 + offsetof(gru_t, ht_1)]);
   mov(reg_ptr_ht, ptr[param1 + offsetof(gru_t, ht)]);
-  ymm_t ymm_one = ymm_t(0);
 
   if (id_ == 2) {
     reg64_t reg_ptr_tmp = r11;
-    mov(reg_ptr_tmp, reinterpret_cast<size_t>(exp_float_consts));
-    vmovaps(ymm_one, ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    mov_global(reg_ptr_tmp, exp_float_consts);
+    if (isa_ == platform::avx512f) {
+      load_const_jmm(zmm_t(one_idx_), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    } else {
+      load_const_jmm(ymm_t(one_idx_), ptr[reg_ptr_tmp + OFFSET_EXP_ONE]);
+    }
   }
   int offset = 0;
-  int d = num_ * sizeof(float);
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
-    ymm_t ymm_u = ymm_t(1);
-    ymm_t ymm_r = ymm_t(2);
-    ymm_t ymm_s = ymm_t(3);
-    ymm_t ymm_ht_1 = ymm_t(4);
-    // W: {W_update, W_reset; W_state}
-    if (id_ == 0 || id_ == 2) {
-      vmovups(ymm_u, ptr[reg_ptr_gates + offset]);
-      vmovups(ymm_s, ptr[reg_ptr_gates + offset + 2 * d]);
-    }
-    if (id_ == 1) {
-      vmovups(ymm_r, ptr[reg_ptr_gates + offset + d]);
-    }
-    if (id_ == 1 || id_ == 2) {
-      vmovups(ymm_ht_1, ptr[reg_ptr_ht_1 + offset]);
-    }
-
-    if (id_ == 0) {
-      // ht = act_gate(u) * act_cand(s)
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_s);
-    } else if (id_ == 1) {
-      // ht = act_gate(r) * ht_1
-      act<ymm_t>(ymm_r, ymm_r, act_gate_);
-      vmulps(ymm_r, ymm_r, ymm_ht_1);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_r);
-    } else if (id_ == 2) {
-      // ht = act_gate(u) * act_cand(s) + (1-act_gate(u)) * ht_1
-      ymm_t ymm_one_inner = ymm_t(ymm_one.getIdx());
-      act<ymm_t>(ymm_u, ymm_u, act_gate_);
-      act<ymm_t>(ymm_s, ymm_s, act_cand_);
-      vmulps(ymm_s, ymm_s, ymm_u);
-      vsubps(ymm_u, ymm_one_inner, ymm_u);
-      vmulps(ymm_u, ymm_ht_1, ymm_u);
-      vaddps(ymm_u, ymm_s, ymm_u);
-      vmovups(ptr[reg_ptr_ht + offset], ymm_u);
+  int i = 0;
+  if (isa_ == platform::avx512f) {
+    for (; i + ZMM_FLOAT_BLOCK <= num_; i += ZMM_FLOAT_BLOCK) {
+      genBlock<zmm_t>(offset);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
     }
+  }
+  for (; i + YMM_FLOAT_BLOCK <= num_; i += YMM_FLOAT_BLOCK) {
+    genBlock<ymm_t>(offset);
     offset += sizeof(float) * YMM_FLOAT_BLOCK;
   }
   ret();
@@ -107,6 +119,29 @@ DECLARE_GRU_CREATOR(GRUHtPart2);
 
 #undef DECLARE_GRU_CREATOR
 
+// use zmm as much as possible and ymm for the rest
+#define DECLARE_GRU_AVX512_CREATOR(name)                              \
+  class name##AVX512Creator : public JitCodeCreator<gru_attr_t> {     \
+   public:                                                            \
+    bool CanBeUsed(const gru_attr_t& attr) const override {           \
+      return platform::MayIUse(platform::avx512f) && attr.d % 8 == 0; \
+    }                                                                 \
+    size_t CodeSize(const gru_attr_t& attr) const override {          \
+      return 96 + (attr.d / ZMM_FLOAT_BLOCK + 1) * 96 * 2 * 8;        \
+    }                                                                 \
+    std::unique_ptr<GenBase> CreateJitCode(                           \
+        const gru_attr_t& attr) const override {                      \
+      return make_unique<name##JitCode>(attr, CodeSize(attr),         \
+                                        platform::avx512f);           \
+    }                                                                 \
+  }
+
+DECLARE_GRU_AVX512_CREATOR(GRUH1);
+DECLARE_GRU_AVX512_CREATOR(GRUHtPart1);
+DECLARE_GRU_AVX512_CREATOR(GRUHtPart2);
+
+#undef DECLARE_GRU_AVX512_CREATOR
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -114,6 +149,8 @@ DECLARE_GRU_CREATOR(GRUHtPart2);
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kGRUH1, gen::GRUH1Creator);
-REGISTER_JITKERNEL_GEN(kGRUHtPart1, gen::GRUHtPart1Creator);
-REGISTER_JITKERNEL_GEN(kGRUHtPart2, gen::GRUHtPart2Creator);
+REGISTER_JITKERNEL_GEN(kGRUH1, gen::GRUH1AVX512Creator, gen::GRUH1Creator);
+REGISTER_JITKERNEL_GEN(kGRUHtPart1, gen::GRUHtPart1AVX512Creator,
+                       gen::GRUHtPart1Creator);
+REGISTER_JITKERNEL_GEN(kGRUHtPart2, gen::GRUHtPart2AVX512Creator,
+                       gen::GRUHtPart2Creator);
@@ -28,8 +28,9 @@ namespace gen {
 class GRUJitCode : public VActFunc {
  public:
   explicit GRUJitCode(int id, const gru_attr_t& attr, size_t code_size,
+                      platform::cpu_isa_t isa = platform::avx,
                       void* code_ptr = nullptr)
-      : VActFunc(code_size, code_ptr), id_(id), num_(attr.d) {
+      : VActFunc(code_size, code_ptr), id_(id), num_(attr.d), isa_(isa) {
     auto typeExchange = [](KernelType type) -> gen::operand_type {
       if (type == KernelType::kVSigmoid) {
         return operand_type::SIGMOID;
@@ -83,24 +84,38 @@ class GRUJitCode : public VActFunc {
     };
     AddTypeStr(act_gate_);
     AddTypeStr(act_cand_);
+    if (isa_ == platform::avx512f) {
+      base += "_AVX512";
+    }
     return base;
   }
   void genCode() override;
 
  protected:
+  // compute one block of d at offset, with zmm or ymm
+  template <typename JMM>
+  void genBlock(int offset);
+
   int id_;
   int num_;
+  platform::cpu_isa_t isa_;
   operand_type act_gate_;
   operand_type act_cand_;
   reg64_t param1{abi_param1};
+  reg64_t reg_ptr_gates{rax};
+  reg64_t reg_ptr_ht_1{r9};
+  reg64_t reg_ptr_ht{r10};
+  // keep ones in it when id_ == 2
+  int one_idx_{0};
 };
 
 #define DECLARE_GRU_JITCODE(name, id)                                \
   class name##JitCode : public GRUJitCode {                          \
    public:                                                           \
     explicit name##JitCode(const gru_attr_t& attr, size_t code_size, \
+                           platform::cpu_isa_t isa = platform::avx,  \
                            void* code_ptr = nullptr)                 \
-        : GRUJitCode(id, attr, code_size, code_ptr) {}               \
+        : GRUJitCode(id, attr, code_size, isa, code_ptr) {}          \
   };
 
 DECLARE_GRU_JITCODE(GRUH1, 0);
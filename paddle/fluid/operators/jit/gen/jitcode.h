@@ -16,7 +16,9 @@
 
 #include <string>
 #include <type_traits>
+#include <vector>
 #include "paddle/fluid/operators/jit/gen_base.h"
+#include "paddle/fluid/operators/jit/jitcode_cache.h"
 #include "paddle/fluid/platform/cpu_info.h"
 
 #define XBYAK_USE_MMAP_ALLOCATOR
@@ -77,12 +79,31 @@ class JitCode : public GenBase, public Xbyak::CodeGenerator {
     const Xbyak::uint8* code = CodeGenerator::getCode();
     return code;
   }
+  bool relocatable() const override { return relocatable_; }
+  std::vector<JitCodeReloc> relocations() const override { return relocs_; }
 
  protected:
   Xbyak::Reg64 param1{abi_param1};
   const int EVEX_max_8b_offt = 0x200;
   const Xbyak::Reg64 reg_EVEX_max_8b_offt = rbp;
 
+  // Load the address of global data, which should always be used instead of
+  // mov with the raw address. The registered symbols are recorded as
+  // relocations, others make the code can not be saved to disk cache.
+  void mov_global(const Xbyak::Reg64& reg, const void* addr) {
+    // always encode as movabs reg, imm64 to make the slot 8 bytes
+    db(0x48 | (reg.getIdx() >= 8 ? 0x01 : 0x00));
+    db(0xB8 | (reg.getIdx() & 0x07));
+    const size_t offset = CodeGenerator::getSize();
+    dq(reinterpret_cast<uint64_t>(addr));
+    std::string symbol = GetJitCodeSymbolName(addr);
+    if (symbol.empty()) {
+      relocatable_ = false;
+    } else {
+      relocs_.push_back({offset, symbol});
+    }
+  }
+
   virtual void preCode() {
     for (int i = 0; i < num_g_abi_regs; ++i) {
       push(Xbyak::Reg64(g_abi_regs[i]));
@@ -97,6 +118,42 @@ class JitCode : public GenBase, public Xbyak::CodeGenerator {
     }
     ret();
   }
+  // mask of the rest elements which are less than one zmm
+  const Xbyak::Opmask k_tail_mask = k1;
+  void set_tail_mask(int rest, const Xbyak::Reg32& reg_tmp) {
+    mov(reg_tmp, (1 << rest) - 1);
+    kmovw(k_tail_mask, reg_tmp);
+  }
+  // bfloat16 is the upper 16 bits of float, so load by zero extending and
+  // shifting left, and save by truncating, or by rounding with avx512_bf16.
+  void load_bf16(const Xbyak::Zmm& dst, const Xbyak::Address& src,
+                 bool tail = false) {
+    if (tail) {
+      vpmovzxwd(dst | k_tail_mask | T_z, src);
+    } else {
+      vpmovzxwd(dst, src);
+    }
+    vpslld(dst, dst, 16);
+  }
+  void store_bf16(const Xbyak::Address& dst, const Xbyak::Zmm& src,
+                  bool tail = false) {
+    if (platform::MayIUse(platform::avx512_bf16)) {
+      Xbyak::Ymm ymm_src(src.getIdx());
+      vcvtneps2bf16(ymm_src, src);
+      if (tail) {
+        vmovdqu16(dst | k_tail_mask, ymm_src);
+      } else {
+        vmovdqu16(dst, ymm_src);
+      }
+    } else {
+      vpsrld(src, src, 16);
+      if (tail) {
+        vpmovdw(dst | k_tail_mask, src);
+      } else {
+        vpmovdw(dst, src);
+      }
+    }
+  }
   void L(const char* label) { Xbyak::CodeGenerator::L(label); }
   void L(Xbyak::Label& label) { Xbyak::CodeGenerator::L(label); }  // NOLINT
   // Enhanced vector extension
@@ -121,6 +178,10 @@ class JitCode : public GenBase, public Xbyak::CodeGenerator {
       return zword[re];
     }
   }
+
+ private:
+  bool relocatable_{true};
+  std::vector<JitCodeReloc> relocs_;
 };
 
 }  // namespace gen
@@ -25,15 +25,73 @@ namespace operators {
 namespace jit {
 namespace gen {
 
+template <typename JMM>
+void LSTMJitCode::genBlock(int offset) {
+  int d = num_ * sizeof(float);
+  /* gates: W_ch, W_ih, W_fh, W_oh */
+  JMM jmm_c = JMM(0);
+  JMM jmm_i = JMM(1);
+  JMM jmm_f = JMM(2);
+  JMM jmm_o = JMM(3);
+  JMM jmm_ct_1 = JMM(4);
+  JMM jmm_wp0 = JMM(5);
+  JMM jmm_wp1 = JMM(6);
+  JMM jmm_wp2 = JMM(7);
+  vmovups(jmm_c, ptr[reg_ptr_gates + offset]);
+  vmovups(jmm_i, ptr[reg_ptr_gates + offset + d]);
+  vmovups(jmm_f, ptr[reg_ptr_gates + offset + 2 * d]);
+  vmovups(jmm_o, ptr[reg_ptr_gates + offset + 3 * d]);
+  if (!compute_c1h1_) {
+    vmovups(jmm_ct_1, ptr[reg_ptr_ct_1 + offset]);
+  }
+  if (use_peephole_) {
+    vmovups(jmm_wp0, ptr[reg_ptr_wp + offset]);
+    vmovups(jmm_wp1, ptr[reg_ptr_wp + offset + d]);
+    vmovups(jmm_wp2, ptr[reg_ptr_wp + offset + 2 * d]);
+  }
+  /* C_t = act_cand(c) * act_gate(i) + C_t-1 * act_gate(f) */
+  // act_cand(c)
+  act<JMM>(jmm_c, jmm_c, act_cand_);
+  // act_gate(i) or act_gate(ct_1 * wp0 + i)
+  if (!compute_c1h1_ && use_peephole_) {
+    vmulps(jmm_wp0, jmm_ct_1, jmm_wp0);
+    vaddps(jmm_i, jmm_i, jmm_wp0);
+  }
+  act<JMM>(jmm_i, jmm_i, act_gate_);
+  vmulps(jmm_c, jmm_c, jmm_i);
+  if (!compute_c1h1_) {
+    // act_gate(f) or act_gate(ct_1 * wp1 + f)
+    if (use_peephole_) {
+      vmulps(jmm_wp1, jmm_ct_1, jmm_wp1);
+      vaddps(jmm_f, jmm_f, jmm_wp1);
+    }
+    act<JMM>(jmm_f, jmm_f, act_gate_);
+    // ct
+    vmulps(jmm_f, jmm_f, jmm_ct_1);
+    vaddps(jmm_f, jmm_f, jmm_c);
+  }
+  /* H_t = act_cell(C_t) * act_gate(o) */
+  // act_cell(C_t)
+  JMM jmm_ct = compute_c1h1_ ? jmm_c : jmm_f;
+  JMM jmm_tmp = jmm_i;
+  act<JMM>(jmm_tmp, jmm_ct, act_cell_);
+  // act_gate(o) or act_gate(ct * wp2 + o)
+  if (use_peephole_) {
+    vmulps(jmm_wp2, jmm_ct, jmm_wp2);
+    vaddps(jmm_o, jmm_o, jmm_wp2);
+  }
+  act<JMM>(jmm_o, jmm_o, act_gate_);
+  // ht
+  vmulps(jmm_o, jmm_o, jmm_tmp);
+  // save ct and ht
+  vmovups(ptr[reg_ptr_ct + offset], jmm_ct);
+  vmovups(ptr[reg_ptr_ht + offset], jmm_o);
+}
+
 void LSTMJitCode::genCode() {
   if (use_peephole_) {
     preCode();
   }
-  reg64_t reg_ptr_gates = rax;
-  reg64_t reg_ptr_ct_1 = r9;
-  reg64_t reg_ptr_ct = r10;
-  reg64_t reg_ptr_ht = r11;
-  reg64_t reg_ptr_wp = r12;
   mov(reg_ptr_gates, ptr[param1 + offsetof(lstm_t, gates)]);
   mov(reg_ptr_ct_1, ptr[param1 + offsetof(lstm_t, ct_1)]);
   mov(reg_ptr_ct, ptr[param1 + offsetof(lstm_t, ct)]);
@@ -43,66 +101,15 @@ void LSTMJitCode::genCode() {
   }
 
   int offset = 0;
-  int d = num_ * sizeof(float);
-  for (int i = 0; i < num_ / YMM_FLOAT_BLOCK; ++i) {
-    /* gates: W_ch, W_ih, W_fh, W_oh */
-    ymm_t ymm_c = ymm_t(0);
-    ymm_t ymm_i = ymm_t(1);
-    ymm_t ymm_f = ymm_t(2);
-    ymm_t ymm_o = ymm_t(3);
-    ymm_t ymm_ct_1 = ymm_t(4);
-    ymm_t ymm_wp0 = ymm_t(5);
-    ymm_t ymm_wp1 = ymm_t(6);
-    ymm_t ymm_wp2 = ymm_t(7);
-    vmovups(ymm_c, ptr[reg_ptr_gates + offset]);
-    vmovups(ymm_i, ptr[reg_ptr_gates + offset + d]);
-    vmovups(ymm_f, ptr[reg_ptr_gates + offset + 2 * d]);
-    vmovups(ymm_o, ptr[reg_ptr_gates + offset + 3 * d]);
-    if (!compute_c1h1_) {
-      vmovups(ymm_ct_1, ptr[reg_ptr_ct_1 + offset]);
-    }
-    if (use_peephole_) {
-      vmovups(ymm_wp0, ptr[reg_ptr_wp + offset]);
-      vmovups(ymm_wp1, ptr[reg_ptr_wp + offset + d]);
-      vmovups(ymm_wp2, ptr[reg_ptr_wp + offset + 2 * d]);
-    }
-    /* C_t = act_cand(c) * act_gate(i) + C_t-1 * act_gate(f) */
-    // act_cand(c)
-    act<ymm_t>(ymm_c, ymm_c, act_cand_);
-    // act_gate(i) or act_gate(ct_1 * wp0 + i)
-    if (!compute_c1h1_ && use_peephole_) {
-      vmulps(ymm_wp0, ymm_ct_1, ymm_wp0);
-      vaddps(ymm_i, ymm_i, ymm_wp0);
-    }
-    act<ymm_t>(ymm_i, ymm_i, act_gate_);
-    vmulps(ymm_c, ymm_c, ymm_i);
-    if (!compute_c1h1_) {
-      // act_gate(f) or act_gate(ct_1 * wp1 + f)
-      if (use_peephole_) {
-        vmulps(ymm_wp1, ymm_ct_1, ymm_wp1);
-        vaddps(ymm_f, ymm_f, ymm_wp1);
-      }
-      act<ymm_t>(ymm_f, ymm_f, act_gate_);
-      // ct
-      vmulps(ymm_f, ymm_f, ymm_ct_1);
-      vaddps(ymm_f, ymm_f, ymm_c);
-    }
-    /* H_t = act_cell(C_t) * act_gate(o) */
-    // act_cell(C_t)
-    ymm_t ymm_ct = compute_c1h1_ ? ymm_c : ymm_f;
-    ymm_t ymm_tmp = ymm_i;
-    act<ymm_t>(ymm_tmp, ymm_ct, act_cell_);
-    // act_gate(o) or act_gate(ct * wp2 + o)
-    if (use_peephole_) {
-      vmulps(ymm_wp2, ymm_ct, ymm_wp2);
-      vaddps(ymm_o, ymm_o, ymm_wp2);
+  int i = 0;
+  if (isa_ == platform::avx512f) {
+    for (; i + ZMM_FLOAT_BLOCK <= num_; i += ZMM_FLOAT_BLOCK) {
+      genBlock<zmm_t>(offset);
+      offset += sizeof(float) * ZMM_FLOAT_BLOCK;
     }
-    act<ymm_t>(ymm_o, ymm_o, act_gate_);
-    // ht
-    vmulps(ymm_o, ymm_o, ymm_tmp);
-    // save ct and ht
-    vmovups(ptr[reg_ptr_ct + offset], ymm_ct);
-    vmovups(ptr[reg_ptr_ht + offset], ymm_o);
+  }
+  for (; i + YMM_FLOAT_BLOCK <= num_; i += YMM_FLOAT_BLOCK) {
+    genBlock<ymm_t>(offset);
     offset += sizeof(float) * YMM_FLOAT_BLOCK;
   }
 
@@ -134,6 +141,28 @@ DECLARE_LSTM_CREATOR(LSTMC1H1);
 
 #undef DECLARE_LSTM_CREATOR
 
+// use zmm as much as possible and ymm for the rest
+#define DECLARE_LSTM_AVX512_CREATOR(name)                             \
+  class name##AVX512Creator : public JitCodeCreator<lstm_attr_t> {    \
+   public:                                                            \
+    bool CanBeUsed(const lstm_attr_t& attr) const override {          \
+      return platform::MayIUse(platform::avx512f) && attr.d % 8 == 0; \
+    }                                                                 \
+    size_t CodeSize(const lstm_attr_t& attr) const override {         \
+      return 96 + (attr.d / ZMM_FLOAT_BLOCK + 1) * 90 * 4 * 8;        \
+    }                                                                 \
+    std::unique_ptr<GenBase> CreateJitCode(                           \
+        const lstm_attr_t& attr) const override {                     \
+      return make_unique<name##JitCode>(attr, CodeSize(attr),         \
+                                        platform::avx512f);           \
+    }                                                                 \
+  }
+
+DECLARE_LSTM_AVX512_CREATOR(LSTMCtHt);
+DECLARE_LSTM_AVX512_CREATOR(LSTMC1H1);
+
+#undef DECLARE_LSTM_AVX512_CREATOR
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -141,5 +170,7 @@ DECLARE_LSTM_CREATOR(LSTMC1H1);
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kLSTMCtHt, gen::LSTMCtHtCreator);
-REGISTER_JITKERNEL_GEN(kLSTMC1H1, gen::LSTMC1H1Creator);
+REGISTER_JITKERNEL_GEN(kLSTMCtHt, gen::LSTMCtHtAVX512Creator,
+                       gen::LSTMCtHtCreator);
+REGISTER_JITKERNEL_GEN(kLSTMC1H1, gen::LSTMC1H1AVX512Creator,
+                       gen::LSTMC1H1Creator);
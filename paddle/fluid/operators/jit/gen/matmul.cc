@@ -15,6 +15,7 @@
 #include "paddle/fluid/operators/jit/gen/matmul.h"
 
 #include <stddef.h>  // offsetof
+#include <algorithm>
 
 #include "paddle/fluid/operators/jit/registry.h"
 #include "paddle/fluid/platform/cpu_info.h"
@@ -106,6 +107,112 @@ void MatMulJitCode::genCode() {
   postCode();
 }
 
+void BatchedMatMulJitCode::genBlock(int rows, int cols, int n_offset) {
+  // registers: rows * cols accumulators, cols of B, one broadcast of A and
+  // one temporary when FMA is not available
+  const int w_reg_idx = rows * cols;
+  const int x_reg_idx = w_reg_idx + cols;
+  const int tmp_reg_idx = x_reg_idx + 1;
+  const int block_len = sizeof(float) * YMM_FLOAT_BLOCK;
+  for (int i = 0; i < rows * cols; ++i) {
+    vxorps(ymm_t(i), ymm_t(i), ymm_t(i));
+  }
+  mov(reg_ptr_a, reg_ptr_a_row);
+  mov(reg_ptr_b, param_b);
+  mov(reg_k, k_);
+  Label l_next_k;
+  L(l_next_k);
+  {
+    for (int j = 0; j < cols; ++j) {
+      vmovups(ymm_t(w_reg_idx + j), ptr[reg_ptr_b + n_offset + j * block_len]);
+    }
+    for (int i = 0; i < rows; ++i) {
+      vbroadcastss(ymm_t(x_reg_idx), ptr[reg_ptr_a + i * k_ * sizeof(float)]);
+      for (int j = 0; j < cols; ++j) {
+        const int acc = i * cols + j;
+        if (use_fma_) {
+          vfmadd231ps(ymm_t(acc), ymm_t(w_reg_idx + j), ymm_t(x_reg_idx));
+        } else {
+          vmulps(ymm_t(tmp_reg_idx), ymm_t(w_reg_idx + j), ymm_t(x_reg_idx));
+          vaddps(ymm_t(acc), ymm_t(acc), ymm_t(tmp_reg_idx));
+        }
+      }
+    }
+    add(reg_ptr_a, sizeof(float));
+    add(reg_ptr_b, n_ * sizeof(float));
+    dec(reg_k);
+    jnz(l_next_k, T_NEAR);
+  }
+  if (act_ == kVRelu) {
+    vxorps(ymm_t(x_reg_idx), ymm_t(x_reg_idx), ymm_t(x_reg_idx));
+  }
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < cols; ++j) {
+      const int acc = i * cols + j;
+      const int offset = n_offset + j * block_len;
+      if (with_bias_) {
+        vaddps(ymm_t(acc), ymm_t(acc), ptr[param_bias + offset]);
+      }
+      if (act_ == kVRelu) {
+        vmaxps(ymm_t(acc), ymm_t(acc), ymm_t(x_reg_idx));
+      }
+      vmovups(ptr[reg_ptr_c_row + i * n_ * sizeof(float) + offset],
+              ymm_t(acc));
+    }
+  }
+}
+
+void BatchedMatMulJitCode::genCode() {
+  preCode();
+  constexpr int max_cols = 4;
+  constexpr int max_rows = 6;
+  const int num_block = n_ / YMM_FLOAT_BLOCK;
+  const int num_regs = 16 - (use_fma_ ? 1 : 2);
+  const int block_len = sizeof(float) * YMM_FLOAT_BLOCK;
+
+  Label l_next_batch, l_done;
+  mov(reg_batch.cvt32(), dword[param_attr]);
+  cmp(reg_batch, 0);
+  jle(l_done, T_NEAR);
+  L(l_next_batch);
+  {
+    // go through the columns of C in groups, so that the panel of B stays
+    // in cache while all rows of A are computed
+    for (int col = 0; col < num_block; col += max_cols) {
+      const int cols = std::min(max_cols, num_block - col);
+      const int rows = std::min(max_rows, (num_regs - cols) / cols);
+      const int n_offset = col * block_len;
+      mov(reg_ptr_a_row, param_a);
+      mov(reg_ptr_c_row, param_c);
+      if (m_ / rows > 0) {
+        Label l_next_rows;
+        mov(reg_m, m_ / rows);
+        L(l_next_rows);
+        {
+          genBlock(rows, cols, n_offset);
+          add(reg_ptr_a_row, rows * k_ * sizeof(float));
+          add(reg_ptr_c_row, rows * n_ * sizeof(float));
+          dec(reg_m);
+          jnz(l_next_rows, T_NEAR);
+        }
+      }
+      if (m_ % rows > 0) {
+        genBlock(m_ % rows, cols, n_offset);
+      }
+    }
+    add(param_a, m_ * k_ * sizeof(float));
+    add(param_b, k_ * n_ * sizeof(float));
+    add(param_c, m_ * n_ * sizeof(float));
+    if (with_bias_) {
+      add(param_bias, n_ * sizeof(float));
+    }
+    dec(reg_batch);
+    jnz(l_next_batch, T_NEAR);
+  }
+  L(l_done);
+  postCode();
+}
+
 class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
  public:
   bool CanBeUsed(const matmul_attr_t& attr) const override {
@@ -140,6 +247,41 @@ class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
   }
 };
 
+class BatchedMatMulCreator : public JitCodeCreator<batched_matmul_attr_t> {
+ public:
+  bool CanBeUsed(const batched_matmul_attr_t& attr) const override {
+    // only small gemm benefits from the generated code, the large ones should
+    // go to MKL
+    return platform::MayIUse(platform::avx) &&
+           attr.n % YMM_FLOAT_BLOCK == 0 && attr.m <= 128 && attr.n <= 128 &&
+           attr.k <= 512 && (attr.act == kVIdentity || attr.act == kVRelu);
+  }
+  size_t CodeSize(const batched_matmul_attr_t& attr) const override {
+    // every column group generates at most two row blocks, each of them has
+    // at most 6 * 4 accumulators
+    return 96 + (attr.n / (YMM_FLOAT_BLOCK * 4) + 1) * 2 * 256 * 8;
+  }
+  std::unique_ptr<GenBase> CreateJitCode(
+      const batched_matmul_attr_t& attr) const override {
+    PADDLE_ENFORCE_GT(attr.m, 0, platform::errors::InvalidArgument(
+                                     "The attribute m (first matrix's row) of "
+                                     "BatchedMatMul should be larger than 0. "
+                                     "But it is %d.",
+                                     attr.m));
+    PADDLE_ENFORCE_GT(attr.n, 0, platform::errors::InvalidArgument(
+                                     "The attribute n (second matrix's col) "
+                                     "of BatchedMatMul should be larger than "
+                                     "0. But it is %d.",
+                                     attr.n));
+    PADDLE_ENFORCE_GT(attr.k, 0, platform::errors::InvalidArgument(
+                                     "The attribute k (first matrix's col) of "
+                                     "BatchedMatMul should be larger than 0. "
+                                     "But it is %d.",
+                                     attr.k));
+    return make_unique<BatchedMatMulJitCode>(attr, CodeSize(attr));
+  }
+};
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -148,3 +290,4 @@ class MatMulCreator : public JitCodeCreator<matmul_attr_t> {
 namespace gen = paddle::operators::jit::gen;
 
 REGISTER_JITKERNEL_GEN(kMatMul, gen::MatMulCreator);
+REGISTER_JITKERNEL_GEN(kBatchedMatMul, gen::BatchedMatMulCreator);
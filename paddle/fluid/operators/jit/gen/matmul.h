@@ -60,6 +60,66 @@ class MatMulJitCode : public JitCode {
   reg64_t reg_ptr_wgt{r10};
 };
 
+// C(batch, M, N) = act(A(batch, M, K) * B(batch, K, N) + bias(batch, N))
+// The batch is read from attr at runtime, so one code serves any batch size.
+class BatchedMatMulJitCode : public JitCode {
+ public:
+  explicit BatchedMatMulJitCode(const batched_matmul_attr_t& attr,
+                                size_t code_size = 256 * 1024,
+                                void* code_ptr = nullptr)
+      : JitCode(code_size, code_ptr),
+        m_(attr.m),
+        n_(attr.n),
+        k_(attr.k),
+        with_bias_(attr.with_bias),
+        act_(attr.act) {
+    PADDLE_ENFORCE_EQ(n_ % YMM_FLOAT_BLOCK, 0,
+                      platform::errors::Unimplemented(
+                          "Jitcode of batched matmul only support n (second "
+                          "matrix's col) divisible by %d now. But n is %d.",
+                          YMM_FLOAT_BLOCK, n_));
+    if (!(act_ == kVIdentity || act_ == kVRelu)) {
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "Jitcode of batched matmul only support fusing identity and relu."));
+    }
+    use_fma_ = platform::MayIUse(platform::avx2);
+    this->genCode();
+  }
+
+  std::string name() const override {
+    std::string base = "BatchedMatMulJitCode";
+    base = base + "_M" + std::to_string(m_) + "_N" + std::to_string(n_) + "_K" +
+           std::to_string(k_);
+    base += (with_bias_ ? "_Bias" : "");
+    base += (act_ == kVRelu ? "_Relu" : "");
+    return base;
+  }
+  void genCode() override;
+
+ private:
+  // compute rows x (cols * YMM_FLOAT_BLOCK) of C at the column offset
+  void genBlock(int rows, int cols, int n_offset);
+
+  int m_, n_, k_;
+  bool with_bias_;
+  KernelType act_;
+  bool use_fma_{false};
+
+  reg64_t param_a{abi_param1};
+  reg64_t param_b{abi_param2};
+  reg64_t param_bias{abi_param3};
+  reg64_t param_c{abi_param4};
+  reg64_t param_attr{abi_param5};
+
+  reg64_t reg_batch{r9};
+  reg64_t reg_m{r10};
+  reg64_t reg_k{r11};
+  reg64_t reg_ptr_a_row{r12};
+  reg64_t reg_ptr_c_row{r13};
+  reg64_t reg_ptr_a{r14};
+  reg64_t reg_ptr_b{r15};
+};
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
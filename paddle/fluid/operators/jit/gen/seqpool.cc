@@ -14,8 +14,11 @@
 
 #include "paddle/fluid/operators/jit/gen/seqpool.h"
 
+#include <type_traits>
+
 #include "paddle/fluid/operators/jit/gen/act.h"  // for exp_float_consts ones
 #include "paddle/fluid/operators/jit/registry.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/cpu_info.h"
 
 namespace paddle {
@@ -24,47 +27,68 @@ namespace jit {
 namespace gen {
 
 void SeqPoolJitCode::genCode() {
-  constexpr int block = YMM_FLOAT_BLOCK;
-  constexpr int max_num_regs = 8;
+  // zmm has 32 registers, half for the sum and half for the loads
+  const bool use_zmm = isa_ == platform::avx512f;
+  const int block = use_zmm ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
+  const int max_num_regs = use_zmm ? 16 : 8;
   const int num_block = w_ / block;
   const int num_groups = num_block / max_num_regs;
   int rest_num_regs = num_block % max_num_regs;
   mov(reg32_int_h, dword[param_attr]);
-  if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
-    mov(reg_tmp, reinterpret_cast<size_t>(exp_float_consts));
+  const bool scale = type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt;
+  if (scale) {
+    sub(rsp, kFpHSlotBytes);
+    mov_global(reg_tmp, exp_float_consts);
     vmovups(xmm_t(1), ptr[reg_tmp + OFFSET_EXP_ONE]);
-    mov(reg_tmp, reinterpret_cast<size_t>(fp_h_));
-    fild(dword[param_attr]);
-    fstp(dword[reg_tmp]);
-    vmovss(xmm_t(0), ptr[reg_tmp]);
+    vcvtsi2ss(xmm_t(0), xmm_t(0), reg32_int_h);
     if (type_ == SeqPoolType::kSqrt) {
       vsqrtps(xmm_t(0), xmm_t(0));
     }
     vdivps(xmm_t(1), xmm_t(1), xmm_t(0));
-    vmovss(ptr[reg_tmp], xmm_t(1));
+    vmovss(fp_h(), xmm_t(1));
   }
-  const int group_len = max_num_regs * block * sizeof(float);
+  const int group_len = max_num_regs * block * elem_size_;
   for (int g = 0; g < num_groups; ++g) {
-    pool_height<ymm_t>(g * group_len, block, max_num_regs);
+    if (use_zmm) {
+      pool_height<zmm_t>(g * group_len, block, max_num_regs);
+    } else {
+      pool_height<ymm_t>(g * group_len, block, max_num_regs);
+    }
   }
   if (rest_num_regs > 0) {
-    pool_height<ymm_t>(num_groups * group_len, block, rest_num_regs);
+    if (use_zmm) {
+      pool_height<zmm_t>(num_groups * group_len, block, rest_num_regs);
+    } else {
+      pool_height<ymm_t>(num_groups * group_len, block, rest_num_regs);
+    }
   }
   // part of rest_w * height
   const int rest = w_ % block;
-  pool_height_of_rest_width(rest, (w_ - rest) * sizeof(float), max_num_regs);
+  if (!use_zmm) {
+    pool_height_of_rest_width(rest, (w_ - rest) * sizeof(float),
+                              max_num_regs);
+  } else if (rest > 0) {
+    pool_height_of_rest_width_masked(rest, (w_ - rest) * elem_size_);
+  }
+  if (scale) {
+    add(rsp, kFpHSlotBytes);
+  }
   ret();
 }
 
-class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
+// isa is avx or avx512f, T is float or bfloat16 which needs avx512f
+template <typename T, platform::cpu_isa_t isa>
+class SeqPoolCreatorImpl : public JitCodeCreator<seq_pool_attr_t, T> {
  public:
   bool CanBeUsed(const seq_pool_attr_t& attr) const override {
-    return platform::MayIUse(platform::avx);
+    return platform::MayIUse(isa);
   }
   size_t CodeSize(const seq_pool_attr_t& attr) const override {
+    const int block =
+        isa == platform::avx512f ? ZMM_FLOAT_BLOCK : YMM_FLOAT_BLOCK;
     return 96 +
-           ((attr.w / YMM_FLOAT_BLOCK + 4 /* for rest */) *
-                4 /* load, mul and save */ +
+           ((attr.w / block + 4 /* for rest */) *
+                6 /* load, convert, mul and save */ +
             256) *
                16;
   }
@@ -78,10 +102,16 @@ class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
                                      "The attribute height of SeqPool should "
                                      "be larger than 0. But it is %d.",
                                      attr.h));
-    return make_unique<SeqPoolJitCode>(attr, CodeSize(attr));
+    return make_unique<SeqPoolJitCode>(
+        attr, CodeSize(attr), isa, std::is_same<T, platform::bfloat16>::value);
   }
 };
 
+using SeqPoolCreator = SeqPoolCreatorImpl<float, platform::avx>;
+using SeqPoolAVX512Creator = SeqPoolCreatorImpl<float, platform::avx512f>;
+using SeqPoolBF16Creator =
+    SeqPoolCreatorImpl<platform::bfloat16, platform::avx512f>;
+
 }  // namespace gen
 }  // namespace jit
 }  // namespace operators
@@ -89,4 +119,5 @@ class SeqPoolCreator : public JitCodeCreator<seq_pool_attr_t> {
 
 namespace gen = paddle::operators::jit::gen;
 
-REGISTER_JITKERNEL_GEN(kSeqPool, gen::SeqPoolCreator);
+REGISTER_JITKERNEL_GEN(kSeqPool, gen::SeqPoolAVX512Creator,
+                       gen::SeqPoolCreator, gen::SeqPoolBF16Creator);
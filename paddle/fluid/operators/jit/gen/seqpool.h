@@ -29,14 +29,23 @@ class SeqPoolJitCode : public JitCode {
  public:
   explicit SeqPoolJitCode(const seq_pool_attr_t& attr,
                           size_t code_size = 256 * 1024,
-                          void* code_ptr = nullptr)
-      : JitCode(code_size, code_ptr), w_(attr.w), type_(attr.type) {
+                          platform::cpu_isa_t isa = platform::avx,
+                          bool bf16 = false, void* code_ptr = nullptr)
+      : JitCode(code_size, code_ptr),
+        w_(attr.w),
+        type_(attr.type),
+        isa_(isa),
+        bf16_(bf16),
+        elem_size_(bf16 ? sizeof(int16_t) : sizeof(float)) {
     if (!(type_ == SeqPoolType::kSum || type_ == SeqPoolType::kAvg ||
           type_ == SeqPoolType::kSqrt)) {
       PADDLE_THROW(platform::errors::Unimplemented(
           "Only supports sum, average and sqrt pool type."));
     }
-    fp_h_[0] = 1.f;
+    PADDLE_ENFORCE_EQ(
+        !bf16_ || isa_ == platform::avx512f, true,
+        platform::errors::InvalidArgument(
+            "The bfloat16 SeqPoolJitCode can only be generated with avx512f."));
     this->genCode();
   }
 
@@ -50,54 +59,111 @@ class SeqPoolJitCode : public JitCode {
       base += "_Sqrt";
     }
     base += ("_W" + std::to_string(w_));
+    if (isa_ == platform::avx512f) {
+      base += "_AVX512";
+    }
+    if (bf16_) {
+      base += "_BF16";
+    }
     return base;
   }
   void genCode() override;
 
  protected:
+  // load or save as float or bfloat16, only zmm supports tail and bfloat16
+  void load_jmm(const Xbyak::Xmm& dst, const Xbyak::Address& src,
+                bool tail = false) {
+    if (bf16_) {
+      load_bf16(zmm_t(dst.getIdx()), src, tail);
+    } else if (tail) {
+      vmovups(zmm_t(dst.getIdx()) | k_tail_mask | T_z, src);
+    } else {
+      vmovups(dst, src);
+    }
+  }
+
+  void save_jmm(const Xbyak::Address& dst, const Xbyak::Xmm& src,
+                bool tail = false) {
+    if (bf16_) {
+      store_bf16(dst, zmm_t(src.getIdx()), tail);
+    } else if (tail) {
+      vmovups(dst | k_tail_mask, zmm_t(src.getIdx()));
+    } else {
+      vmovups(dst, src);
+    }
+  }
+
   template <typename JMM>
   void pool_height(int w_offset, int block, int max_num_regs) {
     int offset = w_offset;
     for (int i = 0; i < max_num_regs; ++i) {
-      vmovups(JMM(i), ptr[param_src + offset]);
-      offset += sizeof(float) * block;
+      load_jmm(JMM(i), ptr[param_src + offset]);
+      offset += elem_size_ * block;
     }
     cmp(reg32_int_h, 1);
     Label l_next_h, l_h_done;
     jle(l_h_done, T_NEAR);
     mov(reg_h_i, 1);
     mov(reg_tmp, param_src);
-    add(reg_tmp, w_ * sizeof(float) + w_offset);
+    add(reg_tmp, w_ * elem_size_ + w_offset);
     L(l_next_h);
     {
       mov(reg_ptr_src_i, reg_tmp);
       for (int i = 0; i < max_num_regs; ++i) {
-        vmovups(JMM(i + max_num_regs), ptr[reg_ptr_src_i]);
+        load_jmm(JMM(i + max_num_regs), ptr[reg_ptr_src_i]);
         // sum anyway
         vaddps(JMM(i), JMM(i), JMM(i + max_num_regs));
-        add(reg_ptr_src_i, sizeof(float) * block);
+        add(reg_ptr_src_i, elem_size_ * block);
       }
       inc(reg_h_i);
-      add(reg_tmp, w_ * sizeof(float));
+      add(reg_tmp, w_ * elem_size_);
       cmp(reg_h_i, reg32_int_h);
       jl(l_next_h, T_NEAR);
     }
     L(l_h_done);
     // save right now
     if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
-      mov(reg_tmp, reinterpret_cast<size_t>(fp_h_));
-      vbroadcastss(JMM(max_num_regs), ptr[reg_tmp]);
+      vbroadcastss(JMM(max_num_regs), fp_h());
     }
     offset = w_offset;
     for (int i = 0; i < max_num_regs; ++i) {
       if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
         vmulps(JMM(i), JMM(i), JMM(max_num_regs));
       }
-      vmovups(ptr[param_dst + offset], JMM(i));
-      offset += sizeof(float) * block;
+      save_jmm(ptr[param_dst + offset], JMM(i));
+      offset += elem_size_ * block;
     }
   }
 
+  // the rest width is less than one zmm, use the masked load and save
+  void pool_height_of_rest_width_masked(int rest, int w_offset) {
+    zmm_t zmm_sum = zmm_t(0);
+    zmm_t zmm_src = zmm_t(1);
+    set_tail_mask(rest, reg_tmp.cvt32());
+    load_jmm(zmm_sum, ptr[param_src + w_offset], true);
+    cmp(reg32_int_h, 1);
+    Label l_next_h, l_h_done;
+    jle(l_h_done, T_NEAR);
+    mov(reg_h_i, 1);
+    mov(reg_tmp, param_src);
+    add(reg_tmp, w_ * elem_size_ + w_offset);
+    L(l_next_h);
+    {
+      load_jmm(zmm_src, ptr[reg_tmp], true);
+      vaddps(zmm_sum, zmm_sum, zmm_src);
+      inc(reg_h_i);
+      add(reg_tmp, w_ * elem_size_);
+      cmp(reg_h_i, reg32_int_h);
+      jl(l_next_h, T_NEAR);
+    }
+    L(l_h_done);
+    if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
+      vbroadcastss(zmm_src, fp_h());
+      vmulps(zmm_sum, zmm_sum, zmm_src);
+    }
+    save_jmm(ptr[param_dst + w_offset], zmm_sum, true);
+  }
+
   void pool_height_of_rest_width(int rest, int w_offset, int max_num_regs) {
     const int rest_used_num_regs = load_rest(rest, w_offset, 0);
     const bool has_block4 = rest / 4 > 0;
@@ -145,8 +211,7 @@ class SeqPoolJitCode : public JitCode {
     L(l_h_done);
     // save right now
     if (type_ == SeqPoolType::kAvg || type_ == SeqPoolType::kSqrt) {
-      mov(reg_tmp, reinterpret_cast<size_t>(fp_h_));
-      vbroadcastss(xmm_t(max_num_regs), ptr[reg_tmp]);
+      vbroadcastss(xmm_t(max_num_regs), fp_h());
       for (int i = 0; i < rest_used_num_regs; ++i) {
         vmulps(xmm_t(i), xmm_t(i), xmm_t(max_num_regs));
       }
@@ -154,6 +219,11 @@ class SeqPoolJitCode : public JitCode {
     save_rest(rest, w_offset);
   }
 
+  // 1/h or 1/sqrt(h) is kept in a stack slot reserved by genCode, then the
+  // code is thread safe and relocatable. The slot keeps rsp 8 bytes aligned.
+  static constexpr int kFpHSlotBytes = 8;
+  Xbyak::Address fp_h() const { return dword[rsp]; }
+
   // return the number of used regs, use start from reg 0
   int load_rest(int rest, int w_offset, const int num_shift_regs,
                 const int reg_start = 0) {
@@ -200,9 +270,11 @@ class SeqPoolJitCode : public JitCode {
   }
 
  private:
-  float ALIGN32_BEG fp_h_[1] ALIGN32_END;
   int w_;
   SeqPoolType type_;
+  platform::cpu_isa_t isa_;
+  bool bf16_;
+  int elem_size_;
   reg64_t param_src{abi_param1};
   reg64_t param_dst{abi_param2};
   reg64_t param_attr{abi_param3};
@@ -27,12 +27,23 @@ namespace paddle {
 namespace operators {
 namespace jit {
 
+// The absolute address of a registered symbol (see RegisterJitCodeSymbol),
+// which is embedded as 8 bytes at the offset of the code.
+struct JitCodeReloc {
+  size_t offset;
+  std::string symbol;
+};
+
 class GenBase : public Kernel {
  public:
   virtual ~GenBase() = default;
   virtual std::string name() const = 0;
   virtual size_t getSize() const = 0;
   virtual const unsigned char* getCodeInternal() const = 0;
+  // Only the relocatable code can be saved and reloaded by other processes,
+  // all the absolute addresses in it should be listed in relocations.
+  virtual bool relocatable() const { return false; }
+  virtual std::vector<JitCodeReloc> relocations() const { return {}; }
   const char* ImplType() const override { return "JitCode"; }
   template <typename Func>
   Func getCode() const {
@@ -61,7 +72,8 @@ class GenCreator {
   virtual ~GenCreator() = default;
 };
 
-template <typename Attr>
+// T is the data type which the created code reads and writes.
+template <typename Attr, typename T = float>
 class JitCodeCreator : public GenCreator {
  public:
   virtual ~JitCodeCreator() = default;
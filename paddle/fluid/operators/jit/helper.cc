@@ -57,6 +57,8 @@ const char* to_string(KernelType kt) {
     ONE_CASE(kNCHW16CMulNC);
     ONE_CASE(kSeqPool);
     ONE_CASE(kMatMul);
+    ONE_CASE(kBatchedMatMul);
+    ONE_CASE(kAttention);
     ONE_CASE(kHMax);
     ONE_CASE(kHSum);
     ONE_CASE(kStrideASum);
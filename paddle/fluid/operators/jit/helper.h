@@ -18,14 +18,17 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>  // for std::move
 #include <vector>
 
 #include "paddle/fluid/operators/jit/gen_base.h"
+#include "paddle/fluid/operators/jit/jitcode_cache.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
 #include "paddle/fluid/operators/jit/kernel_key.h"
 #include "paddle/fluid/operators/jit/kernel_pool.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/place.h"
 
 namespace paddle {
@@ -34,15 +37,23 @@ namespace jit {
 
 class GenBase;
 
+// The data types which could have jitcode, float and bfloat16 only.
+template <typename T>
+struct IsJitCodeType
+    : std::integral_constant<bool,
+                             std::is_same<T, float>::value ||
+                                 std::is_same<T, platform::bfloat16>::value> {};
+
 template <typename KernelTuple, typename PlaceType>
 inline typename std::enable_if<
-    std::is_same<typename KernelTuple::data_type, float>::value &&
+    IsJitCodeType<typename KernelTuple::data_type>::value &&
         std::is_same<PlaceType, platform::CPUPlace>::value,
     const Kernel*>::type
 GetJitCode(const typename KernelTuple::attr_type& attr) {
   using Attr = typename KernelTuple::attr_type;
+  using T = typename KernelTuple::data_type;
   int64_t key = JitCodeKey<Attr>(attr);
-  auto& codes = JitCodePool<KernelTuple::kernel_type>::Instance();
+  auto& codes = JitCodePool<KernelTuple::kernel_type, T>::Instance();
   if (codes.Has(key)) {
     return codes.AllKernels().at(key).get();
   }
@@ -55,9 +66,22 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
   if (iter != creator_map.end()) {
     auto& creators = iter->second;
     for (auto& cur : creators) {
-      auto i = dynamic_cast<const JitCodeCreator<Attr>*>(cur.get());
+      auto i = dynamic_cast<const JitCodeCreator<Attr, T>*>(cur.get());
       if (i && i->CanBeUsed(attr)) {
-        auto p = i->CreateJitCode(attr);
+        auto& disk_cache = JitCodeDiskCache::Instance();
+        std::string disk_key;
+        std::unique_ptr<GenBase> p;
+        if (disk_cache.Enabled()) {
+          disk_key = disk_cache.Key(KernelTuple::kernel_type, typeid(T).name(),
+                                    typeid(*i).name(), key);
+          p = disk_cache.Load(disk_key);
+        }
+        if (!p) {
+          p = i->CreateJitCode(attr);
+          if (p && disk_cache.Enabled()) {
+            disk_cache.Save(disk_key, *p);
+          }
+        }
         if (p) {
           auto res = p.get();
           codes.Insert(key, std::move(p));
@@ -71,7 +95,7 @@ GetJitCode(const typename KernelTuple::attr_type& attr) {
 
 template <typename KernelTuple, typename PlaceType>
 inline typename std::enable_if<
-    !std::is_same<typename KernelTuple::data_type, float>::value ||
+    !IsJitCodeType<typename KernelTuple::data_type>::value ||
         !std::is_same<PlaceType, platform::CPUPlace>::value,
     const Kernel*>::type
 GetJitCode(const typename KernelTuple::attr_type& attr) {
@@ -241,6 +265,15 @@ class KernelFuncs {
   DISABLE_COPY_AND_ASSIGN(KernelFuncs);
 };
 
+// Return the best function of the attr, or nullptr if it is the refer one.
+// The callers having a faster fallback than the refer function use it.
+template <typename KernelTuple, typename PlaceType = platform::CPUPlace>
+typename KernelTuple::func_type GetNonReferFunc(
+    const typename KernelTuple::attr_type& attr) {
+  auto func = KernelFuncs<KernelTuple, PlaceType>::Cache().At(attr);
+  return func == GetReferFunc<KernelTuple>() ? nullptr : func;
+}
+
 const char* to_string(KernelType kt);
 const char* to_string(SeqPoolType kt);
 
@@ -288,6 +321,22 @@ inline std::ostream& operator<<(std::ostream& os, const matmul_attr_t& attr) {
   return os;
 }
 
+inline std::ostream& operator<<(std::ostream& os,
+                                const batched_matmul_attr_t& attr) {
+  os << "Batch[" << attr.batch << "],M[" << attr.m << "],N[" << attr.n
+     << "],K[" << attr.k << "],with_bias["
+     << (attr.with_bias ? "True" : "False") << "],act["
+     << to_string(attr.act) << "]";
+  return os;
+}
+
+inline std::ostream& operator<<(std::ostream& os,
+                                const attention_attr_t& attr) {
+  os << "seq_q[" << attr.seq_q << "],seq_k[" << attr.seq_k << "],head_dim["
+     << attr.head_dim << "],alpha[" << attr.alpha << "]";
+  return os;
+}
+
 // expose the method to pack matmul weight
 template <typename T>
 void pack_weights(const T* src, T* dst, int n, int k);
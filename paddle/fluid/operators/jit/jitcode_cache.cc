@@ -0,0 +1,363 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "paddle/fluid/operators/jit/jitcode_cache.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include <xxhash.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "glog/logging.h"
+#include "paddle/fluid/framework/commit.h"
+#include "paddle/fluid/operators/jit/helper.h"
+#include "paddle/fluid/platform/cpu_info.h"
+#include "paddle/fluid/platform/enforce.h"
+
+DEFINE_string(jitcode_cache_dir, "",
+              "The directory to save the generated jitcode and reload it in "
+              "the later processes, empty means disabled.");
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+namespace {
+
+struct JitCodeSymbols {
+  std::mutex mtx;
+  std::unordered_map<std::string, const void*> addrs;
+  std::unordered_map<const void*, std::string> names;
+};
+
+JitCodeSymbols& GetJitCodeSymbols() {
+  static JitCodeSymbols g_jitcode_symbols;
+  return g_jitcode_symbols;
+}
+
+// File layout: header, key, name, relocations and then the code which starts
+// at a page aligned offset. The relocation is saved as 8 bytes offset, 4 bytes
+// symbol size and the symbol. The relocated slots are zero in the file.
+constexpr char kMagic[8] = {'P', 'D', 'J', 'I', 'T', 'C', 'D', 'E'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kPageSize = 4096;
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t key_size;
+  uint32_t name_size;
+  uint32_t num_relocs;
+  uint64_t code_offset;
+  uint64_t code_size;
+  uint64_t checksum;
+};
+
+std::string CpuIsaString() {
+  static const std::string isa = [] {
+    const std::pair<platform::cpu_isa_t, const char*> all[] = {
+        {platform::sse42, "sse42"},
+        {platform::avx, "avx"},
+        {platform::avx2, "avx2"},
+        {platform::avx512f, "avx512f"},
+        {platform::avx512_core, "avx512core"},
+        {platform::avx512_core_vnni, "avx512vnni"},
+        {platform::avx512_mic, "avx512mic"},
+        {platform::avx512_mic_4ops, "avx512mic4ops"},
+        {platform::avx512_bf16, "avx512bf16"}};
+    std::string res;
+    for (auto& i : all) {
+      if (platform::MayIUse(i.first)) {
+        res += std::string(res.empty() ? "" : "+") + i.second;
+      }
+    }
+    return res;
+  }();
+  return isa;
+}
+
+// read the fields of cache file with boundary check
+class FileReader {
+ public:
+  FileReader(const unsigned char* data, size_t size)
+      : data_(data), size_(size) {}
+  template <typename T>
+  bool Read(T* out) {
+    if (pos_ + sizeof(T) > size_) {
+      return false;
+    }
+    std::memcpy(out, data_ + pos_, sizeof(T));
+    pos_ += sizeof(T);
+    return true;
+  }
+  bool Read(size_t len, std::string* out) {
+    if (pos_ + len > size_) {
+      return false;
+    }
+    out->assign(reinterpret_cast<const char*>(data_ + pos_), len);
+    pos_ += len;
+    return true;
+  }
+
+ private:
+  const unsigned char* data_;
+  size_t size_;
+  size_t pos_{0};
+};
+
+#ifndef _WIN32
+// The jitcode mapped from the cache file.
+class MappedJitCode : public GenBase {
+ public:
+  MappedJitCode(void* map, size_t map_size, const unsigned char* code,
+                size_t code_size, const std::string& name)
+      : map_(map),
+        map_size_(map_size),
+        code_(code),
+        code_size_(code_size),
+        name_(name) {}
+  ~MappedJitCode() { munmap(map_, map_size_); }
+
+  std::string name() const override { return name_; }
+  size_t getSize() const override { return code_size_; }
+  const unsigned char* getCodeInternal() const override { return code_; }
+
+ private:
+  void* map_;
+  size_t map_size_;
+  const unsigned char* code_;
+  size_t code_size_;
+  std::string name_;
+};
+
+// Check the file, patch the relocations and make the code executable.
+// Return the code start and set the name, or nullptr if the file is invalid.
+unsigned char* RelocateMappedFile(unsigned char* map, size_t map_size,
+                                  const std::string& key, std::string* name) {
+  FileReader reader(map, map_size);
+  FileHeader header;
+  std::string file_key;
+  if (!reader.Read(&header) ||
+      std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ||
+      header.version != kVersion || !reader.Read(header.key_size, &file_key) ||
+      file_key != key || !reader.Read(header.name_size, name) ||
+      header.code_offset > map_size ||
+      header.code_size > map_size - header.code_offset) {
+    return nullptr;
+  }
+  unsigned char* code = map + header.code_offset;
+  if (XXH64(code, header.code_size, 0) != header.checksum) {
+    return nullptr;
+  }
+  for (uint32_t i = 0; i < header.num_relocs; ++i) {
+    uint64_t offset;
+    uint32_t symbol_size;
+    std::string symbol;
+    if (!reader.Read(&offset) || !reader.Read(&symbol_size) ||
+        !reader.Read(symbol_size, &symbol) ||
+        offset + sizeof(uint64_t) > header.code_size) {
+      return nullptr;
+    }
+    const void* addr = GetJitCodeSymbolAddr(symbol);
+    if (addr == nullptr) {
+      return nullptr;
+    }
+    uint64_t value = reinterpret_cast<uint64_t>(addr);
+    std::memcpy(code + offset, &value, sizeof(value));
+  }
+  if (mprotect(map, map_size, PROT_READ | PROT_EXEC) != 0) {
+    return nullptr;
+  }
+  return code;
+}
+#endif
+
+}  // namespace
+
+int RegisterJitCodeSymbol(const std::string& name, const void* addr) {
+  auto& symbols = GetJitCodeSymbols();
+  std::lock_guard<std::mutex> lock(symbols.mtx);
+  auto iter = symbols.addrs.find(name);
+  PADDLE_ENFORCE_EQ(
+      iter == symbols.addrs.end() || iter->second == addr, true,
+      platform::errors::AlreadyExists(
+          "The jitcode symbol %s has been registered with another address.",
+          name));
+  symbols.addrs[name] = addr;
+  symbols.names[addr] = name;
+  return 0;
+}
+
+std::string GetJitCodeSymbolName(const void* addr) {
+  auto& symbols = GetJitCodeSymbols();
+  std::lock_guard<std::mutex> lock(symbols.mtx);
+  auto iter = symbols.names.find(addr);
+  return iter == symbols.names.end() ? "" : iter->second;
+}
+
+const void* GetJitCodeSymbolAddr(const std::string& name) {
+  auto& symbols = GetJitCodeSymbols();
+  std::lock_guard<std::mutex> lock(symbols.mtx);
+  auto iter = symbols.addrs.find(name);
+  return iter == symbols.addrs.end() ? nullptr : iter->second;
+}
+
+JitCodeDiskCache& JitCodeDiskCache::Instance() {
+  static JitCodeDiskCache g_jitcode_disk_cache;
+  return g_jitcode_disk_cache;
+}
+
+std::string JitCodeDiskCache::Key(KernelType kt, const char* data_type,
+                                  const char* creator, int64_t attr_key) const {
+  std::ostringstream os;
+  // The code of the other builds, which may be generated differently, is
+  // keyed differently and rejected when loading.
+  os << to_string(kt) << "_" << data_type << "_" << creator << "_" << attr_key
+     << "_" << CpuIsaString() << "_" << framework::paddle_commit() << "_"
+     << kJitCodeGeneratorVersion;
+  return os.str();
+}
+
+std::string JitCodeDiskCache::FilePath(const std::string& key) const {
+  std::ostringstream os;
+  os << FLAGS_jitcode_cache_dir << "/" << std::hex
+     << XXH64(key.data(), key.size(), 0) << ".jitcode";
+  return os.str();
+}
+
+std::unique_ptr<GenBase> JitCodeDiskCache::Load(const std::string& key) const {
+#ifdef _WIN32
+  return nullptr;
+#else
+  const std::string path = FilePath(key);
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  void* map = MAP_FAILED;
+  size_t map_size = 0;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    map_size = static_cast<size_t>(st.st_size);
+    map = mmap(nullptr, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  }
+  close(fd);
+  if (map == MAP_FAILED) {
+    return nullptr;
+  }
+  std::string name;
+  unsigned char* code = RelocateMappedFile(static_cast<unsigned char*>(map),
+                                           map_size, key, &name);
+  if (code == nullptr) {
+    VLOG(3) << "Ignore the invalid jitcode cache file " << path;
+    munmap(map, map_size);
+    return nullptr;
+  }
+  const size_t code_size =
+      reinterpret_cast<const FileHeader*>(map)->code_size;
+  VLOG(3) << "Load jitcode " << name << " from " << path;
+  return std::unique_ptr<GenBase>(
+      new MappedJitCode(map, map_size, code, code_size, name));
+#endif
+}
+
+void JitCodeDiskCache::Save(const std::string& key,
+                            const GenBase& code) const {
+#ifndef _WIN32
+  if (!code.relocatable()) {
+    VLOG(3) << "Skip saving jitcode " << code.name()
+            << ", which is not relocatable.";
+    return;
+  }
+  const std::string name = code.name();
+  const auto relocs = code.relocations();
+  const size_t code_size = code.getSize();
+  std::vector<unsigned char> code_data(
+      code.getCodeInternal(), code.getCodeInternal() + code_size);
+  for (auto& r : relocs) {
+    if (r.offset + sizeof(uint64_t) > code_size) {
+      LOG(WARNING) << "Skip saving jitcode " << name
+                   << " with invalid relocation.";
+      return;
+    }
+    std::memset(code_data.data() + r.offset, 0, sizeof(uint64_t));
+  }
+
+  std::ostringstream meta;
+  FileHeader header;
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.key_size = static_cast<uint32_t>(key.size());
+  header.name_size = static_cast<uint32_t>(name.size());
+  header.num_relocs = static_cast<uint32_t>(relocs.size());
+  header.code_size = code_size;
+  header.checksum = XXH64(code_data.data(), code_size, 0);
+  size_t meta_size = sizeof(header) + key.size() + name.size();
+  for (auto& r : relocs) {
+    meta_size += sizeof(uint64_t) + sizeof(uint32_t) + r.symbol.size();
+  }
+  header.code_offset = (meta_size + kPageSize - 1) / kPageSize * kPageSize;
+  meta.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  meta << key << name;
+  for (auto& r : relocs) {
+    uint64_t offset = r.offset;
+    uint32_t symbol_size = static_cast<uint32_t>(r.symbol.size());
+    meta.write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+    meta.write(reinterpret_cast<const char*>(&symbol_size),
+               sizeof(symbol_size));
+    meta << r.symbol;
+  }
+  std::string content = meta.str();
+  content.resize(header.code_offset, '\0');
+  content.append(reinterpret_cast<const char*>(code_data.data()), code_size);
+
+  // write to a temporary file then rename, so the processes sharing the
+  // directory never see a partial file
+  mkdir(FLAGS_jitcode_cache_dir.c_str(), 0755);
+  const std::string path = FilePath(key);
+  std::ostringstream tmp_path;
+  tmp_path << path << ".tmp." << getpid() << "."
+           << std::hash<std::thread::id>()(std::this_thread::get_id());
+  {
+    std::ofstream fout(tmp_path.str(), std::ios::out | std::ios::binary);
+    if (!fout.is_open() || !fout.write(content.data(), content.size())) {
+      LOG(WARNING) << "Failed to save jitcode to " << tmp_path.str();
+      std::remove(tmp_path.str().c_str());
+      return;
+    }
+  }
+  if (std::rename(tmp_path.str().c_str(), path.c_str()) != 0) {
+    LOG(WARNING) << "Failed to save jitcode to " << path;
+    std::remove(tmp_path.str().c_str());
+    return;
+  }
+  VLOG(3) << "Save jitcode " << name << " to " << path;
+#endif
+}
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
@@ -0,0 +1,82 @@
+/* Copyright (c) 2020 PaddlePaddle Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <memory>  // for unique_ptr
+#include <string>
+#include "gflags/gflags.h"
+
+#include "paddle/fluid/operators/jit/gen_base.h"
+#include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/macros.h"
+#include "paddle/fluid/platform/variant.h"  // for UNUSED
+
+DECLARE_string(jitcode_cache_dir);
+
+namespace paddle {
+namespace operators {
+namespace jit {
+
+// The global data used by jitcode, like the constant tables, are registered
+// by name, then the addresses embedded in the code can be relocated when the
+// code is reloaded by another process.
+int RegisterJitCodeSymbol(const std::string& name, const void* addr);
+
+// return empty string if the address is not registered
+std::string GetJitCodeSymbolName(const void* addr);
+
+// return nullptr if the name is not registered
+const void* GetJitCodeSymbolAddr(const std::string& name);
+
+// Bump it when the generated code changes, for the builds of the same commit
+// with local changes to the code generators.
+constexpr int kJitCodeGeneratorVersion = 2;
+
+#define REGISTER_JITCODE_SYMBOL(symbol)                 \
+  static int __reg_jitcode_symbol_##symbol##__ UNUSED = \
+      ::paddle::operators::jit::RegisterJitCodeSymbol(#symbol, symbol)
+
+// Persistent cache of the generated jitcode, enabled by setting
+// FLAGS_jitcode_cache_dir. The code is saved once it is generated, and the
+// processes started later map it executable instead of generating again.
+// The key consists of kernel type, data type, creator, attribute and CPU ISA,
+// so one directory can be shared by different machines, and of the commit of
+// the build and kJitCodeGeneratorVersion, so the code cached by the other
+// builds is not loaded.
+class JitCodeDiskCache {
+ public:
+  static JitCodeDiskCache& Instance();
+
+  bool Enabled() const { return !FLAGS_jitcode_cache_dir.empty(); }
+
+  std::string Key(KernelType kt, const char* data_type, const char* creator,
+                  int64_t attr_key) const;
+
+  // return nullptr if it is not cached or the cache file is invalid
+  std::unique_ptr<GenBase> Load(const std::string& key) const;
+
+  // the code which is not relocatable is skipped, and failures are ignored
+  void Save(const std::string& key, const GenBase& code) const;
+
+ private:
+  JitCodeDiskCache() = default;
+  std::string FilePath(const std::string& key) const;
+
+  DISABLE_COPY_AND_ASSIGN(JitCodeDiskCache);
+};
+
+}  // namespace jit
+}  // namespace operators
+}  // namespace paddle
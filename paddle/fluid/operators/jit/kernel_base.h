@@ -24,8 +24,10 @@ namespace jit {
 typedef enum {
   kNone = 0,
   // sort by alphabet
-  kCRFDecoding = 1,
-  kEmbSeqPool = 2,
+  kAttention = 1,
+  kBatchedMatMul,
+  kCRFDecoding,
+  kEmbSeqPool,
   kGRUH1,
   kGRUHtPart1,
   kGRUHtPart2,
@@ -285,6 +287,54 @@ struct MatMulTuple {
   typedef void (*func_type)(const T*, const T*, T*, const matmul_attr_t*);
 };
 
+// A(batch, M, K) * B(batch, K, N) + bias(batch, N) = C(batch, M, N)
+// then the activation is applied on C
+typedef struct batched_matmul_attr_s {
+  int batch;  // batch should always be the first one, it is read at runtime
+  int m, n, k;
+  bool with_bias;
+  KernelType act;
+  batched_matmul_attr_s() = default;
+  explicit batched_matmul_attr_s(int m_, int n_, int k_, int batch_ = 1,
+                                 bool with_bias_ = false,
+                                 KernelType act_ = kVIdentity)
+      : batch(batch_),
+        m(m_),
+        n(n_),
+        k(k_),
+        with_bias(with_bias_),
+        act(act_) {}
+} batched_matmul_attr_t;
+
+template <typename T>
+struct BatchedMatMulTuple {
+  static constexpr KernelType kernel_type = kBatchedMatMul;
+  typedef T data_type;
+  typedef batched_matmul_attr_t attr_type;
+  typedef void (*func_type)(const T*, const T*, const T*, T*,
+                            const batched_matmul_attr_t*);
+};
+
+// out(seq_q, d) = softmax(alpha * q(seq_q, d) * k(seq_k, d)^T + bias_qk) * v
+// bias_qk(seq_q, seq_k) can be nullptr
+typedef struct attention_attr_s {
+  int seq_q, seq_k, head_dim;
+  float alpha;
+  attention_attr_s() = default;
+  explicit attention_attr_s(int seq_q_, int seq_k_, int head_dim_,
+                            float alpha_ = 1.f)
+      : seq_q(seq_q_), seq_k(seq_k_), head_dim(head_dim_), alpha(alpha_) {}
+} attention_attr_t;
+
+template <typename T>
+struct AttentionTuple {
+  static constexpr KernelType kernel_type = kAttention;
+  typedef T data_type;
+  typedef attention_attr_t attr_type;
+  typedef void (*func_type)(const T*, const T*, const T*, const T*, T*,
+                            const attention_attr_t*);
+};
+
 template <typename T>
 struct CRFDecodingTuple {
   static constexpr KernelType kernel_type = kCRFDecoding;
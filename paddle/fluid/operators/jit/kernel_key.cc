@@ -53,6 +53,21 @@ int64_t JitCodeKey<matmul_attr_t>(const matmul_attr_t& attr) {
   return XXH64(&attr, sizeof(int) * 3, 0);  // m, n, k
 }
 
+template <>
+int64_t JitCodeKey<batched_matmul_attr_t>(const batched_matmul_attr_t& attr) {
+  // batch is read at runtime, so it is not a part of the key
+  int keys[5] = {attr.m, attr.n, attr.k, static_cast<int>(attr.with_bias),
+                 static_cast<int>(attr.act)};
+  return XXH64(keys, sizeof(int) * 5, 0);
+}
+
+template <>
+int64_t JitCodeKey<attention_attr_t>(const attention_attr_t& attr) {
+  // alpha is read at runtime, so it is not a part of the key
+  int keys[3] = {attr.seq_q, attr.seq_k, attr.head_dim};
+  return XXH64(keys, sizeof(int) * 3, 0);
+}
+
 template <>
 int64_t JitCodeKey<emb_seq_pool_attr_t>(const emb_seq_pool_attr_t& attr) {
   return attr.table_width;
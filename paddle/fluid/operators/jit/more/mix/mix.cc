@@ -13,6 +13,7 @@
  * limitations under the License. */
 
 #include "paddle/fluid/operators/jit/more/mix/mix.h"
+#include <vector>
 #include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/jit/registry.h"
 
@@ -84,6 +85,44 @@ void Softmax(const T* x, T* y, int n, int bs, int remain) {
   }
 }
 
+// out = softmax(alpha * q * k^T + bias_qk) * v
+// Both products go through the batched small gemm kernel, alpha is folded
+// into the transpose of k.
+void Attention(const T* q, const T* k, const T* v, const T* bias_qk, T* out,
+               const attention_attr_t* attr) {
+  const int seq_q = attr->seq_q;
+  const int seq_k = attr->seq_k;
+  const int d = attr->head_dim;
+  const T alpha = static_cast<T>(attr->alpha);
+  static thread_local std::vector<T> buffer;
+  buffer.resize(static_cast<size_t>(d * seq_k + seq_q * seq_k));
+  T* kt = buffer.data();
+  T* score = kt + d * seq_k;
+  for (int j = 0; j < seq_k; ++j) {
+    for (int h = 0; h < d; ++h) {
+      kt[h * seq_k + j] = alpha * k[j * d + h];
+    }
+  }
+
+  const batched_matmul_attr_t qk_attr(seq_q, seq_k, d);
+  const batched_matmul_attr_t sv_attr(seq_q, d, seq_k);
+  auto compute_qk =
+      KernelFuncs<BatchedMatMulTuple<T>, CPUPlace>::Cache().At(qk_attr);
+  auto compute_sv =
+      KernelFuncs<BatchedMatMulTuple<T>, CPUPlace>::Cache().At(sv_attr);
+  auto compute_softmax =
+      KernelFuncs<SoftmaxTuple<T>, CPUPlace>::Cache().At(seq_k);
+
+  compute_qk(q, kt, nullptr, score, &qk_attr);
+  if (bias_qk) {
+    auto compute_vadd =
+        KernelFuncs<VAddTuple<T>, CPUPlace>::Cache().At(seq_q * seq_k);
+    compute_vadd(bias_qk, score, score, seq_q * seq_k);
+  }
+  compute_softmax(score, score, seq_k, seq_q, 1);
+  compute_sv(score, v, nullptr, out, &sv_attr);
+}
+
 void (*getActFunc(KernelType type, int d))(const T*, T*, int) {  // NOLINT
   if (type == kVSigmoid) {
     return KernelFuncs<VSigmoidTuple<T>, CPUPlace>::Cache().At(d);
@@ -223,6 +262,10 @@ bool VTanhKernel::CanBeUsed(const int& d) const { return true; }
 
 bool SoftmaxKernel::CanBeUsed(const int& d) const { return true; }
 
+bool AttentionKernel::CanBeUsed(const attention_attr_t& attr) const {
+  return true;
+}
+
 bool LSTMCtHtKernel::CanBeUsed(const lstm_attr_t& attr) const { return true; }
 
 bool LSTMC1H1Kernel::CanBeUsed(const lstm_attr_t& attr) const { return true; }
@@ -247,6 +290,7 @@ namespace mix = paddle::operators::jit::more::mix;
 REGISTER_MORE_KERNEL(VSigmoid);
 REGISTER_MORE_KERNEL(VTanh);
 REGISTER_MORE_KERNEL(Softmax);
+REGISTER_MORE_KERNEL(Attention);
 REGISTER_MORE_KERNEL(LSTMCtHt);
 REGISTER_MORE_KERNEL(LSTMC1H1);
 REGISTER_MORE_KERNEL(GRUH1);
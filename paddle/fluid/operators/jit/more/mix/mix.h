@@ -28,6 +28,8 @@ using T = float;
 void VSigmoid(const T* x, T* y, int n);
 void VTanh(const T* x, T* y, int n);
 void Softmax(const T* x, T* y, int n, int bs, int remain);
+void Attention(const T* q, const T* k, const T* v, const T* bias_qk, T* out,
+               const attention_attr_t* attr);
 
 void LSTMCtHt(lstm_t* step, const lstm_attr_t* attr);
 void LSTMC1H1(lstm_t* step, const lstm_attr_t* attr);
@@ -50,6 +52,8 @@ DECLARE_MORE_KERNEL(VTanh);
 // XRN
 DECLARE_MORE_KERNEL(Softmax);
 
+DECLARE_MORE_KERNEL(Attention);
+
 DECLARE_MORE_KERNEL(LSTMCtHt);
 DECLARE_MORE_KERNEL(LSTMC1H1);
 
@@ -255,6 +255,21 @@ bool MatMulKernel<double>::CanBeUsed(const matmul_attr_t& attr) const {
   return true;
 }
 
+template <>
+bool BatchedMatMulKernel<float>::CanBeUsed(
+    const batched_matmul_attr_t& attr) const {
+  return platform::MayIUse(platform::avx) &&
+         (attr.act == kVIdentity || attr.act == kVRelu ||
+          attr.act == kVSigmoid || attr.act == kVTanh);
+}
+
+template <>
+bool BatchedMatMulKernel<double>::CanBeUsed(
+    const batched_matmul_attr_t& attr) const {
+  return attr.act == kVIdentity || attr.act == kVRelu ||
+         attr.act == kVSigmoid || attr.act == kVTanh;
+}
+
 template <>
 bool SoftmaxKernel<float>::CanBeUsed(const int& d) const {
   // tuned on avx2
@@ -292,6 +307,7 @@ namespace mkl = paddle::operators::jit::more::mkl;
                           mkl::func##Kernel<double>)
 
 REGISTER_MKL_KERNEL(MatMul);
+REGISTER_MKL_KERNEL(BatchedMatMul);
 REGISTER_MKL_KERNEL(VMul);
 REGISTER_MKL_KERNEL(VAdd);
 REGISTER_MKL_KERNEL(VScal);
@@ -83,6 +83,36 @@ void VTanh(const T* x, T* y, int n) {
   }
 }
 
+template <typename T>
+void BatchedMatMul(const T* a, const T* b, const T* bias, T* c,
+                   const batched_matmul_attr_t* attr) {
+  const int m = attr->m;
+  const int n = attr->n;
+  const int k = attr->k;
+  const matmul_attr_t mm_attr(m, n, k);
+  for (int i = 0; i < attr->batch; ++i) {
+    MatMul<T>(a, b, c, &mm_attr);
+    if (attr->with_bias) {
+      for (int j = 0; j < m; ++j) {
+        VAdd<T>(bias, c + j * n, c + j * n, n);
+      }
+      bias += n;
+    }
+    if (attr->act == kVRelu) {
+      for (int j = 0; j < m * n; ++j) {
+        c[j] = c[j] > static_cast<T>(0) ? c[j] : static_cast<T>(0);
+      }
+    } else if (attr->act == kVSigmoid) {
+      VSigmoid<T>(c, c, m * n);
+    } else if (attr->act == kVTanh) {
+      VTanh<T>(c, c, m * n);
+    }
+    a += m * k;
+    b += k * n;
+    c += m * n;
+  }
+}
+
 template <typename T>
 void SeqPool(const T* x, T* y, const seq_pool_attr_t* attr) {
   VCopy<T>(x, y, attr->w);
@@ -243,6 +273,7 @@ void Sgd(const T* lr, const T* param, const T* grad, const int64_t* rows,
 
 // ABCMNK
 DECLARE_MKL_KERNEL(MatMul);
+DECLARE_MKL_KERNEL(BatchedMatMul);
 
 // XYZN
 DECLARE_MKL_KERNEL(VMul);
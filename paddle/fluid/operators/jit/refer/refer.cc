@@ -21,6 +21,12 @@ namespace refer = paddle::operators::jit::refer;
   REGISTER_JITKERNEL_REFER(k##func, refer::func##Kernel<float>, \
                            refer::func##Kernel<double>)
 
+// activation and seqpool kernels have bfloat16 versions as well
+#define REGISTER_REFER_KERNEL_WITH_BF16(func)                      \
+  REGISTER_JITKERNEL_REFER(k##func, refer::func##Kernel<float>,    \
+                           refer::func##Kernel<double>,            \
+                           refer::func##Kernel<paddle::platform::bfloat16>)
+
 REGISTER_REFER_KERNEL(VMul);
 REGISTER_REFER_KERNEL(VAdd);
 REGISTER_REFER_KERNEL(VAddRelu);
@@ -30,13 +36,13 @@ REGISTER_REFER_KERNEL(VScal);
 REGISTER_REFER_KERNEL(StrideScal);
 REGISTER_REFER_KERNEL(VAddBias);
 
-REGISTER_REFER_KERNEL(VRelu);
+REGISTER_REFER_KERNEL_WITH_BF16(VRelu);
 REGISTER_REFER_KERNEL(VCopy);
-REGISTER_REFER_KERNEL(VIdentity);
-REGISTER_REFER_KERNEL(VSquare);
-REGISTER_REFER_KERNEL(VExp);
-REGISTER_REFER_KERNEL(VSigmoid);
-REGISTER_REFER_KERNEL(VTanh);
+REGISTER_REFER_KERNEL_WITH_BF16(VIdentity);
+REGISTER_REFER_KERNEL_WITH_BF16(VSquare);
+REGISTER_REFER_KERNEL_WITH_BF16(VExp);
+REGISTER_REFER_KERNEL_WITH_BF16(VSigmoid);
+REGISTER_REFER_KERNEL_WITH_BF16(VTanh);
 
 REGISTER_REFER_KERNEL(LSTMCtHt);
 REGISTER_REFER_KERNEL(LSTMC1H1);
@@ -48,14 +54,17 @@ REGISTER_REFER_KERNEL(GRUHtPart2);
 REGISTER_REFER_KERNEL(CRFDecoding);
 REGISTER_REFER_KERNEL(LayerNorm);
 REGISTER_REFER_KERNEL(NCHW16CMulNC);
-REGISTER_REFER_KERNEL(SeqPool);
+REGISTER_REFER_KERNEL_WITH_BF16(SeqPool);
 REGISTER_REFER_KERNEL(MatMul);
+REGISTER_REFER_KERNEL(BatchedMatMul);
 REGISTER_REFER_KERNEL(HMax);
 REGISTER_REFER_KERNEL(HSum);
 REGISTER_REFER_KERNEL(StrideASum);
 REGISTER_REFER_KERNEL(Softmax);
+REGISTER_REFER_KERNEL(Attention);
 REGISTER_REFER_KERNEL(EmbSeqPool);
 REGISTER_REFER_KERNEL(Sgd);
 REGISTER_REFER_KERNEL(VBroadcast);
 
 #undef REGISTER_REFER_KERNEL
+#undef REGISTER_REFER_KERNEL_WITH_BF16
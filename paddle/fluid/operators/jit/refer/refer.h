@@ -17,9 +17,11 @@
 #include <cmath>
 #include <limits>
 #include <string>
+#include <vector>
 
 #include "paddle/fluid/operators/jit/helper.h"
 #include "paddle/fluid/operators/jit/kernel_base.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/enforce.h"
 
 namespace paddle {
@@ -397,6 +399,33 @@ void MatMul(const T* A, const T* B, T* C, const matmul_attr_t* attr) {
   }
 }
 
+// A(batch, M, K) * B(batch, K, N) + bias(batch, N) = C(batch, M, N)
+template <typename T>
+void BatchedMatMul(const T* A, const T* B, const T* bias, T* C,
+                   const batched_matmul_attr_t* attr) {
+  const int M = attr->m;
+  const int N = attr->n;
+  const int K = attr->k;
+  auto act = getActFunc<T>(attr->act);
+  matmul_attr_t mm_attr(M, N, K);
+  for (int i = 0; i < attr->batch; ++i) {
+    MatMul<T>(A, B, C, &mm_attr);
+    for (int m = 0; m < M; ++m) {
+      T* pc = C + m * N;
+      if (attr->with_bias) {
+        VAdd<T>(bias, pc, pc, N);
+      }
+      act(pc, pc, N);
+    }
+    A += M * K;
+    B += K * N;
+    C += M * N;
+    if (attr->with_bias) {
+      bias += N;
+    }
+  }
+}
+
 template <typename T>
 void HMax(const T* x, T* res, int n) {
   res[0] = x[0];
@@ -459,6 +488,43 @@ void Softmax(const T* x, T* y, int n, int bs = 1, int remain = 1) {
   }
 }
 
+// out = softmax(alpha * q * k^T + bias_qk) * v
+// q is (seq_q, d), k and v are (seq_k, d), bias_qk is (seq_q, seq_k)
+template <typename T>
+void Attention(const T* q, const T* k, const T* v, const T* bias_qk, T* out,
+               const attention_attr_t* attr) {
+  const int seq_q = attr->seq_q;
+  const int seq_k = attr->seq_k;
+  const int d = attr->head_dim;
+  const T alpha = static_cast<T>(attr->alpha);
+  std::vector<T> score(seq_k);
+  for (int i = 0; i < seq_q; ++i) {
+    const T* pq = q + i * d;
+    for (int j = 0; j < seq_k; ++j) {
+      const T* pk = k + j * d;
+      T sum = static_cast<T>(0);
+      for (int h = 0; h < d; ++h) {
+        sum += pq[h] * pk[h];
+      }
+      score[j] = alpha * sum;
+      if (bias_qk) {
+        score[j] += bias_qk[i * seq_k + j];
+      }
+    }
+    Softmax<T>(score.data(), score.data(), seq_k);
+    T* po = out + i * d;
+    for (int h = 0; h < d; ++h) {
+      po[h] = static_cast<T>(0);
+    }
+    for (int j = 0; j < seq_k; ++j) {
+      const T* pv = v + j * d;
+      for (int h = 0; h < d; ++h) {
+        po[h] += score[j] * pv[h];
+      }
+    }
+  }
+}
+
 // embedding seq pool
 // table is a matrix with (tbl_h, tbl_w)
 // idx is a matrix with (idx_h, idx_w)
@@ -552,6 +618,56 @@ void Sgd(const T* lr, const T* param, const T* grad, const int64_t* rows,
   }
 }
 
+// bfloat16 kernels compute in float and truncate back when saving,
+// which is the same as the conversion of platform::bfloat16.
+inline void BF16ToFloat(const platform::bfloat16* x, float* y, int n) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = static_cast<float>(x[i]);
+  }
+}
+
+inline void FloatToBF16(const float* x, platform::bfloat16* y, int n) {
+  for (int i = 0; i < n; ++i) {
+    y[i] = static_cast<platform::bfloat16>(x[i]);
+  }
+}
+
+inline void BF16XYN(void (*func)(const float*, float*, int),
+                    const platform::bfloat16* x, platform::bfloat16* y,
+                    int n) {
+  std::vector<float> buf(n);
+  BF16ToFloat(x, buf.data(), n);
+  func(buf.data(), buf.data(), n);
+  FloatToBF16(buf.data(), y, n);
+}
+
+#define DEFINE_BF16_XYN_KERNEL(name)                                   \
+  template <>                                                          \
+  inline void name<platform::bfloat16>(const platform::bfloat16* x,    \
+                                       platform::bfloat16* y, int n) { \
+    BF16XYN(name<float>, x, y, n);                                     \
+  }
+
+DEFINE_BF16_XYN_KERNEL(VRelu);
+DEFINE_BF16_XYN_KERNEL(VIdentity);
+DEFINE_BF16_XYN_KERNEL(VSquare);
+DEFINE_BF16_XYN_KERNEL(VExp);
+DEFINE_BF16_XYN_KERNEL(VSigmoid);
+DEFINE_BF16_XYN_KERNEL(VTanh);
+
+#undef DEFINE_BF16_XYN_KERNEL
+
+template <>
+inline void SeqPool<platform::bfloat16>(const platform::bfloat16* x,
+                                        platform::bfloat16* y,
+                                        const seq_pool_attr_t* attr) {
+  std::vector<float> src(attr->h * attr->w);
+  std::vector<float> dst(attr->w);
+  BF16ToFloat(x, src.data(), attr->h * attr->w);
+  SeqPool<float>(src.data(), dst.data(), attr);
+  FloatToBF16(dst.data(), y, attr->w);
+}
+
 #define DECLARE_REFER_KERNEL(name)                          \
   template <typename T>                                     \
   class name##Kernel : public ReferKernel<name##Tuple<T>> { \
@@ -601,7 +717,9 @@ DECLARE_REFER_KERNEL(LayerNorm);
 DECLARE_REFER_KERNEL(NCHW16CMulNC);
 DECLARE_REFER_KERNEL(SeqPool);
 DECLARE_REFER_KERNEL(MatMul);
+DECLARE_REFER_KERNEL(BatchedMatMul);
 DECLARE_REFER_KERNEL(Softmax);
+DECLARE_REFER_KERNEL(Attention);
 DECLARE_REFER_KERNEL(EmbSeqPool);
 DECLARE_REFER_KERNEL(Sgd);
 DECLARE_REFER_KERNEL(VBroadcast);
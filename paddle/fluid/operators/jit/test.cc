@@ -12,13 +12,19 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License. */
 
+#include <cstring>
 #include <iostream>
 #include <random>
+#include <string>
+#include <vector>
 
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/commit.h"
+#include "paddle/fluid/operators/jit/jitcode_cache.h"
 #include "paddle/fluid/operators/jit/kernels.h"
+#include "paddle/fluid/platform/bfloat16.h"
 #include "paddle/fluid/platform/cpu_info.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -35,6 +41,19 @@ void RandomVec(const int n, T* a, const T lower = static_cast<T>(-2.f),
   }
 }
 
+template <>
+void RandomVec<paddle::platform::bfloat16>(
+    const int n, paddle::platform::bfloat16* a,
+    const paddle::platform::bfloat16 lower,
+    const paddle::platform::bfloat16 upper) {
+  std::vector<float> buf(n);
+  RandomVec<float>(n, buf.data(), static_cast<float>(lower),
+                   static_cast<float>(upper));
+  for (int i = 0; i < n; ++i) {
+    a[i] = static_cast<paddle::platform::bfloat16>(buf[i]);
+  }
+}
+
 template <typename T>
 void ExpectEQ(const T* target, const T* refer, size_t n) {
   if (std::is_floating_point<T>::value) {
@@ -48,6 +67,19 @@ void ExpectEQ(const T* target, const T* refer, size_t n) {
   }
 }
 
+// bfloat16 only has 8 bits mantissa, and may be rounded or truncated
+template <>
+void ExpectEQ<paddle::platform::bfloat16>(
+    const paddle::platform::bfloat16* target,
+    const paddle::platform::bfloat16* refer, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    float ref = static_cast<float>(refer[i]);
+    float acc = std::max(std::abs(ref) * 1e-2f, static_cast<float>(FLAGS_acc));
+    EXPECT_NEAR(static_cast<float>(target[i]), ref, acc)
+        << " at index : " << i;
+  }
+}
+
 std::vector<int> TestSizes() {
   std::vector<int> s;
   for (int i = 1; i < 32; ++i) {
@@ -715,6 +747,91 @@ void TestKernelMatMul() {
   FLAGS_acc = last_acc;
 }
 
+template <typename KernelTuple, typename PlaceType>
+void TestKernelBatchedMatMul() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  auto last_acc = FLAGS_acc;
+  FLAGS_acc = 1e-3;
+  for (int batch : {1, 3}) {
+    for (int m : {1, 2, 7, 13}) {
+      for (int n : {3, 8, 24, 40, 64}) {
+        for (int k : {1, 5, 16, 100}) {
+          for (bool with_bias : {false, true}) {
+            for (auto act : {jit::kVIdentity, jit::kVRelu}) {
+              auto ref = jit::GetReferFunc<KernelTuple>();
+              EXPECT_TRUE(ref != nullptr);
+              std::vector<T> a(batch * m * k), b(batch * k * n),
+                  bias(batch * n), c(batch * m * n);
+              RandomVec<T>(a.size(), a.data());
+              RandomVec<T>(b.size(), b.data());
+              RandomVec<T>(bias.size(), bias.data());
+              const jit::batched_matmul_attr_t attr(m, n, k, batch, with_bias,
+                                                    act);
+              ref(a.data(), b.data(), bias.data(), c.data(), &attr);
+              auto verifier = [](
+                  const typename KernelTuple::func_type tgt,
+                  const std::vector<T>& a, const std::vector<T>& b,
+                  const std::vector<T>& bias, const std::vector<T>& cref,
+                  const typename KernelTuple::attr_type& attr) {
+                EXPECT_TRUE(tgt != nullptr);
+                EXPECT_EQ(cref.size(),
+                          static_cast<size_t>(attr.batch * attr.m * attr.n));
+                std::vector<T> c(cref.size());
+                tgt(a.data(), b.data(), bias.data(), c.data(), &attr);
+                ExpectEQ<T>(c.data(), cref.data(), cref.size());
+              };
+              TestAllImpls<KernelTuple, PlaceType>(attr, verifier, a, b, bias,
+                                                   c, attr);
+            }
+          }
+        }
+      }
+    }
+  }
+  FLAGS_acc = last_acc;
+}
+
+template <typename KernelTuple, typename PlaceType>
+void TestKernelAttention() {
+  using T = typename KernelTuple::data_type;
+  VLOG(10) << "Test JITKernel: " << jit::to_string(KernelTuple::kernel_type);
+  auto last_acc = FLAGS_acc;
+  FLAGS_acc = 1e-3;
+  for (int seq_q : {1, 5, 32}) {
+    for (int seq_k : {1, 7, 32}) {
+      for (int d : {8, 13, 64}) {
+        for (bool with_bias : {false, true}) {
+          auto ref = jit::GetReferFunc<KernelTuple>();
+          EXPECT_TRUE(ref != nullptr);
+          std::vector<T> q(seq_q * d), k(seq_k * d), v(seq_k * d),
+              bias_qk(seq_q * seq_k), out(seq_q * d);
+          RandomVec<T>(q.size(), q.data());
+          RandomVec<T>(k.size(), k.data());
+          RandomVec<T>(v.size(), v.data());
+          RandomVec<T>(bias_qk.size(), bias_qk.data());
+          const T* bias_data = with_bias ? bias_qk.data() : nullptr;
+          const jit::attention_attr_t attr(seq_q, seq_k, d, 0.125f);
+          ref(q.data(), k.data(), v.data(), bias_data, out.data(), &attr);
+          auto verifier = [](const typename KernelTuple::func_type tgt,
+                             const std::vector<T>& q, const std::vector<T>& k,
+                             const std::vector<T>& v, const T* bias_data,
+                             const std::vector<T>& outref,
+                             const typename KernelTuple::attr_type& attr) {
+            EXPECT_TRUE(tgt != nullptr);
+            std::vector<T> out(outref.size());
+            tgt(q.data(), k.data(), v.data(), bias_data, out.data(), &attr);
+            ExpectEQ<T>(out.data(), outref.data(), outref.size());
+          };
+          TestAllImpls<KernelTuple, PlaceType>(attr, verifier, q, k, v,
+                                               bias_data, out, attr);
+        }
+      }
+    }
+  }
+  FLAGS_acc = last_acc;
+}
+
 template <typename KernelTuple, typename PlaceType>
 void TestKernelSoftmax() {
   using T = typename KernelTuple::data_type;
@@ -980,7 +1097,7 @@ TEST(JITKernel_pool, jitcreator) {
 #if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
   EXPECT_EQ(jitcreators.size(), 0UL);
 #else
-  EXPECT_EQ(jitcreators.size(), 25UL);
+  EXPECT_EQ(jitcreators.size(), 26UL);
 #endif
 }
 
@@ -999,14 +1116,14 @@ TEST(JITKernel_pool, jitpool) {
 
 TEST(JITKernel_pool, more) {
   const auto& kers = jit::KernelPool::Instance().AllKernels();
-  size_t target_num = 8;
+  size_t target_num = 9;
 
 #ifdef __AVX__
   target_num += 2;
 #endif
 
 #ifdef PADDLE_WITH_MKLML
-  target_num += 12;
+  target_num += 13;
 #endif
 
   EXPECT_EQ(kers.size(), target_num);
@@ -1014,7 +1131,7 @@ TEST(JITKernel_pool, more) {
 
 TEST(JITKernel_pool, refer) {
   const auto& kers = jit::ReferKernelPool::Instance().AllKernels();
-  EXPECT_EQ(kers.size(), 31UL);
+  EXPECT_EQ(kers.size(), 33UL);
 }
 
 // test helper
@@ -1080,6 +1197,33 @@ TEST(JITKernel_helper, KernelFuncs) {
 #endif
 }
 
+TEST(JITKernel_helper, GetNonReferFunc) {
+  using paddle::platform::MayIUse;
+  using paddle::platform::avx;
+#if defined(_WIN32) || defined(__APPLE__) || defined(__OSX__)
+  bool has_jitcode = false;
+#else
+  bool has_jitcode = MayIUse(avx);
+#endif
+#ifdef PADDLE_WITH_MKLML
+  bool has_mkl = MayIUse(avx);
+#else
+  bool has_mkl = false;
+#endif
+  using Tuple = jit::BatchedMatMulTuple<float>;
+  jit::batched_matmul_attr_t small(64, 64, 64);
+  auto f1 = jit::GetNonReferFunc<Tuple>(small);
+  EXPECT_EQ(f1 != nullptr, has_jitcode || has_mkl);
+
+  // the jitcode refuses m > 128 and n not a multiple of 8
+  jit::batched_matmul_attr_t large_m(256, 64, 64);
+  auto f2 = jit::GetNonReferFunc<Tuple>(large_m);
+  EXPECT_EQ(f2 != nullptr, has_mkl);
+  jit::batched_matmul_attr_t odd_n(64, 60, 64);
+  auto f3 = jit::GetNonReferFunc<Tuple>(odd_n);
+  EXPECT_EQ(f3 != nullptr, has_mkl);
+}
+
 TEST(JITKernel_helper, GetAllCandidateFuncs) {
   auto funcs = jit::GetAllCandidateFuncs<jit::VExpTuple<float>, CPUPlace>(10);
   auto kers = jit::GetAllCandidateKernels<jit::VExpTuple<float>, CPUPlace>(10);
@@ -1148,8 +1292,9 @@ TEST(JITKernel_helper, attr) {
       << jit::to_string(jit::kVMul) << jit::to_string(jit::kVRelu)
       << jit::to_string(jit::kVScal) << jit::to_string(jit::kSgd)
       << jit::to_string(jit::kVSigmoid) << jit::to_string(jit::kVSquare)
-      << jit::to_string(jit::kVSub) << jit::to_string(jit::kVTanh);
-  EXPECT_EQ(out.str().size(), 234UL);
+      << jit::to_string(jit::kVSub) << jit::to_string(jit::kVTanh)
+      << jit::to_string(jit::kBatchedMatMul) << jit::to_string(jit::kAttention);
+  EXPECT_EQ(out.str().size(), 258UL);
 
   // SeqPoolTypes
   out.str("");
@@ -1186,6 +1331,10 @@ TEST(JITKernel_helper, attr) {
   out.str("");
   out << jit::matmul_attr_t(1, 2, 3);
   EXPECT_EQ(out.str().size(), 14UL);
+
+  out.str("");
+  out << jit::batched_matmul_attr_t(1, 2, 3, 4, true, jit::kVRelu);
+  EXPECT_EQ(out.str().size(), 51UL);
 }
 
 // test keys
@@ -1276,6 +1425,25 @@ TEST(JITKernel_key, matmul) {
   EXPECT_TRUE(key3 != key4);
 }
 
+TEST(JITKernel_key, batched_matmul) {
+  jit::batched_matmul_attr_t attr1(1, 8, 3, 2);
+  jit::batched_matmul_attr_t attr2(1, 8, 3, 5);
+  jit::batched_matmul_attr_t attr3(1, 8, 3, 2, true);
+  jit::batched_matmul_attr_t attr4(1, 8, 3, 2, true, jit::kVRelu);
+  jit::batched_matmul_attr_t attr5(2, 8, 3, 2, true, jit::kVRelu);
+
+  auto key1 = jit::JitCodeKey<jit::batched_matmul_attr_t>(attr1);
+  auto key2 = jit::JitCodeKey<jit::batched_matmul_attr_t>(attr2);
+  auto key3 = jit::JitCodeKey<jit::batched_matmul_attr_t>(attr3);
+  auto key4 = jit::JitCodeKey<jit::batched_matmul_attr_t>(attr4);
+  auto key5 = jit::JitCodeKey<jit::batched_matmul_attr_t>(attr5);
+
+  EXPECT_TRUE(key1 == key2);
+  EXPECT_TRUE(key2 != key3);
+  EXPECT_TRUE(key3 != key4);
+  EXPECT_TRUE(key4 != key5);
+}
+
 TEST(JITKernel_key, emb_seq_pool) {
   jit::emb_seq_pool_attr_t attr1(1, 2, 3, 4, 5, jit::SeqPoolType::kSum);
   jit::emb_seq_pool_attr_t attr2(1, 2, 3, 4, 5, jit::SeqPoolType::kSum);
@@ -1316,6 +1484,70 @@ TEST(JITKernel_key, sgd) {
   EXPECT_TRUE(key4 != key5);
 }
 
+#ifndef _WIN32
+namespace {
+
+const int jitcode_test_symbol[1] = {0};
+REGISTER_JITCODE_SYMBOL(jitcode_test_symbol);
+
+// movabs rax, imm64; ret
+class FakeJitCode : public jit::GenBase {
+ public:
+  FakeJitCode(const void* addr, bool relocatable)
+      : code_({0x48, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0xC3}),
+        relocatable_(relocatable) {
+    uint64_t value = reinterpret_cast<uint64_t>(addr);
+    std::memcpy(code_.data() + 2, &value, sizeof(value));
+  }
+  std::string name() const override { return "FakeJitCode"; }
+  size_t getSize() const override { return code_.size(); }
+  const unsigned char* getCodeInternal() const override {
+    return code_.data();
+  }
+  bool relocatable() const override { return relocatable_; }
+  std::vector<jit::JitCodeReloc> relocations() const override {
+    return {{2, "jitcode_test_symbol"}};
+  }
+
+ private:
+  std::vector<unsigned char> code_;
+  bool relocatable_;
+};
+
+}  // namespace
+
+TEST(JITKernel_cache, disk) {
+  char dir[] = "/tmp/jitcode_cache_test_XXXXXX";
+  ASSERT_TRUE(mkdtemp(dir) != nullptr);
+  auto old_dir = FLAGS_jitcode_cache_dir;
+  FLAGS_jitcode_cache_dir = dir;
+  auto& cache = jit::JitCodeDiskCache::Instance();
+  ASSERT_TRUE(cache.Enabled());
+
+  auto key = cache.Key(jit::kVExp, "f", "FakeCreator", 8);
+  // keyed by the build, so the code cached by the other builds is not loaded
+  EXPECT_NE(key.find(paddle::framework::paddle_commit() + "_" +
+                     std::to_string(jit::kJitCodeGeneratorVersion)),
+            std::string::npos);
+  EXPECT_TRUE(cache.Load(key) == nullptr);
+  // the saved address is replaced by the registered one when loading
+  cache.Save(key, FakeJitCode(nullptr, true));
+  auto code = cache.Load(key);
+  ASSERT_TRUE(code != nullptr);
+  EXPECT_EQ(code->name(), "FakeJitCode");
+  EXPECT_EQ(code->getSize(), 11UL);
+  auto func = code->getCode<const void* (*)()>();
+  EXPECT_EQ(func(), static_cast<const void*>(jitcode_test_symbol));
+
+  EXPECT_TRUE(cache.Load(cache.Key(jit::kVExp, "f", "FakeCreator", 9)) ==
+              nullptr);
+  auto key2 = cache.Key(jit::kVExp, "f", "FakeCreator", 10);
+  cache.Save(key2, FakeJitCode(jitcode_test_symbol, false));
+  EXPECT_TRUE(cache.Load(key2) == nullptr);
+  FLAGS_jitcode_cache_dir = old_dir;
+}
+#endif
+
 // test kernerls
 #define TestKernelVMul TestKernelXYZN
 #define TestKernelVAdd TestKernelXYZN
@@ -1382,9 +1614,25 @@ TEST_CPU_KERNEL(CRFDecoding);
 TEST_CPU_KERNEL(SeqPool);
 TEST_CPU_KERNEL(EmbSeqPool);
 TEST_CPU_KERNEL(MatMul);
+TEST_CPU_KERNEL(BatchedMatMul);
 TEST_CPU_KERNEL(Softmax);
+TEST_CPU_KERNEL(Attention);
 TEST_CPU_KERNEL(Sgd);
 TEST_CPU_KERNEL(VBroadcast);
 
 TEST_CPU_KERNEL(StrideASum);
 TEST_CPU_KERNEL(StrideScal);
+
+#define TEST_CPU_BF16_KERNEL(kernel_type)                                 \
+  TEST(JITKernel, kernel_type##BF16) {                                    \
+    TestKernel##kernel_type<                                              \
+        jit::kernel_type##Tuple<paddle::platform::bfloat16>, CPUPlace>(); \
+  }
+
+TEST_CPU_BF16_KERNEL(VRelu);
+TEST_CPU_BF16_KERNEL(VIdentity);
+TEST_CPU_BF16_KERNEL(VSquare);
+TEST_CPU_BF16_KERNEL(VExp);
+TEST_CPU_BF16_KERNEL(VSigmoid);
+TEST_CPU_BF16_KERNEL(VTanh);
+TEST_CPU_BF16_KERNEL(SeqPool);
@@ -20,7 +20,9 @@ limitations under the License. */
 
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
+#include "paddle/fluid/framework/mmap_params.h"
 #include "paddle/fluid/framework/op_registry.h"
+#include "paddle/fluid/memory/malloc.h"
 #include "paddle/fluid/platform/device_context.h"
 
 namespace paddle {
@@ -40,7 +42,14 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
                           "The number of variables to be loaded is %d, expect "
                           "it to be greater than 0.",
                           out_var_names.size()));
-    if (!model_from_memory) {
+    if (!model_from_memory && framework::IsMmapParamsFile(filename)) {
+      LoadMmapParams(ctx, place, filename, nullptr, load_as_fp16,
+                     out_var_names);
+    } else if (model_from_memory && framework::IsMmapParamsBuffer(filename)) {
+      auto buffer = memory::AllocShared(platform::CPUPlace(), filename.size());
+      memcpy(buffer->ptr(), filename.data(), filename.size());
+      LoadMmapParams(ctx, place, filename, buffer, load_as_fp16, out_var_names);
+    } else if (!model_from_memory) {
       std::ifstream fin(filename, std::ios::binary);
       PADDLE_ENFORCE_EQ(
           static_cast<bool>(fin), true,
@@ -61,6 +70,58 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
     }
   }
 
+  // Load the parameters in mmap format, the CPU tensors share the memory of
+  // the mapped file, or of the buffer if it is not nullptr.
+  void LoadMmapParams(const framework::ExecutionContext &context,
+                      const platform::Place &place, const std::string &filename,
+                      std::shared_ptr<memory::Allocation> buffer,
+                      bool load_as_fp16,
+                      const std::vector<std::string> &out_var_names) const {
+    auto out_vars = context.MultiOutputVar("Out");
+    std::vector<framework::LoDTensor *> tensors;
+    for (size_t i = 0; i < out_var_names.size(); i++) {
+      PADDLE_ENFORCE_NOT_NULL(
+          out_vars[i], platform::errors::InvalidArgument(
+                           "The variable %s to be loaded cannot be found.",
+                           out_var_names[i]));
+      tensors.push_back(out_vars[i]->GetMutable<framework::LoDTensor>());
+    }
+    if (buffer) {
+      framework::LoadMmapParams(buffer, tensors, place);
+    } else {
+      framework::LoadMmapParams(filename, tensors, place);
+    }
+    if (load_as_fp16) {
+      for (auto *var : out_vars) {
+        CastToFP16(place, var);
+      }
+    }
+  }
+
+  void CastToFP16(const platform::Place &place,
+                  framework::Variable *var) const {
+    auto *tensor = var->GetMutable<framework::LoDTensor>();
+    auto in_dtype = tensor->type();
+    auto out_dtype = framework::proto::VarType::FP16;
+
+    if (in_dtype != out_dtype) {
+      // convert to float16 tensor
+      auto in_kernel_type = framework::OpKernelType(in_dtype, place);
+      auto out_kernel_type = framework::OpKernelType(out_dtype, place);
+      framework::LoDTensor fp16_tensor;
+      // copy LoD info to the new tensor
+      fp16_tensor.set_lod(tensor->lod());
+      framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
+                               &fp16_tensor);
+
+      // reset output tensor
+      var->Clear();
+      tensor = var->GetMutable<framework::LoDTensor>();
+      tensor->set_lod(fp16_tensor.lod());
+      tensor->ShareDataWith(fp16_tensor);
+    }
+  }
+
   void LoadParamsFromBuffer(
       const framework::ExecutionContext &context, const platform::Place &place,
       std::istream *buffer, bool load_as_fp16,
@@ -88,25 +149,8 @@ class LoadCombineOpKernel : public framework::OpKernel<T> {
       // Get data from fin to tensor
       DeserializeFromStream(*buffer, tensor, dev_ctx);
 
-      auto in_dtype = tensor->type();
-      auto out_dtype =
-          load_as_fp16 ? framework::proto::VarType::FP16 : in_dtype;
-
-      if (in_dtype != out_dtype) {
-        // convert to float16 tensor
-        auto in_kernel_type = framework::OpKernelType(in_dtype, place);
-        auto out_kernel_type = framework::OpKernelType(out_dtype, place);
-        framework::LoDTensor fp16_tensor;
-        // copy LoD info to the new tensor
-        fp16_tensor.set_lod(tensor->lod());
-        framework::TransDataType(in_kernel_type, out_kernel_type, *tensor,
-                                 &fp16_tensor);
-
-        // reset output tensor
-        out_vars[i]->Clear();
-        tensor = out_vars[i]->GetMutable<framework::LoDTensor>();
-        tensor->set_lod(fp16_tensor.lod());
-        tensor->ShareDataWith(fp16_tensor);
+      if (load_as_fp16) {
+        CastToFP16(place, out_vars[i]);
       }
     }
     buffer->peek();
@@ -17,6 +17,7 @@ limitations under the License. */
 #include <vector>
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/fluid/operators/jit/kernels.h"
 #include "paddle/fluid/operators/math/blas.h"
 #ifdef PADDLE_WITH_MKLDNN
 #include "paddle/fluid/platform/mkldnn_helper.h"
@@ -57,6 +58,63 @@ static framework::DDim ColumnMatrixFromVector(const framework::DDim &y_dim) {
   return framework::make_ddim({y_dim[0], 1});
 }
 
+/**
+ * Small gemms (N, K <= 128) are dominated by the BLAS call overhead on CPU,
+ * they are computed by the jit batched matmul kernel instead. Return false if
+ * the shapes are not supported or only the refer kernel can compute them, and
+ * BLAS should be used.
+ */
+template <typename DeviceContext, typename T>
+struct SmallMatMulFunctor {
+  bool operator()(const framework::Tensor &x,
+                  const math::MatDescriptor &mat_dim_a,
+                  const framework::Tensor &y,
+                  const math::MatDescriptor &mat_dim_b, T alpha,
+                  framework::Tensor *out) const {
+    return false;
+  }
+};
+
+template <>
+struct SmallMatMulFunctor<platform::CPUDeviceContext, float> {
+  bool operator()(const framework::Tensor &x,
+                  const math::MatDescriptor &mat_dim_a,
+                  const framework::Tensor &y,
+                  const math::MatDescriptor &mat_dim_b, float alpha,
+                  framework::Tensor *out) const {
+    if (mat_dim_a.trans_ || mat_dim_b.trans_ || alpha != 1.f) {
+      return false;
+    }
+    if (mat_dim_b.width_ > 128 || mat_dim_a.width_ > 128 ||
+        x.numel() == 0 || y.numel() == 0) {
+      return false;
+    }
+    int64_t m = mat_dim_a.height_;
+    int64_t batch = 1;
+    if (mat_dim_b.batch_size_ == 0) {
+      // Y is shared by all batches of X, fold the batches into rows
+      m *= std::max<int64_t>(mat_dim_a.batch_size_, 1);
+    } else if (mat_dim_a.batch_size_ == mat_dim_b.batch_size_) {
+      batch = mat_dim_a.batch_size_;
+    } else {
+      return false;
+    }
+    const jit::batched_matmul_attr_t attr(
+        static_cast<int>(m), static_cast<int>(mat_dim_b.width_),
+        static_cast<int>(mat_dim_a.width_), static_cast<int>(batch));
+    // The jitcode refuses the large m and the n not a multiple of 8, and the
+    // MKL kernel is not built everywhere. The refer loops are far slower than
+    // BLAS for them.
+    auto compute = jit::GetNonReferFunc<jit::BatchedMatMulTuple<float>>(attr);
+    if (compute == nullptr) {
+      return false;
+    }
+    compute(x.data<float>(), y.data<float>(), nullptr, out->data<float>(),
+            &attr);
+    return true;
+  }
+};
+
 template <typename DeviceContext, typename T>
 class MatMulKernel : public framework::OpKernel<T> {
  public:
@@ -90,6 +148,10 @@ class MatMulKernel : public framework::OpKernel<T> {
         mat_dim_a.batch_size_ = 0;
       }
     }
+    if (head_number <= 1 && SmallMatMulFunctor<DeviceContext, T>()(
+                                x, mat_dim_a, y, mat_dim_b, scale, out)) {
+      return;
+    }
 #if defined(PADDLE_WITH_MKLML) && !defined(PADDLE_WITH_CUDA) && \
     !defined(PADDLE_WITH_HIP)
     bool split_vertical_y = (mat_dim_a.width_ != mat_dim_b.height_);
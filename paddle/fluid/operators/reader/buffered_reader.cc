@@ -13,6 +13,9 @@
 // limitations under the License.
 
 #include "paddle/fluid/operators/reader/buffered_reader.h"
+
+#include <algorithm>
+
 #include "paddle/fluid/platform/profiler.h"
 
 namespace paddle {
@@ -32,12 +35,16 @@ BufferedReader::~BufferedReader() {
 
 BufferedReader::BufferedReader(
     const std::shared_ptr<framework::ReaderBase> &reader,
-    const platform::Place &place, size_t buffer_size, bool pin_memory)
+    const platform::Place &place, size_t buffer_size, bool pin_memory,
+    size_t batch_size)
     : framework::DecoratedReader(reader),
-      thread_pool_(1),
+      thread_pool_(batch_size > 1 && platform::is_cpu_place(place)
+                       ? buffer_size
+                       : 1),
       place_(place),
       buffer_size_(buffer_size),
-      pin_memory_(pin_memory) {
+      pin_memory_(pin_memory),
+      batch_size_(batch_size) {
   VLOG(1) << "BufferedReader";
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   if (platform::is_gpu_place(place_) && !pin_memory) {
@@ -80,10 +87,134 @@ void BufferedReader::ReadTillBufferFullAsync() {
   }
 }
 
+void BufferedReader::ReadBatch(size_t seq, TensorVec *batch) {
+  std::vector<TensorVec> samples;
+  samples.reserve(batch_size_);
+  {
+    std::unique_lock<std::mutex> lock(sample_mutex_);
+    sample_cv_.wait(lock, [this, seq] { return sample_seq_ == seq; });
+  }
+  // Let the next batch read its samples, even if the reading fails.
+  auto next_batch = [this] {
+    {
+      std::lock_guard<std::mutex> guard(sample_mutex_);
+      ++sample_seq_;
+    }
+    sample_cv_.notify_all();
+  };
+  try {
+    for (size_t k = 0; k < batch_size_; ++k) {
+      samples.emplace_back();
+      reader_->ReadNext(&samples.back());
+      if (samples.back().empty()) {
+        samples.pop_back();
+        break;
+      }
+    }
+  } catch (...) {
+    next_batch();
+    throw;
+  }
+  next_batch();
+
+  if (samples.empty()) {
+    batch->clear();
+    return;
+  }
+
+  platform::RecordEvent record_event("BufferedReader:AssembleBatch");
+  size_t num_slots = samples[0].size();
+  batch->resize(num_slots);
+  for (size_t j = 0; j < num_slots; ++j) {
+    const auto &first = samples[0][j];
+    auto first_dims = framework::vectorize(first.dims());
+    size_t num_levels = first.lod().size();
+    framework::LoD lod(num_levels);
+    for (auto &level : lod) {
+      level.push_back(0);
+    }
+    int64_t rows = 0;
+    for (size_t k = 0; k < samples.size(); ++k) {
+      PADDLE_ENFORCE_EQ(samples[k].size(), num_slots,
+                        platform::errors::InvalidArgument(
+                            "The sample %d of the batch has %d tensors, but "
+                            "the first sample has %d.",
+                            k, samples[k].size(), num_slots));
+      const auto &sample = samples[k][j];
+      PADDLE_ENFORCE_EQ(
+          platform::is_cpu_place(sample.place()), true,
+          platform::errors::InvalidArgument(
+              "The samples assembled into batches must be on CPUPlace."));
+      PADDLE_ENFORCE_EQ(sample.type(), first.type(),
+                        platform::errors::InvalidArgument(
+                            "The tensor %d of the sample %d has a data type "
+                            "different from the first sample.",
+                            j, k));
+      PADDLE_ENFORCE_EQ(sample.lod().size(), num_levels,
+                        platform::errors::InvalidArgument(
+                            "The tensor %d of the sample %d has %d LoD "
+                            "levels, but the first sample has %d.",
+                            j, k, sample.lod().size(), num_levels));
+      auto dims = framework::vectorize(sample.dims());
+      if (num_levels == 0) {
+        PADDLE_ENFORCE_EQ(dims == first_dims, true,
+                          platform::errors::InvalidArgument(
+                              "The tensor %d of the sample %d has dims [%s], "
+                              "which can not be stacked with [%s].",
+                              j, k, sample.dims(), first.dims()));
+        continue;
+      }
+      PADDLE_ENFORCE_EQ(
+          dims.size() == first_dims.size() &&
+              std::equal(dims.begin() + 1, dims.end(), first_dims.begin() + 1),
+          true, platform::errors::InvalidArgument(
+                    "The tensor %d of the sample %d has dims [%s], which can "
+                    "not be concatenated with [%s].",
+                    j, k, sample.dims(), first.dims()));
+      rows += dims[0];
+      for (size_t level = 0; level < num_levels; ++level) {
+        size_t base = lod[level].back();
+        const auto &sample_level = sample.lod()[level];
+        for (size_t idx = 1; idx < sample_level.size(); ++idx) {
+          lod[level].push_back(base + sample_level[idx]);
+        }
+      }
+    }
+
+    auto &dst = (*batch)[j];
+    // The memory of the former batch is reused unless the trainer holds it.
+    if (dst.IsInitialized() && dst.Holder().use_count() > 1) {
+      dst = framework::LoDTensor();
+    }
+    if (num_levels == 0) {
+      first_dims.insert(first_dims.begin(),
+                        static_cast<int64_t>(samples.size()));
+    } else {
+      first_dims[0] = rows;
+    }
+    dst.Resize(framework::make_ddim(first_dims));
+    dst.set_layout(first.layout());
+    dst.set_lod(lod);
+    auto *dst_ptr = static_cast<uint8_t *>(
+        dst.mutable_data(platform::CPUPlace(), first.type()));
+    for (auto &sample : samples) {
+      auto size = sample[j].numel() * framework::SizeOfType(sample[j].type());
+      memory::Copy(platform::CPUPlace(), dst_ptr, platform::CPUPlace(),
+                   sample[j].data<void>(), size);
+      dst_ptr += size;
+    }
+  }
+}
+
 void BufferedReader::ReadAsync(size_t i) {
-  position_.emplace(thread_pool_.enqueue([this, i]() -> size_t {
+  size_t seq = read_seq_++;
+  position_.emplace(thread_pool_.enqueue([this, i, seq]() -> size_t {
     TensorVec &cpu = cpu_buffer_[i];
-    reader_->ReadNext(&cpu);
+    if (batch_size_ > 1) {
+      ReadBatch(seq, &cpu);
+    } else {
+      reader_->ReadNext(&cpu);
+    }
 
     if (cpu.empty()) {
       return -1UL;
@@ -275,6 +406,11 @@ void BufferedReader::ShutdownImpl() {
   VLOG(1) << "ShutdownImpl";
   reader_->Shutdown();
   while (!position_.empty()) {
+    // The reads of the former epoch must not write the buffer with the ones
+    // of the next epoch.
+    if (batch_size_ > 1 && position_.front().valid()) {
+      position_.front().wait();
+    }
     position_.pop();
   }
   prev_pos_ = -1UL;
@@ -302,6 +438,9 @@ void BufferedReader::ReadNextImpl(std::vector<framework::LoDTensor> *out) {
     *out = std::move(cuda_buffer_[i]);
   } else if (platform::is_npu_place(place_)) {
     *out = std::move(npu_buffer_[i]);
+  } else if (batch_size_ > 1) {
+    // Keep the batch to reuse its memory.
+    *out = cpu_buffer_[i];
   } else {
     *out = std::move(cpu_buffer_[i]);
   }
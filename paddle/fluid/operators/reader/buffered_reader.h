@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
 #include <list>
 #include <memory>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <vector>
 
@@ -33,6 +35,19 @@ namespace paddle {
 namespace operators {
 namespace reader {
 
+/*
+ * If batch_size > 1, the underlying reader reads samples, and the batches of
+ * batch_size samples are assembled by the reader: the tensors of a slot are
+ * stacked into a tensor of [batch_size] + the dims of the samples, or, if the
+ * samples have LoD, concatenated along the dim 0 with the LoD merged, as the
+ * DataFeeder builds the LoD of the sequences. The last batch holds the
+ * samples left.
+ *
+ * On CPUPlace the batches in the buffer are assembled by buffer_size
+ * threads while the trainer computes the previous batches, and the memory
+ * of a batch is reused by the later batch in its position of the buffer if
+ * the trainer no longer holds the tensors.
+ */
 class BufferedReader : public framework::DecoratedReader {
   using TensorVec = std::vector<framework::LoDTensor>;
   using VecFuture = std::future<TensorVec>;
@@ -40,7 +55,7 @@ class BufferedReader : public framework::DecoratedReader {
  public:
   BufferedReader(const std::shared_ptr<framework::ReaderBase>& reader,
                  const platform::Place& place, size_t buffer_size,
-                 bool pin_memory = false);
+                 bool pin_memory = false, size_t batch_size = 1);
 
   ~BufferedReader() override;
 
@@ -49,6 +64,10 @@ class BufferedReader : public framework::DecoratedReader {
 
   void ReadAsync(size_t i);
 
+  // Read the samples of the batch of the sequence number in turn, and
+  // assemble them into the batch.
+  void ReadBatch(size_t seq, TensorVec* batch);
+
  protected:
   void ShutdownImpl() override;
   void StartImpl() override;
@@ -59,6 +78,14 @@ class BufferedReader : public framework::DecoratedReader {
   platform::Place place_;
   const size_t buffer_size_;
   bool pin_memory_;
+  const size_t batch_size_;
+
+  // The sequence number of the next batch read, and the one whose samples
+  // are read by the threads now.
+  size_t read_seq_{0};
+  size_t sample_seq_{0};
+  std::mutex sample_mutex_;
+  std::condition_variable sample_cv_;
 
   std::queue<std::future<size_t>> position_;
 
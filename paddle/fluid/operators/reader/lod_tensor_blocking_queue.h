@@ -20,6 +20,7 @@
 
 #include "paddle/fluid/framework/ddim.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/ring_queue.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
 #include "paddle/fluid/platform/place.h"
 
@@ -29,52 +30,92 @@ namespace reader {
 
 class LoDTensorBlockingQueue {
  public:
-  explicit LoDTensorBlockingQueue(size_t capacity, bool speed_test_mode = false)
-      : queue_(capacity, speed_test_mode) {}
+  // If lock_free, the tensors are passed through a lock-free ring, where the
+  // threads pushing and popping spin a while before sleeping, instead of a
+  // deque guarded by a mutex. It does not work with speed_test_mode.
+  explicit LoDTensorBlockingQueue(size_t capacity, bool speed_test_mode = false,
+                                  bool lock_free = false)
+      : queue_(capacity, speed_test_mode) {
+    if (lock_free && !speed_test_mode) {
+      ring_queue_.reset(new RingQueue(capacity));
+    }
+  }
 
   ~LoDTensorBlockingQueue() { VLOG(10) << "Destruct LoDTensorBlockingQueue"; }
 
   bool Push(const std::vector<framework::LoDTensor>& lod_tensor_vec) {
+    if (ring_queue_) return ring_queue_->Send(lod_tensor_vec);
     return queue_.Send(lod_tensor_vec);
   }
 
   bool Push(std::vector<framework::LoDTensor>&& lod_tensor_vec) {
+    if (ring_queue_) return ring_queue_->Send(std::move(lod_tensor_vec));
     return queue_.Send(std::move(lod_tensor_vec));
   }
 
   std::vector<framework::LoDTensor> Pop(bool* ok = nullptr) {
     std::vector<framework::LoDTensor> lod_tensor_vec;
-    bool success = queue_.Receive(&lod_tensor_vec);
+    bool success = ring_queue_ ? ring_queue_->Receive(&lod_tensor_vec)
+                               : queue_.Receive(&lod_tensor_vec);
     if (ok != nullptr) *ok = success;
     return lod_tensor_vec;
   }
 
-  inline size_t Cap() const { return queue_.Cap(); }
+  inline size_t Cap() const {
+    return ring_queue_ ? ring_queue_->Cap() : queue_.Cap();
+  }
 
-  inline size_t Size() const { return queue_.Size(); }
+  inline size_t Size() const {
+    return ring_queue_ ? ring_queue_->Size() : queue_.Size();
+  }
 
-  inline void ReOpen() { queue_.ReOpen(); }
+  inline void ReOpen() {
+    if (ring_queue_) {
+      ring_queue_->ReOpen();
+    } else {
+      queue_.ReOpen();
+    }
+  }
 
   inline void Close() {
     VLOG(1) << "LoDTensorBlockingQueue close";
-    queue_.Close();
+    if (ring_queue_) {
+      ring_queue_->Close();
+    } else {
+      queue_.Close();
+    }
   }
 
-  inline bool IsClosed() const { return queue_.IsClosed(); }
+  inline bool IsClosed() const {
+    return ring_queue_ ? ring_queue_->IsClosed() : queue_.IsClosed();
+  }
 
-  inline void Kill() { queue_.Kill(); }
+  inline void Kill() {
+    if (ring_queue_) {
+      ring_queue_->Kill();
+    } else {
+      queue_.Kill();
+    }
+  }
 
   inline bool WaitForInited(size_t) { return true; }
 
  private:
+  using RingQueue =
+      framework::RingBlockingQueue<std::vector<framework::LoDTensor>>;
+
   BlockingQueue<std::vector<framework::LoDTensor>> queue_;
+  std::unique_ptr<RingQueue> ring_queue_;
 };
 
 class OrderedMultiDeviceLoDTensorBlockingQueue {
  public:
   OrderedMultiDeviceLoDTensorBlockingQueue(size_t capacity,
-                                           bool speed_test_mode = false)
-      : capacity_(capacity), speed_test_mode_(speed_test_mode) {}
+                                           bool speed_test_mode = false,
+                                           bool lock_free = false)
+      : capacity_(capacity),
+        speed_test_mode_(speed_test_mode),
+        lock_free_(lock_free) {}
 
   ~OrderedMultiDeviceLoDTensorBlockingQueue() {
     VLOG(10) << "Destruct OrderedMultiDeviceLoDTensorBlockingQueue";
@@ -105,7 +146,8 @@ class OrderedMultiDeviceLoDTensorBlockingQueue {
       queues_.resize(dev_cnt);
       for (auto& item : queues_) {
         auto cap = (capacity_ + dev_cnt - 1) / dev_cnt;
-        item.reset(new LoDTensorBlockingQueue(cap, speed_test_mode_));
+        item.reset(
+            new LoDTensorBlockingQueue(cap, speed_test_mode_, lock_free_));
       }
     }
     cv_.notify_all();
@@ -154,7 +196,7 @@ class OrderedMultiDeviceLoDTensorBlockingQueue {
     auto dev_cnt = queues_.size();
     for (auto& item : queues_) {
       auto cap = (capacity_ + dev_cnt - 1) / dev_cnt;
-      item.reset(new LoDTensorBlockingQueue(cap, speed_test_mode_));
+      item.reset(new LoDTensorBlockingQueue(cap, speed_test_mode_, lock_free_));
     }
     data_index_ = 0;
   }
@@ -189,6 +231,7 @@ class OrderedMultiDeviceLoDTensorBlockingQueue {
   size_t dev_cnt_{0};
   const size_t capacity_;
   const bool speed_test_mode_;
+  const bool lock_free_;
   bool is_closed_{false};
 
   std::vector<std::function<void()>> reset_methods_;
@@ -200,12 +243,14 @@ class OrderedMultiDeviceLoDTensorBlockingQueue {
 
 class LoDTensorBlockingQueueHolder {
  public:
-  void InitOnce(size_t capacity, bool speed_test_mode = false) {
+  void InitOnce(size_t capacity, bool speed_test_mode = false,
+                bool lock_free = false) {
     PADDLE_ENFORCE_EQ(
         queue_, nullptr,
         platform::errors::AlreadyExists("LoDTensorBlockingQueueHolder::"
                                         "InitOnce() can only be called once"));
-    queue_.reset(new LoDTensorBlockingQueue(capacity, speed_test_mode));
+    queue_.reset(
+        new LoDTensorBlockingQueue(capacity, speed_test_mode, lock_free));
   }
 
   inline const std::shared_ptr<LoDTensorBlockingQueue>& GetQueue() const {
@@ -218,13 +263,14 @@ class LoDTensorBlockingQueueHolder {
 
 class OrderedMultiDeviceLoDTensorBlockingQueueHolder {
  public:
-  void InitOnce(size_t capacity, bool speed_test_mode = false) {
+  void InitOnce(size_t capacity, bool speed_test_mode = false,
+                bool lock_free = false) {
     PADDLE_ENFORCE_EQ(queue_, nullptr,
                       platform::errors::AlreadyExists(
                           "OrderedMultiDeviceLoDTensorBlockingQueueHolder::"
                           "InitOnce() can only be called once"));
-    queue_.reset(new OrderedMultiDeviceLoDTensorBlockingQueue(capacity,
-                                                              speed_test_mode));
+    queue_.reset(new OrderedMultiDeviceLoDTensorBlockingQueue(
+        capacity, speed_test_mode, lock_free));
   }
 
   inline const std::shared_ptr<OrderedMultiDeviceLoDTensorBlockingQueue>&
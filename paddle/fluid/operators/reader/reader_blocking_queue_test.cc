@@ -12,11 +12,16 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <chrono>  // NOLINT
 #include <thread>  // NOLINT
 
 #include "gtest/gtest.h"
+#include "paddle/fluid/framework/ring_queue.h"
 #include "paddle/fluid/operators/reader/blocking_queue.h"
 
+using paddle::framework::MPMCRing;
+using paddle::framework::RingBlockingQueue;
+using paddle::framework::SPSCRing;
 using paddle::operators::reader::BlockingQueue;
 
 TEST(BlockingQueue, CapacityTest) {
@@ -238,3 +243,61 @@ TEST(BlockingQueue, speed_test_mode) {
   }
   EXPECT_EQ(q2.Size(), queue_size);
 }
+
+// The items per second passed by the senders to the receivers through the
+// queue of the capacity, where an item is a vector as the tensors fed.
+template <typename Queue>
+double SendReceiveRate(size_t num_senders, size_t num_receivers,
+                       size_t capacity) {
+  const size_t num_items = 200000 / num_senders;
+  Queue q(capacity);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> receivers;
+  for (size_t i = 0; i < num_receivers; ++i) {
+    receivers.emplace_back([&q] {
+      std::vector<size_t> elem;
+      while (q.Receive(&elem)) {
+      }
+    });
+  }
+  std::vector<std::thread> senders;
+  for (size_t i = 0; i < num_senders; ++i) {
+    senders.emplace_back([&q, num_items] {
+      for (size_t j = 0; j < num_items; ++j) {
+        q.Send(std::vector<size_t>(4, j));
+      }
+    });
+  }
+  for (auto& t : senders) {
+    t.join();
+  }
+  q.Close();
+  for (auto& t : receivers) {
+    t.join();
+  }
+  return num_items * num_senders /
+         std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+             .count();
+}
+
+TEST(BlockingQueue, benchmark_contention) {
+  using Item = std::vector<size_t>;
+  LOG(INFO) << "1 sender, 1 receiver: deque "
+            << SendReceiveRate<BlockingQueue<Item>>(1, 1, 64)
+            << " items/s, SPSC ring "
+            << SendReceiveRate<RingBlockingQueue<Item, SPSCRing<Item>>>(1, 1,
+                                                                         64)
+            << " items/s, MPMC ring "
+            << SendReceiveRate<RingBlockingQueue<Item, MPMCRing<Item>>>(1, 1,
+                                                                         64)
+            << " items/s";
+  for (size_t num_senders : {4, 8}) {
+    LOG(INFO) << num_senders << " senders, 2 receivers: deque "
+              << SendReceiveRate<BlockingQueue<Item>>(num_senders, 2, 64)
+              << " items/s, MPMC ring "
+              << SendReceiveRate<RingBlockingQueue<Item, MPMCRing<Item>>>(
+                     num_senders, 2, 64)
+              << " items/s";
+  }
+}
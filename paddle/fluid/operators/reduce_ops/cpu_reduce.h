@@ -0,0 +1,376 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "paddle/fluid/framework/ddim.h"
+#include "paddle/fluid/framework/tensor.h"
+#include "paddle/fluid/platform/device_context.h"
+
+namespace paddle {
+namespace operators {
+
+// The reducers of the CPU reduce engine. Init is the identity of Reduce,
+// Finalize is applied once to the reduced result of n elements and Grad
+// computes dx from x, y = reduce(x) and dy.
+template <typename T>
+struct CPUSumReducer {
+  static constexpr bool kNeedXY = false;
+  static inline T Init() { return static_cast<T>(0); }
+  static inline T Reduce(T a, T b) { return a + b; }
+  static inline T Finalize(T v, int64_t n) { return v; }
+  static inline T Grad(T x, T y, T dy, int64_t n) { return dy; }
+};
+
+template <typename T>
+struct CPUMeanReducer {
+  static constexpr bool kNeedXY = false;
+  static inline T Init() { return static_cast<T>(0); }
+  static inline T Reduce(T a, T b) { return a + b; }
+  static inline T Finalize(T v, int64_t n) { return v / static_cast<T>(n); }
+  static inline T Grad(T x, T y, T dy, int64_t n) {
+    return dy / static_cast<T>(n);
+  }
+};
+
+// If there are multiple minimum or maximum elements, all of them get the
+// gradient, which is the same as MaxOrMinGradFunctor.
+template <typename T>
+struct CPUMaxReducer {
+  static constexpr bool kNeedXY = true;
+  static inline T Init() { return std::numeric_limits<T>::lowest(); }
+  static inline T Reduce(T a, T b) { return a > b ? a : b; }
+  static inline T Finalize(T v, int64_t n) { return v; }
+  static inline T Grad(T x, T y, T dy, int64_t n) {
+    return x == y ? dy : static_cast<T>(0);
+  }
+};
+
+template <typename T>
+struct CPUMinReducer {
+  static constexpr bool kNeedXY = true;
+  static inline T Init() { return std::numeric_limits<T>::max(); }
+  static inline T Reduce(T a, T b) { return a < b ? a : b; }
+  static inline T Finalize(T v, int64_t n) { return v; }
+  static inline T Grad(T x, T y, T dy, int64_t n) {
+    return x == y ? dy : static_cast<T>(0);
+  }
+};
+
+// The reducer of a Functor used by ReduceKernel or ReduceGradKernel, which
+// should be specialized beside the Functor. void means the CPU reduce engine
+// does not support the Functor, then it goes to the Eigen implementation.
+template <typename Functor, typename T>
+struct CPUReducerTraits {
+  using Reducer = void;
+};
+
+namespace detail {
+
+// elements reduced by one task, large enough to amortize the scheduling
+constexpr int64_t kCPUReduceRowChunk = 16384;
+constexpr int64_t kCPUReduceColBlock = 256;
+constexpr int64_t kCPUReduceColChunk = 64;
+// split the reduced axis only when there are fewer tasks than this
+constexpr int64_t kCPUReduceMinTasks = 64;
+// run serially below this numel
+constexpr int64_t kCPUReduceParallelNumel = 1 << 15;
+// independent accumulators of the row reduction, so it could be vectorized
+constexpr int kCPUReduceLanes = 16;
+
+static inline int64_t DivUp(int64_t a, int64_t b) { return (a + b - 1) / b; }
+
+// merge the adjacent dims which are all reduced or all kept, and drop the
+// dims whose size is 1, then get x_dim = [outer, reduce, inner].
+// eg: x_dim = [8, 512, 1, 768], reduce_dims = [1, 2]
+//     --MergeReduceDims--> outer = 8, reduce = 512, inner = 768
+// return false if the merged x_dim can not be expressed in this way, such as
+// x_dim = [2, 3, 4] with reduce_dims = [0, 2].
+inline bool MergeReduceDims(const framework::DDim& x_dim,
+                            const std::vector<int>& reduce_dims,
+                            bool reduce_all, int64_t* outer, int64_t* reduce,
+                            int64_t* inner) {
+  const int rank = x_dim.size();
+  std::vector<bool> is_reduced(rank, reduce_all);
+  for (auto d : reduce_dims) {
+    is_reduced[d >= 0 ? d : d + rank] = true;
+  }
+  std::vector<int64_t> merged_dims;
+  std::vector<bool> merged_reduced;
+  for (int i = 0; i < rank; ++i) {
+    if (x_dim[i] == 1) {
+      continue;
+    }
+    if (!merged_dims.empty() && merged_reduced.back() == is_reduced[i]) {
+      merged_dims.back() *= x_dim[i];
+    } else {
+      merged_dims.push_back(x_dim[i]);
+      merged_reduced.push_back(is_reduced[i]);
+    }
+  }
+  *outer = *reduce = *inner = 1;
+  size_t i = 0;
+  if (i < merged_dims.size() && !merged_reduced[i]) {
+    *outer = merged_dims[i++];
+  }
+  if (i < merged_dims.size() && merged_reduced[i]) {
+    *reduce = merged_dims[i++];
+  }
+  if (i < merged_dims.size() && !merged_reduced[i]) {
+    *inner = merged_dims[i++];
+  }
+  if (i != merged_dims.size()) {
+    return false;
+  }
+  // reduce nothing, take it as reducing an axis of size 1
+  if (merged_dims.size() == 1 && !merged_reduced[0]) {
+    *inner = *outer;
+    *outer = 1;
+  }
+  return true;
+}
+
+template <typename T, typename Reducer>
+inline T ReduceRow(const T* x, int64_t n) {
+  T acc[kCPUReduceLanes];
+  for (int j = 0; j < kCPUReduceLanes; ++j) {
+    acc[j] = Reducer::Init();
+  }
+  int64_t i = 0;
+  for (; i + kCPUReduceLanes <= n; i += kCPUReduceLanes) {
+    for (int j = 0; j < kCPUReduceLanes; ++j) {
+      acc[j] = Reducer::Reduce(acc[j], x[i + j]);
+    }
+  }
+  T res = Reducer::Init();
+  for (int j = 0; j < kCPUReduceLanes; ++j) {
+    res = Reducer::Reduce(res, acc[j]);
+  }
+  for (; i < n; ++i) {
+    res = Reducer::Reduce(res, x[i]);
+  }
+  return res;
+}
+
+// x_dim = [outer, reduce], reduce the contiguous rows
+template <typename T, typename Reducer>
+void CPUReduceRows(const T* x, T* y, int64_t outer, int64_t reduce) {
+  const bool parallel = outer * reduce >= kCPUReduceParallelNumel;
+  if (outer >= kCPUReduceMinTasks || reduce <= kCPUReduceRowChunk) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+    for (int64_t o = 0; o < outer; ++o) {
+      y[o] = Reducer::Finalize(ReduceRow<T, Reducer>(x + o * reduce, reduce),
+                               reduce);
+    }
+    return;
+  }
+  // a few long rows, split each row into chunks
+  const int64_t num_chunks = DivUp(reduce, kCPUReduceRowChunk);
+  std::vector<T> partial(outer * num_chunks);
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+  for (int64_t t = 0; t < outer * num_chunks; ++t) {
+    const int64_t o = t / num_chunks;
+    const int64_t start = (t % num_chunks) * kCPUReduceRowChunk;
+    const int64_t len = std::min(kCPUReduceRowChunk, reduce - start);
+    partial[t] = ReduceRow<T, Reducer>(x + o * reduce + start, len);
+  }
+  for (int64_t o = 0; o < outer; ++o) {
+    y[o] = Reducer::Finalize(
+        ReduceRow<T, Reducer>(partial.data() + o * num_chunks, num_chunks),
+        reduce);
+  }
+}
+
+// x_dim = [outer, reduce, inner], reduce the middle axis with the blocks of
+// contiguous columns
+template <typename T, typename Reducer>
+void CPUReduceCols(const T* x, T* y, int64_t outer, int64_t reduce,
+                   int64_t inner) {
+  const bool parallel = outer * reduce * inner >= kCPUReduceParallelNumel;
+  const int64_t num_blocks = DivUp(inner, kCPUReduceColBlock);
+  const int64_t num_tasks = outer * num_blocks;
+  // split the reduced axis if there are not enough tasks
+  int64_t chunk_rows = reduce;
+  if (num_tasks < kCPUReduceMinTasks) {
+    chunk_rows = std::max(kCPUReduceColChunk,
+                          DivUp(reduce * num_tasks, kCPUReduceMinTasks));
+  }
+  const int64_t num_chunks = DivUp(reduce, chunk_rows);
+  std::vector<T> partial(num_chunks > 1 ? num_chunks * outer * inner : 0);
+  T* dst = num_chunks > 1 ? partial.data() : y;
+
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+  for (int64_t t = 0; t < num_tasks * num_chunks; ++t) {
+    const int64_t c = t / num_tasks;
+    const int64_t o = (t % num_tasks) / num_blocks;
+    const int64_t col = (t % num_blocks) * kCPUReduceColBlock;
+    const int64_t len = std::min(kCPUReduceColBlock, inner - col);
+    const int64_t row_end = std::min(reduce, (c + 1) * chunk_rows);
+    T acc[kCPUReduceColBlock];
+    for (int64_t k = 0; k < len; ++k) {
+      acc[k] = Reducer::Init();
+    }
+    for (int64_t r = c * chunk_rows; r < row_end; ++r) {
+      const T* row = x + (o * reduce + r) * inner + col;
+      for (int64_t k = 0; k < len; ++k) {
+        acc[k] = Reducer::Reduce(acc[k], row[k]);
+      }
+    }
+    T* out = dst + (c * outer + o) * inner + col;
+    for (int64_t k = 0; k < len; ++k) {
+      out[k] = num_chunks > 1 ? acc[k] : Reducer::Finalize(acc[k], reduce);
+    }
+  }
+  if (num_chunks > 1) {
+    const int64_t numel = outer * inner;
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+    for (int64_t i = 0; i < numel; ++i) {
+      T res = partial[i];
+      for (int64_t c = 1; c < num_chunks; ++c) {
+        res = Reducer::Reduce(res, partial[c * numel + i]);
+      }
+      y[i] = Reducer::Finalize(res, reduce);
+    }
+  }
+}
+
+template <typename T, typename Reducer>
+void CPUReduceGradImpl(const T* x, const T* y, const T* dy, T* dx,
+                       int64_t outer, int64_t reduce, int64_t inner) {
+  const bool parallel = outer * reduce * inner >= kCPUReduceParallelNumel;
+  if (inner == 1) {
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+    for (int64_t o = 0; o < outer; ++o) {
+      const T y_o = Reducer::kNeedXY ? y[o] : static_cast<T>(0);
+      const int64_t offset = o * reduce;
+      for (int64_t r = 0; r < reduce; ++r) {
+        const T x_r = Reducer::kNeedXY ? x[offset + r] : static_cast<T>(0);
+        dx[offset + r] = Reducer::Grad(x_r, y_o, dy[o], reduce);
+      }
+    }
+    return;
+  }
+#ifdef PADDLE_WITH_MKLML
+#pragma omp parallel for if (parallel)
+#endif
+  for (int64_t t = 0; t < outer * reduce; ++t) {
+    const int64_t offset = (t / reduce) * inner;
+    for (int64_t k = 0; k < inner; ++k) {
+      const T x_k = Reducer::kNeedXY ? x[t * inner + k] : static_cast<T>(0);
+      const T y_k = Reducer::kNeedXY ? y[offset + k] : static_cast<T>(0);
+      dx[t * inner + k] = Reducer::Grad(x_k, y_k, dy[offset + k], reduce);
+    }
+  }
+}
+
+template <typename DeviceContext, typename T, typename Functor>
+struct IsCPUReduceSupported
+    : std::integral_constant<
+          bool,
+          std::is_same<DeviceContext, platform::CPUDeviceContext>::value &&
+              std::is_arithmetic<T>::value && !std::is_same<T, bool>::value &&
+              !std::is_void<
+                  typename CPUReducerTraits<Functor, T>::Reducer>::value> {};
+
+}  // namespace detail
+
+// The CPU reduce engine, which merges the adjacent reduced or kept dims, then
+// reduces the rows or the blocks of columns in parallel. It returns false if
+// the Functor, data type or reduce dims are not supported, and the caller
+// should fall back to the Eigen implementation.
+template <typename DeviceContext, typename T, typename Functor>
+typename std::enable_if<
+    detail::IsCPUReduceSupported<DeviceContext, T, Functor>::value, bool>::type
+TryCPUReduce(const framework::Tensor& x, const std::vector<int>& reduce_dims,
+             bool reduce_all, framework::Tensor* y) {
+  using Reducer = typename CPUReducerTraits<Functor, T>::Reducer;
+  int64_t outer, reduce, inner;
+  if (x.numel() == 0 ||
+      !detail::MergeReduceDims(x.dims(), reduce_dims, reduce_all, &outer,
+                               &reduce, &inner)) {
+    return false;
+  }
+  const T* x_data = x.data<T>();
+  T* y_data = y->data<T>();
+  if (inner == 1) {
+    detail::CPUReduceRows<T, Reducer>(x_data, y_data, outer, reduce);
+  } else {
+    detail::CPUReduceCols<T, Reducer>(x_data, y_data, outer, reduce, inner);
+  }
+  return true;
+}
+
+template <typename DeviceContext, typename T, typename Functor>
+typename std::enable_if<
+    !detail::IsCPUReduceSupported<DeviceContext, T, Functor>::value,
+    bool>::type
+TryCPUReduce(const framework::Tensor& x, const std::vector<int>& reduce_dims,
+             bool reduce_all, framework::Tensor* y) {
+  return false;
+}
+
+// dx = Grad(x, broadcast(y), broadcast(dy)), x and y are not read if the
+// Reducer does not need them.
+template <typename DeviceContext, typename T, typename Functor>
+typename std::enable_if<
+    detail::IsCPUReduceSupported<DeviceContext, T, Functor>::value, bool>::type
+TryCPUReduceGrad(const framework::Tensor& x, const framework::Tensor& y,
+                 const framework::Tensor& dy,
+                 const std::vector<int>& reduce_dims, bool reduce_all,
+                 framework::Tensor* dx) {
+  using Reducer = typename CPUReducerTraits<Functor, T>::Reducer;
+  int64_t outer, reduce, inner;
+  if (dx->numel() == 0 ||
+      !detail::MergeReduceDims(dx->dims(), reduce_dims, reduce_all, &outer,
+                               &reduce, &inner) ||
+      dy.numel() != outer * inner ||
+      (Reducer::kNeedXY &&
+       (x.numel() != dx->numel() || y.numel() != dy.numel()))) {
+    return false;
+  }
+  const T* x_data = Reducer::kNeedXY ? x.data<T>() : nullptr;
+  const T* y_data = Reducer::kNeedXY ? y.data<T>() : nullptr;
+  detail::CPUReduceGradImpl<T, Reducer>(x_data, y_data, dy.data<T>(),
+                                        dx->data<T>(), outer, reduce, inner);
+  return true;
+}
+
+template <typename DeviceContext, typename T, typename Functor>
+typename std::enable_if<
+    !detail::IsCPUReduceSupported<DeviceContext, T, Functor>::value,
+    bool>::type
+TryCPUReduceGrad(const framework::Tensor& x, const framework::Tensor& y,
+                 const framework::Tensor& dy,
+                 const std::vector<int>& reduce_dims, bool reduce_all,
+                 framework::Tensor* dx) {
+  return false;
+}
+
+}  // namespace operators
+}  // namespace paddle
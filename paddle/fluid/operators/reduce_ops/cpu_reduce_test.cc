@@ -0,0 +1,231 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/operators/reduce_ops/cpu_reduce.h"
+
+#include <random>
+#include <vector>
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+#include "paddle/fluid/operators/reduce_ops/reduce_mean_op.h"
+#include "paddle/fluid/operators/reduce_ops/reduce_min_max_op.h"
+#include "paddle/fluid/operators/reduce_ops/reduce_sum_op.h"
+#include "paddle/fluid/platform/device_tracer.h"
+
+DEFINE_bool(cpu_reduce_benchmark, false,
+            "Run the shape sweep benchmark of CPU reduce against Eigen.");
+
+namespace paddle {
+namespace operators {
+
+using CPUContext = platform::CPUDeviceContext;
+
+static void RandomTensor(const std::vector<int64_t>& shape,
+                         framework::Tensor* t) {
+  std::mt19937 rng(100);
+  std::uniform_real_distribution<float> dist(-2.f, 2.f);
+  float* data =
+      t->mutable_data<float>(framework::make_ddim(shape), platform::CPUPlace());
+  for (int64_t i = 0; i < t->numel(); ++i) {
+    data[i] = dist(rng);
+  }
+}
+
+// the sum is accumulated in double to compare with the blocked order
+static double NaiveResult(SumFunctor, float v, double sum, int64_t n) {
+  return sum;
+}
+static double NaiveResult(MeanFunctor, float v, double sum, int64_t n) {
+  return sum / n;
+}
+static double NaiveResult(MaxFunctor, float v, double sum, int64_t n) {
+  return v;
+}
+static double NaiveResult(MinFunctor, float v, double sum, int64_t n) {
+  return v;
+}
+
+// reduce x as [outer, reduce, inner] in the naive way
+template <typename Functor>
+static std::vector<double> NaiveReduce(const float* x, int64_t outer,
+                                       int64_t reduce, int64_t inner) {
+  using Reducer = typename CPUReducerTraits<Functor, float>::Reducer;
+  std::vector<double> y(outer * inner);
+  for (int64_t o = 0; o < outer; ++o) {
+    for (int64_t i = 0; i < inner; ++i) {
+      float v = Reducer::Init();
+      double sum = 0;
+      for (int64_t r = 0; r < reduce; ++r) {
+        v = Reducer::Reduce(v, x[(o * reduce + r) * inner + i]);
+        sum += x[(o * reduce + r) * inner + i];
+      }
+      y[o * inner + i] = NaiveResult(Functor(), v, sum, reduce);
+    }
+  }
+  return y;
+}
+
+template <typename Functor>
+static void TestReduce(const std::vector<int64_t>& shape,
+                       const std::vector<int>& dims) {
+  framework::Tensor x, y;
+  RandomTensor(shape, &x);
+  int64_t outer, reduce, inner;
+  ASSERT_TRUE(detail::MergeReduceDims(x.dims(), dims, false, &outer, &reduce,
+                                      &inner));
+  y.mutable_data<float>(framework::make_ddim({outer * inner}),
+                        platform::CPUPlace());
+  ASSERT_TRUE((TryCPUReduce<CPUContext, float, Functor>(x, dims, false, &y)));
+  auto ref = NaiveReduce<Functor>(x.data<float>(), outer, reduce, inner);
+  for (int64_t i = 0; i < y.numel(); ++i) {
+    EXPECT_NEAR(y.data<float>()[i], ref[i], 1e-5 * reduce + 1e-5);
+  }
+}
+
+TEST(CPUReduce, merge_dims) {
+  int64_t outer, reduce, inner;
+  ASSERT_TRUE(detail::MergeReduceDims(framework::make_ddim({8, 512, 1, 768}),
+                                      {1, 2}, false, &outer, &reduce, &inner));
+  EXPECT_EQ(outer, 8);
+  EXPECT_EQ(reduce, 512);
+  EXPECT_EQ(inner, 768);
+  ASSERT_TRUE(detail::MergeReduceDims(framework::make_ddim({2, 3, 4, 5}),
+                                      {-1, 2}, false, &outer, &reduce, &inner));
+  EXPECT_EQ(outer, 6);
+  EXPECT_EQ(reduce, 20);
+  EXPECT_EQ(inner, 1);
+  ASSERT_TRUE(detail::MergeReduceDims(framework::make_ddim({2, 3, 4}), {0},
+                                      true, &outer, &reduce, &inner));
+  EXPECT_EQ(outer, 1);
+  EXPECT_EQ(reduce, 24);
+  EXPECT_EQ(inner, 1);
+  ASSERT_TRUE(detail::MergeReduceDims(framework::make_ddim({2, 1, 4}), {1},
+                                      false, &outer, &reduce, &inner));
+  EXPECT_EQ(outer, 1);
+  EXPECT_EQ(reduce, 1);
+  EXPECT_EQ(inner, 8);
+  EXPECT_FALSE(detail::MergeReduceDims(framework::make_ddim({2, 3, 4}), {0, 2},
+                                       false, &outer, &reduce, &inner));
+}
+
+TEST(CPUReduce, forward) {
+  const std::vector<std::pair<std::vector<int64_t>, std::vector<int>>> cases =
+      {{{100}, {0}},
+       {{3, 70000}, {1}},
+       {{70000, 3}, {0}},
+       {{4, 33, 300}, {1}},
+       {{2, 5000, 17}, {1}},
+       {{2, 3, 4, 5}, {1, 2}},
+       {{2, 3, 4, 5}, {0, 1}},
+       {{2, 3, 4, 5}, {2, 3}}};
+  for (auto& c : cases) {
+    TestReduce<SumFunctor>(c.first, c.second);
+    TestReduce<MeanFunctor>(c.first, c.second);
+    TestReduce<MaxFunctor>(c.first, c.second);
+    TestReduce<MinFunctor>(c.first, c.second);
+  }
+}
+
+TEST(CPUReduce, unsupported) {
+  framework::Tensor x, y;
+  RandomTensor({2, 3, 4}, &x);
+  y.mutable_data<float>(framework::make_ddim({3}), platform::CPUPlace());
+  EXPECT_FALSE(
+      (TryCPUReduce<CPUContext, float, SumFunctor>(x, {0, 2}, false, &y)));
+}
+
+TEST(CPUReduce, grad) {
+  framework::Tensor x, y, dy, dx;
+  RandomTensor({4, 6, 5}, &x);
+  RandomTensor({4, 5}, &dy);
+  y.mutable_data<float>(framework::make_ddim({4, 5}), platform::CPUPlace());
+  dx.mutable_data<float>(x.dims(), platform::CPUPlace());
+  ASSERT_TRUE((TryCPUReduce<CPUContext, float, MaxFunctor>(x, {1}, false, &y)));
+
+  ASSERT_TRUE((TryCPUReduceGrad<CPUContext, float, SumGradFunctor>(
+      x, y, dy, {1}, false, &dx)));
+  for (int64_t i = 0; i < dx.numel(); ++i) {
+    EXPECT_EQ(dx.data<float>()[i], dy.data<float>()[(i / 30) * 5 + i % 5]);
+  }
+  ASSERT_TRUE((TryCPUReduceGrad<CPUContext, float, MeanGradFunctor>(
+      x, y, dy, {1}, false, &dx)));
+  for (int64_t i = 0; i < dx.numel(); ++i) {
+    EXPECT_EQ(dx.data<float>()[i],
+              dy.data<float>()[(i / 30) * 5 + i % 5] / 6.f);
+  }
+  ASSERT_TRUE((TryCPUReduceGrad<CPUContext, float, MaxOrMinGradFunctor>(
+      x, y, dy, {1}, false, &dx)));
+  for (int64_t i = 0; i < dx.numel(); ++i) {
+    const int64_t j = (i / 30) * 5 + i % 5;
+    EXPECT_EQ(dx.data<float>()[i],
+              x.data<float>()[i] == y.data<float>()[j] ? dy.data<float>()[j]
+                                                        : 0.f);
+  }
+}
+
+template <typename Func>
+static double BenchUs(Func func, int repeat = 20) {
+  func();
+  auto start = platform::PosixInNsec();
+  for (int i = 0; i < repeat; ++i) {
+    func();
+  }
+  return (platform::PosixInNsec() - start) * 1e-3 / repeat;
+}
+
+// compare with the Eigen implementation used by ReduceFunctor, which is the
+// same as ReduceFunctor<CPUDeviceContext, float, 3, 1, SumFunctor>
+TEST(CPUReduce, benchmark) {
+  if (!FLAGS_cpu_reduce_benchmark) {
+    return;
+  }
+  CPUContext ctx;
+  auto& place = *ctx.eigen_device();
+  const std::vector<std::vector<int64_t>> shapes = {
+      {1, 1 << 22, 1}, {4096, 1024, 1}, {64, 65536, 1}, {1, 4096, 1024},
+      {32, 512, 768},  {32, 128, 4096}, {1024, 64, 32}, {8, 8192, 64}};
+  for (auto& shape : shapes) {
+    framework::Tensor x, y, dx;
+    RandomTensor(shape, &x);
+    y.mutable_data<float>(framework::make_ddim({shape[0], shape[2]}),
+                          platform::CPUPlace());
+    dx.mutable_data<float>(x.dims(), platform::CPUPlace());
+    auto x_e = framework::EigenTensor<float, 3>::From(x);
+    auto y_e = framework::EigenTensor<float, 2>::From(y);
+    auto dx_e = framework::EigenTensor<float, 3>::From(dx);
+    Eigen::array<int, 1> reduce_dim({{1}});
+    Eigen::array<int, 3> bcast({{1, static_cast<int>(shape[1]), 1}});
+    Eigen::DSizes<int, 3> y_3d(shape[0], 1, shape[2]);
+
+    double eigen = BenchUs([&] { y_e.device(place) = x_e.sum(reduce_dim); });
+    double engine = BenchUs([&] {
+      TryCPUReduce<CPUContext, float, SumFunctor>(x, {1}, false, &y);
+    });
+    double eigen_grad = BenchUs(
+        [&] { dx_e.device(place) = y_e.reshape(y_3d).broadcast(bcast); });
+    double engine_grad = BenchUs([&] {
+      TryCPUReduceGrad<CPUContext, float, SumGradFunctor>(x, y, y, {1}, false,
+                                                          &dx);
+    });
+    LOG(INFO) << "reduce_sum [" << shape[0] << ", " << shape[1] << ", "
+              << shape[2] << "] axis 1: Eigen " << eigen << " us, CPUReduce "
+              << engine << " us; grad: Eigen " << eigen_grad
+              << " us, CPUReduce " << engine_grad << " us";
+  }
+}
+
+}  // namespace operators
+}  // namespace paddle
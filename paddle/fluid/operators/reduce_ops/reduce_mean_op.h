@@ -35,5 +35,15 @@ struct MeanGradFunctor {
   }
 };
 
+template <typename T>
+struct CPUReducerTraits<MeanFunctor, T> {
+  using Reducer = CPUMeanReducer<T>;
+};
+
+template <typename T>
+struct CPUReducerTraits<MeanGradFunctor, T> {
+  using Reducer = CPUMeanReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -46,5 +46,21 @@ struct MaxOrMinGradFunctor {
   }
 };
 
+template <typename T>
+struct CPUReducerTraits<MaxFunctor, T> {
+  using Reducer = CPUMaxReducer<T>;
+};
+
+template <typename T>
+struct CPUReducerTraits<MinFunctor, T> {
+  using Reducer = CPUMinReducer<T>;
+};
+
+// only Grad of the reducer is used, which is the same for max and min
+template <typename T>
+struct CPUReducerTraits<MaxOrMinGradFunctor, T> {
+  using Reducer = CPUMaxReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
@@ -22,6 +22,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/tensor_util.h"
 #include "paddle/fluid/operators/cast_op.h"
 #include "paddle/fluid/operators/math/math_function.h"
+#include "paddle/fluid/operators/reduce_ops/cpu_reduce.h"
 #include "paddle/fluid/operators/reduce_ops/reduce_op_function.h"
 #if defined(__HIPCC__) || defined(__NVCC__)
 #include "paddle/fluid/operators/reduce_ops/reduce_op.cu.h"
@@ -186,6 +187,10 @@ struct ReduceKernelFunctor {
   template <typename OutT>
   void apply() const {
     output->mutable_data<OutT>(context.GetPlace());
+    if (TryCPUReduce<DeviceContext, OutT, Functor>(*input, dims, reduce_all,
+                                                   output)) {
+      return;
+    }
     if (reduce_all) {
       // Flatten and reduce 1-D tensor
       auto x = EigenVector<OutT>::Flatten(*input);
@@ -373,6 +378,11 @@ class ReduceGradKernel : public framework::OpKernel<T> {
     // not be set as Input in grad Maker, use Out_grad to replace here
     if (!input1) input1 = input2;
 
+    if (TryCPUReduceGrad<DeviceContext, T, Functor>(
+            *input0, *input1, *input2, dims, reduce_all, output)) {
+      return;
+    }
+
     if (reduce_all) {
       auto x = EigenVector<T>::Flatten(*input0);
       auto x_reduce = EigenVector<T>::Flatten(*input1);
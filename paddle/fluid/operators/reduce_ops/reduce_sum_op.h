@@ -33,6 +33,11 @@ class ReduceSumGradKernel : public framework::OpKernel<T> {
 
     auto* output = context.Output<Tensor>(framework::GradVarName("X"));
     output->mutable_data<T>(context.GetPlace());
+    if (TryCPUReduceGrad<DeviceContext, T, Functor>(
+            *input0, *input2, *input2, dims, context.Attr<bool>("reduce_all"),
+            output)) {
+      return;
+    }
     const auto* input2_d = input2->data<T>();
     auto* output_d = output->data<T>();
 
@@ -115,5 +120,15 @@ struct SumGradFunctor {
   }
 };
 
+template <typename T>
+struct CPUReducerTraits<SumFunctor, T> {
+  using Reducer = CPUSumReducer<T>;
+};
+
+template <typename T>
+struct CPUReducerTraits<SumGradFunctor, T> {
+  using Reducer = CPUSumReducer<T>;
+};
+
 }  // namespace operators
 }  // namespace paddle
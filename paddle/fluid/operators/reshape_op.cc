@@ -376,8 +376,7 @@ class ReshapeKernel {
     }
 
     out->Resize(out_dims);
-    out->mutable_data(ctx.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -391,8 +390,7 @@ class ReshapeGradKernel {
     auto *d_x = ctx.Output<framework::Tensor>(framework::GradVarName("X"));
     auto in_dims = d_x->dims();
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *d_out, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(in_dims);
@@ -407,8 +405,7 @@ class ReshapeDoubleGradKernel {
 
     auto out_dims = dd_out->dims();
 
-    dd_out->mutable_data(ctx.GetPlace(), dd_x->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *dd_x, ctx.GetPlace(),
         ctx.template device_context<platform::DeviceContext>(), dd_out);
     dd_out->Resize(out_dims);
@@ -14,6 +14,7 @@ limitations under the License. */
 
 #include <string>
 
+#include "paddle/fluid/framework/op_version_registry.h"
 #include "paddle/fluid/operators/save_combine_op.h"
 
 namespace paddle {
@@ -71,6 +72,12 @@ to a file on disk.
         "The \"file_path\" where the LoDTensor variables will be saved.")
         .AddCustomChecker(
             [](const std::string& path) { return !path.empty(); });
+    AddAttr<bool>("save_as_mmap_format",
+                  "(boolean, default false)"
+                  "If true, the variables will be saved in the aligned format "
+                  "which load_combine maps into memory, so the loaded CPU "
+                  "tensors share the pages of the file without copying.")
+        .SetDefault(false);
     AddAttr<bool>("save_to_memory",
                   "(boolean, default false)"
                   "If true, the variables will be saved to binary strings.")
@@ -106,3 +113,14 @@ REGISTER_OP_CPU_KERNEL(
                              paddle::platform::bfloat16>,
     ops::SaveCombineOpKernel<paddle::platform::CPUDeviceContext, int>,
     ops::SaveCombineOpKernel<paddle::platform::CPUDeviceContext, int64_t>);
+
+REGISTER_OP_VERSION(save_combine)
+    .AddCheckpoint(
+        R"ROC(
+      Upgrade save_combine to add a new attribute [save_as_mmap_format].
+    )ROC",
+        paddle::framework::compatible::OpVersionDesc().NewAttr(
+            "save_as_mmap_format",
+            "In order to save the parameters in the format which can be "
+            "mapped into memory by load_combine",
+            false));
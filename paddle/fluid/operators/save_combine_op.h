@@ -23,6 +23,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/data_type.h"
 #include "paddle/fluid/framework/data_type_transform.h"
 #include "paddle/fluid/framework/lod_tensor.h"
+#include "paddle/fluid/framework/mmap_params.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/platform/device_context.h"
 #include "paddle/fluid/platform/port.h"
@@ -38,6 +39,7 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     auto overwrite = ctx.Attr<bool>("overwrite");
     auto save_as_fp16 = ctx.Attr<bool>("save_as_fp16");
     auto save_to_memory = ctx.Attr<bool>("save_to_memory");
+    auto save_as_mmap_format = ctx.Attr<bool>("save_as_mmap_format");
     auto output = ctx.Output<std::string>("Y");
 
     bool is_present = FileExists(filename);
@@ -61,6 +63,11 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
     platform::DeviceContextPool &pool = platform::DeviceContextPool::Instance();
     auto &dev_ctx = *pool.Get(place);
 
+    // the tensors to save in mmap format, and the converted fp16 tensors
+    std::vector<const framework::LoDTensor *> mmap_tensors;
+    std::vector<framework::LoDTensor> fp16_tensors;
+    fp16_tensors.reserve(inp_var_names.size());
+
     for (size_t i = 0; i < inp_var_names.size(); i++) {
       PADDLE_ENFORCE_NOT_NULL(
           inp_vars[i],
@@ -91,11 +98,21 @@ class SaveCombineOpKernel : public framework::OpKernel<T> {
         // copy LoD info to the new tensor
         out.set_lod(tensor.lod());
         framework::TransDataType(in_kernel_type, out_kernel_type, tensor, &out);
-        framework::SerializeToStream(ss, out, dev_ctx);
+        if (save_as_mmap_format) {
+          fp16_tensors.emplace_back(std::move(out));
+          mmap_tensors.push_back(&fp16_tensors.back());
+        } else {
+          framework::SerializeToStream(ss, out, dev_ctx);
+        }
+      } else if (save_as_mmap_format) {
+        mmap_tensors.push_back(&tensor);
       } else {
         framework::SerializeToStream(ss, tensor, dev_ctx);
       }
     }
+    if (save_as_mmap_format) {
+      framework::SerializeMmapParams(ss, inp_var_names, mmap_tensors, dev_ctx);
+    }
     if (save_to_memory) {
       PADDLE_ENFORCE_NE(output, nullptr,
                         platform::errors::InvalidArgument(
@@ -78,7 +78,7 @@ void CheckValues(T* expect, U* actual, const paddle::framework::LoD& expect_lod,
 // Here, we create 4 LoDTensors and use save_combine_op to first save these
 // in a single file. Then, we use load_combine_op to load these sequentially
 template <typename T, typename U>
-void SaveLoadCombineOp() {
+void SaveLoadCombineOp(bool save_as_mmap_format = false) {
   paddle::framework::Scope scope;
   paddle::platform::CPUPlace place;
 
@@ -107,9 +107,11 @@ void SaveLoadCombineOp() {
                                             &scope, &expect_lod4);
 
   // Set attributes
-  std::string filename = "check_tensor.ls";
+  std::string filename =
+      save_as_mmap_format ? "check_tensor_mmap.ls" : "check_tensor.ls";
   paddle::framework::AttributeMap attrs;
   attrs.insert({"file_path", std::string(filename)});
+  attrs.insert({"save_as_mmap_format", save_as_mmap_format});
 
   // Run the save_combine_op
   auto save_combine_op = paddle::framework::OpRegistry::CreateOp(
@@ -147,6 +149,8 @@ TEST(SaveLoadCombineBF16Op, CPU) {
   SaveLoadCombineOp<paddle::platform::bfloat16, paddle::platform::bfloat16>();
 }
 
+TEST(SaveLoadCombineMmapOp, CPU) { SaveLoadCombineOp<float, float>(true); }
+
 // FP16 version of SaveLoadCombineOp Test, only altering the saving aspect
 // to save as FP16.
 TEST(SaveCombineFP16Op, CPU) {
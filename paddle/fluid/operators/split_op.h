@@ -144,6 +144,28 @@ class SplitOpKernel : public framework::OpKernel<T> {
 
     auto place = ctx.GetPlace();
 
+    // The outputs along the axis 0 are contiguous, so they are made the
+    // copy-on-write views of the input on CPU, unless any of them has a
+    // memory block of its own to write, e.g. a part of a fused buffer.
+    if (axis == 0 && platform::is_cpu_place(place)) {
+      bool can_share = true;
+      for (auto* out : outs) {
+        can_share = can_share && out->dims()[0] > 0 &&
+                    out->CanShareDataCopyOnWrite(*in);
+      }
+      if (can_share) {
+        int64_t begin = 0;
+        for (auto* out : outs) {
+          auto out_dims = out->dims();
+          int64_t end = begin + out_dims[0];
+          out->ShareDataCopyOnWrite(in->Slice(begin, end));
+          out->Resize(out_dims);
+          begin = end;
+        }
+        return;
+      }
+    }
+
     std::vector<const framework::Tensor*> shape_refer;
     for (size_t j = 0; j < outs.size(); ++j) {
       outs[j]->mutable_data<T>(ctx.GetPlace());
@@ -39,8 +39,7 @@ class SqueezeKernel : public framework::OpKernel<T> {
     auto x_dims = in->dims();
     auto out_dims = GetOutputShape(axes, x_dims, true);
 
-    out->mutable_data(context.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, context.GetPlace(),
         context.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -56,8 +55,9 @@ class SqueezeGradKernel : public framework::OpKernel<T> {
     auto *d_x = ctx.Output<framework::LoDTensor>(framework::GradVarName("X"));
     auto in_dims = ctx.Input<framework::LoDTensor>("X")->dims();
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopySync(*d_out, ctx.GetPlace(), d_x);
+    framework::TensorCopyOnWrite(
+        *d_out, ctx.GetPlace(),
+        ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(in_dims);
   }
 };
@@ -74,8 +74,7 @@ class Squeeze2Kernel : public framework::OpKernel<T> {
     auto x_dims = in->dims();
     auto out_dims = GetOutputShape(axes, x_dims, true);
 
-    out->mutable_data(context.GetPlace(), in->type());
-    framework::TensorCopy(
+    framework::TensorCopyOnWrite(
         *in, context.GetPlace(),
         context.template device_context<platform::DeviceContext>(), out);
     out->Resize(out_dims);
@@ -94,8 +93,9 @@ class Squeeze2GradKernel : public framework::OpKernel<T> {
     auto xshape_dims = ctx.Input<framework::LoDTensor>("XShape")->dims();
     auto x_dims = framework::slice_ddim(xshape_dims, 1, xshape_dims.size());
 
-    d_x->mutable_data(ctx.GetPlace(), d_out->type());
-    framework::TensorCopySync(*d_out, ctx.GetPlace(), d_x);
+    framework::TensorCopyOnWrite(
+        *d_out, ctx.GetPlace(),
+        ctx.template device_context<platform::DeviceContext>(), d_x);
     d_x->Resize(x_dims);
   }
 };
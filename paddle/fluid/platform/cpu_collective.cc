@@ -0,0 +1,583 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef _WIN32
+#include "paddle/fluid/platform/cpu_collective.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <thread>  // NOLINT
+
+#include "gflags/gflags.h"
+#include "glog/logging.h"
+#include "paddle/fluid/platform/enforce.h"
+#include "paddle/fluid/platform/float16.h"
+#include "paddle/fluid/string/split.h"
+
+DECLARE_string(cpu_allreduce_algorithm);
+DECLARE_bool(cpu_allreduce_fp16_compression);
+
+namespace paddle {
+namespace platform {
+
+namespace {
+
+constexpr char kCommMagic[8] = {'P', 'D', 'C', 'P', 'U', 'C', 'O', 'M'};
+
+// Sent by a rank connecting to a lower rank.
+struct CommHeader {
+  char magic[8];
+  int32_t ring_id;
+  int32_t rank;
+};
+
+// The data not greater than it is all reduced by kRecursiveHalving for
+// kAuto, see the benchmark of cpu_collective_test.
+constexpr int64_t kRecursiveHalvingMaxBytes = 32 << 10;
+
+// Wait for the ranks not started yet up to 15 minutes, as the NCCL comm id.
+constexpr int kConnectTimeoutMs = 900 * 1000;
+
+#define CPU_COMM_CHECK(call, name)                                         \
+  do {                                                                     \
+    int retval;                                                            \
+    do {                                                                   \
+      retval = (call);                                                     \
+    } while (retval == -1 && errno == EINTR);                              \
+    PADDLE_ENFORCE_NE(retval, -1, platform::errors::Unavailable(           \
+                                      "Call to %s failed: %s", name,       \
+                                      strerror(errno)));                   \
+  } while (false)
+
+static sockaddr_in ParseEndpoint(const std::string &ep) {
+  auto addr = string::Split(ep, ':');
+  PADDLE_ENFORCE_EQ(
+      addr.size(), 2UL,
+      platform::errors::InvalidArgument(
+          "The endpoint should contain host and port, but got %s.", ep));
+  struct addrinfo hints, *res = nullptr;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  PADDLE_ENFORCE_EQ(getaddrinfo(addr[0].c_str(), nullptr, &hints, &res), 0,
+                    platform::errors::InvalidArgument(
+                        "Fail to get the address of the host %s.", addr[0]));
+  sockaddr_in sin = *reinterpret_cast<sockaddr_in *>(res->ai_addr);
+  freeaddrinfo(res);
+  sin.sin_port = htons(std::stoi(addr[1]));
+  return sin;
+}
+
+static bool SendAll(int fd, const void *buf, size_t bytes) {
+  auto *p = static_cast<const char *>(buf);
+  while (bytes > 0) {
+    ssize_t n = send(fd, p, bytes, MSG_NOSIGNAL);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static bool RecvAll(int fd, void *buf, size_t bytes) {
+  auto *p = static_cast<char *>(buf);
+  while (bytes > 0) {
+    ssize_t n = recv(fd, p, bytes, 0);
+    if (n == -1 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    bytes -= n;
+  }
+  return true;
+}
+
+static int Listen(const std::string &ep, int backlog) {
+  sockaddr_in address = ParseEndpoint(ep);
+  address.sin_addr.s_addr = INADDR_ANY;
+  int fd = -1;
+  CPU_COMM_CHECK(fd = socket(AF_INET, SOCK_STREAM, 0), "socket");
+  int opt = 1;
+  CPU_COMM_CHECK(setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)),
+                 "setsockopt");
+  int waited_ms = 0;
+  while (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) ==
+         -1) {
+    PADDLE_ENFORCE_LT(waited_ms, kConnectTimeoutMs,
+                      platform::errors::Unavailable(
+                          "Bind %s failed: %s", ep, strerror(errno)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    waited_ms += 100;
+  }
+  CPU_COMM_CHECK(listen(fd, backlog), "listen");
+  return fd;
+}
+
+static bool IsValidHeader(const CommHeader &header, int ring_id, int rank) {
+  return memcmp(header.magic, kCommMagic, sizeof(kCommMagic)) == 0 &&
+         header.ring_id == ring_id && header.rank == rank;
+}
+
+// Connect to the peer rank listening at the endpoint, retrying until it
+// accepts the connection of the ring and replies with its header. The reply
+// also tells a socket connected to itself, which happens when connecting to
+// a local port not listened on yet.
+static int Connect(const std::string &ep, const CommHeader &header,
+                   int peer) {
+  sockaddr_in address = ParseEndpoint(ep);
+  int waited_ms = 0;
+  while (true) {
+    int fd = -1;
+    CPU_COMM_CHECK(fd = socket(AF_INET, SOCK_STREAM, 0), "socket");
+    CommHeader reply;
+    if (connect(fd, reinterpret_cast<sockaddr *>(&address),
+                sizeof(address)) == 0 &&
+        SendAll(fd, &header, sizeof(header)) &&
+        RecvAll(fd, &reply, sizeof(reply)) &&
+        IsValidHeader(reply, header.ring_id, peer)) {
+      return fd;
+    }
+    close(fd);
+    PADDLE_ENFORCE_LT(waited_ms, kConnectTimeoutMs,
+                      platform::errors::Unavailable(
+                          "Connect %s failed: %s", ep, strerror(errno)));
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    waited_ms += 100;
+  }
+}
+
+template <typename T>
+struct SumFunctor {
+  T operator()(T a, T b) const { return a + b; }
+};
+
+template <typename T>
+struct MaxFunctor {
+  T operator()(T a, T b) const { return a > b ? a : b; }
+};
+
+template <typename T>
+struct MinFunctor {
+  T operator()(T a, T b) const { return a < b ? a : b; }
+};
+
+template <typename T>
+struct ProdFunctor {
+  T operator()(T a, T b) const { return a * b; }
+};
+
+template <typename T, template <typename> class Functor>
+void ReduceTo(void *dst, const void *src, int64_t n) {
+  auto *x = static_cast<T *>(dst);
+  auto *y = static_cast<const T *>(src);
+  Functor<T> functor;
+  for (int64_t i = 0; i < n; ++i) {
+    x[i] = functor(x[i], y[i]);
+  }
+}
+
+// float16 is reduced in float32.
+template <template <typename> class Functor>
+void ReduceFloat16To(void *dst, const void *src, int64_t n) {
+  auto *x = static_cast<float16 *>(dst);
+  auto *y = static_cast<const float16 *>(src);
+  Functor<float> functor;
+  for (int64_t i = 0; i < n; ++i) {
+    x[i] = static_cast<float16>(
+        functor(static_cast<float>(x[i]), static_cast<float>(y[i])));
+  }
+}
+
+template <typename T>
+void (*GetReduceFunc(CPUReduceOp op))(void *, const void *, int64_t) {
+  switch (op) {
+    case CPUReduceOp::kSum:
+      return &ReduceTo<T, SumFunctor>;
+    case CPUReduceOp::kMax:
+      return &ReduceTo<T, MaxFunctor>;
+    case CPUReduceOp::kMin:
+      return &ReduceTo<T, MinFunctor>;
+    case CPUReduceOp::kProd:
+      return &ReduceTo<T, ProdFunctor>;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument("Invalid reduce op: %d.",
+                                                 static_cast<int>(op)));
+}
+
+template <>
+void (*GetReduceFunc<float16>(CPUReduceOp op))(void *, const void *,
+                                               int64_t) {
+  switch (op) {
+    case CPUReduceOp::kSum:
+      return &ReduceFloat16To<SumFunctor>;
+    case CPUReduceOp::kMax:
+      return &ReduceFloat16To<MaxFunctor>;
+    case CPUReduceOp::kMin:
+      return &ReduceFloat16To<MinFunctor>;
+    case CPUReduceOp::kProd:
+      return &ReduceFloat16To<ProdFunctor>;
+  }
+  PADDLE_THROW(platform::errors::InvalidArgument("Invalid reduce op: %d.",
+                                                 static_cast<int>(op)));
+}
+
+// The offset of the chunk of the n chunks of numel elements.
+inline int64_t ChunkOffset(int64_t numel, int n, int chunk) {
+  return numel * chunk / n;
+}
+
+}  // namespace
+
+CPUComm::CPUComm(const std::vector<std::string> &endpoints, int rank,
+                 int ring_id)
+    : rank_(rank), ring_id_(ring_id), fds_(endpoints.size(), -1) {
+  int nranks = static_cast<int>(endpoints.size());
+  PADDLE_ENFORCE_EQ(
+      rank >= 0 && rank < nranks, true,
+      platform::errors::InvalidArgument(
+          "The rank %d is out of the range of the %d endpoints.", rank,
+          nranks));
+  if (nranks == 1) return;
+
+  // The ranks connect to the lower ranks one by one and then accept the
+  // higher ranks, so each rank accepts once it has connected to all the
+  // ranks lower than it.
+  int listen_fd = Listen(endpoints[rank], nranks);
+  CommHeader header;
+  memcpy(header.magic, kCommMagic, sizeof(kCommMagic));
+  header.ring_id = ring_id;
+  header.rank = rank;
+  for (int peer = 0; peer < rank; ++peer) {
+    fds_[peer] = Connect(endpoints[peer], header, peer);
+  }
+  for (int accepted = 0; accepted < nranks - 1 - rank;) {
+    int fd = -1;
+    CPU_COMM_CHECK(fd = accept(listen_fd, nullptr, nullptr), "accept");
+    CommHeader peer_header;
+    // Drop the connections of others, e.g. probing whether the rank is up,
+    // or of another ring, which is connected again later.
+    if (!RecvAll(fd, &peer_header, sizeof(peer_header)) ||
+        peer_header.rank <= rank || peer_header.rank >= nranks ||
+        !IsValidHeader(peer_header, ring_id, peer_header.rank) ||
+        fds_[peer_header.rank] != -1 || !SendAll(fd, &header, sizeof(header))) {
+      close(fd);
+      continue;
+    }
+    fds_[peer_header.rank] = fd;
+    ++accepted;
+  }
+  close(listen_fd);
+
+  for (int fd : fds_) {
+    if (fd == -1) continue;
+    int opt = 1;
+    CPU_COMM_CHECK(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt)),
+                   "setsockopt");
+    CPU_COMM_CHECK(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK),
+                   "fcntl");
+  }
+  VLOG(1) << "CPUComm of ring " << ring_id << " connected " << nranks
+          << " ranks at rank " << rank;
+}
+
+CPUComm::~CPUComm() {
+  for (int fd : fds_) {
+    if (fd != -1) close(fd);
+  }
+}
+
+void CPUComm::AllReduce(void *data, int64_t numel,
+                        framework::proto::VarType::Type dtype, CPUReduceOp op,
+                        CPUAllReduceAlgo algo) {
+  ReduceFunc reduce = nullptr;
+  size_t elem_size = 0;
+  switch (dtype) {
+    case framework::proto::VarType::FP32:
+      reduce = GetReduceFunc<float>(op);
+      elem_size = sizeof(float);
+      break;
+    case framework::proto::VarType::FP64:
+      reduce = GetReduceFunc<double>(op);
+      elem_size = sizeof(double);
+      break;
+    case framework::proto::VarType::FP16:
+      reduce = GetReduceFunc<float16>(op);
+      elem_size = sizeof(float16);
+      break;
+    case framework::proto::VarType::INT32:
+      reduce = GetReduceFunc<int32_t>(op);
+      elem_size = sizeof(int32_t);
+      break;
+    case framework::proto::VarType::INT64:
+      reduce = GetReduceFunc<int64_t>(op);
+      elem_size = sizeof(int64_t);
+      break;
+    default:
+      PADDLE_THROW(platform::errors::Unimplemented(
+          "The data type %d is not supported by CPUComm::AllReduce.",
+          static_cast<int>(dtype)));
+  }
+  if (nranks() == 1 || numel == 0) return;
+
+  if (algo == CPUAllReduceAlgo::kAuto) {
+    if (FLAGS_cpu_allreduce_algorithm == "ring") {
+      algo = CPUAllReduceAlgo::kRing;
+    } else if (FLAGS_cpu_allreduce_algorithm == "recursive_halving") {
+      algo = CPUAllReduceAlgo::kRecursiveHalving;
+    } else {
+      algo = static_cast<int64_t>(numel * elem_size) <=
+                     kRecursiveHalvingMaxBytes
+                 ? CPUAllReduceAlgo::kRecursiveHalving
+                 : CPUAllReduceAlgo::kRing;
+    }
+  }
+  if (algo == CPUAllReduceAlgo::kRing && numel >= nranks()) {
+    RingAllReduce(static_cast<char *>(data), numel, elem_size, reduce);
+  } else {
+    RecursiveHalvingAllReduce(static_cast<char *>(data), numel, elem_size,
+                              reduce);
+  }
+}
+
+void CPUComm::AllReduceFP16Compressed(float *data, int64_t numel,
+                                      CPUAllReduceAlgo algo) {
+  std::vector<float16> compressed(data, data + numel);
+  AllReduce(compressed.data(), numel, framework::proto::VarType::FP16,
+            CPUReduceOp::kSum, algo);
+  for (int64_t i = 0; i < numel; ++i) {
+    data[i] = static_cast<float>(compressed[i]);
+  }
+}
+
+void CPUComm::AllReduceGradient(void *data, int64_t numel,
+                                framework::proto::VarType::Type dtype) {
+  if (FLAGS_cpu_allreduce_fp16_compression &&
+      dtype == framework::proto::VarType::FP32) {
+    AllReduceFP16Compressed(static_cast<float *>(data), numel);
+  } else {
+    AllReduce(data, numel, dtype, CPUReduceOp::kSum);
+  }
+}
+
+void CPUComm::RingAllReduce(char *data, int64_t numel, size_t elem_size,
+                            ReduceFunc reduce) {
+  int n = nranks();
+  int right = (rank_ + 1) % n;
+  int left = (rank_ + n - 1) % n;
+  auto chunk_ptr = [&](int chunk) {
+    return data + ChunkOffset(numel, n, chunk) * elem_size;
+  };
+  auto chunk_numel = [&](int chunk) {
+    return ChunkOffset(numel, n, chunk + 1) - ChunkOffset(numel, n, chunk);
+  };
+  char *scratch = Scratch((numel / n + 1) * elem_size);
+
+  // Reduce scatter: after the step s, the chunk rank - s - 1 holds the sum
+  // of the ranks from rank - s - 1 to rank.
+  for (int s = 0; s < n - 1; ++s) {
+    int send_chunk = (rank_ - s + n) % n;
+    int recv_chunk = (rank_ - s - 1 + n) % n;
+    SendRecv(right, chunk_ptr(send_chunk), chunk_numel(send_chunk) * elem_size,
+             left, scratch, chunk_numel(recv_chunk) * elem_size);
+    reduce(chunk_ptr(recv_chunk), scratch, chunk_numel(recv_chunk));
+  }
+  // All gather: the chunk rank + 1 is reduced over all the ranks.
+  for (int s = 0; s < n - 1; ++s) {
+    int send_chunk = (rank_ + 1 - s + n) % n;
+    int recv_chunk = (rank_ - s + n) % n;
+    SendRecv(right, chunk_ptr(send_chunk), chunk_numel(send_chunk) * elem_size,
+             left, chunk_ptr(recv_chunk), chunk_numel(recv_chunk) * elem_size);
+  }
+}
+
+void CPUComm::RecursiveHalvingAllReduce(char *data, int64_t numel,
+                                        size_t elem_size, ReduceFunc reduce) {
+  int n = nranks();
+  int pof2 = 1;
+  while (pof2 * 2 <= n) pof2 *= 2;
+  int rem = n - pof2;
+  size_t bytes = numel * elem_size;
+  char *scratch = Scratch(bytes);
+
+  // Fold the ranks beyond the power of 2: each of the first 2 * rem ranks of
+  // even rank passes its data to the next rank, and waits for the result.
+  int new_rank = -1;
+  if (rank_ < 2 * rem) {
+    if (rank_ % 2 == 0) {
+      SendRecv(rank_ + 1, data, bytes, -1, nullptr, 0);
+    } else {
+      SendRecv(-1, nullptr, 0, rank_ - 1, scratch, bytes);
+      reduce(data, scratch, numel);
+      new_rank = rank_ / 2;
+    }
+  } else {
+    new_rank = rank_ - rem;
+  }
+
+  if (new_rank != -1) {
+    auto real_rank = [rem](int r) { return r < rem ? r * 2 + 1 : r + rem; };
+    // Reduce scatter by halving the elements kept with the partner of each
+    // step, then all gather by doubling them in the reverse order.
+    std::vector<std::pair<int64_t, int64_t>> kept;
+    int64_t lo = 0, hi = numel;
+    for (int mask = pof2 / 2; mask >= 1; mask /= 2) {
+      int partner = real_rank(new_rank ^ mask);
+      int64_t mid = lo + (hi - lo) / 2;
+      int64_t keep_lo = lo, keep_hi = mid, send_lo = mid, send_hi = hi;
+      if (new_rank & mask) {
+        std::swap(keep_lo, send_lo);
+        std::swap(keep_hi, send_hi);
+      }
+      SendRecv(partner, data + send_lo * elem_size,
+               (send_hi - send_lo) * elem_size, partner, scratch,
+               (keep_hi - keep_lo) * elem_size);
+      reduce(data + keep_lo * elem_size, scratch, keep_hi - keep_lo);
+      kept.emplace_back(lo, hi);
+      lo = keep_lo;
+      hi = keep_hi;
+    }
+    for (int mask = 1; mask < pof2; mask *= 2) {
+      int partner = real_rank(new_rank ^ mask);
+      auto range = kept.back();
+      kept.pop_back();
+      // The partner kept the other part of the range.
+      int64_t other_lo = lo == range.first ? hi : range.first;
+      int64_t other_hi = lo == range.first ? range.second : lo;
+      SendRecv(partner, data + lo * elem_size, (hi - lo) * elem_size, partner,
+               data + other_lo * elem_size, (other_hi - other_lo) * elem_size);
+      lo = range.first;
+      hi = range.second;
+    }
+  }
+
+  if (rank_ < 2 * rem) {
+    if (rank_ % 2 == 0) {
+      SendRecv(-1, nullptr, 0, rank_ + 1, data, bytes);
+    } else {
+      SendRecv(rank_ - 1, data, bytes, -1, nullptr, 0);
+    }
+  }
+}
+
+void CPUComm::Broadcast(void *data, int64_t bytes, int root) {
+  if (nranks() == 1) return;
+  if (rank_ == root) {
+    for (int peer = 0; peer < nranks(); ++peer) {
+      if (peer != root) SendRecv(peer, data, bytes, -1, nullptr, 0);
+    }
+  } else {
+    SendRecv(-1, nullptr, 0, root, data, bytes);
+  }
+}
+
+void CPUComm::Barrier() {
+  int32_t value = 0;
+  AllReduce(&value, 1, framework::proto::VarType::INT32, CPUReduceOp::kSum,
+            CPUAllReduceAlgo::kRecursiveHalving);
+}
+
+void CPUComm::SendRecv(int send_rank, const void *send_buf, size_t send_bytes,
+                       int recv_rank, void *recv_buf, size_t recv_bytes) {
+  auto *send_ptr = static_cast<const char *>(send_buf);
+  auto *recv_ptr = static_cast<char *>(recv_buf);
+  size_t sent = send_rank == -1 ? send_bytes : 0;
+  size_t received = recv_rank == -1 ? recv_bytes : 0;
+  while (sent < send_bytes || received < recv_bytes) {
+    pollfd fds[2];
+    int num_fds = 0;
+    if (sent < send_bytes) {
+      fds[num_fds++] = {fds_[send_rank], POLLOUT, 0};
+    }
+    if (received < recv_bytes) {
+      if (num_fds == 1 && fds[0].fd == fds_[recv_rank]) {
+        fds[0].events |= POLLIN;
+      } else {
+        fds[num_fds++] = {fds_[recv_rank], POLLIN, 0};
+      }
+    }
+    CPU_COMM_CHECK(poll(fds, num_fds, -1), "poll");
+    for (int i = 0; i < num_fds; ++i) {
+      if (fds[i].revents & (POLLERR | POLLNVAL)) {
+        PADDLE_THROW(platform::errors::Unavailable(
+            "The connection of CPUComm at rank %d is broken.", rank_));
+      }
+      if ((fds[i].revents & POLLOUT) && sent < send_bytes) {
+        ssize_t n = send(fds[i].fd, send_ptr + sent, send_bytes - sent,
+                         MSG_NOSIGNAL);
+        if (n > 0) {
+          sent += n;
+        } else if (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                   errno != EINTR) {
+          PADDLE_THROW(platform::errors::Unavailable(
+              "Send from rank %d to rank %d failed: %s", rank_, send_rank,
+              strerror(errno)));
+        }
+      }
+      if ((fds[i].revents & (POLLIN | POLLHUP)) && received < recv_bytes) {
+        ssize_t n =
+            recv(fds[i].fd, recv_ptr + received, recv_bytes - received, 0);
+        if (n > 0) {
+          received += n;
+        } else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK &&
+                              errno != EINTR)) {
+          PADDLE_THROW(platform::errors::Unavailable(
+              "Receive from rank %d at rank %d failed: %s", recv_rank, rank_,
+              n == 0 ? "connection closed" : strerror(errno)));
+        }
+      }
+    }
+  }
+}
+
+char *CPUComm::Scratch(size_t bytes) {
+  if (scratch_.size() < bytes) scratch_.resize(bytes);
+  return scratch_.data();
+}
+
+CPUComm *CPUCommContext::CreateComm(const std::vector<std::string> &endpoints,
+                                    int rank, int ring_id) {
+  std::unique_ptr<CPUComm> comm(new CPUComm(endpoints, rank, ring_id));
+  std::lock_guard<std::mutex> lock(comm_map_mutex_);
+  auto &slot = comm_map_[ring_id];
+  slot = std::move(comm);
+  return slot.get();
+}
+
+bool CPUCommContext::Has(int ring_id) const {
+  std::lock_guard<std::mutex> lock(comm_map_mutex_);
+  return comm_map_.count(ring_id) > 0;
+}
+
+CPUComm *CPUCommContext::Get(int ring_id) const {
+  std::lock_guard<std::mutex> lock(comm_map_mutex_);
+  auto it = comm_map_.find(ring_id);
+  PADDLE_ENFORCE_NE(it, comm_map_.end(),
+                    platform::errors::InvalidArgument(
+                        "CPUComm of ring id %d has not been initialized.",
+                        ring_id));
+  return it->second.get();
+}
+
+}  // namespace platform
+}  // namespace paddle
+#endif
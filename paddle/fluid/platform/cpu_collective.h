@@ -0,0 +1,134 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#ifndef _WIN32
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/framework/framework.pb.h"
+#include "paddle/fluid/platform/macros.h"
+
+namespace paddle {
+namespace platform {
+
+enum class CPUReduceOp { kSum = 0, kMax = 1, kMin = 2, kProd = 3 };
+
+// kRing passes 2 * (nranks - 1) / nranks of the data through each rank in
+// 2 * (nranks - 1) steps, suiting the large data. kRecursiveHalving passes
+// about as much in 2 * log2(nranks) steps, suiting the small data for fewer
+// round trips. kAuto picks one by the size of the data.
+enum class CPUAllReduceAlgo { kAuto = 0, kRing = 1, kRecursiveHalving = 2 };
+
+/*
+ * A communicator of the collective training on the CPU among the processes
+ * of the endpoints, with each process connected to all the others by TCP.
+ * The calls must be made in the same order by all the ranks, and by one
+ * thread at a time.
+ */
+class CPUComm {
+ public:
+  // Connect to the ranks of the endpoints, listening on the endpoint of the
+  // rank. The connections of different ring ids are separate, and are built
+  // in the same order by all the ranks.
+  CPUComm(const std::vector<std::string>& endpoints, int rank,
+          int ring_id = 0);
+
+  ~CPUComm();
+
+  int rank() const { return rank_; }
+
+  int nranks() const { return static_cast<int>(fds_.size()); }
+
+  int ring_id() const { return ring_id_; }
+
+  // All reduce the numel elements of the dtype at data in place.
+  void AllReduce(void* data, int64_t numel,
+                 framework::proto::VarType::Type dtype, CPUReduceOp op,
+                 CPUAllReduceAlgo algo = CPUAllReduceAlgo::kAuto);
+
+  // All reduce the sum of the float32 at data, passing them between the
+  // ranks as float16, which halves the bytes sent but loses the precision.
+  void AllReduceFP16Compressed(float* data, int64_t numel,
+                               CPUAllReduceAlgo algo = CPUAllReduceAlgo::kAuto);
+
+  // All reduce the sum of the gradients, passed as float16 if they are
+  // float32 and FLAGS_cpu_allreduce_fp16_compression is set.
+  void AllReduceGradient(void* data, int64_t numel,
+                         framework::proto::VarType::Type dtype);
+
+  // Broadcast the bytes at data from the root to the other ranks.
+  void Broadcast(void* data, int64_t bytes, int root);
+
+  void Barrier();
+
+ private:
+  // Reduce n elements of src into dst.
+  using ReduceFunc = void (*)(void* dst, const void* src, int64_t n);
+
+  void RingAllReduce(char* data, int64_t numel, size_t elem_size,
+                     ReduceFunc reduce);
+
+  void RecursiveHalvingAllReduce(char* data, int64_t numel, size_t elem_size,
+                                 ReduceFunc reduce);
+
+  // Send to a rank while receiving from a rank, so the ranks sending to each
+  // other do not wait for each other.
+  void SendRecv(int send_rank, const void* send_buf, size_t send_bytes,
+                int recv_rank, void* recv_buf, size_t recv_bytes);
+
+  char* Scratch(size_t bytes);
+
+  int rank_;
+  int ring_id_;
+  // The sockets connected to the ranks, -1 for the rank itself.
+  std::vector<int> fds_;
+  // The buffer of the data received to reduce.
+  std::vector<char> scratch_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUComm);
+};
+
+// A singleton of the CPU communicators by the ring ids.
+class CPUCommContext {
+ public:
+  static CPUCommContext& Instance() {
+    static CPUCommContext comm_ctx;
+    return comm_ctx;
+  }
+
+  // A latter comm of the same ring id overrides the former.
+  CPUComm* CreateComm(const std::vector<std::string>& endpoints, int rank,
+                      int ring_id = 0);
+
+  bool Has(int ring_id) const;
+
+  CPUComm* Get(int ring_id) const;
+
+ private:
+  CPUCommContext() = default;
+
+  mutable std::mutex comm_map_mutex_;
+  std::map<int, std::unique_ptr<CPUComm>> comm_map_;
+
+  DISABLE_COPY_AND_ASSIGN(CPUCommContext);
+};
+
+}  // namespace platform
+}  // namespace paddle
+#endif
@@ -0,0 +1,208 @@
+// Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "paddle/fluid/platform/cpu_collective.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+using VarType = framework::proto::VarType;
+
+static std::vector<std::string> MakeEndpoints(int nranks) {
+  // Separate the ports of the tests run at the same time, below the range of
+  // the ports bound by connect.
+  static int next_port = 10000 + getpid() % 100 * 200;
+  std::vector<std::string> endpoints;
+  for (int i = 0; i < nranks; ++i) {
+    endpoints.emplace_back("127.0.0.1:" + std::to_string(next_port++));
+  }
+  return endpoints;
+}
+
+// Run the func by a process per endpoint, each with a comm of its rank.
+static void RunRanks(const std::vector<std::string> &endpoints,
+                     const std::function<void(CPUComm *)> &func) {
+  int nranks = static_cast<int>(endpoints.size());
+  std::vector<pid_t> pids;
+  for (int rank = 0; rank < nranks; ++rank) {
+    pid_t pid = fork();
+    ASSERT_NE(pid, -1);
+    if (pid == 0) {
+      int status = 0;
+      try {
+        CPUComm comm(endpoints, rank);
+        func(&comm);
+        status = ::testing::Test::HasFailure() ? 1 : 0;
+      } catch (std::exception &e) {
+        LOG(ERROR) << "Rank " << rank << " fails: " << e.what();
+        status = 2;
+      }
+      _exit(status);
+    }
+    pids.emplace_back(pid);
+  }
+  for (int rank = 0; rank < nranks; ++rank) {
+    int status = -1;
+    waitpid(pids[rank], &status, 0);
+    EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0)
+        << "rank " << rank << " of " << nranks << " ranks fails";
+  }
+}
+
+static void RunRanks(int nranks, const std::function<void(CPUComm *)> &func) {
+  RunRanks(MakeEndpoints(nranks), func);
+}
+
+template <typename T>
+static void TestAllReduce(int nranks, int64_t numel, VarType::Type dtype,
+                          CPUAllReduceAlgo algo) {
+  RunRanks(nranks, [=](CPUComm *comm) {
+    auto value = [](int rank, int64_t i) {
+      return static_cast<T>((rank + i) % 3 + 1);
+    };
+    std::vector<std::pair<CPUReduceOp, std::function<T(T, T)>>> ops{
+        {CPUReduceOp::kSum, [](T a, T b) { return a + b; }},
+        {CPUReduceOp::kMax, [](T a, T b) { return a > b ? a : b; }},
+        {CPUReduceOp::kMin, [](T a, T b) { return a < b ? a : b; }},
+        {CPUReduceOp::kProd, [](T a, T b) { return a * b; }}};
+    for (auto &op : ops) {
+      std::vector<T> data(numel);
+      for (int64_t i = 0; i < numel; ++i) {
+        data[i] = value(comm->rank(), i);
+      }
+      comm->AllReduce(data.data(), numel, dtype, op.first, algo);
+      for (int64_t i = 0; i < numel; ++i) {
+        T expected = value(0, i);
+        for (int rank = 1; rank < nranks; ++rank) {
+          expected = op.second(expected, value(rank, i));
+        }
+        ASSERT_EQ(data[i], expected) << "op " << static_cast<int>(op.first)
+                                     << ", element " << i;
+      }
+    }
+  });
+}
+
+TEST(CPUComm, ring_all_reduce) {
+  for (int nranks = 1; nranks <= 5; ++nranks) {
+    for (int64_t numel : {1, 7, 1000}) {
+      TestAllReduce<float>(nranks, numel, VarType::FP32,
+                           CPUAllReduceAlgo::kRing);
+    }
+  }
+  TestAllReduce<int64_t>(3, 100, VarType::INT64, CPUAllReduceAlgo::kRing);
+}
+
+TEST(CPUComm, recursive_halving_all_reduce) {
+  for (int nranks = 1; nranks <= 7; ++nranks) {
+    for (int64_t numel : {1, 7, 1000}) {
+      TestAllReduce<float>(nranks, numel, VarType::FP32,
+                           CPUAllReduceAlgo::kRecursiveHalving);
+    }
+  }
+  TestAllReduce<double>(3, 100, VarType::FP64,
+                        CPUAllReduceAlgo::kRecursiveHalving);
+  TestAllReduce<int32_t>(6, 100, VarType::INT32,
+                         CPUAllReduceAlgo::kRecursiveHalving);
+}
+
+TEST(CPUComm, fp16_compression) {
+  RunRanks(3, [](CPUComm *comm) {
+    std::vector<float> data(1000);
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = 0.001f * i * (comm->rank() + 1);
+    }
+    comm->AllReduceFP16Compressed(data.data(), data.size());
+    for (size_t i = 0; i < data.size(); ++i) {
+      float expected = 0.006f * i;
+      ASSERT_NEAR(data[i], expected, std::abs(expected) * 2e-3f + 1e-4f);
+    }
+  });
+}
+
+TEST(CPUComm, broadcast_and_barrier) {
+  RunRanks(4, [](CPUComm *comm) {
+    std::vector<int64_t> data(100, comm->rank());
+    comm->Broadcast(data.data(), data.size() * sizeof(int64_t), 2);
+    for (auto value : data) {
+      ASSERT_EQ(value, 2);
+    }
+    for (int i = 0; i < 10; ++i) {
+      comm->Barrier();
+    }
+  });
+}
+
+TEST(CPUComm, multiple_rings) {
+  auto endpoints = MakeEndpoints(3);
+  RunRanks(endpoints, [&](CPUComm *comm) {
+    // The second ring connects at the same endpoints as the first.
+    auto &ctx = CPUCommContext::Instance();
+    auto *ring = ctx.CreateComm(endpoints, comm->rank(), 1);
+    EXPECT_TRUE(ctx.Has(1));
+    EXPECT_FALSE(ctx.Has(2));
+    EXPECT_EQ(ctx.Get(1), ring);
+    EXPECT_EQ(ring->ring_id(), 1);
+    float data = comm->rank() + 1;
+    ring->AllReduce(&data, 1, VarType::FP32, CPUReduceOp::kSum);
+    comm->AllReduce(&data, 1, VarType::FP32, CPUReduceOp::kSum);
+    EXPECT_EQ(data, 18.0f);
+  });
+}
+
+// The time of all reducing the float32 of each size among 4 ranks by each
+// algorithm, by which kAuto picks the algorithm.
+TEST(CPUComm, benchmark_all_reduce) {
+  const int nranks = 4;
+  RunRanks(nranks, [](CPUComm *comm) {
+    for (int64_t bytes = 1 << 10; bytes <= 16 << 20; bytes *= 4) {
+      std::vector<float> data(bytes / sizeof(float), 1.0f);
+      int iters = static_cast<int>(std::max<int64_t>(2, (16 << 20) / bytes));
+      std::string times;
+      for (auto algo :
+           {CPUAllReduceAlgo::kRing, CPUAllReduceAlgo::kRecursiveHalving}) {
+        comm->Barrier();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < iters; ++i) {
+          comm->AllReduce(data.data(), data.size(), VarType::FP32,
+                          CPUReduceOp::kMax, algo);
+        }
+        times += " " + std::to_string(std::chrono::duration<double, std::micro>(
+                                          std::chrono::steady_clock::now() -
+                                          start)
+                                          .count() /
+                                      iters);
+      }
+      if (comm->rank() == 0) {
+        LOG(INFO) << "All reduce " << bytes
+                  << " bytes by ring and recursive halving (us):" << times;
+      }
+    }
+  });
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -229,6 +229,24 @@ DEFINE_int32(communicator_send_queue_size, 20,
              "queue size to recv gradient before send");
 #endif
 
+#ifdef PADDLE_WITH_PSCORE
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_pserver_sparse_table_snapshot_save
+ * Since Version: 2.1.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_pserver_sparse_table_snapshot_save=true, the sparse tables
+ *          are saved as <table>.block<id>.bin instead of the text files.
+ * Note: Save the sparse tables on the parameter servers in a binary snapshot
+ *       format. Every shard of a table is copied in its own task thread and
+ *       written in columns, so the pulls and pushes go on while saving and
+ *       the saved shards are consistent. The snapshots are loaded by the
+ *       same load path as the text files.
+ */
+DEFINE_bool(pserver_sparse_table_snapshot_save, false,
+            "save the sparse tables in the binary snapshot format");
+#endif
+
 /**
  * Distributed related FLAG
  * Name: FLAGS_dist_threadpool_size
@@ -309,6 +327,44 @@ DEFINE_double(memory_fraction_of_eager_deletion, 1.0,
               "only the FLAGS_memory_fraction_of_eager_deletion of the largest "
               "variables would be deleted.");
 
+/**
+ * Memory related FLAG
+ * Name: FLAGS_cpu_deferred_gc_slack_mb
+ * Since Version: 2.1
+ * Value Range: double, default=0
+ * Example: FLAGS_cpu_deferred_gc_slack_mb=64, the garbages on CPU collected
+ *          by ParallelExecutor are batched per thread and released by a
+ *          background thread, and at most 64MB of them wait to be released.
+ * Note: The threads running the ops hand the garbages over instead of
+ *       releasing them to the allocator one by one, which reduces the lock
+ *       contention of the allocator when FLAGS_eager_delete_tensor_gb=0.
+ *       If it is not greater than 0, the garbages are released by the
+ *       threads collecting them.
+ */
+DEFINE_double(cpu_deferred_gc_slack_mb, 0,
+              "The bound (MB) of the garbages on CPU waiting to be released "
+              "by the background reclaimer. The releases are not deferred if "
+              "it is not greater than 0.");
+
+/**
+ * Memory related FLAG
+ * Name: FLAGS_dataloader_shm_pool_mb
+ * Since Version: 2.1
+ * Value Range: uint64, default=0
+ * Example: FLAGS_dataloader_shm_pool_mb=512, each worker process of the
+ *          DataLoader maps up to 512MB of shared memory segments, whose
+ *          slots hold the tensors sent to the trainer and are reused once
+ *          the trainer releases them.
+ * Note: The tensors not fitting in the pool, or sent when it is 0, are put
+ *       in their own shared memory files, created and unlinked per tensor.
+ *       The slots of the tensors sent but never read, e.g. left in the
+ *       queue when the DataLoader is shut down early, are not reused, and
+ *       only reclaimed when the worker exits and unlinks its segments.
+ */
+DEFINE_uint64(dataloader_shm_pool_mb, 0,
+              "The size (MB) of the pool of the shared memory segments of "
+              "each DataLoader worker. The pool is disabled if it is 0.");
+
 /**
  * Allocator related FLAG
  * Name: FLAGS_allocator_strategy
@@ -556,6 +612,23 @@ DEFINE_int32(
     "less FLAGS_max_inplace_grad_add, than it will be use several grad_add"
     "instead of sum. Default is 0.");
 
+/**
+ * Performance related FLAG
+ * Name: dygraph_backward_num_threads
+ * Since Version: 2.1.0
+ * Value Range: int32, default=1
+ * Example: FLAGS_dygraph_backward_num_threads=4, run the independent grad
+ * ops of a dygraph backward on 4 threads.
+ * Note: Only the backward of the grad ops all on CPU runs in parallel, and
+ * not that of the data parallel training. The gradients summed from several
+ * grad ops are summed in the order the ops finish, unless
+ * FLAGS_sort_sum_gradient is set.
+ */
+DEFINE_int32(dygraph_backward_num_threads, 1,
+             "The number of threads running the grad ops of the dygraph "
+             "backward on CPU. Default is 1, which runs them in order on "
+             "the calling thread.");
+
 /**
  * Debug related FLAG
  * Name: tracer_mkldnn_ops_on
@@ -602,3 +675,74 @@ DEFINE_bool(check_kernel_launch, false,
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 DEFINE_bool(conv2d_disable_cudnn, false, "Disable cudnn in conv2d");
 #endif
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_enable_op_metrics
+ * Since Version: 2.1.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_op_metrics=true, record the run time of each op type,
+ * kernel and place into the metrics registry.
+ * Note: The metrics can be rendered in the Prometheus text format by
+ * paddle.fluid.core.get_metrics_text.
+ */
+DEFINE_bool(enable_op_metrics, false,
+            "Record the runtime metrics of operators, executors, data feeds "
+            "and the parameter server client.");
+
+/**
+ * Operator related FLAG
+ * Name: FLAGS_enable_infer_shape_cache
+ * Since Version: 2.1.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_enable_infer_shape_cache=true, skip the runtime InferShape
+ * and PrepareData of the ops whose inputs have the same dims, data types,
+ * layouts and places as a former run.
+ * Note: The cache of an op is disabled once its hit rate is low, e.g. for the
+ * dynamic-shape models.
+ */
+DEFINE_bool(enable_infer_shape_cache, false,
+            "Cache the runtime InferShape of operators keyed by the "
+            "signature of their inputs.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_cpu_allreduce_algorithm
+ * Since Version: 2.1.0
+ * Value Range: string, {"auto", "ring", "recursive_halving"}, default="auto"
+ * Example: FLAGS_cpu_allreduce_algorithm="ring", all reduce the data of any
+ * size by the ring algorithm in the collective training on the CPU.
+ * Note: "auto" all reduces the small data by the recursive halving and
+ * doubling for fewer round trips, and the large data by the ring.
+ */
+DEFINE_string(cpu_allreduce_algorithm, "auto",
+              "The algorithm of the all reduce of the collective training on "
+              "the CPU, one of auto, ring and recursive_halving.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_cpu_allreduce_fp16_compression
+ * Since Version: 2.1.0
+ * Value Range: bool, default=false
+ * Example: FLAGS_cpu_allreduce_fp16_compression=true, pass the float32
+ * gradients between the trainers on the CPU as float16.
+ * Note: It halves the bytes sent by the all reduce of the gradients, at the
+ * cost of their precision.
+ */
+DEFINE_bool(cpu_allreduce_fp16_compression, false,
+            "Pass the float32 gradients as float16 in the all reduce of the "
+            "collective training on the CPU.");
+
+/**
+ * Distributed related FLAG
+ * Name: FLAGS_comm_overlap_report_interval
+ * Since Version: 2.1.0
+ * Value Range: int32, default=0
+ * Example: FLAGS_comm_overlap_report_interval=100, log the communication
+ * time per step of the last 100 steps run by the ParallelExecutor, and the
+ * part of it not overlapped by the computation.
+ * Note: 0 to disable the report. Timing the ops adds some overhead.
+ */
+DEFINE_int32(comm_overlap_report_interval, 0,
+             "Log how much the communication overlaps the computation in the "
+             "ParallelExecutor every this many steps, 0 to disable it.");
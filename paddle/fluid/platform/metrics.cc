@@ -0,0 +1,222 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/metrics.h"
+
+#include <stdio.h>
+#include <chrono>  // NOLINT
+#include <fstream>
+#include <sstream>
+
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+static bool IsValidMetricName(const std::string& name) {
+  if (name.empty()) return false;
+  for (size_t i = 0; i < name.size(); ++i) {
+    char c = name[i];
+    bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                 c == '_' || c == ':' || (i > 0 && c >= '0' && c <= '9');
+    if (!valid) return false;
+  }
+  return true;
+}
+
+static std::string EscapeLabelValue(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\') {
+      escaped += "\\\\";
+    } else if (c == '"') {
+      escaped += "\\\"";
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Render the labels inside the braces, e.g. op_type="mul",place="CPUPlace"
+static std::string RenderLabels(const MetricLabels& labels) {
+  std::string rendered;
+  for (auto& label : labels) {
+    PADDLE_ENFORCE_EQ(IsValidMetricName(label.first), true,
+                      platform::errors::InvalidArgument(
+                          "The metric label name %s is invalid.", label.first));
+    if (!rendered.empty()) rendered += ',';
+    rendered += label.first + "=\"" + EscapeLabelValue(label.second) + "\"";
+  }
+  return rendered;
+}
+
+static std::string WithLabels(const std::string& name,
+                              const std::string& labels,
+                              const std::string& extra = "") {
+  std::string all = labels;
+  if (!extra.empty()) {
+    if (!all.empty()) all += ',';
+    all += extra;
+  }
+  return all.empty() ? name : name + "{" + all + "}";
+}
+
+uint64_t MetricHistogram::Count() const {
+  uint64_t count = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    count += BucketCount(i);
+  }
+  return count;
+}
+
+void MetricHistogram::Reset() {
+  for (int i = 0; i < kNumBuckets; ++i) {
+    buckets_[i].store(0, std::memory_order_relaxed);
+  }
+  sum_ns_.store(0, std::memory_order_relaxed);
+}
+
+static uint64_t NowInNsec() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+MetricTimer::MetricTimer(MetricHistogram* histogram) : histogram_(histogram) {
+  if (histogram_) start_ns_ = NowInNsec();
+}
+
+MetricTimer::~MetricTimer() {
+  if (histogram_) histogram_->Observe(NowInNsec() - start_ns_);
+}
+
+MetricsRegistry& MetricsRegistry::Instance() {
+  // leaked on purpose, the metrics may be updated by the threads still
+  // running at exit
+  static MetricsRegistry* registry = new MetricsRegistry();
+  return *registry;
+}
+
+MetricsRegistry::Family* MetricsRegistry::GetFamily(const std::string& name,
+                                                    const std::string& help,
+                                                    bool is_histogram) {
+  PADDLE_ENFORCE_EQ(IsValidMetricName(name), true,
+                    platform::errors::InvalidArgument(
+                        "The metric name %s is invalid.", name));
+  auto it = families_.find(name);
+  if (it == families_.end()) {
+    Family& family = families_[name];
+    family.help = help;
+    family.is_histogram = is_histogram;
+    return &family;
+  }
+  PADDLE_ENFORCE_EQ(
+      it->second.is_histogram, is_histogram,
+      platform::errors::AlreadyExists(
+          "The metric %s is already registered as a %s.", name,
+          it->second.is_histogram ? "histogram" : "counter"));
+  return &it->second;
+}
+
+MetricCounter* MetricsRegistry::GetCounter(const std::string& name,
+                                           const std::string& help,
+                                           const MetricLabels& labels) {
+  std::string key = RenderLabels(labels);
+  std::lock_guard<std::mutex> lock(mu_);
+  auto& counter = GetFamily(name, help, false)->counters[key];
+  if (!counter) counter.reset(new MetricCounter());
+  return counter.get();
+}
+
+MetricHistogram* MetricsRegistry::GetHistogram(const std::string& name,
+                                               const std::string& help,
+                                               const MetricLabels& labels) {
+  std::string key = RenderLabels(labels);
+  std::lock_guard<std::mutex> lock(mu_);
+  auto& histogram = GetFamily(name, help, true)->histograms[key];
+  if (!histogram) histogram.reset(new MetricHistogram());
+  return histogram.get();
+}
+
+std::string MetricsRegistry::Render() const {
+  std::ostringstream os;
+  os.precision(9);
+  std::lock_guard<std::mutex> lock(mu_);
+  for (auto& kv : families_) {
+    const std::string& name = kv.first;
+    const Family& family = kv.second;
+    os << "# HELP " << name << " " << family.help << "\n";
+    if (!family.is_histogram) {
+      os << "# TYPE " << name << " counter\n";
+      for (auto& counter : family.counters) {
+        os << WithLabels(name, counter.first) << " " << counter.second->Get()
+           << "\n";
+      }
+      continue;
+    }
+    os << "# TYPE " << name << " histogram\n";
+    for (auto& histogram : family.histograms) {
+      const std::string& labels = histogram.first;
+      const MetricHistogram& h = *histogram.second;
+      uint64_t cumulative = 0;
+      for (int i = 0; i < MetricHistogram::kNumBuckets - 1; ++i) {
+        cumulative += h.BucketCount(i);
+        std::ostringstream le;
+        le << "le=\"" << MetricHistogram::BucketBound(i) << "\"";
+        os << WithLabels(name + "_bucket", labels, le.str()) << " "
+           << cumulative << "\n";
+      }
+      cumulative += h.BucketCount(MetricHistogram::kNumBuckets - 1);
+      os << WithLabels(name + "_bucket", labels, "le=\"+Inf\"") << " "
+         << cumulative << "\n";
+      os << WithLabels(name + "_sum", labels) << " " << h.SumSeconds() << "\n";
+      os << WithLabels(name + "_count", labels) << " " << cumulative << "\n";
+    }
+  }
+  return os.str();
+}
+
+void MetricsRegistry::Export(const std::string& path) const {
+  std::string tmp_path = path + ".tmp";
+  {
+    std::ofstream fout(tmp_path);
+    PADDLE_ENFORCE_EQ(
+        static_cast<bool>(fout), true,
+        platform::errors::Unavailable("Cannot open %s to export the metrics.",
+                                      tmp_path));
+    fout << Render();
+  }
+  PADDLE_ENFORCE_EQ(
+      rename(tmp_path.c_str(), path.c_str()), 0,
+      platform::errors::Unavailable("Cannot rename %s to %s.", tmp_path, path));
+}
+
+void MetricsRegistry::Reset() {
+  std::lock_guard<std::mutex> lock(mu_);
+  for (auto& kv : families_) {
+    for (auto& counter : kv.second.counters) {
+      counter.second->Reset();
+    }
+    for (auto& histogram : kv.second.histograms) {
+      histogram.second->Reset();
+    }
+  }
+}
+
+}  // namespace platform
+}  // namespace paddle
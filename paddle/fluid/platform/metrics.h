@@ -0,0 +1,146 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gflags/gflags.h"
+
+DECLARE_bool(enable_op_metrics);
+
+namespace paddle {
+namespace platform {
+
+// The runtime metrics are kept in a process-wide registry and rendered in the
+// Prometheus text exposition format, so that an exporter can scrape the live
+// metrics of a running job from a local file.
+//
+// Looking a metric up takes a lock, so the callers look the metric up once and
+// keep the pointer, which is valid until the end of the process. Updating a
+// metric only uses relaxed atomic operations.
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+class MetricCounter {
+ public:
+  void Increase(uint64_t value = 1) {
+    value_.fetch_add(value, std::memory_order_relaxed);
+  }
+  uint64_t Get() const { return value_.load(std::memory_order_relaxed); }
+  void Reset() { value_.store(0, std::memory_order_relaxed); }
+
+ private:
+  std::atomic<uint64_t> value_{0};
+};
+
+// A latency histogram in log2 buckets. The bucket 0 counts the values no more
+// than 1us, the bucket i counts the values in (2^(i-1), 2^i] us, which matches
+// the "le" bounds of Prometheus, and the last bucket counts all the larger
+// values.
+class MetricHistogram {
+ public:
+  static constexpr int kNumBuckets = 28;
+
+  void Observe(uint64_t ns) {
+    buckets_[BucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+  }
+  // The upper bound of the bucket in seconds, the last one is +Inf.
+  static double BucketBound(int i) { return (1ULL << i) * 1e-6; }
+  // The least i of ns <= 2^i us, i.e. ceil(log2(ceil(ns / 1000))).
+  static int BucketIndex(uint64_t ns) {
+    uint64_t us = ns / 1000 + (ns % 1000 != 0);
+    if (us <= 1) return 0;
+    uint64_t rest = us - 1;
+    int i = 0;
+    while (rest != 0 && i < kNumBuckets - 1) {
+      rest >>= 1;
+      ++i;
+    }
+    return i;
+  }
+
+  uint64_t Count() const;
+  double SumSeconds() const {
+    return sum_ns_.load(std::memory_order_relaxed) * 1e-9;
+  }
+  uint64_t BucketCount(int i) const {
+    return buckets_[i].load(std::memory_order_relaxed);
+  }
+  void Reset();
+
+ private:
+  std::atomic<uint64_t> buckets_[kNumBuckets] = {};
+  std::atomic<uint64_t> sum_ns_{0};
+};
+
+class MetricsRegistry {
+ public:
+  static MetricsRegistry& Instance();
+
+  // Return the metric of the name and the labels, and create it at the first
+  // time. All the metrics of one name should be of the same kind.
+  MetricCounter* GetCounter(const std::string& name, const std::string& help,
+                            const MetricLabels& labels = {});
+  MetricHistogram* GetHistogram(const std::string& name,
+                                const std::string& help,
+                                const MetricLabels& labels = {});
+
+  // Render all the metrics in the Prometheus text exposition format.
+  std::string Render() const;
+  // Write the rendered metrics to path atomically, the file is written to a
+  // temporary file then renamed, so a reader never sees a partial one.
+  void Export(const std::string& path) const;
+  // Reset the values of all the metrics, the metrics themselves are kept.
+  void Reset();
+
+ private:
+  MetricsRegistry() = default;
+
+  struct Family {
+    std::string help;
+    bool is_histogram;
+    // keyed by the rendered labels, e.g. {op_type="mul"}
+    std::map<std::string, std::unique_ptr<MetricCounter>> counters;
+    std::map<std::string, std::unique_ptr<MetricHistogram>> histograms;
+  };
+  Family* GetFamily(const std::string& name, const std::string& help,
+                    bool is_histogram);
+
+  mutable std::mutex mu_;
+  std::map<std::string, Family> families_;
+};
+
+// Observe the elapsed time of a scope in a histogram, do nothing if the
+// histogram is nullptr.
+class MetricTimer {
+ public:
+  explicit MetricTimer(MetricHistogram* histogram);
+  ~MetricTimer();
+
+ private:
+  MetricHistogram* histogram_;
+  uint64_t start_ns_{0};
+};
+
+}  // namespace platform
+}  // namespace paddle
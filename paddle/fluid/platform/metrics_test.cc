@@ -0,0 +1,126 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/metrics.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+static bool Contains(const std::string& text, const std::string& line) {
+  return text.find(line) != std::string::npos;
+}
+
+TEST(Metrics, histogram_bucket) {
+  EXPECT_EQ(MetricHistogram::BucketIndex(0), 0);
+  EXPECT_EQ(MetricHistogram::BucketIndex(999), 0);
+  EXPECT_EQ(MetricHistogram::BucketIndex(1000), 0);
+  EXPECT_EQ(MetricHistogram::BucketIndex(1001), 1);
+  EXPECT_EQ(MetricHistogram::BucketIndex(1999), 1);
+  EXPECT_EQ(MetricHistogram::BucketIndex(2000), 1);
+  EXPECT_EQ(MetricHistogram::BucketIndex(2001), 2);
+  EXPECT_EQ(MetricHistogram::BucketIndex(1000000), 10);
+  // The values at the bounds are in the bucket of the bound, as the "le" of
+  // Prometheus.
+  for (int i = 0; i < MetricHistogram::kNumBuckets - 1; ++i) {
+    uint64_t bound_ns = (1ULL << i) * 1000;
+    EXPECT_EQ(MetricHistogram::BucketIndex(bound_ns), i);
+    EXPECT_EQ(MetricHistogram::BucketIndex(bound_ns + 1), i + 1);
+    EXPECT_DOUBLE_EQ(MetricHistogram::BucketBound(i), bound_ns * 1e-9);
+  }
+  EXPECT_EQ(MetricHistogram::BucketIndex(UINT64_MAX),
+            MetricHistogram::kNumBuckets - 1);
+}
+
+TEST(Metrics, registry) {
+  auto& registry = MetricsRegistry::Instance();
+  auto* a = registry.GetCounter("test_counter_total", "A test counter.",
+                                {{"op_type", "mul"}});
+  auto* b = registry.GetCounter("test_counter_total", "A test counter.",
+                                {{"op_type", "relu"}});
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, registry.GetCounter("test_counter_total", "A test counter.",
+                                   {{"op_type", "mul"}}));
+  EXPECT_THROW(registry.GetHistogram("test_counter_total", "", {}),
+               paddle::platform::EnforceNotMet);
+  EXPECT_THROW(registry.GetCounter("test counter", "", {}),
+               paddle::platform::EnforceNotMet);
+}
+
+TEST(Metrics, concurrent_update) {
+  auto* counter = MetricsRegistry::Instance().GetCounter(
+      "test_concurrent_total", "Updated by many threads.");
+  auto* histogram = MetricsRegistry::Instance().GetHistogram(
+      "test_concurrent_seconds", "Updated by many threads.");
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 8; ++i) {
+    threads.emplace_back([=] {
+      for (int j = 0; j < 10000; ++j) {
+        counter->Increase();
+        histogram->Observe(j);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  EXPECT_EQ(counter->Get(), 80000UL);
+  EXPECT_EQ(histogram->Count(), 80000UL);
+}
+
+TEST(Metrics, render) {
+  auto& registry = MetricsRegistry::Instance();
+  auto* histogram = registry.GetHistogram(
+      "test_op_run_seconds", "The run time.",
+      {{"op_type", "mul"}, {"place", "CUDAPlace(\"0\")"}});
+  histogram->Observe(500);
+  histogram->Observe(1500);
+  histogram->Observe(3000000);
+  registry.GetCounter("test_render_total", "A counter.")->Increase(3);
+
+  std::string text = registry.Render();
+  EXPECT_TRUE(Contains(text, "# HELP test_op_run_seconds The run time.\n"));
+  EXPECT_TRUE(Contains(text, "# TYPE test_op_run_seconds histogram\n"));
+  const std::string labels = "op_type=\"mul\",place=\"CUDAPlace(\\\"0\\\")\"";
+  EXPECT_TRUE(Contains(text, "test_op_run_seconds_bucket{" + labels +
+                                 ",le=\"1e-06\"} 1\n"));
+  EXPECT_TRUE(Contains(text, "test_op_run_seconds_bucket{" + labels +
+                                 ",le=\"2e-06\"} 2\n"));
+  EXPECT_TRUE(Contains(text, "test_op_run_seconds_bucket{" + labels +
+                                 ",le=\"+Inf\"} 3\n"));
+  EXPECT_TRUE(
+      Contains(text, "test_op_run_seconds_count{" + labels + "} 3\n"));
+  EXPECT_TRUE(Contains(text, "# TYPE test_render_total counter\n"));
+  EXPECT_TRUE(Contains(text, "\ntest_render_total 3\n"));
+
+  registry.Export("metrics_test.prom");
+  std::stringstream exported;
+  exported << std::ifstream("metrics_test.prom").rdbuf();
+  EXPECT_TRUE(Contains(exported.str(), "# TYPE test_op_run_seconds"));
+
+  registry.Reset();
+  EXPECT_EQ(histogram->Count(), 0UL);
+  EXPECT_TRUE(Contains(registry.Render(), "\ntest_render_total 0\n"));
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -20,6 +20,7 @@ limitations under the License. */
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/profiler.h"
 #include "paddle/fluid/platform/profiler_helper.h"
+#include "paddle/fluid/platform/sampling_profiler.h"
 #ifdef PADDLE_WITH_CUDA
 #include "paddle/fluid/platform/dynload/nvtx.h"
 #endif
@@ -66,6 +67,13 @@ RecordEvent::RecordEvent(const std::string &name, const EventRole role,
   }
 #endif
 #endif
+  if (UNLIKELY(IsSamplingProfilerEnabled()) && !name.empty() &&
+      ShouldSampleEvent()) {
+    is_sampled_ = true;
+    sampled_name_id_ = InternEventName(name);
+    role_ = role;
+    start_ns_ = PosixInNsec();
+  }
   if (g_state == ProfilerState::kDisabled || name.empty()) return;
 
   // do some initialization
@@ -87,6 +95,9 @@ RecordEvent::~RecordEvent() {
   }
 #endif
 #endif
+  if (is_sampled_) {
+    RecordSampledEvent(sampled_name_id_, role_, start_ns_, PosixInNsec());
+  }
   if (g_state == ProfilerState::kDisabled || !is_enabled_) return;
   // lock is not needed, the code below is thread-safe
   DeviceTracer *tracer = GetDeviceTracer();
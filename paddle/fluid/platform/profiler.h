@@ -133,12 +133,12 @@ struct RecordEvent {
 
   bool is_enabled_{false};
   bool is_pushed_{false};
+  // recorded by the sampling profiler
+  bool is_sampled_{false};
+  uint32_t sampled_name_id_;
   uint64_t start_ns_;
   // Event name
   std::string name_;
-  // Need to distinguish name by op type, block_id, program_id and perhaps
-  // different kernel invocations within an op.
-  std::string full_name_;
   EventRole role_{EventRole::kOrdinary};
 };
 
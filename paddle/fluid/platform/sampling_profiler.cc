@@ -0,0 +1,487 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/sampling_profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <thread>  // NOLINT
+#include <unordered_map>
+
+#include "glog/logging.h"
+#include "paddle/fluid/platform/device_tracer.h"
+#include "paddle/fluid/platform/enforce.h"
+
+namespace paddle {
+namespace platform {
+
+std::atomic<bool> g_sampling_profiler_enabled{false};
+
+double SampledEventStats::PercentileUs(double p) const {
+  uint64_t target = static_cast<uint64_t>(p * calls);
+  uint64_t count = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    count += buckets[i];
+    if (count > target || count == calls) {
+      return std::min(static_cast<double>(1ULL << i), max_us);
+    }
+  }
+  return max_us;
+}
+
+namespace {
+
+// The interval to drain the ring buffers of all threads.
+constexpr int64_t kDrainIntervalMs = 100;
+// The number of the latest events kept for the chrome trace.
+constexpr size_t kMaxTraceEvents = 1 << 17;
+
+struct RawEvent {
+  uint32_t name_id;
+  EventRole role;
+  uint32_t thread_id;
+  uint64_t start_ns;
+  uint64_t end_ns;
+};
+
+// A single producer single consumer ring buffer. The owner thread pushes the
+// events without lock, and the drain thread reads them. The fields are
+// atomic so that reading a slot being overwritten is well defined, such
+// events are detected and dropped by checking the head again after reading.
+class EventRing {
+ public:
+  EventRing(size_t size, uint32_t thread_id)
+      : slots_(size), thread_id_(thread_id) {}
+
+  void Push(uint32_t name_id, EventRole role, uint64_t start_ns,
+            uint64_t end_ns) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[head % slots_.size()];
+    slot.id_role.store(
+        (static_cast<uint64_t>(name_id) << 32) | static_cast<uint32_t>(role),
+        std::memory_order_relaxed);
+    slot.start_ns.store(start_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  // Append the new events to out, and return the number of dropped events.
+  uint64_t Drain(std::vector<RawEvent>* out) {
+    const uint64_t size = slots_.size();
+    uint64_t head = head_.load(std::memory_order_acquire);
+    uint64_t dropped = 0;
+    // The slot of the event at head may be written by a push not published
+    // yet, it is the one of the event at head - size.
+    if (head - tail_ >= size) {
+      dropped = head - tail_ - size + 1;
+      tail_ = head - size + 1;
+    }
+    size_t begin = out->size();
+    for (uint64_t i = tail_; i < head; ++i) {
+      const Slot& slot = slots_[i % size];
+      uint64_t id_role = slot.id_role.load(std::memory_order_relaxed);
+      out->push_back({static_cast<uint32_t>(id_role >> 32),
+                      static_cast<EventRole>(id_role & 0xFFFFFFFF), thread_id_,
+                      slot.start_ns.load(std::memory_order_relaxed),
+                      slot.end_ns.load(std::memory_order_relaxed)});
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t new_head = head_.load(std::memory_order_relaxed);
+    if (new_head - tail_ >= size) {
+      // the oldest events are overwritten while reading
+      uint64_t overwritten =
+          std::min(new_head - tail_ - size + 1, head - tail_);
+      out->erase(out->begin() + begin, out->begin() + begin + overwritten);
+      dropped += overwritten;
+    }
+    tail_ = head;
+    return dropped;
+  }
+
+  std::atomic<bool> alive{true};
+
+ private:
+  struct Slot {
+    std::atomic<uint64_t> id_role{0};
+    std::atomic<uint64_t> start_ns{0};
+    std::atomic<uint64_t> end_ns{0};
+  };
+
+  std::vector<Slot> slots_;
+  uint32_t thread_id_;
+  std::atomic<uint64_t> head_{0};
+  // only accessed by the drain thread
+  uint64_t tail_{0};
+};
+
+class SamplingProfiler {
+ public:
+  static SamplingProfiler& Instance() {
+    // never destroyed, the ring buffers may be used by the threads exiting
+    // after the static objects are destroyed
+    static SamplingProfiler* profiler = new SamplingProfiler();
+    return *profiler;
+  }
+
+  void Enable(const SamplingProfilerOptions& options) {
+    PADDLE_ENFORCE_GT(options.sample_rate, 0,
+                      platform::errors::InvalidArgument(
+                          "The sample_rate of the sampling profiler should be "
+                          "greater than 0, but received %d.",
+                          options.sample_rate));
+    PADDLE_ENFORCE_GT(options.ring_size, 0,
+                      platform::errors::InvalidArgument(
+                          "The ring_size of the sampling profiler should be "
+                          "greater than 0."));
+    std::lock_guard<std::mutex> control_guard(control_mu_);
+    DisableImpl();
+    {
+      std::lock_guard<std::mutex> guard(mu_);
+      options_ = options;
+      stats_.clear();
+      trace_.clear();
+      dropped_ = 0;
+      rings_.clear();
+      // the threads create new ring buffers with the new options
+      generation_.fetch_add(1, std::memory_order_relaxed);
+      stop_ = false;
+    }
+    g_sampling_profiler_enabled.store(true, std::memory_order_relaxed);
+    drain_thread_.reset(new std::thread([this] { DrainLoop(); }));
+  }
+
+  void Disable() {
+    std::lock_guard<std::mutex> control_guard(control_mu_);
+    DisableImpl();
+  }
+
+  int sample_rate() const {
+    return sample_rate_cache_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t generation() const {
+    return generation_.load(std::memory_order_relaxed);
+  }
+
+  std::shared_ptr<EventRing> NewRing() {
+    std::lock_guard<std::mutex> guard(mu_);
+    auto ring =
+        std::make_shared<EventRing>(options_.ring_size, next_thread_id_++);
+    rings_.push_back(ring);
+    sample_rate_cache_.store(options_.sample_rate, std::memory_order_relaxed);
+    return ring;
+  }
+
+  uint32_t Intern(const std::string& name) {
+    std::lock_guard<std::mutex> guard(names_mu_);
+    auto it = name_ids_.find(name);
+    if (it != name_ids_.end()) return it->second;
+    uint32_t id = static_cast<uint32_t>(names_.size());
+    names_.push_back(name);
+    name_ids_.emplace(name, id);
+    return id;
+  }
+
+  std::vector<SampledEventStats> Stats() {
+    std::lock_guard<std::mutex> guard(mu_);
+    DrainLocked();
+    return SortedStatsLocked();
+  }
+
+  uint64_t Dropped() {
+    std::lock_guard<std::mutex> guard(mu_);
+    DrainLocked();
+    return dropped_;
+  }
+
+  void Export(const std::string& path) {
+    std::lock_guard<std::mutex> guard(mu_);
+    DrainLocked();
+    WriteFile(path + ".summary", Summary());
+    WriteFile(path + ".trace.json", ChromeTrace());
+  }
+
+ private:
+  SamplingProfiler() = default;
+
+  void DisableImpl() {
+    if (!drain_thread_) return;
+    g_sampling_profiler_enabled.store(false, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> guard(mu_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    drain_thread_->join();
+    drain_thread_.reset();
+    std::string path;
+    {
+      std::lock_guard<std::mutex> guard(mu_);
+      path = options_.export_path;
+    }
+    if (!path.empty()) {
+      Export(path);
+    }
+  }
+
+  void DrainLoop() {
+    auto last_export = std::chrono::steady_clock::now();
+    std::unique_lock<std::mutex> lock(mu_);
+    while (!stop_) {
+      cv_.wait_for(lock, std::chrono::milliseconds(kDrainIntervalMs),
+                   [this] { return stop_; });
+      DrainLocked();
+      auto now = std::chrono::steady_clock::now();
+      if (!options_.export_path.empty() &&
+          now - last_export >=
+              std::chrono::milliseconds(options_.export_interval_ms)) {
+        std::string path = options_.export_path;
+        std::string summary = Summary();
+        std::string trace = ChromeTrace();
+        last_export = now;
+        // do not block the threads creating ring buffers while writing
+        lock.unlock();
+        WriteFile(path + ".summary", summary);
+        WriteFile(path + ".trace.json", trace);
+        lock.lock();
+      }
+    }
+    DrainLocked();
+  }
+
+  void DrainLocked() {
+    events_.clear();
+    for (auto it = rings_.begin(); it != rings_.end();) {
+      // read alive before draining, so the events pushed before the thread
+      // exits are not lost
+      bool alive = (*it)->alive.load(std::memory_order_acquire);
+      dropped_ += (*it)->Drain(&events_);
+      it = alive ? it + 1 : rings_.erase(it);
+    }
+    std::lock_guard<std::mutex> guard(names_mu_);
+    for (auto& e : events_) {
+      auto& stats = stats_[e.name_id];
+      double us = (e.end_ns - e.start_ns) / 1000.0;
+      if (stats.calls == 0) {
+        stats.name = names_[e.name_id];
+        stats.min_us = us;
+        stats.max_us = us;
+      }
+      stats.calls++;
+      stats.total_us += us;
+      stats.min_us = std::min(stats.min_us, us);
+      stats.max_us = std::max(stats.max_us, us);
+      int bucket = 0;
+      for (uint64_t v = static_cast<uint64_t>(us); v > 0; v >>= 1) {
+        ++bucket;
+      }
+      stats.buckets[std::min(bucket, SampledEventStats::kNumBuckets - 1)]++;
+      trace_.push_back(e);
+      if (trace_.size() > kMaxTraceEvents) {
+        trace_.pop_front();
+      }
+    }
+  }
+
+  std::vector<SampledEventStats> SortedStatsLocked() const {
+    std::vector<SampledEventStats> result;
+    for (auto& item : stats_) {
+      result.push_back(item.second);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const SampledEventStats& a, const SampledEventStats& b) {
+                return a.total_us > b.total_us;
+              });
+    return result;
+  }
+
+  std::string Summary() const {
+    std::ostringstream os;
+    os << "------------------------->     Sampling Profiling Report     "
+          "<-------------------------\n\n";
+    os << "Sample rate: 1/" << options_.sample_rate
+       << "\tDropped events: " << dropped_ << "\n";
+    os << "Time unit: us, Calls are the sampled calls, the percentiles are "
+          "the upper bounds of the histogram buckets.\n\n";
+    os << std::setw(40) << std::left << "Event" << std::setw(12) << "Calls"
+       << std::setw(14) << "Total" << std::setw(12) << "Min."
+       << std::setw(12) << "Max." << std::setw(12) << "Ave."
+       << std::setw(12) << "P50" << std::setw(12) << "P90" << std::setw(12)
+       << "P99"
+       << "\n";
+    for (auto& stats : SortedStatsLocked()) {
+      os << std::setw(40) << std::left << stats.name << std::setw(12)
+         << stats.calls << std::setw(14) << stats.total_us << std::setw(12)
+         << stats.min_us << std::setw(12) << stats.max_us << std::setw(12)
+         << stats.AveUs() << std::setw(12) << stats.PercentileUs(0.5)
+         << std::setw(12) << stats.PercentileUs(0.9) << std::setw(12)
+         << stats.PercentileUs(0.99) << "\n";
+    }
+    return os.str();
+  }
+
+  std::string ChromeTrace() const {
+    static const char* kRoleNames[] = {"Ordinary", "InnerOp", "UniqueOp",
+                                       "Special"};
+    std::lock_guard<std::mutex> guard(names_mu_);
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+    for (size_t i = 0; i < trace_.size(); ++i) {
+      auto& e = trace_[i];
+      os << (i ? ",\n" : "\n") << "{\"name\":\""
+         << JsonEscape(names_[e.name_id]) << "\",\"cat\":\""
+         << kRoleNames[static_cast<int>(e.role)]
+         << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << e.thread_id
+         << ",\"ts\":" << e.start_ns / 1000.0
+         << ",\"dur\":" << (e.end_ns - e.start_ns) / 1000.0 << "}";
+    }
+    os << "\n]}\n";
+    return os.str();
+  }
+
+  static std::string JsonEscape(const std::string& s) {
+    std::string result;
+    for (char c : s) {
+      if (c == '"' || c == '\\') {
+        result.push_back('\\');
+        result.push_back(c);
+      } else if (static_cast<unsigned char>(c) < 0x20) {
+        result.push_back(' ');
+      } else {
+        result.push_back(c);
+      }
+    }
+    return result;
+  }
+
+  // write to a temporary file then rename, so the readers never see a
+  // partial file
+  static void WriteFile(const std::string& path, const std::string& content) {
+    std::string tmp_path = path + ".tmp";
+    {
+      std::ofstream ofs(tmp_path);
+      if (!ofs) {
+        LOG(WARNING) << "Failed to open " << tmp_path
+                     << " for the sampling profiler.";
+        return;
+      }
+      ofs << content;
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      LOG(WARNING) << "Failed to write " << path
+                   << " for the sampling profiler.";
+    }
+  }
+
+  // serialize Enable and Disable
+  std::mutex control_mu_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  bool stop_{false};
+  std::unique_ptr<std::thread> drain_thread_;
+  SamplingProfilerOptions options_;
+  std::vector<std::shared_ptr<EventRing>> rings_;
+  std::atomic<uint64_t> generation_{0};
+  uint32_t next_thread_id_{0};
+  // Read by the recording threads without mu_.
+  std::atomic<int> sample_rate_cache_{1};
+  uint64_t dropped_{0};
+  std::vector<RawEvent> events_;
+  std::unordered_map<uint32_t, SampledEventStats> stats_;
+  std::deque<RawEvent> trace_;
+
+  mutable std::mutex names_mu_;
+  std::vector<std::string> names_;
+  std::unordered_map<std::string, uint32_t> name_ids_;
+};
+
+struct ThreadSampler {
+  ~ThreadSampler() {
+    if (ring) ring->alive.store(false, std::memory_order_release);
+  }
+
+  EventRing* GetRing() {
+    auto& profiler = SamplingProfiler::Instance();
+    if (!ring || generation != profiler.generation()) {
+      if (ring) ring->alive.store(false, std::memory_order_release);
+      generation = profiler.generation();
+      ring = profiler.NewRing();
+      sample_rate = profiler.sample_rate();
+      counter = 0;
+    }
+    return ring.get();
+  }
+
+  std::shared_ptr<EventRing> ring;
+  uint64_t generation{0};
+  int sample_rate{1};
+  int counter{0};
+  std::unordered_map<std::string, uint32_t> name_ids;
+};
+
+thread_local ThreadSampler t_sampler;
+
+}  // namespace
+
+void EnableSamplingProfiler(const SamplingProfilerOptions& options) {
+  SamplingProfiler::Instance().Enable(options);
+}
+
+void DisableSamplingProfiler() { SamplingProfiler::Instance().Disable(); }
+
+bool ShouldSampleEvent() {
+  auto& sampler = t_sampler;
+  sampler.GetRing();
+  if (++sampler.counter < sampler.sample_rate) return false;
+  sampler.counter = 0;
+  return true;
+}
+
+uint32_t InternEventName(const std::string& name) {
+  auto& name_ids = t_sampler.name_ids;
+  auto it = name_ids.find(name);
+  if (it != name_ids.end()) return it->second;
+  uint32_t id = SamplingProfiler::Instance().Intern(name);
+  name_ids.emplace(name, id);
+  return id;
+}
+
+void RecordSampledEvent(uint32_t name_id, EventRole role, uint64_t start_ns,
+                        uint64_t end_ns) {
+  t_sampler.GetRing()->Push(name_id, role, start_ns, end_ns);
+}
+
+std::vector<SampledEventStats> GetSampledEventStats() {
+  return SamplingProfiler::Instance().Stats();
+}
+
+uint64_t GetSampledEventsDropped() {
+  return SamplingProfiler::Instance().Dropped();
+}
+
+void ExportSamplingProfile(const std::string& path) {
+  SamplingProfiler::Instance().Export(path);
+}
+
+}  // namespace platform
+}  // namespace paddle
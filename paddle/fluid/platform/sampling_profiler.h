@@ -0,0 +1,96 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "paddle/fluid/platform/event.h"
+
+namespace paddle {
+namespace platform {
+
+// The sampling profiler is a low overhead mode of RecordEvent that can be
+// kept on in production. Every thread records one of each sample_rate events
+// into its own fixed-size ring buffer, with the event name interned to an id.
+// A background thread drains the ring buffers into per-event latency
+// histograms, and exports a summary and a chrome trace of the recent events
+// periodically, without stopping the job.
+// It is independent of EnableProfiler/DisableProfiler, both can be used at
+// the same time.
+struct SamplingProfilerOptions {
+  // record one of every sample_rate events of each thread
+  int sample_rate{100};
+  // the number of events kept by the ring buffer of each thread, the events
+  // are dropped if the ring buffer is full before it is drained
+  size_t ring_size{4096};
+  // export the profile every export_interval_ms, no periodical export if
+  // export_path is empty
+  int64_t export_interval_ms{10000};
+  // the summary is written to export_path + ".summary", and the chrome trace
+  // to export_path + ".trace.json"
+  std::string export_path;
+};
+
+// The latency histogram of one event. The bucket 0 counts the events less
+// than 1us, and the bucket i counts the events in [2^(i-1), 2^i) us.
+struct SampledEventStats {
+  static constexpr int kNumBuckets = 32;
+
+  std::string name;
+  uint64_t calls{0};
+  double total_us{0.};
+  double min_us{0.};
+  double max_us{0.};
+  uint64_t buckets[kNumBuckets] = {0};
+
+  double AveUs() const { return calls ? total_us / calls : 0.; }
+  // the upper bound of the bucket containing the percentile p, p in [0, 1]
+  double PercentileUs(double p) const;
+};
+
+extern std::atomic<bool> g_sampling_profiler_enabled;
+
+inline bool IsSamplingProfilerEnabled() {
+  return g_sampling_profiler_enabled.load(std::memory_order_relaxed);
+}
+
+// Start the sampling profiler, the statistics of the last run are cleared.
+void EnableSamplingProfiler(const SamplingProfilerOptions& options);
+// Stop the sampling profiler, and export the profile at last if export_path
+// is set.
+void DisableSamplingProfiler();
+
+// Return whether the current event of this thread should be recorded.
+bool ShouldSampleEvent();
+// The id is unique in the process, and never changes once interned.
+uint32_t InternEventName(const std::string& name);
+void RecordSampledEvent(uint32_t name_id, EventRole role, uint64_t start_ns,
+                        uint64_t end_ns);
+
+// Drain the ring buffers and return the statistics since enabled, sorted by
+// the total time.
+std::vector<SampledEventStats> GetSampledEventStats();
+// The number of sampled events dropped since enabled, because of the full
+// ring buffers.
+uint64_t GetSampledEventsDropped();
+// Drain the ring buffers and write the summary and the chrome trace of the
+// latest events.
+void ExportSamplingProfile(const std::string& path);
+
+}  // namespace platform
+}  // namespace paddle
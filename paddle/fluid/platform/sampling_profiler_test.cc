@@ -0,0 +1,153 @@
+/* Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License. */
+
+#include "paddle/fluid/platform/sampling_profiler.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "paddle/fluid/platform/device_tracer.h"
+#include "paddle/fluid/platform/profiler.h"
+
+namespace paddle {
+namespace platform {
+
+static void RunEvents(const std::string& name, int n) {
+  for (int i = 0; i < n; ++i) {
+    RecordEvent event(name);
+  }
+}
+
+static const SampledEventStats* FindStats(
+    const std::vector<SampledEventStats>& stats, const std::string& name) {
+  for (auto& s : stats) {
+    if (s.name == name) return &s;
+  }
+  return nullptr;
+}
+
+TEST(SamplingProfiler, intern) {
+  uint32_t a = InternEventName("sampling_intern_a");
+  uint32_t b = InternEventName("sampling_intern_b");
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, InternEventName("sampling_intern_a"));
+  uint32_t a_in_thread;
+  std::thread t(
+      [&] { a_in_thread = InternEventName(std::string("sampling_intern_a")); });
+  t.join();
+  EXPECT_EQ(a, a_in_thread);
+}
+
+TEST(SamplingProfiler, sample_rate) {
+  SamplingProfilerOptions options;
+  options.sample_rate = 10;
+  EnableSamplingProfiler(options);
+  RunEvents("op_a", 1000);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i) {
+    threads.emplace_back([] { RunEvents("op_b", 200); });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  auto stats = GetSampledEventStats();
+  DisableSamplingProfiler();
+
+  auto* a = FindStats(stats, "op_a");
+  auto* b = FindStats(stats, "op_b");
+  ASSERT_NE(a, nullptr);
+  ASSERT_NE(b, nullptr);
+  EXPECT_EQ(a->calls, 100UL);
+  EXPECT_EQ(b->calls, 80UL);
+  uint64_t bucket_calls = 0;
+  for (int i = 0; i < SampledEventStats::kNumBuckets; ++i) {
+    bucket_calls += a->buckets[i];
+  }
+  EXPECT_EQ(bucket_calls, a->calls);
+  EXPECT_LE(a->min_us, a->AveUs());
+  EXPECT_LE(a->AveUs(), a->max_us);
+  EXPECT_LE(a->PercentileUs(0.5), a->PercentileUs(0.99));
+
+  // disabled
+  RunEvents("op_c", 100);
+  EXPECT_EQ(FindStats(GetSampledEventStats(), "op_c"), nullptr);
+}
+
+TEST(SamplingProfiler, ring_overflow) {
+  SamplingProfilerOptions options;
+  options.sample_rate = 1;
+  options.ring_size = 16;
+  EnableSamplingProfiler(options);
+  RunEvents("op_overflow", 10000);
+  auto stats = GetSampledEventStats();
+  uint64_t dropped = GetSampledEventsDropped();
+  DisableSamplingProfiler();
+
+  auto* s = FindStats(stats, "op_overflow");
+  ASSERT_NE(s, nullptr);
+  EXPECT_EQ(s->calls + dropped, 10000UL);
+}
+
+TEST(SamplingProfiler, export) {
+  SamplingProfilerOptions options;
+  options.sample_rate = 1;
+  options.export_path = "sampling_profiler_test";
+  options.export_interval_ms = 50;
+  EnableSamplingProfiler(options);
+  RunEvents("op_\"export\"", 10);
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  // exported periodically without stopping
+  std::ifstream periodic(options.export_path + ".summary");
+  EXPECT_TRUE(periodic.good());
+  DisableSamplingProfiler();
+
+  std::stringstream summary, trace;
+  summary << std::ifstream(options.export_path + ".summary").rdbuf();
+  trace << std::ifstream(options.export_path + ".trace.json").rdbuf();
+  EXPECT_NE(summary.str().find("Sampling Profiling Report"), std::string::npos);
+  EXPECT_NE(summary.str().find("op_\"export\""), std::string::npos);
+  EXPECT_NE(trace.str().find("traceEvents"), std::string::npos);
+  EXPECT_NE(trace.str().find("op_\\\"export\\\""), std::string::npos);
+}
+
+// The overhead of RecordEvent in ns, with the sampling profiler disabled and
+// enabled in different sample rates.
+TEST(SamplingProfiler, overhead) {
+  const int n = 1000000;
+  const std::string name = "op_overhead";
+  auto bench = [&] {
+    uint64_t start = PosixInNsec();
+    RunEvents(name, n);
+    return static_cast<double>(PosixInNsec() - start) / n;
+  };
+  LOG(INFO) << "RecordEvent with the sampling profiler disabled: " << bench()
+            << " ns";
+  for (int rate : {1000, 100, 1}) {
+    SamplingProfilerOptions options;
+    options.sample_rate = rate;
+    options.ring_size = 1 << 16;
+    EnableSamplingProfiler(options);
+    double ns = bench();
+    DisableSamplingProfiler();
+    LOG(INFO) << "RecordEvent with the sampling rate 1/" << rate << ": " << ns
+              << " ns";
+  }
+}
+
+}  // namespace platform
+}  // namespace paddle
@@ -39,6 +39,7 @@ DECLARE_bool(cpu_deterministic);
 DECLARE_bool(enable_rpc_profiler);
 DECLARE_int32(multiple_of_cupti_buffer_size);
 DECLARE_bool(reader_queue_speed_test_mode);
+DECLARE_bool(reader_queue_lock_free);
 DECLARE_int32(call_stack_level);
 DECLARE_bool(sort_sum_gradient);
 DECLARE_bool(check_kernel_launch);
@@ -49,9 +50,15 @@ DECLARE_bool(enable_parallel_graph);
 DECLARE_string(pe_profile_fname);
 DECLARE_string(print_sub_graph_dir);
 DECLARE_bool(use_ngraph);
+// distributed
+DECLARE_string(cpu_allreduce_algorithm);
+DECLARE_bool(cpu_allreduce_fp16_compression);
+DECLARE_int32(comm_overlap_report_interval);
 // memory management
 DECLARE_string(allocator_strategy);
 DECLARE_double(eager_delete_tensor_gb);
+DECLARE_double(cpu_deferred_gc_slack_mb);
+DECLARE_uint64(dataloader_shm_pool_mb);
 DECLARE_double(fraction_of_cpu_memory_to_use);
 DECLARE_bool(free_idle_chunk);
 DECLARE_bool(free_when_no_cache_hit);
@@ -64,8 +71,11 @@ DECLARE_bool(use_pinned_memory);
 DECLARE_bool(use_system_allocator);
 // others
 DECLARE_bool(benchmark);
+DECLARE_bool(enable_op_metrics);
+DECLARE_bool(enable_infer_shape_cache);
 DECLARE_int32(inner_op_parallelism);
 DECLARE_int32(max_inplace_grad_add);
+DECLARE_int32(dygraph_backward_num_threads);
 DECLARE_string(tracer_profile_fname);
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
 // cudnn
@@ -106,6 +116,10 @@ DECLARE_int32(rpc_get_thread_num);
 DECLARE_int32(rpc_prefetch_thread_num);
 #endif
 
+#ifdef PADDLE_WITH_PSCORE
+DECLARE_bool(pserver_sparse_table_snapshot_save);
+#endif
+
 namespace paddle {
 namespace pybind {
 
@@ -365,7 +379,12 @@ static void RegisterGlobalVarGetterSetter() {
       FLAGS_memory_fraction_of_eager_deletion, FLAGS_use_pinned_memory,
       FLAGS_benchmark, FLAGS_inner_op_parallelism, FLAGS_tracer_profile_fname,
       FLAGS_paddle_num_threads, FLAGS_use_mkldnn, FLAGS_max_inplace_grad_add,
-      FLAGS_tracer_mkldnn_ops_on, FLAGS_tracer_mkldnn_ops_off);
+      FLAGS_tracer_mkldnn_ops_on, FLAGS_tracer_mkldnn_ops_off,
+      FLAGS_enable_op_metrics, FLAGS_enable_infer_shape_cache,
+      FLAGS_cpu_deferred_gc_slack_mb, FLAGS_dygraph_backward_num_threads,
+      FLAGS_dataloader_shm_pool_mb, FLAGS_reader_queue_lock_free,
+      FLAGS_cpu_allreduce_algorithm, FLAGS_cpu_allreduce_fp16_compression,
+      FLAGS_comm_overlap_report_interval);
 
 #if defined(PADDLE_WITH_CUDA) || defined(PADDLE_WITH_HIP)
   REGISTER_PUBLIC_GLOBAL_VAR(
@@ -392,6 +411,10 @@ static void RegisterGlobalVarGetterSetter() {
                              FLAGS_rpc_get_thread_num,
                              FLAGS_rpc_prefetch_thread_num);
 #endif
+
+#ifdef PADDLE_WITH_PSCORE
+  REGISTER_PUBLIC_GLOBAL_VAR(FLAGS_pserver_sparse_table_snapshot_save);
+#endif
 }
 }  // namespace pybind
 }  // namespace paddle
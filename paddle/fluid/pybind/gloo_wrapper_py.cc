@@ -42,6 +42,7 @@ void BindGlooWrapper(py::module* m) {
       .def("set_size", &framework::GlooWrapper::SetSize)
       .def("set_iface", &framework::GlooWrapper::SetIface)
       .def("set_prefix", &framework::GlooWrapper::SetPrefix)
+      .def("set_topology_aware", &framework::GlooWrapper::SetTopologyAware)
       .def("set_hdfs_store", &framework::GlooWrapper::SetHdfsStore)
       .def("set_http_store", &framework::GlooWrapper::SetHttpStore)
       .def("all_reduce", &framework::GlooWrapper::AllReduce<uint64_t>)
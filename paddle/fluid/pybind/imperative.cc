@@ -33,6 +33,7 @@ limitations under the License. */
 #include "paddle/fluid/imperative/amp_auto_cast.h"
 #include "paddle/fluid/imperative/basic_engine.h"
 #include "paddle/fluid/imperative/bkcl_context.h"
+#include "paddle/fluid/imperative/cpu_parallel_context.h"
 #include "paddle/fluid/imperative/data_loader.h"
 #include "paddle/fluid/imperative/hooks.h"
 #include "paddle/fluid/imperative/layer.h"
@@ -602,8 +603,8 @@ void BindImperative(py::module *m_ptr) {
           // 3. allocate shared memory
           void *data_ptr = t.data<void>();
           size_t data_size = t.numel() * framework::SizeOfType(t.type());
-          auto shared_writer_holder =
-              memory::allocation::AllocateMemoryMapWriterAllocation(data_size);
+          auto shared_writer_holder = memory::allocation::
+              AllocatePooledMemoryMapWriterAllocation(data_size);
           // 4. maintain mmap fd set & backup ipc_name
           const std::string &ipc_name = shared_writer_holder->ipc_name();
           memory::allocation::MemoryMapFdSet::Instance().Insert(ipc_name);
@@ -637,8 +638,8 @@ void BindImperative(py::module *m_ptr) {
           // 3. allocate shared memory
           void *data_ptr = t.data<void>();
           size_t data_size = t.numel() * framework::SizeOfType(t.type());
-          auto shared_writer_holder =
-              memory::allocation::AllocateMemoryMapWriterAllocation(data_size);
+          auto shared_writer_holder = memory::allocation::
+              AllocatePooledMemoryMapWriterAllocation(data_size);
           // 4. maintain mmap fd set & backup ipc_name
           const std::string &ipc_name = shared_writer_holder->ipc_name();
           memory::allocation::MemoryMapFdSet::Instance().Insert(ipc_name);
@@ -662,6 +663,9 @@ void BindImperative(py::module *m_ptr) {
           platform::errors::NotFound("The shared memory of LoDTensor in "
                                      "DataLoader's child process has been "
                                      "released."));
+      // The segments of the pool are kept in the set until the process
+      // exits, for the readers may never map them.
+      if (mmap_writer_allocation->pooled()) continue;
       memory::allocation::MemoryMapFdSet::Instance().Remove(
           mmap_writer_allocation->ipc_name());
     }
@@ -1570,6 +1574,15 @@ void BindImperative(py::module *m_ptr) {
            &imperative::jit::ProgramDescTracer::CreateProgramDesc)
       .def("reset", &imperative::jit::ProgramDescTracer::Reset);
 
+  py::class_<imperative::jit::StepCapture>(m, "StepCapture", "")
+      .def(py::init<>())
+      .def("finish", &imperative::jit::StepCapture::Finish)
+      .def("is_finished", &imperative::jit::StepCapture::IsFinished)
+      .def("replay", &imperative::jit::StepCapture::Replay,
+           py::call_guard<py::gil_scoped_release>())
+      .def("op_num", &imperative::jit::StepCapture::OpNum)
+      .def("reset", &imperative::jit::StepCapture::Reset);
+
   py::class_<imperative::Tracer, std::shared_ptr<imperative::Tracer>>(
       m, "Tracer", R"DOC()DOC")
       .def("__init__",
@@ -1628,6 +1641,8 @@ void BindImperative(py::module *m_ptr) {
       .def("_get_program_desc_tracer",
            &imperative::Tracer::GetProgramDescTracer,
            py::return_value_policy::reference)
+      .def("_set_step_capture", &imperative::Tracer::SetStepCapture,
+           py::keep_alive<1, 2>())
       .def("_generate_unique_name", &imperative::Tracer::GenerateUniqueName,
            py::arg("key") = "dygraph_tmp")
       .def("_set_amp_op_list",
@@ -1776,6 +1791,12 @@ void BindImperative(py::module *m_ptr) {
          const std::vector<std::shared_ptr<imperative::VarBase>> &grad_tensors,
          bool retain_graph, const imperative::Tracer &tracer) {
         auto *engine = tracer.GetEngine();
+        if (auto *step_capture = tracer.GetStepCapture()) {
+          // the grad graph is retained to be run by the replays
+          VLOG(3) << "Start backward captured";
+          step_capture->Backward(engine, tensors, grad_tensors);
+          return;
+        }
         engine->Init(tensors, grad_tensors, retain_graph);
         VLOG(3) << "Start backward";
         engine->Execute();
@@ -1784,7 +1805,7 @@ void BindImperative(py::module *m_ptr) {
       py::call_guard<py::gil_scoped_release>());
 
 #if defined(PADDLE_WITH_NCCL) || defined(PADDLE_WITH_RCCL) || \
-    defined(PADDLE_WITH_XPU_BKCL)
+    defined(PADDLE_WITH_XPU_BKCL) || defined(PADDLE_WITH_GLOO)
   py::class_<imperative::ParallelContext,
              std::shared_ptr<imperative::ParallelContext>>(m,
                                                            "ParallelContext");
@@ -1829,6 +1850,18 @@ void BindImperative(py::module *m_ptr) {
            &imperative::BKCLParallelContext::InitWithRingID,
            py::arg("ring_id"));
 #endif
+
+#if defined(PADDLE_WITH_GLOO)
+  py::class_<imperative::CPUParallelContext, imperative::ParallelContext,
+             std::shared_ptr<imperative::CPUParallelContext>>(
+      m, "CPUParallelContext")
+      .def(py::init<const imperative::ParallelStrategy &,
+                    const platform::CPUPlace &>())
+      .def("init", [](imperative::CPUParallelContext &self) { self.Init(); })
+      .def("init_with_ring_id",
+           &imperative::CPUParallelContext::InitWithRingID,
+           py::arg("ring_id"));
+#endif
   m.def("pylayer_apply",
         [](const platform::CPUPlace &place, const py::object &cls,
            const py::args args, const py::kwargs kwargs) {
@@ -45,6 +45,7 @@ limitations under the License. */
 #include "paddle/fluid/framework/op_info.h"
 #include "paddle/fluid/framework/op_registry.h"
 #include "paddle/fluid/framework/op_version_registry.h"
+#include "paddle/fluid/framework/parallel_checkpoint.h"
 #include "paddle/fluid/framework/parallel_executor.h"
 #include "paddle/fluid/framework/prune.h"
 #include "paddle/fluid/framework/reader.h"
@@ -67,9 +68,11 @@ limitations under the License. */
 #include "paddle/fluid/platform/dynload/dynamic_loader.h"
 #include "paddle/fluid/platform/enforce.h"
 #include "paddle/fluid/platform/init.h"
+#include "paddle/fluid/platform/metrics.h"
 #include "paddle/fluid/platform/monitor.h"
 #include "paddle/fluid/platform/place.h"
 #include "paddle/fluid/platform/profiler.h"
+#include "paddle/fluid/platform/sampling_profiler.h"
 #include "paddle/fluid/pybind/cuda_streams_py.h"
 #include "paddle/fluid/pybind/io.h"
 #ifdef PADDLE_WITH_ASCEND
@@ -1090,12 +1093,19 @@ PYBIND11_MODULE(core_noavx, m) {
                 "Now only LoDTensor on shared memory can be serialized."));
             int type_idx = static_cast<int>(t.type());
 
+            if (mmap_writer_allocation->pooled()) {
+              // the offset of the slot in the segment of the pool
+              return py::make_tuple(mmap_writer_allocation->ipc_name(),
+                                    mmap_writer_allocation->size(),
+                                    type_idx, vectorize(t.dims()), t.lod(),
+                                    mmap_writer_allocation->offset());
+            }
             return py::make_tuple(mmap_writer_allocation->ipc_name(),
                                   mmap_writer_allocation->size(),
                                   type_idx, vectorize(t.dims()), t.lod());
           },
           [](py::tuple t) {  // __setstate__
-            if (t.size() != 5)
+            if (t.size() != 5 && t.size() != 6)
               throw std::runtime_error("Invalid LoDTensor state!");
 
             // 1. Create a new C++ instance
@@ -1104,13 +1114,21 @@ PYBIND11_MODULE(core_noavx, m) {
             // 2. Rebuild Allocation
             const std::string &ipc_name = t[0].cast<std::string>();
             size_t size = t[1].cast<size_t>();
-            auto shared_reader_holder =
-              memory::allocation::RebuildMemoryMapReaderAllocation(
-                ipc_name, size);
+            std::shared_ptr<memory::allocation::MemoryMapReaderAllocation>
+              shared_reader_holder;
+            if (t.size() == 6) {
+              shared_reader_holder =
+                memory::allocation::RebuildPooledMemoryMapReaderAllocation(
+                  ipc_name, t[5].cast<size_t>(), size);
+            } else {
+              shared_reader_holder =
+                memory::allocation::RebuildMemoryMapReaderAllocation(
+                  ipc_name, size);
 
-            // 3. Maintain global fd set
-            VLOG(3) << "LoDTensor ipc name: " << ipc_name;
-            memory::allocation::MemoryMapFdSet::Instance().Insert(ipc_name);
+              // 3. Maintain global fd set
+              VLOG(3) << "LoDTensor ipc name: " << ipc_name;
+              memory::allocation::MemoryMapFdSet::Instance().Insert(ipc_name);
+            }
 
             // 4. Rebuild LoDTensor
             tensor.ResetHolderWithType(shared_reader_holder,
@@ -1857,6 +1875,40 @@ All parameter, weight, gradient are variables in Paddle.
 
   m.def("_get_eager_deletion_vars", &framework::GetEagerDeletionCleanVars);
 
+  m.def("_save_parallel_checkpoint",
+        [](const std::string &dir, const std::vector<std::string> &names,
+           const Scope &scope, int num_threads, int num_files,
+           size_t chunk_size, bool compress, bool incremental) {
+          framework::ParallelCheckpointOptions options;
+          options.num_threads = num_threads;
+          options.num_files = num_files;
+          options.chunk_size = chunk_size;
+          options.compress = compress;
+          options.incremental = incremental;
+          auto stats =
+              framework::SaveParallelCheckpoint(dir, names, scope, options);
+          return std::unordered_map<std::string, uint64_t>{
+              {"chunks_written", stats.chunks_written},
+              {"chunks_reused", stats.chunks_reused},
+              {"bytes_written", stats.bytes_written}};
+        },
+        py::arg("dir"), py::arg("names"), py::arg("scope"),
+        py::arg("num_threads") = 8, py::arg("num_files") = 8,
+        py::arg("chunk_size") = 64UL << 20, py::arg("compress") = false,
+        py::arg("incremental") = false,
+        py::call_guard<py::gil_scoped_release>());
+  m.def("_load_parallel_checkpoint",
+        [](const std::string &dir, const std::vector<std::string> &names,
+           const Scope &scope, int num_threads, bool verify_checksum) {
+          framework::ParallelCheckpointOptions options;
+          options.num_threads = num_threads;
+          options.verify_checksum = verify_checksum;
+          framework::LoadParallelCheckpoint(dir, names, scope, options);
+        },
+        py::arg("dir"), py::arg("names"), py::arg("scope"),
+        py::arg("num_threads") = 8, py::arg("verify_checksum") = true,
+        py::call_guard<py::gil_scoped_release>());
+
   py::class_<framework::Executor>(m, "Executor")
       .def(py::init<const platform::Place &>())
       .def("close", &Executor::Close)
@@ -2208,6 +2260,23 @@ All parameter, weight, gradient are variables in Paddle.
   m.def("disable_profiler", platform::DisableProfiler);
   m.def("is_profiler_enabled", platform::IsProfileEnabled);
   m.def("reset_profiler", platform::ResetProfiler);
+  m.def("enable_sampling_profiler",
+        [](int sample_rate, size_t ring_size, int64_t export_interval_ms,
+           const std::string &export_path) {
+          platform::SamplingProfilerOptions options;
+          options.sample_rate = sample_rate;
+          options.ring_size = ring_size;
+          options.export_interval_ms = export_interval_ms;
+          options.export_path = export_path;
+          platform::EnableSamplingProfiler(options);
+        });
+  m.def("disable_sampling_profiler", platform::DisableSamplingProfiler);
+  m.def("get_metrics_text",
+        [] { return platform::MetricsRegistry::Instance().Render(); });
+  m.def("export_metrics", [](const std::string &path) {
+    platform::MetricsRegistry::Instance().Export(path);
+  });
+  m.def("reset_metrics", [] { platform::MetricsRegistry::Instance().Reset(); });
   m.def("get_pass", [](const std::string &pass_type) {
     auto pass = framework::ir::PassRegistry::Instance().Get(pass_type);
     return std::shared_ptr<framework::ir::Pass>(std::move(pass));
@@ -2431,7 +2500,40 @@ All parameter, weight, gradient are variables in Paddle.
                     [](const ExecutionStrategy &self) { return self.dry_run_; },
                     [](ExecutionStrategy &self, bool dry_run) {
                       self.dry_run_ = dry_run;
-                    });
+                    })
+      .def_property(
+          "op_schedule_type",
+          [](const ExecutionStrategy &self) { return self.op_schedule_type_; },
+          [](ExecutionStrategy &self,
+             ExecutionStrategy::OpScheduleType op_schedule_type) {
+            self.op_schedule_type_ = op_schedule_type;
+          },
+          R"DOC((ExecutionStrategy.OpScheduleType, optional): The order the
+                ready operators are run in. DiscoveryOrder runs them as
+                their inputs get ready. CriticalPath runs the operator of the
+                longest path to the end of the program first.
+                CommunicationFirst runs the operators feeding the
+                communication operators first, such as the gradients to
+                all reduce, so that the communication overlaps the
+                computation left. Only used by the experimental executor.
+                Default DiscoveryOrder.
+
+                Examples:
+                    .. code-block:: python
+
+                        import paddle
+                        import paddle.static as static
+
+                        paddle.enable_static()
+
+                        exec_strategy = static.ExecutionStrategy()
+                        exec_strategy.op_schedule_type = static.ExecutionStrategy.OpScheduleType.CommunicationFirst
+              )DOC");
+
+  py::enum_<ExecutionStrategy::OpScheduleType>(exec_strategy, "OpScheduleType")
+      .value("DiscoveryOrder", ExecutionStrategy::kDiscoveryOrder)
+      .value("CriticalPath", ExecutionStrategy::kCriticalPath)
+      .value("CommunicationFirst", ExecutionStrategy::kCommunicationFirst);
 
   exec_strategy.def_property(
       "use_experimental_executor",
@@ -2983,6 +3085,42 @@ All parameter, weight, gradient are variables in Paddle.
                    self.fuse_all_reduce_ops_ == boost::none;
           },
           [](BuildStrategy &self, bool b) { self.fuse_all_reduce_ops_ = b; })
+      .def_property(
+          "cpu_grad_bucket_size_in_MB",
+          [](const BuildStrategy &self) {
+            return self.cpu_grad_bucket_size_in_MB_;
+          },
+          [](BuildStrategy &self, double size) {
+            PADDLE_ENFORCE_NE(self.IsFinalized(), true,
+                              platform::errors::PreconditionNotMet(
+                                  "BuildStrategy has been finlaized, cannot be "
+                                  "configured again."));
+            PADDLE_ENFORCE_GE(size, 0.0,
+                              platform::errors::InvalidArgument(
+                                  "The cpu_grad_bucket_size_in_MB should not "
+                                  "be negative, but received %f.",
+                                  size));
+            self.cpu_grad_bucket_size_in_MB_ = size;
+          },
+          R"DOC((float, optional): cpu_grad_bucket_size_in_MB is the size bound
+                of the buckets the gradients are coalesced into for the all
+                reduce of the CPU data parallel training. The gradients are
+                packed into the buckets by the order the backward generates
+                them, so that the all reduce of a bucket overlaps the backward
+                of the following layers. It turns on fuse_all_reduce_ops if it
+                is not set. Default 0, which groups the gradients by layers.
+
+                Examples:
+                    .. code-block:: python
+
+                        import paddle
+                        import paddle.static as static
+
+                        paddle.enable_static()
+
+                        build_strategy = static.BuildStrategy()
+                        build_strategy.cpu_grad_bucket_size_in_MB = 25
+                )DOC")
       .def_property("enable_backward_optimizer_op_deps",
                     [](const BuildStrategy &self) {
                       return self.enable_backward_optimizer_op_deps_;
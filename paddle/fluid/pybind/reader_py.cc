@@ -35,6 +35,10 @@
 DEFINE_bool(reader_queue_speed_test_mode, false,
             "If set true, the queue.pop will only get data from queue but not "
             "remove the data from queue for speed testing");
+DEFINE_bool(reader_queue_lock_free, false,
+            "If set true, the data is passed from Python to the readers "
+            "through lock-free rings, where the threads spin a while before "
+            "sleeping when the rings are full or empty");
 
 namespace paddle {
 namespace pybind {
@@ -125,7 +129,7 @@ class MultiDeviceFeedReader {
       const std::vector<framework::proto::VarType::Type> &dtypes,
       const std::vector<bool> &need_check_feed,
       const std::vector<platform::Place> &dst_places, bool use_double_buffer,
-      bool drop_last, bool pin_memory = false)
+      bool drop_last, bool pin_memory = false, size_t batch_size = 1)
       : queue_(queue),
         names_(names),
         pool_(new ::ThreadPool(dst_places.size())),
@@ -158,8 +162,12 @@ class MultiDeviceFeedReader {
         VLOG(10) << "Creating " << i << "-th BufferedReader";
         holder->Reset(
             framework::MakeDecoratedReader<operators::reader::BufferedReader>(
-                reader, p, 2, pin_memory_));
+                reader, p, 2, pin_memory_, batch_size));
       } else {
+        PADDLE_ENFORCE_EQ(batch_size, 1,
+                          platform::errors::InvalidArgument(
+                              "The samples can only be assembled into "
+                              "batches when use_double_buffer is True."));
         if (platform::is_gpu_place(p)) {
           PADDLE_THROW(platform::errors::PermissionDenied(
               "Place cannot be CUDAPlace when use_double_buffer is False"));
@@ -388,12 +396,14 @@ void BindReader(py::module *module) {
           if (is_ordered) {
             auto *holder = var.GetMutable<
                 reader::OrderedMultiDeviceLoDTensorBlockingQueueHolder>();
-            holder->InitOnce(capacity, FLAGS_reader_queue_speed_test_mode);
+            holder->InitOnce(capacity, FLAGS_reader_queue_speed_test_mode,
+                             FLAGS_reader_queue_lock_free);
             return py::cast(holder->GetQueue());
           } else {
             auto *holder =
                 var.GetMutable<reader::LoDTensorBlockingQueueHolder>();
-            holder->InitOnce(capacity, FLAGS_reader_queue_speed_test_mode);
+            holder->InitOnce(capacity, FLAGS_reader_queue_speed_test_mode,
+                             FLAGS_reader_queue_lock_free);
             return py::cast(holder->GetQueue());
           }
         },
@@ -449,11 +459,16 @@ void BindReader(py::module *module) {
            const std::vector<framework::proto::VarType::Type> &dtypes,
            const std::vector<bool> &need_check_feed,
            const std::vector<platform::Place> &dst_places,
-           bool use_double_buffer, bool drop_last, bool pin_memory) {
+           bool use_double_buffer, bool drop_last, bool pin_memory,
+           size_t batch_size) {
           return new MultiDeviceFeedReader<reader::LoDTensorBlockingQueue>(
               queue, names, shapes, dtypes, need_check_feed, dst_places,
-              use_double_buffer, drop_last, pin_memory);
+              use_double_buffer, drop_last, pin_memory, batch_size);
         },
+        py::arg("queue"), py::arg("names"), py::arg("shapes"),
+        py::arg("dtypes"), py::arg("need_check_feed"), py::arg("dst_places"),
+        py::arg("use_double_buffer"), py::arg("drop_last"),
+        py::arg("pin_memory"), py::arg("batch_size") = 1,
         py::return_value_policy::take_ownership);
 
   m.def(
@@ -465,14 +480,17 @@ void BindReader(py::module *module) {
          const std::vector<framework::proto::VarType::Type> &dtypes,
          const std::vector<bool> &need_check_feed,
          const std::vector<platform::Place> &dst_places, bool use_double_buffer,
-         bool drop_last, bool pin_memory) {
+         bool drop_last, bool pin_memory, size_t batch_size) {
         queue->SetDeviceCount(dst_places.size());
         return new MultiDeviceFeedReader<
             reader::OrderedMultiDeviceLoDTensorBlockingQueue>(
             queue, names, shapes, dtypes, need_check_feed, dst_places,
-            use_double_buffer, drop_last, pin_memory);
+            use_double_buffer, drop_last, pin_memory, batch_size);
       },
-      py::return_value_policy::take_ownership);
+      py::arg("queue"), py::arg("names"), py::arg("shapes"), py::arg("dtypes"),
+      py::arg("need_check_feed"), py::arg("dst_places"),
+      py::arg("use_double_buffer"), py::arg("drop_last"), py::arg("pin_memory"),
+      py::arg("batch_size") = 1, py::return_value_policy::take_ownership);
 }
 
 }  // namespace pybind
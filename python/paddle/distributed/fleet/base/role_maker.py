@@ -83,6 +83,7 @@ class Gloo(object):
         self._need_init_all = need_init_all
         self._iface = ""
         self._prefix = kwargs.get("store.prefix", "")
+        self._topology_aware = kwargs.get("store.topology_aware", False)
 
         http_server = None
         if self._rendezvous == Gloo.RENDEZVOUS.HDFS:
@@ -123,6 +124,7 @@ class Gloo(object):
             gloo.set_rank(rank)
             gloo.set_size(nodes)
             gloo.set_prefix(prefix)
+            gloo.set_topology_aware(self._topology_aware)
             gloo.set_iface(self._iface)
             gloo.set_timeout_seconds(self._init_timeout_seconds,
                                      self._run_timeout_seconds)
@@ -150,6 +152,7 @@ class Gloo(object):
             gloo.set_rank(rank)
             gloo.set_size(nodes)
             gloo.set_prefix(prefix)
+            gloo.set_topology_aware(self._topology_aware)
             gloo.set_iface(self._iface)
             gloo.set_timeout_seconds(self._init_timeout_seconds,
                                      self._run_timeout_seconds)
@@ -203,6 +206,7 @@ class Gloo(object):
             gloo.set_rank(rank)
             gloo.set_size(nodes)
             gloo.set_prefix(prefix)
+            gloo.set_topology_aware(self._topology_aware)
             gloo.set_iface(self._iface)
             gloo.set_timeout_seconds(self._init_timeout_seconds,
                                      self._run_timeout_seconds)
@@ -826,6 +830,9 @@ class PaddleCloudRoleMaker(RoleMakerBase):
             raise ValueError(self._gloo._err_type)
 
         need_init_all = True if use_gloo == 2 else False
+        # PADDLE_GLOO_TOPOLOGY_AWARE 1: the trainers on the same host
+        # communicate through the shared memory
+        topology_aware = int(os.getenv("PADDLE_GLOO_TOPOLOGY_AWARE", "0")) == 1
 
         if rendezvous_type == Gloo.RENDEZVOUS.HDFS:
             dfs_name = os.getenv("PADDLE_GLOO_FS_NAME", "")
@@ -836,6 +843,7 @@ class PaddleCloudRoleMaker(RoleMakerBase):
                 "dfs.ugi": dfs_ugi,
                 "dfs.path": dfs_path,
                 "store.prefix": prefix,
+                "store.topology_aware": topology_aware,
             }
         elif rendezvous_type == Gloo.RENDEZVOUS.HTTP:
             start_http_server = False
@@ -855,6 +863,7 @@ class PaddleCloudRoleMaker(RoleMakerBase):
                 "http.host": ip,
                 "http.port": port,
                 "store.prefix": prefix,
+                "store.topology_aware": topology_aware,
                 'start_http_server': start_http_server,
                 'http_server_d': http_server_d,
             }
@@ -863,6 +872,7 @@ class PaddleCloudRoleMaker(RoleMakerBase):
             kwargs = {
                 "dfs.path": dfs_path,
                 "store.prefix": prefix,
+                "store.topology_aware": topology_aware,
             }
 
         if rendezvous_type == Gloo.RENDEZVOUS.HDFS:
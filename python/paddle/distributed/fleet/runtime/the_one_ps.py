@@ -870,6 +870,13 @@ class TheOnePSRuntime(RuntimeBase):
             table_id = sparse_table_maps[var_name]
             path = os.path.join(dirname, var_name + PSERVER_SAVE_SUFFIX,
                                 "{}.block{}.txt".format(var_name, pserver_id))
+            # saved with FLAGS_pserver_sparse_table_snapshot_save, a save
+            # removes the file of the other format
+            snapshot = os.path.join(dirname, var_name + PSERVER_SAVE_SUFFIX,
+                                    "{}.block{}.bin".format(var_name,
+                                                            pserver_id))
+            if os.path.exists(snapshot):
+                path = snapshot
             meta = os.path.join(dirname, var_name + PSERVER_SAVE_SUFFIX,
                                 "{}.block{}.meta".format(var_name, pserver_id))
             self._server.load_sparse(path, meta, table_id)
@@ -121,12 +121,15 @@ def init_parallel_env():
         )
         return
 
-    # 1. gpu xpu check, must be gpu or xpu
-    if not core.is_compiled_with_cuda() and not core.is_compiled_with_xpu():
+    # 1. gpu xpu check, must be gpu or xpu, or cpu with gloo
+    use_cpu = not core.is_compiled_with_cuda(
+    ) and not core.is_compiled_with_xpu()
+    if use_cpu and not hasattr(core, "CPUParallelContext"):
         raise NotImplementedError(
-            "Cannot initialize parallel environment in CPU-only version, now only "
-            "supports initializing the GPU and XPU parallel environment. Please recompile "
-            "or reinstall paddle with GPU or XPU support.")
+            "Cannot initialize parallel environment in CPU-only version without "
+            "GLOO, now only supports initializing the GPU, XPU and CPU with GLOO "
+            "parallel environment. Please recompile or reinstall paddle with GPU, "
+            "XPU or GLOO support.")
 
     # 2. check env
     def _check_var_exists(var_name):
@@ -148,6 +151,12 @@ def init_parallel_env():
 
     # 3: init gloo context (step 1: httpsever start)
     init_gloo = int(os.getenv("PADDLE_WITH_GLOO", "0"))
+    if init_gloo and use_cpu:
+        # the http server would take the endpoint of the trainer 0, which the
+        # CPU parallel context listens on
+        raise ValueError(
+            "PADDLE_WITH_GLOO is not supported by the CPU parallel environment, "
+            "whose collective communication does not rely on gloo.")
     if init_gloo:
         ep_rank_0 = parallel_env.trainer_endpoints[0].split(":")
         manager = Manager()
@@ -184,15 +193,20 @@ def init_parallel_env():
         place = core.CUDAPlace(parallel_env.device_id)
     elif core.is_compiled_with_xpu():
         place = core.XPUPlace(parallel_env.device_id)
+    else:
+        place = core.CPUPlace()
     _set_expected_place(place)
 
-    # init nccl or bkcl context
+    # init nccl, bkcl or cpu context
     if core.is_compiled_with_cuda():
         parallel_helper._set_parallel_ctx(
             core.NCCLParallelContext(strategy, place))
     elif core.is_compiled_with_xpu():
         parallel_helper._set_parallel_ctx(
             core.BKCLParallelContext(strategy, place))
+    else:
+        parallel_helper._set_parallel_ctx(
+            core.CPUParallelContext(strategy, place))
 
     other_endpoints = strategy.trainer_endpoints[:]
     other_endpoints.remove(strategy.current_endpoint)
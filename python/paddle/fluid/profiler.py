@@ -21,7 +21,7 @@ import six
 
 __all__ = [
     'cuda_profiler', 'reset_profiler', 'profiler', 'start_profiler',
-    'stop_profiler'
+    'stop_profiler', 'start_sampling_profiler', 'stop_sampling_profiler'
 ]
 
 NVPROF_CONFIG = [
@@ -310,6 +310,65 @@ def stop_profiler(sorted_key=None, profile_path='/tmp/profile'):
     core.disable_profiler(key_map[sorted_key], profile_path)
 
 
+def start_sampling_profiler(sample_rate=100,
+                            export_path=None,
+                            export_interval_ms=10000,
+                            ring_size=4096):
+    """
+    Enable the sampling profiler, which records one of every `sample_rate`
+    events of each thread with low overhead, so it can be kept on when the
+    job is running. Different from `fluid.profiler.start_profiler`, the
+    per-event latency histograms are exported periodically without stopping
+    the profiler, and the two profilers can be used at the same time.
+
+    Args:
+        sample_rate (int, optional) : Record one of every `sample_rate` events
+            of each thread. Default is 100.
+        export_path (str, optional) : If set, the summary is written to
+            `export_path + '.summary'` and the chrome trace of the latest
+            events is written to `export_path + '.trace.json'` every
+            `export_interval_ms`, and when the profiler is stopped.
+        export_interval_ms (int, optional) : The export interval in
+            milliseconds. Default is 10000.
+        ring_size (int, optional) : The number of events buffered for each
+            thread, the events are dropped if the buffer is full before it is
+            drained. Default is 4096.
+
+    Examples:
+
+        .. code-block:: python
+
+            import paddle.fluid.profiler as profiler
+
+            profiler.start_sampling_profiler(100, '/tmp/sampling_profile')
+            for iter in range(10):
+                pass  # run the program
+            profiler.stop_sampling_profiler()
+    """
+    if sample_rate <= 0:
+        raise ValueError("The sample_rate must be greater than 0.")
+    core.enable_sampling_profiler(sample_rate, ring_size, export_interval_ms,
+                                  export_path or "")
+
+
+def stop_sampling_profiler():
+    """
+    Stop the sampling profiler enabled by
+    `fluid.profiler.start_sampling_profiler`, and export the profile at last
+    if the `export_path` is set.
+
+    Examples:
+
+        .. code-block:: python
+
+            import paddle.fluid.profiler as profiler
+
+            profiler.start_sampling_profiler(100, '/tmp/sampling_profile')
+            profiler.stop_sampling_profiler()
+    """
+    core.disable_sampling_profiler()
+
+
 @signature_safe_contextmanager
 def profiler(state,
              sorted_key=None,
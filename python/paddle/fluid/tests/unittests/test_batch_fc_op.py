@@ -89,10 +89,7 @@ class TestBatchFCOp1(OpTest):
         self.outputs = {"Out": np_out}
 
     def test_check_output_cpu(self):
-        try:
-            self.check_output_with_place(place=core.CPUPlace())
-        except:
-            print("do not support cpu test, skip")
+        self.check_output_with_place(place=core.CPUPlace())
 
     def test_check_grad_cpu(self):
         try:
@@ -110,6 +110,40 @@ class TestFuseAllReduceOpsAndOptiOps(TestFuseAllReduceOps):
             fuse_all_optimizer_ops=True)
 
 
+def fc_with_reshaped_param(use_feed=None):
+    img = fluid.layers.data(name='image', shape=[784], dtype='float32')
+    label = fluid.layers.data(name='label', shape=[1], dtype='int64')
+    # The grad of the parameter is written by reshape2_grad into its place
+    # in the fused buffer.
+    weight = fluid.layers.create_parameter(
+        shape=[784 * 32],
+        dtype='float32',
+        default_initializer=fluid.initializer.Uniform(-0.05, 0.05))
+    hidden = fluid.layers.matmul(img, fluid.layers.reshape(weight, [784, 32]))
+    hidden = fluid.layers.relu(hidden)
+    prediction = fluid.layers.fc(hidden, size=10, act='softmax')
+    loss = fluid.layers.cross_entropy(input=prediction, label=label)
+    loss = fluid.layers.mean(loss)
+    return loss
+
+
+class TestFuseAllReduceOpsWithGradBuckets(TestFuseAllReduceOps):
+    @classmethod
+    def set_strategy(cls, *args, **kwargs):
+        build_strategy, exec_strategy = super(
+            TestFuseAllReduceOpsWithGradBuckets, cls).set_strategy(*args,
+                                                                   **kwargs)
+        if build_strategy.fuse_all_reduce_ops:
+            # Smaller than most of the grads of the models, to pack them
+            # into several buckets, some with a grad only.
+            build_strategy.cpu_grad_bucket_size_in_MB = 0.2
+        return build_strategy, exec_strategy
+
+    def test_reshaped_param_fc_with_fuse_all_reduce(self):
+        self._decorate_compare_fused_all_reduce(fc_with_reshaped_param,
+                                                DeviceType.CPU)
+
+
 class TestFuseAllReduceOpsWithSparseGrad(TestFuseAllReduceOpsBase):
     @classmethod
     def setUpClass(cls):
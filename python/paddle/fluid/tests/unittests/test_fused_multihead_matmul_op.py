@@ -32,8 +32,6 @@ def stable_softmax(x):
     return exps / np.sum(exps)
 
 
-@unittest.skipIf(not core.is_compiled_with_cuda(),
-                 "Paddle core is not compiled with CUDA")
 class TestFusedMultiheadMatmulOp(OpTest):
     def config(self):
         self.seq_len = 128
@@ -108,8 +106,12 @@ class TestFusedMultiheadMatmulOp(OpTest):
         self.outputs = {"Out": reshape_qkv}
 
     def test_check_output(self):
-        place = core.CUDAPlace(0)
-        self.check_output_with_place(place, atol=2e-3)
+        if core.is_compiled_with_cuda():
+            place = core.CUDAPlace(0)
+            self.check_output_with_place(place, atol=2e-3)
+
+    def test_check_output_cpu(self):
+        self.check_output_with_place(core.CPUPlace(), atol=2e-3)
 
 
 class TestFusedMultiHeadMatmulOp2(TestFusedMultiheadMatmulOp):
@@ -0,0 +1,137 @@
+#   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import unittest
+import numpy as np
+from op_test import OpTest
+from test_reorder_lod_tensor import convert_to_offset
+from sequence.test_sequence_pool import compute_seqpool_sum, compute_seqpool_avg, compute_seqpool_sqrt
+from test_cvm_op import cvm_compute
+
+
+class TestFusionSeqPoolCVMConcatFCOp(OpTest):
+    def setUp(self):
+        self.w = 11
+        self.d = 8
+        self.use_cvm = True
+        self.with_bias = True
+        self.act = "relu"
+        self.lods = [[[2, 3, 5]], [[1, 5, 2]]]
+        self.set_conf()
+        self.set_pooltype()
+        self.op_type = 'fusion_seqpool_cvm_concat_fc'
+        bs = len(self.lods[0][0])
+        inputs = []
+        outs = []
+        # The cvm variable is not actually used.
+        cvm = np.array([[0.6, 0.4]]).astype("float32")
+        i = 0
+        for lod in self.lods:
+            assert bs == len(lod[0]), 'All lod size should be equal'
+            x = np.random.uniform(0.1, 1,
+                                  [sum(lod[0]), self.w]).astype('float32')
+            offset = convert_to_offset(lod)
+            out = np.zeros((bs, self.w)).astype('float32')
+            if self.pooltype == "SUM":
+                compute_seqpool_sum(x, offset, out)
+            elif self.pooltype == "AVERAGE":
+                compute_seqpool_avg(x, offset, out)
+            elif self.pooltype == "SQRT":
+                compute_seqpool_sqrt(x, offset, out)
+            else:
+                raise Exception("Unsupported pool type!")
+            inputs.append(('x_{0}'.format(i), (x, lod)))
+            outs.append(cvm_compute(out, self.w, self.use_cvm))
+            i = i + 1
+
+        concat = np.concatenate(outs, axis=1)
+        weight = np.random.uniform(-0.5, 0.5, [concat.shape[1],
+                                               self.d]).astype('float32')
+        out = np.dot(concat, weight)
+        self.inputs = {'X': inputs, "CVM": cvm, "W": weight}
+        if self.with_bias:
+            bias = np.random.uniform(-1, 1, [1, self.d]).astype('float32')
+            out = out + bias
+            self.inputs["Bias"] = bias
+        if self.act == "relu":
+            out = np.maximum(out, 0)
+        self.outputs = {'Out': out}
+        self.attrs = {
+            'pooltype': self.pooltype,
+            'activation_type': self.act,
+        }
+
+    def set_pooltype(self):
+        self.pooltype = "SUM"
+
+    def set_conf(self):
+        pass
+
+    def test_check_output(self):
+        self.check_output(atol=1e-4)
+
+
+class TestFusionSeqPoolCVMConcatFCOpCase1(TestFusionSeqPoolCVMConcatFCOp):
+    def set_conf(self):
+        self.lods = [[[1]]]
+        self.act = ""
+
+
+class TestFusionSeqPoolCVMConcatFCOpCase2(TestFusionSeqPoolCVMConcatFCOp):
+    def set_conf(self):
+        self.lods = [[[1]], [[1]], [[1]]]
+        self.with_bias = False
+
+
+class TestFusionSeqPoolCVMConcatFCOpCase3(TestFusionSeqPoolCVMConcatFCOp):
+    def set_conf(self):
+        self.lods = [[[1, 3, 4, 6]]]
+        self.w = 10
+        self.d = 33
+
+
+# more rows and slots than one block
+class TestFusionSeqPoolCVMConcatFCOpCase4(TestFusionSeqPoolCVMConcatFCOp):
+    def set_conf(self):
+        bs = 70
+        self.lods = [[list(np.random.randint(1, 4, bs))] for _ in range(100)]
+        self.d = 16
+
+
+## test avg pool and sqrt
+def create_test_avg_sqrt_class(parent):
+    class TestSeqPoolAvgCase(parent):
+        def set_pooltype(self):
+            self.pooltype = "AVERAGE"
+
+    class TestSeqPoolSqrtCase(parent):
+        def set_pooltype(self):
+            self.pooltype = "SQRT"
+
+    cls_name_avg = "{0}_{1}".format(parent.__name__, "avg")
+    cls_name_sqrt = "{0}_{1}".format(parent.__name__, "sqrt")
+    TestSeqPoolAvgCase.__name__ = cls_name_avg
+    TestSeqPoolSqrtCase.__name__ = cls_name_sqrt
+    globals()[cls_name_avg] = TestSeqPoolAvgCase
+    globals()[cls_name_sqrt] = TestSeqPoolSqrtCase
+
+
+create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatFCOp)
+create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatFCOpCase1)
+create_test_avg_sqrt_class(TestFusionSeqPoolCVMConcatFCOpCase3)
+
+if __name__ == '__main__':
+    unittest.main()
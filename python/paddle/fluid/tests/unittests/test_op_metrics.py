@@ -0,0 +1,73 @@
+#   Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import os
+import tempfile
+import unittest
+
+import numpy as np
+import paddle
+import paddle.fluid as fluid
+import paddle.fluid.core as core
+
+paddle.enable_static()
+
+
+class TestOpMetrics(unittest.TestCase):
+    def run_program(self):
+        main_program = fluid.Program()
+        startup_program = fluid.Program()
+        with fluid.program_guard(main_program, startup_program):
+            x = fluid.data(name='x', shape=[-1, 16], dtype='float32')
+            y = fluid.layers.fc(input=x, size=8, act='relu')
+            loss = fluid.layers.mean(y)
+        exe = fluid.Executor(fluid.CPUPlace())
+        exe.run(startup_program)
+        for _ in range(3):
+            exe.run(main_program,
+                    feed={'x': np.random.random((4, 16)).astype('float32')},
+                    fetch_list=[loss])
+
+    def test_op_metrics(self):
+        fluid.set_flags({'FLAGS_enable_op_metrics': True})
+        core.reset_metrics()
+        self.run_program()
+        fluid.set_flags({'FLAGS_enable_op_metrics': False})
+
+        text = core.get_metrics_text()
+        self.assertIn('# TYPE paddle_op_run_seconds histogram', text)
+        count_line = [
+            line for line in text.splitlines()
+            if line.startswith('paddle_op_run_seconds_count{op_type="mean"')
+        ]
+        self.assertEqual(len(count_line), 1)
+        self.assertTrue(count_line[0].endswith(' 3'))
+
+        path = os.path.join(tempfile.gettempdir(), 'paddle_metrics.prom')
+        core.export_metrics(path)
+        with open(path) as f:
+            self.assertIn('paddle_op_run_seconds_bucket', f.read())
+
+    def test_disabled(self):
+        core.reset_metrics()
+        self.run_program()
+        for line in core.get_metrics_text().splitlines():
+            if line.startswith('paddle_op_run_seconds_count'):
+                self.assertTrue(line.endswith(' 0'))
+
+
+if __name__ == '__main__':
+    unittest.main()
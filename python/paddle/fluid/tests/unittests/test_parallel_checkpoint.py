@@ -0,0 +1,77 @@
+# Copyright (c) 2021 PaddlePaddle Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+from __future__ import print_function
+
+import shutil
+import tempfile
+import unittest
+
+import numpy as np
+import paddle
+import paddle.fluid as fluid
+import paddle.fluid.core as core
+
+paddle.enable_static()
+
+
+class TestParallelCheckpoint(unittest.TestCase):
+    def setUp(self):
+        self.dir = tempfile.mkdtemp()
+        self.main_program = fluid.Program()
+        self.startup_program = fluid.Program()
+        with fluid.program_guard(self.main_program, self.startup_program):
+            x = fluid.data(name='x', shape=[-1, 32], dtype='float32')
+            hidden = fluid.layers.fc(input=x, size=64, act='relu')
+            fluid.layers.fc(input=hidden, size=10)
+        self.scope = core.Scope()
+        exe = fluid.Executor(fluid.CPUPlace())
+        with fluid.scope_guard(self.scope):
+            exe.run(self.startup_program)
+        self.names = [
+            p.name for p in self.main_program.global_block().all_parameters()
+        ]
+
+    def tearDown(self):
+        shutil.rmtree(self.dir)
+
+    def get_params(self, scope):
+        return [
+            np.array(scope.find_var(name).get_tensor()) for name in self.names
+        ]
+
+    def test_save_load(self):
+        expected = self.get_params(self.scope)
+        stats = core._save_parallel_checkpoint(
+            self.dir, self.names, self.scope, chunk_size=1024, compress=True)
+        self.assertGreater(stats["chunks_written"], len(self.names))
+
+        scope = core.Scope()
+        for name in self.names:
+            scope.var(name)
+        core._load_parallel_checkpoint(self.dir, self.names, scope)
+        for a, b in zip(expected, self.get_params(scope)):
+            self.assertTrue(np.array_equal(a, b))
+
+        stats = core._save_parallel_checkpoint(
+            self.dir,
+            self.names,
+            self.scope,
+            chunk_size=1024,
+            incremental=True)
+        self.assertEqual(stats["chunks_written"], 0)
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -155,6 +155,20 @@ class TestProfiler(unittest.TestCase):
                 batch_range=[5, 10],
                 use_new_api=use_new_api)
 
+    def test_sampling_profiler(self):
+        exe = fluid.Executor(fluid.CPUPlace())
+        main_program, startup_program, avg_cost, _, _ = self.build_program(
+            compile_program=False)
+        exe.run(startup_program)
+        export_path = os.path.join(tempfile.gettempdir(), "sampling_profile")
+        profiler.start_sampling_profiler(
+            sample_rate=1, export_path=export_path, export_interval_ms=100)
+        for _ in range(5):
+            self.run_iter(exe, main_program, [avg_cost])
+        profiler.stop_sampling_profiler()
+        self.assertTrue(os.path.exists(export_path + ".summary"))
+        self.assertTrue(os.path.exists(export_path + ".trace.json"))
+
     @unittest.skipIf(not core.is_compiled_with_cuda(),
                      "profiler is enabled only with GPU")
     def test_cuda_profiler(self):
@@ -26,6 +26,7 @@ COMPILE_RUN_OP_WHITE_LIST = [
     'retinanet_detection_output', \
     'ctc_align', \
     'fusion_seqpool_cvm_concat', \
+    'fusion_seqpool_cvm_concat_fc', \
     'gru', \
     'rpn_target_assign', \
     'retinanet_target_assign', \
@@ -65,6 +65,7 @@ CPU_PARALLEL_JOB = [
     'test_sequence_last_step',
     'test_sequence_first_step',
     'test_seqpool_cvm_concat_fuse_pass',
+    'test_seqpool_cvm_concat_fc_fuse_pass',
     'test_seqpool_concat_fuse_pass',
     'test_seq_concat_fc_fuse_pass',
     'test_selected_rows',